@@ -21,6 +21,7 @@
 #include "mutex.h"
 #include "condition_variable.h"
 #include "dstrings.h"
+#include "thread.h"
 #include <dlib/static_assert.h>
 #include <dlib/spinlock.h>
 
@@ -29,6 +30,23 @@ namespace dmMessage
     // Alignment of allocations
     const uint32_t DM_MESSAGE_ALIGNMENT = 16U;
 
+    // Each socket is a lock-free multi-producer/single-consumer queue. Post pushes the message on an
+    // intrusive stack with a CAS and Dispatch unlinks the whole stack with an exchange and reverses it,
+    // which keeps the order of messages posted from each thread.
+    //
+    // Message memory comes from per producer (thread) page allocators, so that allocating a message never
+    // needs a lock. Exhausted pages are pushed on the allocator's full list by the producer, and pushed back
+    // on the free list by the consumer once the messages in them are dispatched. A page is only pushed on the
+    // full list after all messages in it have been posted, so Dispatch unlinks the full pages before the
+    // messages and can then reclaim them after the dispatch.
+    //
+    // Threads beyond MAX_PRODUCERS - 1 share the last allocator, which is guarded by a spinlock. The other
+    // allocators are owned by one thread at a time, and released to other threads when the owner exits.
+    // The exiting thread hands its current page over to the consumer and frees its free pages.
+    //
+    // Dispatched pages are kept for reuse as long as the socket has at most MAX_RETAINED_PAGES pages,
+    // otherwise they are freed. Only one thread at a time may dispatch a socket.
+
     struct MemoryPage
     {
         uint8_t     m_Memory[DM_MESSAGE_PAGE_SIZE];
@@ -38,17 +56,20 @@ namespace dmMessage
 
     struct MemoryAllocator
     {
-        MemoryAllocator()
-        {
-            m_CurrentPage = 0;
-            m_FreePages = 0;
-            m_FullPages = 0;
-        }
+        // Owned by the producer
         MemoryPage* m_CurrentPage;
-        MemoryPage* m_FreePages;
-        MemoryPage* m_FullPages;
+        MemoryPage* m_LocalFreePages;
+        // Pages pushed by the consumer, taken all at once by the producer
+        MemoryPage* volatile m_FreePages;
+        // Pages pushed by the producer, taken all at once by the consumer
+        MemoryPage* volatile m_FullPages;
     };
 
+    const uint32_t MAX_PRODUCERS = 16;
+    const uint32_t MAX_RETAINED_PAGES = 8;
+    // Producer slots that are owned by one thread, the last slot is shared
+    const uint32_t OWNED_PRODUCER_SLOTS_MASK = (1U << (MAX_PRODUCERS - 1)) - 1;
+
     struct GlobalInit
     {
         GlobalInit() {
@@ -58,27 +79,102 @@ namespace dmMessage
 
     } g_MessageInit;
 
-    static void AllocateNewPage(MemoryAllocator* allocator)
+    static void ReleaseProducer(void* tls_data);
+
+    static dmThread::TlsKey g_ProducerTlsKey = dmThread::AllocTls(ReleaseProducer);
+    static int32_atomic_t g_ProducerSlots = 0;
+    static dmThread::TlsKey g_ConsumerTlsKey = dmThread::AllocTls();
+    static int32_atomic_t g_ConsumerCount = 0;
+
+    static uint32_t AcquireProducerSlot()
+    {
+        for (;;)
+        {
+            int32_t used = g_ProducerSlots;
+            uint32_t available = ~(uint32_t)used & OWNED_PRODUCER_SLOTS_MASK;
+            if (available == 0)
+            {
+                return MAX_PRODUCERS - 1;
+            }
+            uint32_t index = 0;
+            while ((available & (1U << index)) == 0)
+            {
+                ++index;
+            }
+            if (dmAtomicCompareStore32(&g_ProducerSlots, used | (int32_t)(1U << index), used) == used)
+            {
+                return index;
+            }
+        }
+    }
+
+    static uint32_t GetProducerIndex()
+    {
+        void* tls_data = dmThread::GetTlsValue(g_ProducerTlsKey);
+        // Threads on the shared slot take an owned slot as soon as one is released
+        if (tls_data == 0 || ((uintptr_t)tls_data == MAX_PRODUCERS && (uint32_t)g_ProducerSlots != OWNED_PRODUCER_SLOTS_MASK))
+        {
+            // NOTE: We store index + 1. Otherwise we can't differentiate between index 0 and not initialized
+            tls_data = (void*)((uintptr_t)AcquireProducerSlot() + 1);
+            dmThread::SetTlsValue(g_ProducerTlsKey, tls_data);
+        }
+        return (uint32_t)((uintptr_t)tls_data - 1);
+    }
+
+    // Unique id of the calling thread, used to check that a socket is only dispatched by one thread at a time
+    static int32_t GetConsumerId()
+    {
+        void* tls_data = dmThread::GetTlsValue(g_ConsumerTlsKey);
+        if (tls_data == 0)
+        {
+            tls_data = (void*)((uintptr_t)dmAtomicIncrement32(&g_ConsumerCount) + 1);
+            dmThread::SetTlsValue(g_ConsumerTlsKey, tls_data);
+        }
+        return (int32_t)(uintptr_t)tls_data;
+    }
+
+    // Lock-free push of the page chain [first, last] onto a page list
+    static void PushPages(MemoryPage* volatile* list, MemoryPage* first, MemoryPage* last)
+    {
+        MemoryPage* head;
+        do
+        {
+            head = *list;
+            last->m_NextPage = head;
+        } while (dmAtomicCompareStorePtr((void* volatile*) list, first, head) != head);
+    }
+
+    static MemoryPage* TakePages(MemoryPage* volatile* list)
+    {
+        return (MemoryPage*) dmAtomicStorePtr((void* volatile*) list, 0);
+    }
+
+    static void AllocateNewPage(MemoryAllocator* allocator, int32_atomic_t* page_count)
     {
         if (allocator->m_CurrentPage)
         {
-            // Link current page to full pages
-            allocator->m_CurrentPage->m_NextPage = allocator->m_FullPages;
-            allocator->m_FullPages = allocator->m_CurrentPage;
+            // Hand the current page over to the consumer
+            PushPages(&allocator->m_FullPages, allocator->m_CurrentPage, allocator->m_CurrentPage);
+        }
+
+        if (allocator->m_LocalFreePages == 0)
+        {
+            allocator->m_LocalFreePages = TakePages(&allocator->m_FreePages);
         }
 
         MemoryPage* new_page = 0;
 
-        if (allocator->m_FreePages)
+        if (allocator->m_LocalFreePages)
         {
             // Free page to use
-            new_page = allocator->m_FreePages;
-            allocator->m_FreePages = new_page->m_NextPage;
+            new_page = allocator->m_LocalFreePages;
+            allocator->m_LocalFreePages = new_page->m_NextPage;
         }
         else
         {
             // Allocate new page
             new_page = new MemoryPage;
+            dmAtomicIncrement32(page_count);
         }
 
         new_page->m_Current = 0;
@@ -87,7 +183,7 @@ namespace dmMessage
         allocator->m_CurrentPage = new_page;
     }
 
-    static void* AllocateMessage(MemoryAllocator* allocator, uint32_t size)
+    static void* AllocateMessage(MemoryAllocator* allocator, int32_atomic_t* page_count, uint32_t size)
     {
         // At least ALIGNMENT bytes alignment of size in order to ensure that the next allocation is aligned
         size += DM_MESSAGE_ALIGNMENT-1;
@@ -97,7 +193,7 @@ namespace dmMessage
         if (allocator->m_CurrentPage == 0 || (DM_MESSAGE_PAGE_SIZE-allocator->m_CurrentPage->m_Current) < size)
         {
             // No current page or allocation didn't fit.
-            AllocateNewPage(allocator);
+            AllocateNewPage(allocator, page_count);
         }
 
         MemoryPage* page = allocator->m_CurrentPage;
@@ -106,16 +202,48 @@ namespace dmMessage
         return ret;
     }
 
+    static uint32_t FreePages(MemoryPage* p)
+    {
+        uint32_t count = 0;
+        while (p)
+        {
+            MemoryPage* next = p->m_NextPage;
+            delete p;
+            p = next;
+            ++count;
+        }
+        return count;
+    }
+
+    static Message* ReverseMessages(Message* message)
+    {
+        Message* prev = 0;
+        while (message)
+        {
+            Message* next = message->m_Next;
+            message->m_Next = prev;
+            prev = message;
+            message = next;
+        }
+        return prev;
+    }
+
     struct MessageSocket
     {
-        uint32_t        m_RefCount; // Is protected by "g_MessageContext->m_Spinlock"
+        int32_atomic_t  m_RefCount; // Incremented with "g_MessageContext->m_Spinlock" held
         dmhash_t        m_NameHash;
-        Message*        m_Header;
-        Message*        m_Tail;
+        // Most recently posted message, linked towards the oldest
+        Message* volatile m_Head;
         const char*     m_Name;
+        // Only used by DispatchBlocking to wait for messages
         dmMutex::HMutex m_Mutex;
         dmConditionVariable::HConditionVariable m_Condition;
-        MemoryAllocator m_Allocator;
+        dmSpinlock::lock_t m_SharedAllocatorLock;
+        MemoryAllocator m_Allocators[MAX_PRODUCERS];
+        // Number of allocated pages, in use or free
+        int32_atomic_t  m_PageCount;
+        // Id of the thread currently dispatching the socket, or 0
+        int32_atomic_t  m_Consumer;
     };
 
     const uint32_t MAX_SOCKETS = 256;
@@ -150,6 +278,39 @@ namespace dmMessage
         }
     } g_ContextDestroyer;
 
+    static void ReleaseProducerPages(uint32_t* index, const dmhash_t* key, MessageSocket* s)
+    {
+        (void)key;
+        MemoryAllocator* allocator = &s->m_Allocators[*index];
+        if (allocator->m_CurrentPage)
+        {
+            // The page may hold messages that are not dispatched yet
+            PushPages(&allocator->m_FullPages, allocator->m_CurrentPage, allocator->m_CurrentPage);
+            allocator->m_CurrentPage = 0;
+        }
+        uint32_t freed = FreePages(allocator->m_LocalFreePages) + FreePages(TakePages(&allocator->m_FreePages));
+        allocator->m_LocalFreePages = 0;
+        dmAtomicSub32(&s->m_PageCount, (int32_t)freed);
+    }
+
+    // Called when a thread that has posted messages exits
+    static void ReleaseProducer(void* tls_data)
+    {
+        uint32_t index = (uint32_t)((uintptr_t)tls_data - 1);
+        if (index == MAX_PRODUCERS - 1)
+        {
+            return;
+        }
+
+        if (g_MessageContext)
+        {
+            // Sockets are only disposed after they are erased from the table, so they stay valid while the lock is held
+            DM_SPINLOCK_SCOPED_LOCK(g_MessageContext->m_Spinlock);
+            g_MessageContext->m_Sockets.Iterate(ReleaseProducerPages, &index);
+        }
+        dmAtomicSub32(&g_ProducerSlots, (int32_t)(1U << index));
+    }
+
     Result NewSocket(const char* name, HSocket* socket)
     {
         if (g_MessageContext == 0)
@@ -177,13 +338,13 @@ namespace dmMessage
         }
 
         MessageSocket s;
+        memset(&s, 0, sizeof(s));
         s.m_RefCount = 1;
-        s.m_Header = 0;
-        s.m_Tail = 0;
         s.m_NameHash = name_hash;
         s.m_Name = strdup(name);
         s.m_Mutex = dmMutex::New();
         s.m_Condition = dmConditionVariable::New();
+        dmSpinlock::Init(&s.m_SharedAllocatorLock);
 
         g_MessageContext->m_Sockets.Put(name_hash, s);
         *socket = name_hash;
@@ -193,7 +354,7 @@ namespace dmMessage
 
     static void DisposeSocket(MessageSocket* s)
     {
-        Message *message_object = s->m_Header;
+        Message *message_object = ReverseMessages(s->m_Head);
         while (message_object)
         {
             if (message_object->m_DestroyCallback)
@@ -205,23 +366,16 @@ namespace dmMessage
 
         free((void*) s->m_Name);
 
-        MemoryPage* p = s->m_Allocator.m_FreePages;
-        while (p)
-        {
-            MemoryPage* next = p->m_NextPage;
-            delete p;
-            p = next;
-        }
-        p = s->m_Allocator.m_FullPages;
-        while (p)
-        {
-            MemoryPage* next = p->m_NextPage;
-            delete p;
-            p = next;
-        }
-        if (s->m_Allocator.m_CurrentPage)
+        for (uint32_t i = 0; i < MAX_PRODUCERS; ++i)
         {
-            delete s->m_Allocator.m_CurrentPage;
+            MemoryAllocator* allocator = &s->m_Allocators[i];
+            FreePages(allocator->m_LocalFreePages);
+            FreePages(allocator->m_FreePages);
+            FreePages(allocator->m_FullPages);
+            if (allocator->m_CurrentPage)
+            {
+                delete allocator->m_CurrentPage;
+            }
         }
 
         dmConditionVariable::Delete(s->m_Condition);
@@ -233,14 +387,10 @@ namespace dmMessage
 
     static void ReleaseSocket(MessageSocket* s)
     {
+        // The socket is erased from the table before the last reference is released, so it can't be acquired again
+        if (dmAtomicDecrement32(&s->m_RefCount) > 1)
         {
-            DM_SPINLOCK_SCOPED_LOCK(g_MessageContext->m_Spinlock);
-            --s->m_RefCount;
-
-            if (s->m_RefCount > 0)
-            {
-                return;
-            }
+            return;
         }
         DisposeSocket(s);
     }
@@ -258,7 +408,7 @@ namespace dmMessage
 
         assert(s->m_RefCount >= 1);
 
-        ++s->m_RefCount;
+        dmAtomicIncrement32(&s->m_RefCount);
 
         return s;
     }
@@ -275,15 +425,8 @@ namespace dmMessage
             }
 
             g_MessageContext->m_Sockets.Erase(s->m_NameHash);
-            --s->m_RefCount;
-
-            if(s->m_RefCount > 0)
-            {
-                // Defer deletion
-                return RESULT_OK;
-            }
         }
-        DisposeSocket(s);
+        ReleaseSocket(s);
         return RESULT_OK;
     }
 
@@ -343,11 +486,7 @@ namespace dmMessage
         MessageSocket* s = AcquireSocket(socket);
         if (s != 0)
         {
-            bool has_messages;
-            {
-                DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
-                has_messages = s->m_Header != 0;
-            }
+            bool has_messages = s->m_Head != 0;
             ReleaseSocket(s);
             return has_messages;
         }
@@ -375,11 +514,17 @@ namespace dmMessage
             return RESULT_SOCKET_NOT_FOUND;
         }
 
-        dmMutex::Lock(s->m_Mutex);
+        uint32_t producer = GetProducerIndex();
+        bool shared_allocator = producer == MAX_PRODUCERS - 1;
+        if (shared_allocator)
+        {
+            // Held until the message is pushed, since another producer may hand the page over to the consumer
+            dmSpinlock::Lock(&s->m_SharedAllocatorLock);
+        }
 
-        MemoryAllocator* allocator = &s->m_Allocator;
+        MemoryAllocator* allocator = &s->m_Allocators[producer];
         uint32_t data_size = sizeof(Message) + message_data_size;
-        Message *new_message = (Message *) AllocateMessage(allocator, data_size);
+        Message *new_message = (Message *) AllocateMessage(allocator, &s->m_PageCount, data_size);
         if (sender != 0x0)
         {
             new_message->m_Sender = *sender;
@@ -393,28 +538,27 @@ namespace dmMessage
         new_message->m_UserData = user_data;
         new_message->m_Descriptor = descriptor;
         new_message->m_DataSize = message_data_size;
-        new_message->m_Next = 0;
         new_message->m_DestroyCallback = destroy_callback;
         memcpy(&new_message->m_Data[0], message_data, message_data_size);
 
-        bool is_first_message = !s->m_Header;
-
-        if (!s->m_Header)
+        Message* head;
+        do
         {
-            s->m_Header = new_message;
-            s->m_Tail = new_message;
-        }
-        else
+            head = s->m_Head;
+            new_message->m_Next = head;
+        } while (dmAtomicCompareStorePtr((void* volatile*) &s->m_Head, new_message, head) != head);
+
+        if (shared_allocator)
         {
-            s->m_Tail->m_Next = new_message;
-            s->m_Tail = new_message;
+            dmSpinlock::Unlock(&s->m_SharedAllocatorLock);
         }
 
-        if (is_first_message)
+        if (head == 0)
         {
+            // Wake up a blocking dispatch, the lock makes sure it is either waiting or will see the message
+            DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
             dmConditionVariable::Signal(s->m_Condition);
         }
-        dmMutex::Unlock(s->m_Mutex);
 
         ReleaseSocket(s);
 
@@ -453,7 +597,7 @@ namespace dmMessage
         return profiler_string;
     }
 
-    uint32_t InternalDispatch(HSocket socket, DispatchCallback dispatch_callback, void* user_ptr, bool blocking)
+    uint32_t InternalDispatch(HSocket socket, DispatchCallback dispatch_callback, DispatchBatchCallback batch_callback, void* user_ptr, bool blocking)
     {
         MessageSocket* s = AcquireSocket(socket);
         if (s == 0)
@@ -461,16 +605,25 @@ namespace dmMessage
             return 0;
         }
 
-        dmMutex::Lock(s->m_Mutex);
+        // Recursive dispatch from the dispatching thread is fine, but the socket queue only supports one consumer
+        int32_t consumer = GetConsumerId();
+        int32_t current_consumer = dmAtomicCompareStore32(&s->m_Consumer, consumer, 0);
+        assert((current_consumer == 0 || current_consumer == consumer) && "A socket must only be dispatched from one thread at a time");
+        bool outer_dispatch = current_consumer == 0;
 
-        MemoryAllocator* allocator = &s->m_Allocator;
-
-        if (!s->m_Header)
+        if (s->m_Head == 0)
         {
             if (blocking) {
-                dmConditionVariable::Wait(s->m_Condition, s->m_Mutex);
+                DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
+                while (s->m_Head == 0)
+                {
+                    dmConditionVariable::Wait(s->m_Condition, s->m_Mutex);
+                }
             } else {
-                dmMutex::Unlock(s->m_Mutex);
+                if (outer_dispatch)
+                {
+                    dmAtomicStore32(&s->m_Consumer, 0);
+                }
                 ReleaseSocket(s);
                 return 0;
             }
@@ -482,37 +635,72 @@ namespace dmMessage
 
         uint32_t dispatch_count = 0;
 
-        Message *message_object = s->m_Header;
-        s->m_Header = 0;
-        s->m_Tail = 0;
+        // Unlink full pages before the messages, all messages in them are then part of this dispatch
+        MemoryPage* full_pages[MAX_PRODUCERS];
+        for (uint32_t i = 0; i < MAX_PRODUCERS; ++i)
+        {
+            full_pages[i] = TakePages(&s->m_Allocators[i].m_FullPages);
+        }
 
-        // Unlink full pages
-        MemoryPage* full_pages = allocator->m_FullPages;
-        allocator->m_FullPages = 0;
+        Message *first_message = ReverseMessages((Message*) dmAtomicStorePtr((void* volatile*) &s->m_Head, 0));
 
-        dmMutex::Unlock(s->m_Mutex);
+        if (batch_callback)
+        {
+            for (Message* message_object = first_message; message_object; message_object = message_object->m_Next)
+            {
+                dispatch_count++;
+            }
+            if (dispatch_count)
+            {
+                batch_callback(first_message, dispatch_count, user_ptr);
+            }
+            for (Message* message_object = first_message; message_object; message_object = message_object->m_Next)
+            {
+                if (message_object->m_DestroyCallback) {
+                    message_object->m_DestroyCallback(message_object);
+                }
+            }
+        }
+        else
+        {
+            Message *message_object = first_message;
+            while (message_object)
+            {
+                dispatch_callback(message_object, user_ptr);
+                if (message_object->m_DestroyCallback) {
+                    message_object->m_DestroyCallback(message_object);
+                }
+                message_object = message_object->m_Next;
+                dispatch_count++;
+            }
+        }
 
-        while (message_object)
+        // Reclaim all full pages active when dispatch started, pages above the retained budget are freed
+        for (uint32_t i = 0; i < MAX_PRODUCERS; ++i)
         {
-            dispatch_callback(message_object, user_ptr);
-            if (message_object->m_DestroyCallback) {
-                message_object->m_DestroyCallback(message_object);
+            MemoryPage* first = full_pages[i];
+            while (first && (uint32_t)s->m_PageCount > MAX_RETAINED_PAGES)
+            {
+                MemoryPage* next = first->m_NextPage;
+                delete first;
+                dmAtomicDecrement32(&s->m_PageCount);
+                first = next;
+            }
+            if (first)
+            {
+                MemoryPage* last = first;
+                while (last->m_NextPage)
+                {
+                    last = last->m_NextPage;
+                }
+                PushPages(&s->m_Allocators[i].m_FreePages, first, last);
             }
-            message_object = message_object->m_Next;
-            dispatch_count++;
         }
 
-        // Reclaim all full pages active when dispatch started
-        dmMutex::Lock(s->m_Mutex);
-        MemoryPage* p = full_pages;
-        while (p)
+        if (outer_dispatch)
         {
-            MemoryPage* next = p->m_NextPage;
-            p->m_NextPage = allocator->m_FreePages;
-            allocator->m_FreePages = p;
-            p = next;
+            dmAtomicStore32(&s->m_Consumer, 0);
         }
-        dmMutex::Unlock(s->m_Mutex);
 
         ReleaseSocket(s);
 
@@ -521,12 +709,17 @@ namespace dmMessage
 
     uint32_t Dispatch(HSocket socket, DispatchCallback dispatch_callback, void* user_ptr)
     {
-        return InternalDispatch(socket, dispatch_callback, user_ptr, false);
+        return InternalDispatch(socket, dispatch_callback, 0, user_ptr, false);
     }
 
     uint32_t DispatchBlocking(HSocket socket, DispatchCallback dispatch_callback, void* user_ptr)
     {
-        return InternalDispatch(socket, dispatch_callback, user_ptr, true);
+        return InternalDispatch(socket, dispatch_callback, 0, user_ptr, true);
+    }
+
+    uint32_t DispatchBatch(HSocket socket, DispatchBatchCallback dispatch_callback, void* user_ptr)
+    {
+        return InternalDispatch(socket, 0, dispatch_callback, user_ptr, false);
     }
 
     static void ConsumeCallback(dmMessage::Message*, void*)
@@ -128,6 +128,11 @@ namespace dmMessage
      */
     typedef void(*DispatchCallback)(dmMessage::Message *message, void* user_ptr);
 
+    /**
+     * @see #DispatchBatch
+     */
+    typedef void(*DispatchBatchCallback)(dmMessage::Message *messages, uint32_t message_count, void* user_ptr);
+
 
     /**
      * Create a new socket
@@ -201,6 +206,8 @@ namespace dmMessage
      * Dispatch messages
      * @note When dispatched, the messages are considered destroyed. Messages posted during dispatch
      *       are handled in the next invocation to #Dispatch
+     * @note Messages can be posted from any thread, but a socket must only be dispatched from one thread
+     *       at a time. This is asserted in debug builds.
      * @param socket Socket handle of the socket of which messages to dispatch.
      * @param dispatch_callback Callback function that will be called for each message
      *        dispatched. The callbacks parameters contains a pointer to a unique Message
@@ -220,6 +227,19 @@ namespace dmMessage
      */
     uint32_t DispatchBlocking(HSocket socket, DispatchCallback dispatch_callback, void* user_ptr);
 
+    /**
+     * Dispatch all pending messages with a single callback.
+     * See Dispatch() for additional information
+     * @note The messages are linked through Message::m_Next in the order they were posted, and
+     *       the destroy callbacks are called after the dispatch callback has returned
+     * @param socket Socket handle of the socket of which messages to dispatch.
+     * @param dispatch_callback Callback function that will be called once with the first pending
+     *        message and the number of messages, if there are any.
+     * @param user_ptr user data
+     * @return Number of dispatched messages
+     */
+    uint32_t DispatchBatch(HSocket socket, DispatchBatchCallback dispatch_callback, void* user_ptr);
+
     /**
      * Consume all pending messages
      * @param socket Socket handle
@@ -16,6 +16,8 @@
 #if defined(_WIN32)
 #include <stdlib.h>
 #include <wchar.h>
+#include "atomic.h"
+#include "math.h"
 #endif
 
 namespace dmThread
@@ -87,9 +89,14 @@ namespace dmThread
     }
 
     TlsKey AllocTls()
+    {
+        return AllocTls(0);
+    }
+
+    TlsKey AllocTls(TlsDestructor destructor)
     {
         pthread_key_t key;
-        int ret = pthread_key_create(&key, 0);
+        int ret = pthread_key_create(&key, destructor);
         assert(ret == 0);
         return key;
     }
@@ -155,12 +162,50 @@ namespace dmThread
     #endif
     }
     
+    // There are no destructors for TlsAlloc keys, they are called by ThreadStartProxy instead
+    static const uint32_t MAX_TLS_DESTRUCTORS = 16;
+    static TlsKey         g_TlsDestructorKeys[MAX_TLS_DESTRUCTORS];
+    static TlsDestructor  g_TlsDestructors[MAX_TLS_DESTRUCTORS];
+    static int32_atomic_t g_TlsDestructorCount = 0;
+
+    struct ThreadData
+    {
+        ThreadStart m_Start;
+        void*       m_Arg;
+    };
+
+    static DWORD WINAPI ThreadStartProxy(LPVOID arg)
+    {
+        ThreadData* data = (ThreadData*) arg;
+        data->m_Start(data->m_Arg);
+        delete data;
+
+        uint32_t count = dmMath::Min((uint32_t) g_TlsDestructorCount, MAX_TLS_DESTRUCTORS);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            TlsDestructor destructor = g_TlsDestructors[i];
+            if (destructor == 0)
+                continue;
+            void* value = TlsGetValue(g_TlsDestructorKeys[i]);
+            if (value != 0)
+            {
+                TlsSetValue(g_TlsDestructorKeys[i], 0);
+                destructor(value);
+            }
+        }
+        return 0;
+    }
+
     Thread New(ThreadStart thread_start, uint32_t stack_size, void* arg, const char* name)
     {
+        ThreadData* thread_data = new ThreadData;
+        thread_data->m_Start = thread_start;
+        thread_data->m_Arg = arg;
+
         DWORD thread_id;
         HANDLE thread = CreateThread(NULL, stack_size,
-                                     (LPTHREAD_START_ROUTINE) thread_start,
-                                     arg, 0, &thread_id);
+                                     ThreadStartProxy,
+                                     thread_data, 0, &thread_id);
         assert(thread);
 
         SetThreadName((Thread)thread, name);
@@ -179,8 +224,30 @@ namespace dmThread
         return TlsAlloc();
     }
 
+    TlsKey AllocTls(TlsDestructor destructor)
+    {
+        TlsKey key = TlsAlloc();
+        if (destructor)
+        {
+            uint32_t index = (uint32_t) (dmAtomicIncrement32(&g_TlsDestructorCount));
+            assert(index < MAX_TLS_DESTRUCTORS);
+            g_TlsDestructorKeys[index] = key;
+            // Written last, the slot is skipped by ThreadStartProxy until the destructor is set
+            dmAtomicStorePtr((void* volatile*) &g_TlsDestructors[index], (void*) destructor);
+        }
+        return key;
+    }
+
     void FreeTls(TlsKey key)
     {
+        uint32_t count = dmMath::Min((uint32_t) g_TlsDestructorCount, MAX_TLS_DESTRUCTORS);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (g_TlsDestructors[i] != 0 && g_TlsDestructorKeys[i] == key)
+            {
+                dmAtomicStorePtr((void* volatile*) &g_TlsDestructors[i], 0);
+            }
+        }
         BOOL ret = TlsFree(key);
         assert(ret);
     }
@@ -65,6 +65,20 @@ namespace dmThread
 
     TlsKey AllocTls();
 
+    /**
+     * Thread local storage destructor, called with the value of the key when a thread exits
+     */
+    typedef void (*TlsDestructor)(void* value);
+
+    /**
+     * Allocate thread local storage key with a destructor
+     * @note The destructor is only called for non-null values. On win32 it is only called for
+     *       threads created with dmThread::New
+     * @param destructor Destructor called when a thread exits
+     * @return Key
+     */
+    TlsKey AllocTls(TlsDestructor destructor);
+
     /**
      * Free thread local storage key
      * @param key Key
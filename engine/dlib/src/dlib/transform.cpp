@@ -0,0 +1,372 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <math.h>
+#include <string.h>
+#include "transform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_TRANSFORM_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define DM_TRANSFORM_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace dmTransform
+{
+    void TransformSoA::SetSize(uint32_t size)
+    {
+        dmArray<float>* arrays[] = { &m_PositionX, &m_PositionY, &m_PositionZ,
+                                     &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW,
+                                     &m_ScaleX, &m_ScaleY, &m_ScaleZ };
+        for (uint32_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i)
+        {
+            if (arrays[i]->Capacity() < size)
+                arrays[i]->SetCapacity(size);
+            arrays[i]->SetSize(size);
+        }
+    }
+
+    // Same math as Matrix4(Quat, Vector3) followed by appendScale()
+    static inline void ToMatrix4Scalar(const TransformSoA& t, uint32_t i, float* m)
+    {
+        float x = t.m_RotationX[i];
+        float y = t.m_RotationY[i];
+        float z = t.m_RotationZ[i];
+        float w = t.m_RotationW[i];
+        float x2 = x + x;
+        float y2 = y + y;
+        float z2 = z + z;
+        float xx2 = x * x2;
+        float xy2 = x * y2;
+        float xz2 = x * z2;
+        float xw2 = w * x2;
+        float yy2 = y * y2;
+        float yz2 = y * z2;
+        float yw2 = w * y2;
+        float zz2 = z * z2;
+        float zw2 = w * z2;
+        float sx = t.m_ScaleX[i];
+        float sy = t.m_ScaleY[i];
+        float sz = t.m_ScaleZ[i];
+        m[0]  = ((1.0f - yy2) - zz2) * sx;
+        m[1]  = (xy2 + zw2) * sx;
+        m[2]  = (xz2 - yw2) * sx;
+        m[3]  = 0.0f;
+        m[4]  = (xy2 - zw2) * sy;
+        m[5]  = ((1.0f - xx2) - zz2) * sy;
+        m[6]  = (yz2 + xw2) * sy;
+        m[7]  = 0.0f;
+        m[8]  = (xz2 + yw2) * sz;
+        m[9]  = (yz2 - xw2) * sz;
+        m[10] = ((1.0f - xx2) - yy2) * sz;
+        m[11] = 0.0f;
+        m[12] = t.m_PositionX[i];
+        m[13] = t.m_PositionY[i];
+        m[14] = t.m_PositionZ[i];
+        m[15] = 1.0f;
+    }
+
+    // Column-major 4x4 multiply, out = a * b. out may alias b but not a.
+    static inline void MulScalar(const float* a, const float* b, float* out)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            float b0 = b[c*4+0];
+            float b1 = b[c*4+1];
+            float b2 = b[c*4+2];
+            float b3 = b[c*4+3];
+            for (uint32_t r = 0; r < 4; ++r)
+            {
+                out[c*4+r] = a[r] * b0 + a[4+r] * b1 + a[8+r] * b2 + a[12+r] * b3;
+            }
+        }
+    }
+
+    // Scale factor that normalizes the z column of a, see NormalizeZScale()
+    static inline float ZScaleRecip(const float* a)
+    {
+        float len_sqr = a[8]*a[8] + a[9]*a[9] + a[10]*a[10] + a[11]*a[11];
+        return len_sqr > 0.0f ? 1.0f / sqrtf(len_sqr) : 1.0f;
+    }
+
+#if defined(DM_TRANSFORM_SSE)
+
+    void ToMatrix4(const TransformSoA& t, Matrix4* out)
+    {
+        uint32_t n = t.Size();
+        uint32_t i = 0;
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&t.m_RotationX[i]);
+            __m128 y = _mm_loadu_ps(&t.m_RotationY[i]);
+            __m128 z = _mm_loadu_ps(&t.m_RotationZ[i]);
+            __m128 w = _mm_loadu_ps(&t.m_RotationW[i]);
+            __m128 x2 = _mm_add_ps(x, x);
+            __m128 y2 = _mm_add_ps(y, y);
+            __m128 z2 = _mm_add_ps(z, z);
+            __m128 xx2 = _mm_mul_ps(x, x2);
+            __m128 xy2 = _mm_mul_ps(x, y2);
+            __m128 xz2 = _mm_mul_ps(x, z2);
+            __m128 xw2 = _mm_mul_ps(w, x2);
+            __m128 yy2 = _mm_mul_ps(y, y2);
+            __m128 yz2 = _mm_mul_ps(y, z2);
+            __m128 yw2 = _mm_mul_ps(w, y2);
+            __m128 zz2 = _mm_mul_ps(z, z2);
+            __m128 zw2 = _mm_mul_ps(w, z2);
+            __m128 sx = _mm_loadu_ps(&t.m_ScaleX[i]);
+            __m128 sy = _mm_loadu_ps(&t.m_ScaleY[i]);
+            __m128 sz = _mm_loadu_ps(&t.m_ScaleZ[i]);
+
+            // Each register holds one matrix element for four instances
+            __m128 m00 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy2), zz2), sx);
+            __m128 m01 = _mm_mul_ps(_mm_add_ps(xy2, zw2), sx);
+            __m128 m02 = _mm_mul_ps(_mm_sub_ps(xz2, yw2), sx);
+            __m128 m10 = _mm_mul_ps(_mm_sub_ps(xy2, zw2), sy);
+            __m128 m11 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx2), zz2), sy);
+            __m128 m12 = _mm_mul_ps(_mm_add_ps(yz2, xw2), sy);
+            __m128 m20 = _mm_mul_ps(_mm_add_ps(xz2, yw2), sz);
+            __m128 m21 = _mm_mul_ps(_mm_sub_ps(yz2, xw2), sz);
+            __m128 m22 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx2), yy2), sz);
+            __m128 m30 = _mm_loadu_ps(&t.m_PositionX[i]);
+            __m128 m31 = _mm_loadu_ps(&t.m_PositionY[i]);
+            __m128 m32 = _mm_loadu_ps(&t.m_PositionZ[i]);
+            __m128 m03 = zero, m13 = zero, m23 = zero, m33 = one;
+
+            // Transpose back into one column per register
+            _MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+            _MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+            _MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+            _MM_TRANSPOSE4_PS(m30, m31, m32, m33);
+
+            float* m = (float*)&out[i];
+            _mm_storeu_ps(m +  0, m00); _mm_storeu_ps(m +  4, m10); _mm_storeu_ps(m +  8, m20); _mm_storeu_ps(m + 12, m30);
+            _mm_storeu_ps(m + 16, m01); _mm_storeu_ps(m + 20, m11); _mm_storeu_ps(m + 24, m21); _mm_storeu_ps(m + 28, m31);
+            _mm_storeu_ps(m + 32, m02); _mm_storeu_ps(m + 36, m12); _mm_storeu_ps(m + 40, m22); _mm_storeu_ps(m + 44, m32);
+            _mm_storeu_ps(m + 48, m03); _mm_storeu_ps(m + 52, m13); _mm_storeu_ps(m + 56, m23); _mm_storeu_ps(m + 60, m33);
+        }
+        for (; i < n; ++i)
+        {
+            ToMatrix4Scalar(t, i, (float*)&out[i]);
+        }
+    }
+
+    static inline void MulSSE(__m128 a0, __m128 a1, __m128 a2, __m128 a3, const float* b, float* out)
+    {
+        __m128 c0 = _mm_loadu_ps(b + 0);
+        __m128 c1 = _mm_loadu_ps(b + 4);
+        __m128 c2 = _mm_loadu_ps(b + 8);
+        __m128 c3 = _mm_loadu_ps(b + 12);
+    #define DM_MUL_COLUMN(c) \
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_shuffle_ps(c, c, _MM_SHUFFLE(0,0,0,0))), \
+                              _mm_mul_ps(a1, _mm_shuffle_ps(c, c, _MM_SHUFFLE(1,1,1,1)))), \
+                   _mm_add_ps(_mm_mul_ps(a2, _mm_shuffle_ps(c, c, _MM_SHUFFLE(2,2,2,2))), \
+                              _mm_mul_ps(a3, _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,3,3)))))
+        _mm_storeu_ps(out + 0, DM_MUL_COLUMN(c0));
+        _mm_storeu_ps(out + 4, DM_MUL_COLUMN(c1));
+        _mm_storeu_ps(out + 8, DM_MUL_COLUMN(c2));
+        _mm_storeu_ps(out + 12, DM_MUL_COLUMN(c3));
+    #undef DM_MUL_COLUMN
+    }
+
+    void Mul(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* a = (const float*)lhs[i];
+            MulSSE(_mm_loadu_ps(a), _mm_loadu_ps(a + 4), _mm_loadu_ps(a + 8), _mm_loadu_ps(a + 12), (const float*)&rhs[i], (float*)&out[i]);
+        }
+    }
+
+    void MulNoScaleZ(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* a = (const float*)lhs[i];
+            const float* b = (const float*)&rhs[i];
+            float* o = (float*)&out[i];
+            __m128 a0 = _mm_loadu_ps(a);
+            __m128 a1 = _mm_loadu_ps(a + 4);
+            __m128 a2 = _mm_loadu_ps(a + 8);
+            __m128 a3 = _mm_loadu_ps(a + 12);
+            // The translation is transformed by lhs with a normalized z column
+            __m128 t = _mm_loadu_ps(b + 12);
+            __m128 a2n = _mm_mul_ps(a2, _mm_set1_ps(ZScaleRecip(a)));
+            __m128 col3 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0,0,0,0))),
+                                                _mm_mul_ps(a1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1,1,1,1)))),
+                                     _mm_add_ps(_mm_mul_ps(a2n, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2,2,2,2))),
+                                                _mm_mul_ps(a3, _mm_shuffle_ps(t, t, _MM_SHUFFLE(3,3,3,3)))));
+            MulSSE(a0, a1, a2, a3, b, o);
+            _mm_storeu_ps(o + 12, col3);
+        }
+    }
+
+#elif defined(DM_TRANSFORM_NEON)
+
+    void ToMatrix4(const TransformSoA& t, Matrix4* out)
+    {
+        uint32_t n = t.Size();
+        uint32_t i = 0;
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t x = vld1q_f32(&t.m_RotationX[i]);
+            float32x4_t y = vld1q_f32(&t.m_RotationY[i]);
+            float32x4_t z = vld1q_f32(&t.m_RotationZ[i]);
+            float32x4_t w = vld1q_f32(&t.m_RotationW[i]);
+            float32x4_t x2 = vaddq_f32(x, x);
+            float32x4_t y2 = vaddq_f32(y, y);
+            float32x4_t z2 = vaddq_f32(z, z);
+            float32x4_t xx2 = vmulq_f32(x, x2);
+            float32x4_t xy2 = vmulq_f32(x, y2);
+            float32x4_t xz2 = vmulq_f32(x, z2);
+            float32x4_t xw2 = vmulq_f32(w, x2);
+            float32x4_t yy2 = vmulq_f32(y, y2);
+            float32x4_t yz2 = vmulq_f32(y, z2);
+            float32x4_t yw2 = vmulq_f32(w, y2);
+            float32x4_t zz2 = vmulq_f32(z, z2);
+            float32x4_t zw2 = vmulq_f32(w, z2);
+            float32x4_t sx = vld1q_f32(&t.m_ScaleX[i]);
+            float32x4_t sy = vld1q_f32(&t.m_ScaleY[i]);
+            float32x4_t sz = vld1q_f32(&t.m_ScaleZ[i]);
+
+            // vst4q interleaves four registers, i.e. writes one column per instance
+            float32x4x4_t c0, c1, c2, c3;
+            c0.val[0] = vmulq_f32(vsubq_f32(vsubq_f32(one, yy2), zz2), sx);
+            c0.val[1] = vmulq_f32(vaddq_f32(xy2, zw2), sx);
+            c0.val[2] = vmulq_f32(vsubq_f32(xz2, yw2), sx);
+            c0.val[3] = zero;
+            c1.val[0] = vmulq_f32(vsubq_f32(xy2, zw2), sy);
+            c1.val[1] = vmulq_f32(vsubq_f32(vsubq_f32(one, xx2), zz2), sy);
+            c1.val[2] = vmulq_f32(vaddq_f32(yz2, xw2), sy);
+            c1.val[3] = zero;
+            c2.val[0] = vmulq_f32(vaddq_f32(xz2, yw2), sz);
+            c2.val[1] = vmulq_f32(vsubq_f32(yz2, xw2), sz);
+            c2.val[2] = vmulq_f32(vsubq_f32(vsubq_f32(one, xx2), yy2), sz);
+            c2.val[3] = zero;
+            c3.val[0] = vld1q_f32(&t.m_PositionX[i]);
+            c3.val[1] = vld1q_f32(&t.m_PositionY[i]);
+            c3.val[2] = vld1q_f32(&t.m_PositionZ[i]);
+            c3.val[3] = one;
+
+            float tmp[4][16];
+            vst4q_f32(tmp[0], c0);
+            vst4q_f32(tmp[1], c1);
+            vst4q_f32(tmp[2], c2);
+            vst4q_f32(tmp[3], c3);
+            float* m = (float*)&out[i];
+            for (uint32_t j = 0; j < 4; ++j)
+            {
+                vst1q_f32(m + j*16 +  0, vld1q_f32(&tmp[0][j*4]));
+                vst1q_f32(m + j*16 +  4, vld1q_f32(&tmp[1][j*4]));
+                vst1q_f32(m + j*16 +  8, vld1q_f32(&tmp[2][j*4]));
+                vst1q_f32(m + j*16 + 12, vld1q_f32(&tmp[3][j*4]));
+            }
+        }
+        for (; i < n; ++i)
+        {
+            ToMatrix4Scalar(t, i, (float*)&out[i]);
+        }
+    }
+
+    static inline float32x4_t MulColumnNEON(float32x4_t a0, float32x4_t a1, float32x4_t a2, float32x4_t a3, float32x4_t c)
+    {
+        float32x4_t r = vmulq_n_f32(a0, vgetq_lane_f32(c, 0));
+        r = vmlaq_n_f32(r, a1, vgetq_lane_f32(c, 1));
+        r = vmlaq_n_f32(r, a2, vgetq_lane_f32(c, 2));
+        return vmlaq_n_f32(r, a3, vgetq_lane_f32(c, 3));
+    }
+
+    static inline void MulNEON(float32x4_t a0, float32x4_t a1, float32x4_t a2, float32x4_t a3, const float* b, float* out)
+    {
+        float32x4_t c0 = vld1q_f32(b + 0);
+        float32x4_t c1 = vld1q_f32(b + 4);
+        float32x4_t c2 = vld1q_f32(b + 8);
+        float32x4_t c3 = vld1q_f32(b + 12);
+        vst1q_f32(out + 0, MulColumnNEON(a0, a1, a2, a3, c0));
+        vst1q_f32(out + 4, MulColumnNEON(a0, a1, a2, a3, c1));
+        vst1q_f32(out + 8, MulColumnNEON(a0, a1, a2, a3, c2));
+        vst1q_f32(out + 12, MulColumnNEON(a0, a1, a2, a3, c3));
+    }
+
+    void Mul(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* a = (const float*)lhs[i];
+            MulNEON(vld1q_f32(a), vld1q_f32(a + 4), vld1q_f32(a + 8), vld1q_f32(a + 12), (const float*)&rhs[i], (float*)&out[i]);
+        }
+    }
+
+    void MulNoScaleZ(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* a = (const float*)lhs[i];
+            const float* b = (const float*)&rhs[i];
+            float* o = (float*)&out[i];
+            float32x4_t a0 = vld1q_f32(a);
+            float32x4_t a1 = vld1q_f32(a + 4);
+            float32x4_t a2 = vld1q_f32(a + 8);
+            float32x4_t a3 = vld1q_f32(a + 12);
+            // The translation is transformed by lhs with a normalized z column
+            float32x4_t a2n = vmulq_n_f32(a2, ZScaleRecip(a));
+            float32x4_t col3 = MulColumnNEON(a0, a1, a2n, a3, vld1q_f32(b + 12));
+            MulNEON(a0, a1, a2, a3, b, o);
+            vst1q_f32(o + 12, col3);
+        }
+    }
+
+#else
+
+    void ToMatrix4(const TransformSoA& t, Matrix4* out)
+    {
+        uint32_t n = t.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            ToMatrix4Scalar(t, i, (float*)&out[i]);
+        }
+    }
+
+    void Mul(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float tmp[16];
+            MulScalar((const float*)lhs[i], (const float*)&rhs[i], tmp);
+            memcpy(&out[i], tmp, sizeof(tmp));
+        }
+    }
+
+    void MulNoScaleZ(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* a = (const float*)lhs[i];
+            const float* b = (const float*)&rhs[i];
+            float s = ZScaleRecip(a);
+            float tmp[16];
+            MulScalar(a, b, tmp);
+            for (uint32_t r = 0; r < 4; ++r)
+            {
+                tmp[12+r] = a[r] * b[12] + a[4+r] * b[13] + a[8+r] * s * b[14] + a[12+r] * b[15];
+            }
+            memcpy(&out[i], tmp, sizeof(tmp));
+        }
+    }
+
+#endif
+}
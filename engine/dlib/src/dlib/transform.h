@@ -15,6 +15,7 @@
 
 #include <assert.h>
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
+#include "array.h"
 #include "math.h"
 
 namespace dmTransform
@@ -474,6 +475,85 @@ namespace dmTransform
         res.setCol(3, tmp * m2.getCol(3));
         return res;
     }
+
+    /**
+     * Local transforms (translation, rotation, scale) in structure-of-arrays layout.
+     * Each component is kept in a separate array so that the batch functions below
+     * can process several transforms per iteration.
+     */
+    struct TransformSoA
+    {
+        dmArray<float> m_PositionX;
+        dmArray<float> m_PositionY;
+        dmArray<float> m_PositionZ;
+        dmArray<float> m_RotationX;
+        dmArray<float> m_RotationY;
+        dmArray<float> m_RotationZ;
+        dmArray<float> m_RotationW;
+        dmArray<float> m_ScaleX;
+        dmArray<float> m_ScaleY;
+        dmArray<float> m_ScaleZ;
+
+        inline uint32_t Size() const
+        {
+            return m_PositionX.Size();
+        }
+
+        void SetSize(uint32_t size);
+
+        inline void Set(uint32_t index, Vector3 translation, Quat rotation, Vector3 scale)
+        {
+            m_PositionX[index] = translation.getX();
+            m_PositionY[index] = translation.getY();
+            m_PositionZ[index] = translation.getZ();
+            m_RotationX[index] = rotation.getX();
+            m_RotationY[index] = rotation.getY();
+            m_RotationZ[index] = rotation.getZ();
+            m_RotationW[index] = rotation.getW();
+            m_ScaleX[index] = scale.getX();
+            m_ScaleY[index] = scale.getY();
+            m_ScaleZ[index] = scale.getZ();
+        }
+
+        inline void Set(uint32_t index, const Transform& t)
+        {
+            Set(index, t.GetTranslation(), t.GetRotation(), t.GetScale());
+        }
+
+        inline Transform Get(uint32_t index) const
+        {
+            return Transform(Vector3(m_PositionX[index], m_PositionY[index], m_PositionZ[index]),
+                             Quat(m_RotationX[index], m_RotationY[index], m_RotationZ[index], m_RotationW[index]),
+                             Vector3(m_ScaleX[index], m_ScaleY[index], m_ScaleZ[index]));
+        }
+    };
+
+    /**
+     * Convert all transforms into 4-dim matrices. Same result as calling ToMatrix4
+     * for each transform, but four transforms are converted per iteration when SIMD is available.
+     * @param transforms Transforms to convert
+     * @param out Array of at least transforms.Size() matrices
+     */
+    void ToMatrix4(const TransformSoA& transforms, Matrix4* out);
+
+    /**
+     * Multiply matrices pairwise, out[i] = (*lhs[i]) * rhs[i].
+     * The left-hand side is given as pointers since it is typically a parent matrix shared by several entries.
+     * @param lhs Array of count pointers to the left-hand matrices
+     * @param rhs Array of count right-hand matrices
+     * @param out Array of count resulting matrices. May alias rhs.
+     * @param count Number of matrices
+     */
+    void Mul(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count);
+
+    /**
+     * Multiply matrices pairwise without z-scaling the translation, out[i] = MulNoScaleZ(*lhs[i], rhs[i]).
+     * @param lhs Array of count pointers to the left-hand matrices
+     * @param rhs Array of count right-hand matrices
+     * @param out Array of count resulting matrices. May alias rhs.
+     * @param count Number of matrices
+     */
+    void MulNoScaleZ(const Matrix4* const* lhs, const Matrix4* rhs, Matrix4* out, uint32_t count);
 }
 
 #endif // DM_TRANSFORM_H
@@ -0,0 +1,186 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include <assert.h>
+#include <string.h>
+#include "worker_pool.h"
+#include "array.h"
+#include "atomic.h"
+#include "condition_variable.h"
+#include "dstrings.h"
+#include "mutex.h"
+#include "thread.h"
+
+namespace dmWorkerPool
+{
+    const uint32_t THREAD_STACK_SIZE = 0x80000;
+    const uint32_t MAX_THREAD_COUNT = 32;
+
+    struct WorkerPool
+    {
+        dmArray<dmThread::Thread>               m_Threads;
+        dmMutex::HMutex                         m_Mutex;
+        // Serializes calls to Run()
+        dmMutex::HMutex                         m_RunMutex;
+        dmConditionVariable::HConditionVariable m_WorkCond;
+        dmConditionVariable::HConditionVariable m_DoneCond;
+
+        // The current batch. Only modified with m_Mutex held, and while no worker is busy
+        TaskFunction                            m_Function;
+        void*                                   m_Context;
+        int32_t                                 m_Count;
+        int32_atomic_t                          m_Next;
+
+        // Incremented for each new batch. Protected by m_Mutex
+        uint32_t                                m_Generation;
+        // Number of workers currently processing tasks. Protected by m_Mutex
+        uint32_t                                m_Busy;
+        bool                                    m_Quit;
+        char                                    m_Name[32];
+    };
+
+    static void ProcessTasks(WorkerPool* pool)
+    {
+        while (true)
+        {
+            int32_t index = dmAtomicIncrement32(&pool->m_Next);
+            if (index >= pool->m_Count)
+                break;
+            pool->m_Function(pool->m_Context, (uint32_t)index);
+        }
+    }
+
+    static void WorkerThread(void* arg)
+    {
+        WorkerPool* pool = (WorkerPool*)arg;
+        uint32_t generation = 0;
+
+        dmMutex::Lock(pool->m_Mutex);
+        while (true)
+        {
+            while (!pool->m_Quit && pool->m_Generation == generation)
+            {
+                dmConditionVariable::Wait(pool->m_WorkCond, pool->m_Mutex);
+            }
+            if (pool->m_Quit)
+                break;
+
+            generation = pool->m_Generation;
+            pool->m_Busy++;
+            dmMutex::Unlock(pool->m_Mutex);
+
+            ProcessTasks(pool);
+
+            dmMutex::Lock(pool->m_Mutex);
+            if (--pool->m_Busy == 0)
+            {
+                dmConditionVariable::Signal(pool->m_DoneCond);
+            }
+        }
+        dmMutex::Unlock(pool->m_Mutex);
+    }
+
+    HWorkerPool New(const char* name, uint32_t thread_count)
+    {
+#if defined(__EMSCRIPTEN__)
+        thread_count = 0;
+#endif
+        if (thread_count > MAX_THREAD_COUNT)
+            thread_count = MAX_THREAD_COUNT;
+
+        WorkerPool* pool = new WorkerPool;
+        pool->m_Mutex = dmMutex::New();
+        pool->m_RunMutex = dmMutex::New();
+        pool->m_WorkCond = dmConditionVariable::New();
+        pool->m_DoneCond = dmConditionVariable::New();
+        pool->m_Function = 0;
+        pool->m_Context = 0;
+        pool->m_Count = 0;
+        pool->m_Next = 0;
+        pool->m_Generation = 0;
+        pool->m_Busy = 0;
+        pool->m_Quit = false;
+        dmStrlCpy(pool->m_Name, name, sizeof(pool->m_Name));
+
+        pool->m_Threads.SetCapacity(thread_count);
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            pool->m_Threads.Push(dmThread::New(&WorkerThread, THREAD_STACK_SIZE, pool, pool->m_Name));
+        }
+        return pool;
+    }
+
+    void Delete(HWorkerPool pool)
+    {
+        if (!pool)
+            return;
+
+        {
+            dmMutex::ScopedLock lk(pool->m_Mutex);
+            pool->m_Quit = true;
+            dmConditionVariable::Broadcast(pool->m_WorkCond);
+        }
+        for (uint32_t i = 0; i < pool->m_Threads.Size(); ++i)
+        {
+            dmThread::Join(pool->m_Threads[i]);
+        }
+        dmConditionVariable::Delete(pool->m_DoneCond);
+        dmConditionVariable::Delete(pool->m_WorkCond);
+        dmMutex::Delete(pool->m_RunMutex);
+        dmMutex::Delete(pool->m_Mutex);
+        delete pool;
+    }
+
+    uint32_t GetThreadCount(HWorkerPool pool)
+    {
+        return pool ? pool->m_Threads.Size() : 0;
+    }
+
+    void Run(HWorkerPool pool, TaskFunction fn, void* context, uint32_t count)
+    {
+        if (pool == 0 || pool->m_Threads.Empty() || count <= 1)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                fn(context, i);
+            }
+            return;
+        }
+
+        dmMutex::ScopedLock run_lk(pool->m_RunMutex);
+
+        dmMutex::Lock(pool->m_Mutex);
+        // A worker that woke up late for the previous batch might still be running (it won't find any tasks)
+        while (pool->m_Busy > 0)
+        {
+            dmConditionVariable::Wait(pool->m_DoneCond, pool->m_Mutex);
+        }
+        pool->m_Function = fn;
+        pool->m_Context = context;
+        pool->m_Count = (int32_t)count;
+        dmAtomicStore32(&pool->m_Next, 0);
+        pool->m_Generation++;
+        dmConditionVariable::Broadcast(pool->m_WorkCond);
+        dmMutex::Unlock(pool->m_Mutex);
+
+        ProcessTasks(pool);
+
+        // All tasks are taken, wait for the ones still being processed
+        dmMutex::Lock(pool->m_Mutex);
+        while (pool->m_Busy > 0)
+        {
+            dmConditionVariable::Wait(pool->m_DoneCond, pool->m_Mutex);
+        }
+        dmMutex::Unlock(pool->m_Mutex);
+    }
+}
@@ -0,0 +1,64 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#ifndef DM_WORKER_POOL_H
+#define DM_WORKER_POOL_H
+
+#include <stdint.h>
+
+namespace dmWorkerPool
+{
+    typedef struct WorkerPool* HWorkerPool;
+
+    /**
+     * Task function. Invoked once for each index in the range passed to Run()
+     * @param context User context
+     * @param index Task index
+     */
+    typedef void (*TaskFunction)(void* context, uint32_t index);
+
+    /**
+     * Create a new worker pool
+     * @note No threads are created on platforms without thread support (web)
+     * @param name Name of the worker threads
+     * @param thread_count Number of worker threads. With zero threads, all tasks are run on the calling thread
+     * @return Worker pool handle
+     */
+    HWorkerPool New(const char* name, uint32_t thread_count);
+
+    /**
+     * Delete worker pool. Waits for the worker threads to exit
+     * @param pool Worker pool handle
+     */
+    void Delete(HWorkerPool pool);
+
+    /**
+     * Get the number of worker threads
+     * @param pool Worker pool handle. May be 0
+     * @return Number of worker threads, not counting the calling thread
+     */
+    uint32_t GetThreadCount(HWorkerPool pool);
+
+    /**
+     * Run the task function for each index in [0, count) and wait for all of them to finish.
+     * The calling thread also processes tasks. The order in which the tasks are run is undefined.
+     * @note The pool runs a single batch at a time. Concurrent calls are serialized.
+     * @param pool Worker pool handle. If 0, all tasks are run on the calling thread
+     * @param fn Task function
+     * @param context User context passed to the task function
+     * @param count Number of tasks
+     */
+    void Run(HWorkerPool pool, TaskFunction fn, void* context, uint32_t count);
+}
+
+#endif // DM_WORKER_POOL_H
@@ -67,6 +67,27 @@ TEST(atomic, CompareStore)
     ASSERT_EQ(123, x);
 }
 
+TEST(atomic, StorePtr)
+{
+    int a, b;
+    void* volatile x = &a;
+    ASSERT_EQ((void*) &a, dmAtomicStorePtr(&x, &b));
+    ASSERT_EQ((void*) &b, dmAtomicStorePtr(&x, 0));
+    ASSERT_EQ((void*) 0, x);
+}
+
+TEST(atomic, CompareStorePtr)
+{
+    int a, b;
+    void* volatile x = &a;
+    // Nop, (&b != &a)
+    ASSERT_EQ((void*) &a, dmAtomicCompareStorePtr(&x, 0, &b));
+    ASSERT_EQ((void*) &a, x);
+    // Return old value but set new (&a == &a)
+    ASSERT_EQ((void*) &a, dmAtomicCompareStorePtr(&x, &b, &a));
+    ASSERT_EQ((void*) &b, x);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
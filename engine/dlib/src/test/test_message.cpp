@@ -355,6 +355,193 @@ TEST(dmMessage, ThreadTest2)
     ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
 }
 
+struct OrderMessage
+{
+    uint32_t m_Producer;
+    uint32_t m_Index;
+};
+
+struct OrderContext
+{
+    dmMessage::URL* m_Receiver;
+    uint32_t        m_Producer;
+    uint32_t        m_Count;
+};
+
+void PostOrderThread(void* arg)
+{
+    OrderContext* ctx = (OrderContext*) arg;
+    for (uint32_t i = 0; i < ctx->m_Count; ++i)
+    {
+        OrderMessage m = { ctx->m_Producer, i };
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, ctx->m_Receiver, m_HashMessage1, 0, 0x0, &m, sizeof(m), 0));
+    }
+}
+
+void HandleOrderMessage(dmMessage::Message *message_object, void *user_ptr)
+{
+    uint32_t* next_index = (uint32_t*) user_ptr;
+    OrderMessage* m = (OrderMessage*) message_object->m_Data;
+    ASSERT_EQ(next_index[m->m_Producer], m->m_Index);
+    next_index[m->m_Producer]++;
+}
+
+// Messages from each producer must be dispatched in the order they were posted
+TEST(dmMessage, ThreadOrder)
+{
+    const uint32_t thread_count = 4;
+    const uint32_t message_count = 1024 * 16;
+
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    OrderContext contexts[thread_count];
+    dmThread::Thread threads[thread_count];
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        contexts[i].m_Receiver = &receiver;
+        contexts[i].m_Producer = i;
+        contexts[i].m_Count = message_count;
+        threads[i] = dmThread::New(&PostOrderThread, 0xf0000, (void*) &contexts[i], "post");
+    }
+
+    uint32_t next_index[thread_count] = { 0 };
+    uint32_t count = 0;
+    while (count < message_count * thread_count)
+    {
+        count += dmMessage::DispatchBlocking(receiver.m_Socket, HandleOrderMessage, next_index);
+    }
+    ASSERT_EQ(message_count * thread_count, count);
+
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+        ASSERT_EQ(message_count, next_index[i]);
+    }
+
+    ASSERT_EQ(0u, dmMessage::Dispatch(receiver.m_Socket, HandleOrderMessage, next_index));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
+// Threads exit before their messages are dispatched, and more threads than producer allocators post at the same time
+TEST(dmMessage, ThreadExit)
+{
+    const uint32_t thread_count = 24;
+    const uint32_t message_count = 1024;
+
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    for (uint32_t round = 0; round < 4; ++round)
+    {
+        OrderContext contexts[thread_count];
+        dmThread::Thread threads[thread_count];
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            contexts[i].m_Receiver = &receiver;
+            contexts[i].m_Producer = i;
+            contexts[i].m_Count = message_count;
+            threads[i] = dmThread::New(&PostOrderThread, 0xf0000, (void*) &contexts[i], "post");
+        }
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            dmThread::Join(threads[i]);
+        }
+
+        uint32_t next_index[thread_count] = { 0 };
+        ASSERT_EQ(message_count * thread_count, dmMessage::Dispatch(receiver.m_Socket, HandleOrderMessage, next_index));
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            ASSERT_EQ(message_count, next_index[i]);
+        }
+    }
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
+struct ThroughputContext
+{
+    dmMessage::URL* m_Receiver;
+    uint32_t        m_Count;
+};
+
+void PostThroughputThread(void* arg)
+{
+    ThroughputContext* ctx = (ThroughputContext*) arg;
+    CustomMessageData1 message_data1;
+    message_data1.m_MyValue = 0;
+    for (uint32_t i = 0; i < ctx->m_Count; ++i)
+    {
+        dmMessage::Post(0x0, ctx->m_Receiver, m_HashMessage1, 0, 0x0, &message_data1, sizeof(CustomMessageData1), 0);
+    }
+}
+
+// Posts from thread_count producers while the main thread dispatches. Returns posts per second
+static double BenchThroughput(dmMessage::URL* receiver, uint32_t thread_count, uint32_t message_count)
+{
+    const uint32_t max_threads = 8;
+    assert(thread_count <= max_threads);
+    ThroughputContext contexts[max_threads];
+    dmThread::Thread threads[max_threads];
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        contexts[i].m_Receiver = receiver;
+        contexts[i].m_Count = message_count;
+        threads[i] = dmThread::New(&PostThroughputThread, 0xf0000, (void*) &contexts[i], "post");
+    }
+
+    uint32_t count = 0;
+    while (count < message_count * thread_count)
+    {
+        count += dmMessage::Dispatch(receiver->m_Socket, HandleMessage, 0);
+    }
+    uint64_t end = dmTime::GetTime();
+
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+    return (message_count * thread_count) / ((end - start) / 1000000.0);
+}
+
+TEST(dmMessage, BenchThroughput)
+{
+    const uint32_t iter_count = 1024 * 64;
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    CustomMessageData1 message_data1;
+    message_data1.m_MyValue = 0;
+
+    // Single threaded, post and dispatch in batches as a frame would
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t iter = 0; iter < iter_count; ++iter)
+    {
+        dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, &message_data1, sizeof(CustomMessageData1), 0);
+        if ((iter & 1023) == 1023)
+        {
+            ASSERT_EQ(1024u, dmMessage::Dispatch(receiver.m_Socket, HandleMessage, 0));
+        }
+    }
+    uint64_t end = dmTime::GetTime();
+    printf("Throughput 1 thread: %.0f posts/s\n", iter_count / ((end - start) / 1000000.0));
+
+    const uint32_t thread_counts[] = { 1, 2, 4, 8 };
+    for (uint32_t i = 0; i < sizeof(thread_counts)/sizeof(thread_counts[0]); ++i)
+    {
+        double posts_per_second = BenchThroughput(&receiver, thread_counts[i], iter_count / thread_counts[i]);
+        printf("Throughput %u producer threads + dispatch: %.0f posts/s\n", thread_counts[i], posts_per_second);
+    }
+
+    ASSERT_EQ(0u, dmMessage::Dispatch(receiver.m_Socket, HandleMessage, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
 void HandleIntegrityMessage(dmMessage::Message *message_object, void *user_ptr)
 {
     dmhash_t hash = dmHashBuffer64(message_object->m_Data, message_object->m_DataSize);
@@ -460,6 +647,52 @@ TEST(dmMessage, MessagePostDispatch)
     ASSERT_EQ(7011, g_PostDistpatchCalled);
 }
 
+static uint32_t g_BatchDestroyCount = 0;
+
+void BatchMessageDestroyCallback(dmMessage::Message* message)
+{
+    g_BatchDestroyCount++;
+}
+
+void HandleBatchMessages(dmMessage::Message* messages, uint32_t message_count, void* user_ptr)
+{
+    // No destroy callbacks are called until the whole batch is handled
+    ASSERT_EQ(0u, g_BatchDestroyCount);
+
+    uint32_t* batch_count = (uint32_t*) user_ptr;
+    (*batch_count)++;
+
+    uint32_t i = 0;
+    for (dmMessage::Message* message = messages; message; message = message->m_Next, ++i)
+    {
+        ASSERT_EQ(i, *(uint32_t*) message->m_Data);
+    }
+    ASSERT_EQ(message_count, i);
+}
+
+TEST(dmMessage, DispatchBatch)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    uint32_t batch_count = 0;
+    ASSERT_EQ(0u, dmMessage::DispatchBatch(receiver.m_Socket, HandleBatchMessages, &batch_count));
+    ASSERT_EQ(0u, batch_count);
+
+    const uint32_t message_count = 1000;
+    g_BatchDestroyCount = 0;
+    for (uint32_t i = 0; i < message_count; ++i)
+    {
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, &i, sizeof(i), BatchMessageDestroyCallback));
+    }
+    ASSERT_EQ(message_count, dmMessage::DispatchBatch(receiver.m_Socket, HandleBatchMessages, &batch_count));
+    ASSERT_EQ(1u, batch_count);
+    ASSERT_EQ(message_count, g_BatchDestroyCount);
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
 
 int main(int argc, char **argv)
 {
@@ -96,6 +96,40 @@ TEST(Thread, Tls)
     dmThread::FreeTls(g_TlsKey);
 }
 
+int32_atomic_t g_TlsDestructorCalls = 0;
+
+static void TlsDestructor(void* value)
+{
+    assert(value == (void*) &g_TlsDestructorCalls);
+    dmAtomicIncrement32(&g_TlsDestructorCalls);
+}
+
+static void TlsDestructorThreadFunction(void* arg)
+{
+    // The destructor is only called for threads with a value
+    if (arg != 0)
+    {
+        dmThread::SetTlsValue(g_TlsKey, (void*) &g_TlsDestructorCalls);
+    }
+}
+
+TEST(Thread, TlsDestructor)
+{
+    g_TlsKey = dmThread::AllocTls(TlsDestructor);
+
+    dmThread::Thread t1 = dmThread::New(&TlsDestructorThreadFunction, 0x80000, (void*) 1, "t1");
+    dmThread::Thread t2 = dmThread::New(&TlsDestructorThreadFunction, 0x80000, (void*) 0, "t2");
+    dmThread::Thread t3 = dmThread::New(&TlsDestructorThreadFunction, 0x80000, (void*) 1, "t3");
+
+    dmThread::Join(t1);
+    dmThread::Join(t2);
+    dmThread::Join(t3);
+
+    ASSERT_EQ(2, g_TlsDestructorCalls);
+
+    dmThread::FreeTls(g_TlsKey);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -10,10 +10,13 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <stdio.h>
+#include <stdlib.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include "dlib/transform.h"
 #include "dlib/math.h"
+#include "dlib/time.h"
 
 using namespace Vectormath::Aos;
 using namespace dmTransform;
@@ -209,9 +212,152 @@ TEST(dmTransform, Inverse)
     ASSERT_TRANSFORM_NEAR(i, Mul(Inv(t0), t0));
 }
 
+static Transform RandomTransform()
+{
+    Vector3 t(rand() / (float)RAND_MAX * 100.0f, rand() / (float)RAND_MAX * 100.0f, rand() / (float)RAND_MAX * 100.0f);
+    Quat r = normalize(Quat(rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f));
+    Vector3 s(0.5f + rand() / (float)RAND_MAX, 0.5f + rand() / (float)RAND_MAX, 0.5f + rand() / (float)RAND_MAX);
+    return Transform(t, r, s);
+}
+
+#define ASSERT_M4_NEAR(expected, actual)\
+    ASSERT_V4_NEAR(expected.getCol0(), actual.getCol0());\
+    ASSERT_V4_NEAR(expected.getCol1(), actual.getCol1());\
+    ASSERT_V4_NEAR(expected.getCol2(), actual.getCol2());\
+    ASSERT_V4_NEAR(expected.getCol3(), actual.getCol3());
+
+TEST(dmTransform, SoA)
+{
+    TransformSoA soa;
+    soa.SetSize(3);
+    ASSERT_EQ(3U, soa.Size());
+    Transform t0(Vector3(1.0f, 2.0f, 3.0f), Quat::rotationZ((float) M_PI_2), Vector3(2.0f, 3.0f, 4.0f));
+    soa.Set(1, t0);
+    ASSERT_TRANSFORM_NEAR(t0, soa.Get(1));
+}
+
+TEST(dmTransform, BatchToMatrix4)
+{
+    // Odd size to exercise the remainder path
+    const uint32_t count = 23;
+    TransformSoA soa;
+    soa.SetSize(count);
+    Transform transforms[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        transforms[i] = RandomTransform();
+        soa.Set(i, transforms[i]);
+    }
+
+    Matrix4 out[count];
+    ToMatrix4(soa, out);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Matrix4 expected = ToMatrix4(transforms[i]);
+        ASSERT_M4_NEAR(expected, out[i]);
+    }
+}
+
+TEST(dmTransform, BatchMul)
+{
+    const uint32_t count = 13;
+    Matrix4 parents[2] = { ToMatrix4(RandomTransform()), ToMatrix4(RandomTransform()) };
+    parents[1].setCol2(parents[1].getCol2() * 3.0f);
+    const Matrix4* lhs[count];
+    Matrix4 rhs[count];
+    Matrix4 out[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        lhs[i] = &parents[i & 1];
+        rhs[i] = ToMatrix4(RandomTransform());
+    }
+
+    Mul(lhs, rhs, out, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Matrix4 expected = *lhs[i] * rhs[i];
+        ASSERT_M4_NEAR(expected, out[i]);
+    }
+
+    MulNoScaleZ(lhs, rhs, out, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Matrix4 expected = MulNoScaleZ(*lhs[i], rhs[i]);
+        ASSERT_M4_NEAR(expected, out[i]);
+    }
+
+    // In place
+    MulNoScaleZ(lhs, rhs, rhs, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_M4_NEAR(out[i], rhs[i]);
+    }
+}
+
+// Compares the per-instance scalar path (ToMatrix4 + MulNoScaleZ per transform) with the batch functions
+TEST(dmTransform, BatchPerformance)
+{
+    const uint32_t counts[] = { 10000, 50000, 100000 };
+    const uint32_t iterations = 10;
+    Matrix4 parent = ToMatrix4(RandomTransform());
+
+    for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        uint32_t count = counts[c];
+        dmArray<Transform> transforms;
+        transforms.SetCapacity(count);
+        transforms.SetSize(count);
+        TransformSoA soa;
+        soa.SetSize(count);
+        dmArray<const Matrix4*> lhs;
+        lhs.SetCapacity(count);
+        lhs.SetSize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            transforms[i] = RandomTransform();
+            soa.Set(i, transforms[i]);
+            lhs[i] = &parent;
+        }
+
+        dmArray<Matrix4> scalar_out;
+        scalar_out.SetCapacity(count);
+        scalar_out.SetSize(count);
+        dmArray<Matrix4> batch_out;
+        batch_out.SetCapacity(count);
+        batch_out.SetSize(count);
+
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t it = 0; it < iterations; ++it)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                scalar_out[i] = MulNoScaleZ(parent, ToMatrix4(transforms[i]));
+            }
+        }
+        uint64_t scalar_time = dmTime::GetTime() - start;
+
+        start = dmTime::GetTime();
+        for (uint32_t it = 0; it < iterations; ++it)
+        {
+            ToMatrix4(soa, batch_out.Begin());
+            MulNoScaleZ(lhs.Begin(), batch_out.Begin(), batch_out.Begin(), count);
+        }
+        uint64_t batch_time = dmTime::GetTime() - start;
+
+        printf("%6u transforms: scalar %6.3f ms, batch %6.3f ms\n", count,
+                scalar_time / (1000.0f * iterations), batch_time / (1000.0f * iterations));
+
+        for (uint32_t i = 0; i < count; i += 997)
+        {
+            ASSERT_M4_NEAR(scalar_out[i], batch_out[i]);
+        }
+    }
+}
+
 #undef EPSILON
 #undef ASSERT_V3_NEAR
 #undef ASSERT_V4_NEAR
+#undef ASSERT_M4_NEAR
 #undef ASSERT_TRANSFORMS1_NEAR
 #undef ASSERT_TRANSFORM_NEAR
 
@@ -0,0 +1,90 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include <stdint.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "../dlib/array.h"
+#include "../dlib/atomic.h"
+#include "../dlib/worker_pool.h"
+
+struct TaskContext
+{
+    dmArray<int32_atomic_t> m_Visits;
+    int32_atomic_t          m_Sum;
+};
+
+static void CountTask(void* context, uint32_t index)
+{
+    TaskContext* ctx = (TaskContext*)context;
+    dmAtomicIncrement32(&ctx->m_Visits[index]);
+    dmAtomicAdd32(&ctx->m_Sum, (int32_t)index);
+}
+
+static void RunAndVerify(dmWorkerPool::HWorkerPool pool, uint32_t count)
+{
+    TaskContext ctx;
+    ctx.m_Visits.SetCapacity(count);
+    ctx.m_Visits.SetSize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        ctx.m_Visits[i] = 0;
+    ctx.m_Sum = 0;
+
+    dmWorkerPool::Run(pool, CountTask, &ctx, count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(1, ctx.m_Visits[i]);
+    }
+    ASSERT_EQ((int32_t)((count * (count - 1)) / 2), ctx.m_Sum);
+}
+
+TEST(dmWorkerPool, NoPool)
+{
+    ASSERT_EQ(0U, dmWorkerPool::GetThreadCount(0));
+    RunAndVerify(0, 0);
+    RunAndVerify(0, 1);
+    RunAndVerify(0, 100);
+}
+
+TEST(dmWorkerPool, NoThreads)
+{
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New("test", 0);
+    ASSERT_EQ(0U, dmWorkerPool::GetThreadCount(pool));
+    RunAndVerify(pool, 100);
+    dmWorkerPool::Delete(pool);
+}
+
+TEST(dmWorkerPool, Threads)
+{
+    const uint32_t thread_counts[] = { 1, 2, 4, 8 };
+    for (uint32_t t = 0; t < sizeof(thread_counts)/sizeof(thread_counts[0]); ++t)
+    {
+        dmWorkerPool::HWorkerPool pool = dmWorkerPool::New("test", thread_counts[t]);
+        ASSERT_EQ(thread_counts[t], dmWorkerPool::GetThreadCount(pool));
+
+        // Many small batches in a row, to exercise the hand over between batches
+        for (uint32_t i = 0; i < 200; ++i)
+        {
+            RunAndVerify(pool, i % 17);
+        }
+        RunAndVerify(pool, 10000);
+        dmWorkerPool::Delete(pool);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -200,6 +200,7 @@ namespace dmEngine
     : m_Config(0)
     , m_Alive(true)
     , m_MainCollection(0)
+    , m_WorkerPool(0)
     , m_LastReloadMTime(0)
     , m_MouseSensitivity(1.0f)
     , m_GraphicsContext(0)
@@ -280,6 +281,8 @@ namespace dmEngine
 
         dmGameObject::DeleteRegister(engine->m_Register);
 
+        dmWorkerPool::Delete(engine->m_WorkerPool);
+
         UnloadBootstrapContent(engine);
 
         dmSound::Finalize();
@@ -684,6 +687,7 @@ namespace dmEngine
         int32_t http_cache = dmConfigFile::GetInt(engine->m_Config, "resource.http_cache", 1);
         params.m_MaxResources = max_resources;
         params.m_Flags = 0;
+        params.m_LoadThreadCount = dmConfigFile::GetInt(engine->m_Config, "resource.load_threads", 1);
         if (dLib::IsDebugMode())
         {
             params.m_Flags = RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT;
@@ -784,6 +788,9 @@ namespace dmEngine
             ++deviceIndex;
         }
 
+        engine->m_WorkerPool = dmWorkerPool::New("dmworker", dmConfigFile::GetInt(engine->m_Config, "engine.worker_thread_count", 0));
+        dmGameObject::SetWorkerPool(engine->m_Register, engine->m_WorkerPool);
+
         dmGameObject::Result go_result = dmGameObject::SetCollectionDefaultCapacity(engine->m_Register, dmConfigFile::GetInt(engine->m_Config, dmGameObject::COLLECTION_MAX_INSTANCES_KEY, dmGameObject::DEFAULT_MAX_COLLECTION_CAPACITY));
         if(go_result != dmGameObject::RESULT_OK)
         {
@@ -811,6 +818,7 @@ namespace dmEngine
         engine->m_ParticleFXContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ParticleFXContext.m_MaxParticleFXCount = dmConfigFile::GetInt(engine->m_Config, dmParticle::MAX_INSTANCE_COUNT_KEY, 64);
         engine->m_ParticleFXContext.m_MaxParticleCount = dmConfigFile::GetInt(engine->m_Config, dmParticle::MAX_PARTICLE_COUNT_KEY, 1024);
+        engine->m_ParticleFXContext.m_WorkerPool = engine->m_WorkerPool;
         engine->m_ParticleFXContext.m_Debug = false;
 
         dmInput::NewContextParams input_params;
@@ -910,10 +918,13 @@ namespace dmEngine
         engine->m_SpriteContext.m_RenderContext = engine->m_RenderContext;
         engine->m_SpriteContext.m_MaxSpriteCount = dmConfigFile::GetInt(engine->m_Config, "sprite.max_count", 128);
         engine->m_SpriteContext.m_Subpixels = dmConfigFile::GetInt(engine->m_Config, "sprite.subpixels", 1);
+        engine->m_SpriteContext.m_PersistentVertexBuffer = dmConfigFile::GetInt(engine->m_Config, "sprite.persistent_vertex_buffer", 0);
+        engine->m_SpriteContext.m_WorkerPool = engine->m_WorkerPool;
 
         engine->m_ModelContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ModelContext.m_Factory = engine->m_Factory;
         engine->m_ModelContext.m_MaxModelCount = max_model_count;
+        engine->m_ModelContext.m_WorkerPool = engine->m_WorkerPool;
 
         engine->m_MeshContext.m_RenderContext = engine->m_RenderContext;
         engine->m_MeshContext.m_Factory       = engine->m_Factory;
@@ -922,6 +933,7 @@ namespace dmEngine
         engine->m_SpineModelContext.m_RenderContext = engine->m_RenderContext;
         engine->m_SpineModelContext.m_Factory = engine->m_Factory;
         engine->m_SpineModelContext.m_MaxSpineModelCount = max_spine_count;
+        engine->m_SpineModelContext.m_WorkerPool = engine->m_WorkerPool;
 
         engine->m_LabelContext.m_RenderContext      = engine->m_RenderContext;
         engine->m_LabelContext.m_MaxLabelCount      = dmConfigFile::GetInt(engine->m_Config, "label.max_count", 64);
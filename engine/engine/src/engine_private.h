@@ -18,6 +18,7 @@
 #include <dlib/configfile.h>
 #include <dlib/hashtable.h>
 #include <dlib/message.h>
+#include <dlib/worker_pool.h>
 
 #include <resource/resource.h>
 
@@ -114,6 +115,8 @@ namespace dmEngine
 
         dmGameObject::HRegister                     m_Register;
         dmGameObject::HCollection                   m_MainCollection;
+        /// Worker threads shared by the engine systems, see "engine.worker_thread_count"
+        dmWorkerPool::HWorkerPool                   m_WorkerPool;
         dmArray<dmGameObject::InputAction>          m_InputBuffer;
 
         uint32_t                                    m_LastReloadMTime;
@@ -594,6 +594,7 @@ namespace dmEngineService
         r = dmWebServer::Send(request, &resource.m_Size, 4); CHECK_RESULT_BOOL(r);
         r = dmWebServer::Send(request, &resource.m_SizeOnDisc, 4); CHECK_RESULT_BOOL(r);
         r = dmWebServer::Send(request, &resource.m_RefCount, 4); CHECK_RESULT_BOOL(r);
+        r = dmWebServer::Send(request, &resource.m_SizeMapped, 4); CHECK_RESULT_BOOL(r);
         return true;
     }
 
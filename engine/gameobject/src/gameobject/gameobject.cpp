@@ -158,6 +158,7 @@ namespace dmGameObject
     {
         m_ComponentTypeCount = 0;
         m_DefaultCollectionCapacity = DEFAULT_MAX_COLLECTION_CAPACITY;
+        m_WorkerPool = 0;
         m_Mutex = dmMutex::New();
         m_SocketToCollection.SetCapacity(15, 17);
     }
@@ -192,6 +193,10 @@ namespace dmGameObject
         m_InstanceIndices.SetCapacity(max_instances);
         m_WorldTransforms.SetCapacity(max_instances);
         m_WorldTransforms.SetSize(max_instances);
+        m_PrevLocalTransforms.SetCapacity(max_instances);
+        m_PrevLocalTransforms.SetSize(max_instances);
+        m_WorldTransformChanged.SetCapacity(max_instances);
+        m_WorldTransformChanged.SetSize(max_instances);
         m_IDToInstance.SetCapacity(dmMath::Max(1U, max_instances/3), max_instances);
         // TODO: Un-hard-code
         m_InputFocusStack.SetCapacity(16);
@@ -209,6 +214,7 @@ namespace dmGameObject
         m_ScaleAlongZ = 0;
         m_DirtyTransforms = 1;
         m_Initialized = 0;
+        m_DispatchingMessages = 0;
 
         m_InstancesToDeleteHead = INVALID_INSTANCE_INDEX;
         m_InstancesToDeleteTail = INVALID_INSTANCE_INDEX;
@@ -218,6 +224,9 @@ namespace dmGameObject
 
         memset(&m_Instances[0], 0, sizeof(Instance*) * max_instances);
         memset(&m_WorldTransforms[0], 0xcc, sizeof(dmTransform::Transform) * max_instances);
+        // All bits set is a NaN, which never matches a local transform
+        memset(&m_PrevLocalTransforms[0], 0xff, sizeof(dmTransform::Transform) * max_instances);
+        memset(&m_WorldTransformChanged[0], 1, sizeof(uint8_t) * max_instances);
         memset(&m_LevelIndices[0], 0, sizeof(m_LevelIndices));
         memset(&m_ComponentInstanceCount[0], 0, sizeof(uint32_t) * MAX_COMPONENT_TYPES);
     }
@@ -231,6 +240,12 @@ namespace dmGameObject
         return RESULT_OK;
     }
 
+    void SetWorkerPool(HRegister regist, dmWorkerPool::HWorkerPool pool)
+    {
+        assert(regist != 0x0);
+        regist->m_WorkerPool = pool;
+    }
+
     uint32_t GetCollectionDefaultCapacity(HRegister regist)
     {
         assert(regist != 0x0);
@@ -526,6 +541,17 @@ namespace dmGameObject
         return RESULT_OK;
     }
 
+    Result SetOnMessagesFunction(HRegister regist, dmResource::ResourceType resource_type, ComponentOnMessages on_messages_func)
+    {
+        ComponentType* type = FindComponentType(regist, resource_type, 0x0);
+        if (type == 0x0)
+        {
+            return RESULT_RESOURCE_TYPE_NOT_FOUND;
+        }
+        type->m_OnMessagesFunction = on_messages_func;
+        return RESULT_OK;
+    }
+
     void SortComponentTypes(HRegister regist)
     {
         std::sort(regist->m_ComponentTypesOrder, regist->m_ComponentTypesOrder + regist->m_ComponentTypeCount, ComponentTypeSortPred(regist));
@@ -588,6 +614,13 @@ namespace dmGameObject
         level.OffsetCapacity(offset);
     }
 
+    // Forces the world transform of the instance (and its children) to be recalculated in the next UpdateTransforms
+    static inline void InvalidateWorldTransform(Collection* collection, uint16_t index)
+    {
+        // All bits set is a NaN, which never matches a local transform
+        memset(&collection->m_PrevLocalTransforms[index], 0xff, sizeof(dmTransform::Transform));
+    }
+
     static void InsertInstanceInLevelIndex(Collection* collection, HInstance instance)
     {
         /*
@@ -602,6 +635,9 @@ namespace dmGameObject
         level.SetSize(level_index + 1);
         level[level_index] = instance->m_Index;
         instance->m_LevelIndex = level_index;
+
+        // New instance or new parent
+        InvalidateWorldTransform(collection, instance->m_Index);
     }
 
     static HInstance AllocInstance(Prototype* proto, const char* prototype_name) {
@@ -2039,12 +2075,8 @@ namespace dmGameObject
         bool m_Success;
     };
 
-    void DispatchMessagesFunction(dmMessage::Message* message, void* user_ptr)
+    static Instance* FindReceiverInstance(Collection* collection, dmMessage::Message* message)
     {
-        DispatchMessagesContext* context = (DispatchMessagesContext*) user_ptr;
-        Collection* collection = context->m_Collection;
-
-        Instance* instance = 0x0;
         // Start by looking for the instance in the user-data,
         // which is the case when an instance sends to itself.
         if (message->m_UserData != 0
@@ -2054,28 +2086,25 @@ namespace dmGameObject
             Instance* user_data_instance = (Instance*)message->m_UserData;
             if (message->m_Receiver.m_Path == user_data_instance->m_Identifier)
             {
-                instance = user_data_instance;
+                return user_data_instance;
             }
         }
-        if (instance == 0x0)
-        {
-            instance = GetInstanceFromIdentifier(context->m_Collection, message->m_Receiver.m_Path);
-        }
-        if (instance == 0x0)
-        {
-            const dmMessage::URL* sender = &message->m_Sender;
-            const char* socket_name = dmMessage::GetSocketName(sender->m_Socket);
-            const char* path_name = dmHashReverseSafe64(sender->m_Path);
-            const char* fragment_name = dmHashReverseSafe64(sender->m_Fragment);
+        return GetInstanceFromIdentifier(collection, message->m_Receiver.m_Path);
+    }
 
-            dmLogError("Instance '%s' could not be found when dispatching message '%s' sent from %s:%s#%s",
-                        dmHashReverseSafe64(message->m_Receiver.m_Path),
-                        dmHashReverseSafe64(message->m_Id),
-                        socket_name, path_name, fragment_name);
+    static bool IsGameObjectMessage(dmMessage::Message* message)
+    {
+        dmDDF::Descriptor* descriptor = (dmDDF::Descriptor*)message->m_Descriptor;
+        return descriptor != 0
+            && (descriptor == dmGameObjectDDF::AcquireInputFocus::m_DDFDescriptor
+             || descriptor == dmGameObjectDDF::ReleaseInputFocus::m_DDFDescriptor
+             || descriptor == dmGameObjectDDF::RequestTransform::m_DDFDescriptor
+             || descriptor == dmGameObjectDDF::SetParent::m_DDFDescriptor);
+    }
 
-            context->m_Success = false;
-            return;
-        }
+    // Handles the messages addressed to the game object itself, see IsGameObjectMessage
+    static void DispatchGameObjectMessage(Collection* collection, Instance* instance, dmMessage::Message* message)
+    {
         if (message->m_Descriptor != 0)
         {
             dmDDF::Descriptor* descriptor = (dmDDF::Descriptor*)message->m_Descriptor;
@@ -2119,7 +2148,7 @@ namespace dmGameObject
                 dmGameObject::HInstance parent = 0;
                 if (sp->m_ParentId != 0)
                 {
-                    parent = dmGameObject::GetInstanceFromIdentifier(context->m_Collection, sp->m_ParentId);
+                    parent = dmGameObject::GetInstanceFromIdentifier(collection, sp->m_ParentId);
                     if (parent == 0)
                         dmLogWarning("Could not find parent instance with id '%s'.", dmHashReverseSafe64(sp->m_ParentId));
 
@@ -2142,6 +2171,7 @@ namespace dmGameObject
                     {
                         world = dmTransform::MulNoScaleZ(parent_t, dmTransform::ToMatrix4(instance->m_Transform));
                     }
+                    InvalidateWorldTransform(collection, instance->m_Index);
                 }
                 else
                 {
@@ -2166,24 +2196,74 @@ namespace dmGameObject
                 return;
             }
         }
+    }
+
+    static void DeliverComponentMessages(DispatchMessagesContext* context, Instance* instance, Prototype::Component* component, uintptr_t* component_instance_data, dmMessage::Message** messages, uint32_t message_count)
+    {
+        Collection* collection = context->m_Collection;
+        ComponentType* component_type = component->m_Type;
+        if (component_type->m_OnMessagesFunction)
+        {
+            DM_PROFILE(GameObject, "OnMessageFunction");
+            ComponentOnMessagesParams params;
+            params.m_Instance = instance;
+            params.m_World = collection->m_ComponentWorlds[component->m_TypeIndex];
+            params.m_Context = component_type->m_Context;
+            params.m_UserData = component_instance_data;
+            params.m_Messages = messages;
+            params.m_MessageCount = message_count;
+            UpdateResult res = component_type->m_OnMessagesFunction(params);
+            if (res != UPDATE_RESULT_OK)
+                context->m_Success = false;
+            return;
+        }
+
+        for (uint32_t i = 0; i < message_count; ++i)
+        {
+            DM_PROFILE(GameObject, "OnMessageFunction");
+            ComponentOnMessageParams params;
+            params.m_Instance = instance;
+            params.m_World = collection->m_ComponentWorlds[component->m_TypeIndex];
+            params.m_Context = component_type->m_Context;
+            params.m_UserData = component_instance_data;
+            params.m_Message = messages[i];
+            UpdateResult res = component_type->m_OnMessageFunction(params);
+            if (res != UPDATE_RESULT_OK)
+                context->m_Success = false;
+        }
+    }
+
+    // Dispatches messages with the same receiver to the addressed component, or to all components of the instance
+    static void DispatchComponentMessages(DispatchMessagesContext* context, Instance* instance, dmMessage::Message** messages, uint32_t message_count)
+    {
+        if (message_count == 0)
+        {
+            return;
+        }
+
         Prototype* prototype = instance->m_Prototype;
+        dmhash_t fragment = messages[0]->m_Receiver.m_Fragment;
 
-        if (message->m_Receiver.m_Fragment != 0)
+        if (fragment != 0)
         {
             uint16_t component_index;
-            Result result = GetComponentIndex(instance, message->m_Receiver.m_Fragment, &component_index);
+            Result result = GetComponentIndex(instance, fragment, &component_index);
             if (result != RESULT_OK)
             {
-                const dmMessage::URL* sender = &message->m_Sender;
-                const char* socket_name = dmMessage::GetSocketName(sender->m_Socket);
-                const char* path_name = dmHashReverseSafe64(sender->m_Path);
-                const char* fragment_name = dmHashReverseSafe64(sender->m_Fragment);
-
-                dmLogError("Component '%s#%s' could not be found when dispatching message '%s' sent from %s:%s#%s",
-                            dmHashReverseSafe64(message->m_Receiver.m_Path),
-                            dmHashReverseSafe64(message->m_Receiver.m_Fragment),
-                            dmHashReverseSafe64(message->m_Id),
-                            socket_name, path_name, fragment_name);
+                for (uint32_t i = 0; i < message_count; ++i)
+                {
+                    dmMessage::Message* message = messages[i];
+                    const dmMessage::URL* sender = &message->m_Sender;
+                    const char* socket_name = dmMessage::GetSocketName(sender->m_Socket);
+                    const char* path_name = dmHashReverseSafe64(sender->m_Path);
+                    const char* fragment_name = dmHashReverseSafe64(sender->m_Fragment);
+
+                    dmLogError("Component '%s#%s' could not be found when dispatching message '%s' sent from %s:%s#%s",
+                                dmHashReverseSafe64(message->m_Receiver.m_Path),
+                                dmHashReverseSafe64(message->m_Receiver.m_Fragment),
+                                dmHashReverseSafe64(message->m_Id),
+                                socket_name, path_name, fragment_name);
+                }
                 context->m_Success = false;
                 return;
             }
@@ -2191,7 +2271,7 @@ namespace dmGameObject
             ComponentType* component_type = component->m_Type;
             assert(component_type);
 
-            if (component_type->m_OnMessageFunction)
+            if (component_type->m_OnMessageFunction || component_type->m_OnMessagesFunction)
             {
                 // TODO: Not optimal way to find index of component instance data
                 uint32_t next_component_instance_data = 0;
@@ -2210,18 +2290,7 @@ namespace dmGameObject
                 {
                     component_instance_data = &instance->m_ComponentInstanceUserData[next_component_instance_data];
                 }
-                {
-                    DM_PROFILE(GameObject, "OnMessageFunction");
-                    ComponentOnMessageParams params;
-                    params.m_Instance = instance;
-                    params.m_World = collection->m_ComponentWorlds[component->m_TypeIndex];
-                    params.m_Context = component_type->m_Context;
-                    params.m_UserData = component_instance_data;
-                    params.m_Message = message;
-                    UpdateResult res = component_type->m_OnMessageFunction(params);
-                    if (res != UPDATE_RESULT_OK)
-                        context->m_Success = false;
-                }
+                DeliverComponentMessages(context, instance, component, component_instance_data, messages, message_count);
             }
             else
             {
@@ -2238,37 +2307,106 @@ namespace dmGameObject
                 ComponentType* component_type = component->m_Type;
                 assert(component_type);
 
-                if (component_type->m_OnMessageFunction)
+                uintptr_t* component_instance_data = 0;
+                if (component_type->m_InstanceHasUserData)
                 {
-                    uintptr_t* component_instance_data = 0;
-                    if (component_type->m_InstanceHasUserData)
-                    {
-                        component_instance_data = &instance->m_ComponentInstanceUserData[next_component_instance_data++];
-                    }
-                    {
-                        DM_PROFILE(GameObject, "OnMessageFunction");
-                        ComponentOnMessageParams params;
-                        params.m_Instance = instance;
-                        params.m_World = collection->m_ComponentWorlds[component->m_TypeIndex];
-                        params.m_Context = component_type->m_Context;
-                        params.m_UserData = component_instance_data;
-                        params.m_Message = message;
-                        UpdateResult res = component_type->m_OnMessageFunction(params);
-                        if (res != UPDATE_RESULT_OK)
-                            context->m_Success = false;
-                    }
+                    component_instance_data = &instance->m_ComponentInstanceUserData[next_component_instance_data++];
                 }
-                else
+                if (component_type->m_OnMessageFunction || component_type->m_OnMessagesFunction)
                 {
-                    if (component_type->m_InstanceHasUserData)
-                    {
-                        ++next_component_instance_data;
-                    }
+                    DeliverComponentMessages(context, instance, component, component_instance_data, messages, message_count);
                 }
             }
         }
     }
 
+    // Dispatches all messages to the same receiver, the instance is only looked up once for the group
+    static void DispatchMessageGroup(DispatchMessagesContext* context, dmMessage::Message** messages, uint32_t message_count)
+    {
+        Collection* collection = context->m_Collection;
+
+        Instance* instance = FindReceiverInstance(collection, messages[0]);
+        if (instance == 0x0)
+        {
+            for (uint32_t i = 0; i < message_count; ++i)
+            {
+                dmMessage::Message* message = messages[i];
+                const dmMessage::URL* sender = &message->m_Sender;
+                const char* socket_name = dmMessage::GetSocketName(sender->m_Socket);
+                const char* path_name = dmHashReverseSafe64(sender->m_Path);
+                const char* fragment_name = dmHashReverseSafe64(sender->m_Fragment);
+
+                dmLogError("Instance '%s' could not be found when dispatching message '%s' sent from %s:%s#%s",
+                            dmHashReverseSafe64(message->m_Receiver.m_Path),
+                            dmHashReverseSafe64(message->m_Id),
+                            socket_name, path_name, fragment_name);
+            }
+            context->m_Success = false;
+            return;
+        }
+
+        // Messages handled by the game object itself split the group into runs, to keep the order of the messages
+        uint32_t run_start = 0;
+        for (uint32_t i = 0; i < message_count; ++i)
+        {
+            dmMessage::Message* message = messages[i];
+            if (IsGameObjectMessage(message))
+            {
+                DispatchComponentMessages(context, instance, &messages[run_start], i - run_start);
+                DispatchGameObjectMessage(collection, instance, message);
+                run_start = i + 1;
+            }
+        }
+        DispatchComponentMessages(context, instance, &messages[run_start], message_count - run_start);
+    }
+
+    void DispatchMessagesFunction(dmMessage::Message* messages, uint32_t message_count, void* user_ptr)
+    {
+        DispatchMessagesContext* context = (DispatchMessagesContext*) user_ptr;
+        Collection* collection = context->m_Collection;
+
+        // The scratch buffer belongs to the outermost dispatch, in case messages are dispatched recursively
+        dmArray<dmMessage::Message*> local_messages;
+        bool use_scratch = !collection->m_DispatchingMessages;
+        dmArray<dmMessage::Message*>& ordered_messages = use_scratch ? collection->m_DispatchMessages : local_messages;
+        collection->m_DispatchingMessages = 1;
+
+        if (ordered_messages.Capacity() < message_count)
+        {
+            ordered_messages.SetCapacity(message_count);
+        }
+        ordered_messages.SetSize(message_count);
+
+        uint32_t index = 0;
+        for (dmMessage::Message* message = messages; message; message = message->m_Next, ++index)
+        {
+            ordered_messages[index] = message;
+        }
+
+        // Only consecutive messages to the same receiver are grouped, so messages are always delivered in post order
+        uint32_t group_count = 0;
+        uint32_t group_start = 0;
+        for (uint32_t i = 1; i <= message_count; ++i)
+        {
+            if (i == message_count ||
+                ordered_messages[i]->m_Receiver.m_Path != ordered_messages[group_start]->m_Receiver.m_Path ||
+                ordered_messages[i]->m_Receiver.m_Fragment != ordered_messages[group_start]->m_Receiver.m_Fragment)
+            {
+                DispatchMessageGroup(context, &ordered_messages[group_start], i - group_start);
+                group_start = i;
+                ++group_count;
+            }
+        }
+
+        if (use_scratch)
+        {
+            collection->m_DispatchingMessages = 0;
+        }
+
+        DM_COUNTER("DispatchedMessages", message_count);
+        DM_COUNTER("DispatchedMessageGroups", group_count);
+    }
+
     static bool DispatchMessages(Collection* collection, dmMessage::HSocket* sockets, uint32_t socket_count)
     {
         DM_PROFILE(GameObject, "DispatchMessages");
@@ -2292,7 +2430,7 @@ namespace dmGameObject
                 {
                     UpdateTransforms(collection);
                 }
-                uint32_t message_count = dmMessage::Dispatch(sockets[i], &DispatchMessagesFunction, (void*) &ctx);
+                uint32_t message_count = dmMessage::DispatchBatch(sockets[i], &DispatchMessagesFunction, (void*) &ctx);
                 if (message_count)
                 {
                     collection->m_DirtyTransforms = true;
@@ -2322,63 +2460,103 @@ namespace dmGameObject
         }
     }
 
-    void UpdateTransforms(Collection* collection)
+    // Number of instances per parallel task. Levels with less than two chunks are updated on the calling thread
+    static const uint32_t TRANSFORM_CHUNK_SIZE = 256;
+
+    static inline bool TransformEquals(const dmTransform::Transform& a, const dmTransform::Transform& b)
     {
-        DM_PROFILE(GameObject, "UpdateTransforms");
+        const uint32_t* ra = (const uint32_t*)a.GetRotationPtr();
+        const uint32_t* rb = (const uint32_t*)b.GetRotationPtr();
+        return ra[0] == rb[0] && ra[1] == rb[1] && ra[2] == rb[2] && ra[3] == rb[3] &&
+               Vec3Equals((const uint32_t*)a.GetPositionPtr(), (const uint32_t*)b.GetPositionPtr()) &&
+               Vec3Equals((const uint32_t*)a.GetScalePtr(), (const uint32_t*)b.GetScalePtr());
+    }
+
+    // Only reads the world transform of the parent (previous level), so the instances within a level can be updated in any order
+    static inline void UpdateTransform(Collection* collection, uint16_t index)
+    {
+        Instance* instance = collection->m_Instances[index];
+        CheckEuler(instance);
+
+        uint16_t parent_index = instance->m_Parent;
+        bool parent_changed = parent_index != INVALID_INSTANCE_INDEX && collection->m_WorldTransformChanged[parent_index];
 
-        // Calculate world transforms
-        // First root-level instances
-        dmArray<uint16_t>& root_level = collection->m_LevelIndices[0];
-        uint32_t root_count = root_level.Size();
-        for (uint32_t i = 0; i < root_count; ++i)
+        dmTransform::Transform& prev = collection->m_PrevLocalTransforms[index];
+        if (!parent_changed && TransformEquals(prev, instance->m_Transform))
         {
-            uint16_t index = root_level[i];
-            Instance* instance = collection->m_Instances[index];
-            CheckEuler(instance);
-            collection->m_WorldTransforms[index] = dmTransform::ToMatrix4(instance->m_Transform);
-            uint16_t parent_index = instance->m_Parent;
-            assert(parent_index == INVALID_INSTANCE_INDEX);
+            collection->m_WorldTransformChanged[index] = 0;
+            return;
         }
+        prev = instance->m_Transform;
+        collection->m_WorldTransformChanged[index] = 1;
 
+        Matrix4* trans = &collection->m_WorldTransforms[index];
+        Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
+        if (parent_index == INVALID_INSTANCE_INDEX)
+        {
+            *trans = own;
+            return;
+        }
 
-        if (collection->m_ScaleAlongZ) {
-            for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
-            {
-                dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-                uint32_t instance_count = level.Size();
-                for (uint32_t i = 0; i < instance_count; ++i)
-                {
-                    uint16_t index = level[i];
-                    Instance* instance = collection->m_Instances[index];
-                    CheckEuler(instance);
-                    Matrix4* trans = &collection->m_WorldTransforms[index];
+        Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
+        if (collection->m_ScaleAlongZ)
+        {
+            *trans = *parent_trans * own;
+        }
+        else
+        {
+            *trans = dmTransform::MulNoScaleZ(*parent_trans, own);
+        }
+    }
 
-                    uint16_t parent_index = instance->m_Parent;
-                    assert(parent_index != INVALID_INSTANCE_INDEX);
+    struct UpdateTransformsContext
+    {
+        Collection*     m_Collection;
+        const uint16_t* m_Indices;
+        uint32_t        m_Count;
+    };
 
-                    Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
-                    Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
-                    *trans = *parent_trans * own;
-                }
+    static void UpdateTransformsChunk(void* _ctx, uint32_t chunk)
+    {
+        UpdateTransformsContext* ctx = (UpdateTransformsContext*)_ctx;
+        uint32_t start = chunk * TRANSFORM_CHUNK_SIZE;
+        uint32_t end = dmMath::Min(start + TRANSFORM_CHUNK_SIZE, ctx->m_Count);
+        for (uint32_t i = start; i < end; ++i)
+        {
+            UpdateTransform(ctx->m_Collection, ctx->m_Indices[i]);
+        }
+    }
+
+    void UpdateTransforms(Collection* collection)
+    {
+        DM_PROFILE(GameObject, "UpdateTransforms");
+
+        dmWorkerPool::HWorkerPool pool = collection->m_Register->m_WorkerPool;
+        bool parallel = dmWorkerPool::GetThreadCount(pool) > 0;
+
+        // Calculate world transforms, level by level, starting with the root-level instances.
+        // The parent of an instance is always in the previous level.
+        for (uint32_t level_i = 0; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+        {
+            dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
+            uint32_t instance_count = level.Size();
+            if (instance_count == 0)
+                continue;
+
+            if (parallel && instance_count >= 2 * TRANSFORM_CHUNK_SIZE)
+            {
+                UpdateTransformsContext ctx;
+                ctx.m_Collection = collection;
+                ctx.m_Indices = level.Begin();
+                ctx.m_Count = instance_count;
+                uint32_t chunk_count = (instance_count + TRANSFORM_CHUNK_SIZE - 1) / TRANSFORM_CHUNK_SIZE;
+                dmWorkerPool::Run(pool, UpdateTransformsChunk, &ctx, chunk_count);
             }
-        } else {
-            for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+            else
             {
-                dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-                uint32_t instance_count = level.Size();
                 for (uint32_t i = 0; i < instance_count; ++i)
                 {
-                    uint16_t index = level[i];
-                    Instance* instance = collection->m_Instances[index];
-                    CheckEuler(instance);
-                    Matrix4* trans = &collection->m_WorldTransforms[index];
-
-                    uint16_t parent_index = instance->m_Parent;
-                    assert(parent_index != INVALID_INSTANCE_INDEX);
-
-                    Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
-                    Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
-                    *trans = dmTransform::MulNoScaleZ(*parent_trans, own);
+                    UpdateTransform(collection, level[i]);
                 }
             }
         }
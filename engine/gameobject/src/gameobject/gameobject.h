@@ -21,6 +21,7 @@
 #include <dlib/hashtable.h>
 #include <dlib/message.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include <ddf/ddf.h>
 
@@ -546,6 +547,33 @@ namespace dmGameObject
      */
     typedef UpdateResult (*ComponentOnMessage)(const ComponentOnMessageParams& params);
 
+    /**
+     * Parameters to ComponentOnMessages callback.
+     */
+    struct ComponentOnMessagesParams
+    {
+        /// Instance handle
+        HInstance m_Instance;
+        /// World
+        void* m_World;
+        /// User context
+        void* m_Context;
+        /// User data storage pointer
+        uintptr_t* m_UserData;
+        /// Messages to the component, in the order they were posted
+        dmMessage::Message** m_Messages;
+        /// Number of messages
+        uint32_t m_MessageCount;
+    };
+
+    /**
+     * Component on-messages function. Called with all pending messages sent to the same component,
+     * instead of calling the on-message function for each message.
+     * @param params Input parameters
+     * @return UPDATE_RESULT_OK on success
+     */
+    typedef UpdateResult (*ComponentOnMessages)(const ComponentOnMessagesParams& params);
+
     /**
      * Parameters to ComponentOnInput callback.
      */
@@ -677,6 +705,7 @@ namespace dmGameObject
         ComponentsRender        m_RenderFunction;
         ComponentsPostUpdate    m_PostUpdateFunction;
         ComponentOnMessage      m_OnMessageFunction;
+        ComponentOnMessages     m_OnMessagesFunction;
         ComponentOnInput        m_OnInputFunction;
         ComponentOnReload       m_OnReloadFunction;
         ComponentSetProperties  m_SetPropertiesFunction;
@@ -709,6 +738,14 @@ namespace dmGameObject
      */
     Result SetCollectionDefaultCapacity(HRegister regist, uint32_t capacity);
 
+    /**
+     * Set the worker pool used to update the transforms of large hierarchy levels in parallel.
+     * The pool must outlive the register.
+     * @param regist Register
+     * @param pool Worker pool, or 0x0 to update all transforms on the calling thread
+     */
+    void SetWorkerPool(HRegister regist, dmWorkerPool::HWorkerPool pool);
+
     /**
      * Get default capacity of collections in this register.
      * @param regist Register
@@ -772,6 +809,16 @@ namespace dmGameObject
      */
     Result SetUpdateOrderPrio(HRegister regist, dmResource::ResourceType resource_type, uint16_t prio);
 
+    /**
+     * Set the function receiving all pending messages to a component at once. Takes precedence
+     * over the on-message function of the component type.
+     * @param regist Register
+     * @param resource_type Resource type
+     * @param on_messages_func On-messages function
+     * @return RESULT_OK on success
+     */
+    Result SetOnMessagesFunction(HRegister regist, dmResource::ResourceType resource_type, ComponentOnMessages on_messages_func);
+
     /**
      * Sort component types according to update order priority.
      * @param regist Register
@@ -19,6 +19,7 @@
 #include <dlib/math.h>
 #include <dlib/mutex.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include "gameobject.h"
 #include "gameobject_props.h"
@@ -213,6 +214,9 @@ namespace dmGameObject
 
         dmHashTable64<Collection*>  m_SocketToCollection;
 
+        // Used for updating large transform hierarchy levels in parallel. Not owned by the register
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
+
         Register();
         ~Register();
     };
@@ -263,12 +267,21 @@ namespace dmGameObject
         // Array of world transforms. Calculated using m_LevelIndices above
         dmArray<Matrix4>         m_WorldTransforms;
 
+        // The local transforms used when the world transforms were last calculated.
+        // Instances whose local transform and parent are unchanged keep their world transform.
+        dmArray<dmTransform::Transform> m_PrevLocalTransforms;
+        // Set if the world transform was recalculated in the last UpdateTransforms, read by the children
+        dmArray<uint8_t>         m_WorldTransformChanged;
+
         // Identifier to Instance mapping
         dmHashTable64<Instance*> m_IDToInstance;
 
         // Stack keeping track of which instance has the input focus
         dmArray<Instance*>       m_InputFocusStack;
 
+        // Scratch buffer used to group messages by receiver when dispatching
+        dmArray<dmMessage::Message*> m_DispatchMessages;
+
         // Name-hash of the collection.
         dmhash_t                 m_NameHash;
 
@@ -302,6 +315,8 @@ namespace dmGameObject
         uint32_t                 m_ScaleAlongZ : 1;
         uint32_t                 m_DirtyTransforms : 1;
         uint32_t                 m_Initialized : 1;
+        // Set while the scratch buffers for message dispatch are in use
+        uint32_t                 m_DispatchingMessages : 1;
     };
 
     struct CollectionHandle
@@ -20,6 +20,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/time.h>
 #include <dlib/log.h>
+#include <dlib/worker_pool.h>
 #include <resource/resource.h>
 #include "../gameobject.h"
 #include "../gameobject_private.h"
@@ -888,6 +889,76 @@ TEST_F(HierarchyTest, TestEmptyInstance)
     dmGameObject::Delete(m_Collection, go, false);
 }
 
+TEST_F(HierarchyTest, TestHierarchyWorkerPool)
+{
+    // Large enough levels to be split into chunks and updated on the worker threads
+    const uint32_t count = 1000;
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New("transforms", 4);
+    dmGameObject::SetWorkerPool(m_Register, pool);
+
+    dmGameObject::HCollection collection = dmGameObject::NewCollection("large_collection", m_Factory, m_Register, 2 * count);
+
+    dmArray<dmGameObject::HInstance> parents;
+    dmArray<dmGameObject::HInstance> children;
+    parents.SetCapacity(count);
+    children.SetCapacity(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmGameObject::HInstance parent = dmGameObject::New(collection, 0x0);
+        dmGameObject::HInstance child = dmGameObject::New(collection, 0x0);
+        ASSERT_NE((void*)0, parent);
+        ASSERT_NE((void*)0, child);
+        dmGameObject::SetPosition(parent, Point3((float)i, 0, 0));
+        dmGameObject::SetRotation(parent, Quat::rotationZ(0.01f * i));
+        dmGameObject::SetPosition(child, Point3(0, 1, 0));
+        ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(child, parent));
+        parents.Push(parent);
+        children.Push(child);
+    }
+
+    ASSERT_TRUE(dmGameObject::Update(collection, &m_UpdateContext));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Matrix4 parent_m = Matrix4::rotationZ(0.01f * i);
+        parent_m.setCol3(Vector4((float)i, 0, 0, 1));
+        Point3 expected_child_pos = Point3((parent_m * Point3(0, 1, 0)).getXYZ());
+        ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(parents[i]) - Point3((float)i, 0, 0)), EPSILON);
+        ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(children[i]) - expected_child_pos), 0.001f);
+    }
+
+    // Only move every other parent, the children of the unchanged parents keep their world transform
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        dmGameObject::SetRotation(parents[i], Quat::identity());
+        dmGameObject::SetPosition(parents[i], Point3((float)i, 10, 0));
+    }
+
+    ASSERT_TRUE(dmGameObject::Update(collection, &m_UpdateContext));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Matrix4 parent_m = Matrix4::rotationZ(0.01f * i);
+        parent_m.setCol3(Vector4((float)i, 0, 0, 1));
+        Point3 expected_child_pos = Point3((parent_m * Point3(0, 1, 0)).getXYZ());
+        if (i % 2 == 0)
+        {
+            expected_child_pos = Point3((float)i, 11, 0);
+        }
+        ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(children[i]) - expected_child_pos), 0.001f);
+    }
+
+    // Reparenting must recalculate the world transform even if the local transform is unchanged
+    dmGameObject::SetParent(children[1], parents[0]);
+    ASSERT_TRUE(dmGameObject::Update(collection, &m_UpdateContext));
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(children[1]) - Point3(0, 11, 0)), 0.001f);
+
+    dmGameObject::DeleteCollection(collection);
+    dmGameObject::PostUpdate(m_Register);
+    dmGameObject::SetWorkerPool(m_Register, 0);
+    dmWorkerPool::Delete(pool);
+}
+
 #undef EPSILON
 
 int main(int argc, char **argv)
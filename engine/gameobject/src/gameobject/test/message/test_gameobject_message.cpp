@@ -16,6 +16,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 #include <dlib/hash.h>
 #include <dlib/message.h>
@@ -93,6 +94,7 @@ protected:
     static dmGameObject::CreateResult CompMessageTargetCreate(const dmGameObject::ComponentCreateParams& params);
     static dmGameObject::CreateResult CompMessageTargetDestroy(const dmGameObject::ComponentDestroyParams& params);
     static dmGameObject::UpdateResult CompMessageTargetOnMessage(const dmGameObject::ComponentOnMessageParams& params);
+    static dmGameObject::UpdateResult CompMessageTargetOnMessages(const dmGameObject::ComponentOnMessagesParams& params);
 
 public:
     dmGameObject::UpdateContext m_UpdateContext;
@@ -105,6 +107,10 @@ public:
     std::map<uint32_t, uint32_t> m_MessageMap;
 
     uint32_t m_MessageTargetCounter;
+    // Number of messages in each call to CompMessageTargetOnMessages
+    std::vector<uint32_t> m_MessageTargetGroups;
+    // Receiver of each message delivered to CompMessageTargetOnMessages, in delivery order
+    std::vector<dmhash_t> m_MessageTargetReceivers;
     dmGameObject::ModuleContext m_ModuleContext;
 };
 
@@ -184,6 +190,29 @@ dmGameObject::UpdateResult MessageTest::CompMessageTargetOnMessage(const dmGameO
     return dmGameObject::UPDATE_RESULT_OK;
 }
 
+dmGameObject::UpdateResult MessageTest::CompMessageTargetOnMessages(const dmGameObject::ComponentOnMessagesParams& params)
+{
+    MessageTest* self = (MessageTest*) params.m_Context;
+    self->m_MessageTargetGroups.push_back(params.m_MessageCount);
+
+    dmGameObject::ComponentOnMessageParams message_params;
+    message_params.m_Instance = params.m_Instance;
+    message_params.m_World = params.m_World;
+    message_params.m_Context = params.m_Context;
+    message_params.m_UserData = params.m_UserData;
+    for (uint32_t i = 0; i < params.m_MessageCount; ++i)
+    {
+        // All messages in the group are sent to this component
+        assert(params.m_Messages[i]->m_Receiver.m_Path == dmGameObject::GetIdentifier(params.m_Instance));
+        self->m_MessageTargetReceivers.push_back(params.m_Messages[i]->m_Receiver.m_Path);
+        message_params.m_Message = params.m_Messages[i];
+        dmGameObject::UpdateResult result = CompMessageTargetOnMessage(message_params);
+        if (result != dmGameObject::UPDATE_RESULT_OK)
+            return result;
+    }
+    return dmGameObject::UPDATE_RESULT_OK;
+}
+
 void DispatchCallback(dmMessage::Message *message, void* user_ptr)
 {
     MessageTest* test = (MessageTest*)user_ptr;
@@ -268,6 +297,67 @@ TEST_F(MessageTest, TestComponentMessage)
     dmGameObject::Delete(m_Collection, go, false);
 }
 
+TEST_F(MessageTest, TestComponentMessageGroups)
+{
+    dmResource::ResourceType resource_type;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetTypeFromExtension(m_Factory, "mt", &resource_type));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetOnMessagesFunction(m_Register, resource_type, CompMessageTargetOnMessages));
+
+    dmGameObject::HInstance go_a = dmGameObject::New(m_Collection, "/component_message.goc");
+    ASSERT_NE((void*) 0, (void*) go_a);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go_a, "test_instance_a"));
+    dmGameObject::HInstance go_b = dmGameObject::New(m_Collection, "/component_message.goc");
+    ASSERT_NE((void*) 0, (void*) go_b);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go_b, "test_instance_b"));
+
+    dmMessage::URL receiver_a;
+    receiver_a.m_Socket = dmGameObject::GetMessageSocket(m_Collection);
+    receiver_a.m_Path = dmGameObject::GetIdentifier(go_a);
+    receiver_a.m_Fragment = dmHashString64("mt");
+    dmMessage::URL receiver_b = receiver_a;
+    receiver_b.m_Path = dmGameObject::GetIdentifier(go_b);
+    dmMessage::URL sender_a = receiver_a;
+    sender_a.m_Fragment = dmHashString64("script");
+    dmMessage::URL sender_b = receiver_b;
+    sender_b.m_Fragment = dmHashString64("script");
+
+    // Consecutive messages to the same component are delivered in one call
+    dmhash_t inc_id = dmHashString64("inc");
+    dmhash_t dec_id = dmHashString64("dec");
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_a, &receiver_a, inc_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_a, &receiver_a, inc_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_b, &receiver_b, dec_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_b, &receiver_b, dec_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_a, &receiver_a, inc_id, 0, 0, 0x0, 0, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    ASSERT_EQ(1U, m_MessageTargetCounter);
+    ASSERT_EQ(3U, m_MessageTargetGroups.size());
+    ASSERT_EQ(2U, m_MessageTargetGroups[0]);
+    ASSERT_EQ(2U, m_MessageTargetGroups[1]);
+    ASSERT_EQ(1U, m_MessageTargetGroups[2]);
+
+    // Interleaved messages are never reordered across receivers
+    m_MessageTargetGroups.clear();
+    m_MessageTargetReceivers.clear();
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_b, &receiver_b, dec_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_a, &receiver_a, inc_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_b, &receiver_b, dec_id, 0, 0, 0x0, 0, 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&sender_a, &receiver_a, inc_id, 0, 0, 0x0, 0, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    ASSERT_EQ(1U, m_MessageTargetCounter);
+    ASSERT_EQ(4U, m_MessageTargetGroups.size());
+    ASSERT_EQ(4U, m_MessageTargetReceivers.size());
+    ASSERT_EQ(receiver_b.m_Path, m_MessageTargetReceivers[0]);
+    ASSERT_EQ(receiver_a.m_Path, m_MessageTargetReceivers[1]);
+    ASSERT_EQ(receiver_b.m_Path, m_MessageTargetReceivers[2]);
+    ASSERT_EQ(receiver_a.m_Path, m_MessageTargetReceivers[3]);
+
+    dmGameObject::Delete(m_Collection, go_a, false);
+    dmGameObject::Delete(m_Collection, go_b, false);
+}
+
 TEST_F(MessageTest, TestComponentMessageFail)
 {
     dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/component_message.goc");
@@ -566,6 +566,7 @@ namespace dmGameSystem
         gui_component->m_Instance = params.m_Instance;
         gui_component->m_Material = 0;
         gui_component->m_ComponentIndex = params.m_ComponentIndex;
+        gui_component->m_UsedCachedVertexCount = 0;
         gui_component->m_Enabled = 1;
         gui_component->m_AddedToUpdate = 0;
 
@@ -786,6 +787,119 @@ namespace dmGameSystem
         return (dmGraphics::HTexture) result;
     }
 
+    // Drops all cached node vertices when most of the cached vertices belong to nodes that were
+    // deleted, changed size or were not rendered the last time the scene was rendered
+    static void BeginNodeVertexCache(GuiComponent* component)
+    {
+        if (component->m_CachedVertices.Size() > 2 * component->m_UsedCachedVertexCount + 4096)
+        {
+            component->m_CachedVertices.SetSize(0);
+            if (!component->m_NodeVertexCache.Empty())
+            {
+                memset(component->m_NodeVertexCache.Begin(), 0, component->m_NodeVertexCache.Size() * sizeof(GuiNodeVertexCache));
+            }
+        }
+        component->m_UsedCachedVertexCount = 0;
+    }
+
+    static inline void SetNodeVertexKey(float* out, const Vector4& v)
+    {
+        out[0] = v.getX();
+        out[1] = v.getY();
+        out[2] = v.getZ();
+        out[3] = v.getW();
+    }
+
+    static void SetNodeVertexKey(GuiNodeVertexKey& key, const Matrix4& transform, const Vector4& color, const Vector4& shape, const Vector4& size)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            SetNodeVertexKey(key.m_Transform + c * 4, transform.getCol(c));
+        }
+        SetNodeVertexKey(key.m_Color, color);
+        SetNodeVertexKey(key.m_Shape, shape);
+        SetNodeVertexKey(key.m_Size, size);
+    }
+
+    // Returns the cached vertices of the node if they were generated from the same state
+    static GuiNodeVertexCache* GetNodeVertexCache(GuiComponent* component, dmGui::HScene scene, dmGui::HNode node, const GuiNodeVertexKey& key, bool* hit)
+    {
+        dmArray<GuiNodeVertexCache>& cache = component->m_NodeVertexCache;
+        uint32_t index = dmGui::GetNodeIndex(scene, node);
+        if (index >= cache.Size())
+        {
+            uint32_t size = cache.Size();
+            if (index >= cache.Capacity())
+            {
+                cache.SetCapacity(dmMath::Max(index + 1, cache.Capacity() * 2));
+            }
+            cache.SetSize(index + 1);
+            memset(&cache[size], 0, (index + 1 - size) * sizeof(GuiNodeVertexCache));
+        }
+        GuiNodeVertexCache* entry = &cache[index];
+        *hit = entry->m_VertexCapacity > 0 && memcmp(&entry->m_Key, &key, sizeof(key)) == 0;
+        if (*hit)
+        {
+            component->m_UsedCachedVertexCount += entry->m_VertexCapacity;
+        }
+        return entry;
+    }
+
+    // Stores the vertices generated for the node, reusing the vertices reserved for the node when they fit
+    static void StoreNodeVertexCache(GuiComponent* component, GuiNodeVertexCache* entry, const GuiNodeVertexKey& key, const BoxVertex* vertices, uint32_t vertex_count)
+    {
+        dmArray<BoxVertex>& cached_vertices = component->m_CachedVertices;
+        if (entry->m_VertexCapacity < vertex_count)
+        {
+            if (cached_vertices.Remaining() < vertex_count)
+            {
+                cached_vertices.OffsetCapacity(dmMath::Max(vertex_count, cached_vertices.Capacity() / 2));
+            }
+            entry->m_VertexStart = cached_vertices.Size();
+            entry->m_VertexCapacity = vertex_count;
+            cached_vertices.SetSize(cached_vertices.Size() + vertex_count);
+        }
+        if (vertex_count > 0)
+        {
+            memcpy(&cached_vertices[entry->m_VertexStart], vertices, vertex_count * sizeof(BoxVertex));
+        }
+        entry->m_VertexCount = vertex_count;
+        entry->m_Key = key;
+        component->m_UsedCachedVertexCount += entry->m_VertexCapacity;
+    }
+
+    // Copies a run of cached vertices, from consecutive nodes, to the client vertex buffer
+    static void FlushNodeVertexCache(GuiWorld* gui_world, GuiComponent* component, uint32_t* run_start, uint32_t* run_count)
+    {
+        uint32_t count = *run_count;
+        if (count == 0)
+            return;
+
+        dmArray<BoxVertex>& vertex_buffer = gui_world->m_ClientVertexBuffer;
+        if (vertex_buffer.Remaining() < count)
+        {
+            vertex_buffer.OffsetCapacity(dmMath::Max(128U, count));
+        }
+        uint32_t size = vertex_buffer.Size();
+        vertex_buffer.SetSize(size + count);
+        memcpy(&vertex_buffer[size], &component->m_CachedVertices[*run_start], count * sizeof(BoxVertex));
+        *run_count = 0;
+    }
+
+    // Adds the cached vertices of the node to the run of cached vertices to copy, flushing the run when not contiguous
+    static void AppendNodeVertexCache(GuiWorld* gui_world, GuiComponent* component, const GuiNodeVertexCache* entry, uint32_t* run_start, uint32_t* run_count)
+    {
+        if (*run_count > 0 && *run_start + *run_count != entry->m_VertexStart)
+        {
+            FlushNodeVertexCache(gui_world, component, run_start, run_count);
+        }
+        if (*run_count == 0)
+        {
+            *run_start = entry->m_VertexStart;
+        }
+        *run_count += entry->m_VertexCount;
+    }
+
     void RenderTextNodes(dmGui::HScene scene,
                          const dmGui::RenderEntry* entries,
                          const Matrix4* node_transforms,
@@ -1114,6 +1228,11 @@ namespace dmGameSystem
         float org_height = (float)dmGraphics::GetOriginalTextureHeight(ro.m_Textures[0]);
         assert(org_width > 0 && org_height > 0);
 
+        GuiComponent* component = (GuiComponent*)dmGui::GetSceneUserData(scene);
+        uint32_t cached_start = 0;
+        uint32_t cached_count = 0;
+        uint32_t generated_count = 0;
+
         int rendered_vert_count = 0;
         for (uint32_t i = 0; i < node_count; ++i)
         {
@@ -1137,13 +1256,42 @@ namespace dmGameSystem
             bool use_geometries = texture_set_ddf && texture_set_ddf->m_Geometries.m_Count > 0;
 
             // we skip sprite trimming on slice 9 nodes
+            const dmGameSystemDDF::SpriteGeometry* geometry = 0;
             if (!use_slice_nine && use_geometries)
             {
                 int32_t frame_index = dmGui::GetNodeAnimationFrame(scene, node);
                 frame_index = texture_set_ddf->m_FrameIndices[frame_index];
+                geometry = &texture_set_ddf->m_Geometries.m_Data[frame_index];
+            }
 
-                const dmGameSystemDDF::SpriteGeometry* geometry = &texture_set_ddf->m_Geometries.m_Data[frame_index];
+            bool flip_u, flip_v;
+            GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
+            const float* tc = dmGui::GetNodeFlipbookAnimUV(scene, node);
 
+            GuiNodeVertexKey key;
+            memset(&key, 0, sizeof(key));
+            SetNodeVertexKey(key, node_transforms[i], pm_color, slice9, Vector4(size.getX(), size.getY(), org_width, org_height));
+            key.m_TexCoords = tc;
+            key.m_Geometry = geometry;
+            key.m_Flags = (flip_u ? 1 : 0) | (flip_v ? 2 : 0);
+            key.m_NodeType = dmGui::NODE_TYPE_BOX;
+
+            // Unchanged nodes copy the vertices from the last time they were rendered
+            bool hit;
+            GuiNodeVertexCache* cache = GetNodeVertexCache(component, scene, node, key, &hit);
+            if (hit)
+            {
+                AppendNodeVertexCache(gui_world, component, cache, &cached_start, &cached_count);
+                rendered_vert_count += cache->m_VertexCount;
+                continue;
+            }
+
+            FlushNodeVertexCache(gui_world, component, &cached_start, &cached_count);
+            const uint32_t vertex_start = gui_world->m_ClientVertexBuffer.Size();
+            ++generated_count;
+
+            if (geometry)
+            {
                 const Matrix4& w = node_transforms[i];
 
                 // NOTE: The original rendering code is from the comp_sprite.cpp.
@@ -1156,9 +1304,6 @@ namespace dmGameSystem
                 // Depending on the sprite is flipped or not, we loop the vertices forward or backward
                 // to respect face winding (and backface culling)
 
-                bool flip_u, flip_v;
-                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
-
                 int reverse = (int)flip_u ^ (int)flip_v;
 
                 float scaleX = flip_u ? -1 : 1;
@@ -1183,6 +1328,7 @@ namespace dmGameSystem
                 }
 
                 rendered_vert_count += index_count;
+                StoreNodeVertexCache(component, cache, key, gui_world->m_ClientVertexBuffer.Begin() + vertex_start, index_count);
                 continue;
             }
 
@@ -1214,13 +1360,10 @@ namespace dmGameSystem
             xs[0] = ys[0] = 0;
             xs[3] = ys[3] = 1;
             bool uv_rotated;
-            const float* tc = dmGui::GetNodeFlipbookAnimUV(scene, node);
             if(tc)
             {
                 static const uint32_t uvIndex[2][4] = {{0,1,2,3}, {3,2,1,0}};
                 uv_rotated = tc[0] != tc[2] && tc[3] != tc[5];
-                bool flip_u, flip_v;
-                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
                 if(uv_rotated)
                 {
                     const uint32_t *uI = flip_v ? uvIndex[1] : uvIndex[0];
@@ -1315,7 +1458,11 @@ namespace dmGameSystem
                     gui_world->m_ClientVertexBuffer.Push(v01);
                 }
             }
+            StoreNodeVertexCache(component, cache, key, gui_world->m_ClientVertexBuffer.Begin() + vertex_start, verts_per_node);
         }
+        FlushNodeVertexCache(gui_world, component, &cached_start, &cached_count);
+        DM_COUNTER("Gui.GeneratedNodes", generated_count);
+
         ro.m_VertexCount = rendered_vert_count;
     }
 
@@ -1390,6 +1537,11 @@ namespace dmGameSystem
             gui_world->m_ClientVertexBuffer.OffsetCapacity(dmMath::Max(128U, max_total_vertices));
         }
 
+        GuiComponent* component = (GuiComponent*)dmGui::GetSceneUserData(scene);
+        uint32_t cached_start = 0;
+        uint32_t cached_count = 0;
+        uint32_t generated_count = 0;
+
         for (uint32_t i = 0; i < node_count; ++i)
         {
             const dmGui::HNode node = entries[i].m_Node;
@@ -1404,13 +1556,37 @@ namespace dmGameSystem
             Vector4 pm_color(color.getXYZ(), node_opacities[i]);
 
             const uint32_t perimeterVertices = dmMath::Max<uint32_t>(4, dmGui::GetNodePerimeterVertices(scene, node));
-            const float innerMultiplier = dmGui::GetNodeInnerRadius(scene, node) / size.getX();
+            const float innerRadius = dmGui::GetNodeInnerRadius(scene, node);
+            const float innerMultiplier = innerRadius / size.getX();
             const dmGui::PieBounds outerBounds = dmGui::GetNodeOuterBounds(scene, node);
+            float stopAngle = dmGui::GetNodePieFillAngle(scene, node);
+
+            bool flip_u, flip_v;
+            GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
+            const float* tc = dmGui::GetNodeFlipbookAnimUV(scene, node);
+
+            GuiNodeVertexKey key;
+            memset(&key, 0, sizeof(key));
+            SetNodeVertexKey(key, node_transforms[i], pm_color, Vector4(innerRadius, stopAngle, (float)perimeterVertices, (float)outerBounds), Vector4(size.getX(), size.getY(), 0.0f, 0.0f));
+            key.m_TexCoords = tc;
+            key.m_Flags = (flip_u ? 1 : 0) | (flip_v ? 2 : 0);
+            key.m_NodeType = dmGui::NODE_TYPE_PIE;
+
+            // Unchanged nodes copy the vertices from the last time they were rendered
+            bool hit;
+            GuiNodeVertexCache* cache = GetNodeVertexCache(component, scene, node, key, &hit);
+            if (hit)
+            {
+                AppendNodeVertexCache(gui_world, component, cache, &cached_start, &cached_count);
+                continue;
+            }
+
+            FlushNodeVertexCache(gui_world, component, &cached_start, &cached_count);
+            ++generated_count;
 
             const float PI = 3.1415926535f;
             const float ad = PI * 2.0f / (float)perimeterVertices;
 
-            float stopAngle = dmGui::GetNodePieFillAngle(scene, node);
             bool backwards = false;
             if (stopAngle < 0)
             {
@@ -1433,11 +1609,8 @@ namespace dmGameSystem
 
             float u0,su,v0,sv;
             bool uv_rotated;
-            const float* tc = dmGui::GetNodeFlipbookAnimUV(scene, node);
             if(tc)
             {
-                bool flip_u, flip_v;
-                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
                 uv_rotated = tc[0] != tc[2] && tc[3] != tc[5];
                 if(uv_rotated ? flip_v : flip_u)
                 {
@@ -1529,7 +1702,10 @@ namespace dmGameSystem
             }
 
             assert((gui_world->m_ClientVertexBuffer.Size() - sizeBefore) <= ComputeRequiredVertices(dmGui::GetNodePerimeterVertices(scene, entries[i].m_Node)));
+            StoreNodeVertexCache(component, cache, key, gui_world->m_ClientVertexBuffer.Begin() + sizeBefore, gui_world->m_ClientVertexBuffer.Size() - sizeBefore);
         }
+        FlushNodeVertexCache(gui_world, component, &cached_start, &cached_count);
+        DM_COUNTER("Gui.GeneratedNodes", generated_count);
 
         ro.m_VertexCount = gui_world->m_ClientVertexBuffer.Size() - ro.m_VertexStart;
     }
@@ -1549,6 +1725,7 @@ namespace dmGameSystem
         GuiWorld* gui_world = gui_context->m_GuiWorld;
 
         gui_world->m_RenderedParticlesSize = 0;
+        BeginNodeVertexCache((GuiComponent*)dmGui::GetSceneUserData(scene));
         gui_context->m_FirstStencil = true;
 
         dmGui::HNode first_node = entries[0].m_Node;
@@ -1760,6 +1937,7 @@ namespace dmGameSystem
         out_data->m_Skeleton = rig_res->m_SkeletonRes->m_Skeleton;
         out_data->m_MeshSet = rig_res->m_MeshSetRes->m_MeshSet;
         out_data->m_AnimationSet = rig_res->m_AnimationSetRes->m_AnimationSet;
+        out_data->m_CompressedAnimationSet = rig_res->m_AnimationSetRes->m_CompressedAnimationSet;
         out_data->m_Texture = rig_res->m_TextureSet->m_Texture;
         out_data->m_TextureSet = rig_res->m_TextureSet;
         out_data->m_PoseIdxToInfluence = &rig_res->m_PoseIdxToInfluence;
@@ -1774,6 +1952,11 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    void* CompGuiGetComponent(const dmGameObject::ComponentGetParams& params)
+    {
+        return (GuiComponent*)*params.m_UserData;
+    }
+
     dmGameObject::UpdateResult CompGuiUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
     {
         GuiWorld* gui_world = (GuiWorld*)params.m_World;
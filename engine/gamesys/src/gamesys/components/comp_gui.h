@@ -26,17 +26,6 @@ namespace dmGameSystem
 
     struct GuiSceneResource;
 
-    struct GuiComponent
-    {
-        GuiSceneResource*       m_Resource;
-        dmGui::HScene           m_Scene;
-        dmGameObject::HInstance m_Instance;
-        dmRender::HMaterial     m_Material;
-        uint16_t                m_ComponentIndex;
-        uint8_t                 m_Enabled : 1;
-        uint8_t                 m_AddedToUpdate : 1;
-    };
-
     struct BoxVertex
     {
         inline BoxVertex() {}
@@ -73,6 +62,53 @@ namespace dmGameSystem
         float m_Color[4];
     };
 
+    /**
+     * State a box or pie node's vertices are generated from. Compared bitwise, any change
+     * (transform, color, size, slice-9, texture, flipbook frame or pie shape) means the
+     * vertices must be generated again.
+     */
+    struct GuiNodeVertexKey
+    {
+        float       m_Transform[16];
+        float       m_Color[4];
+        /// Slice-9 for box nodes, inner radius, fill angle, perimeter vertices and bounds for pie nodes
+        float       m_Shape[4];
+        /// Node size and original texture size
+        float       m_Size[4];
+        const void* m_TexCoords;
+        const void* m_Geometry;
+        uint32_t    m_Flags;
+        uint32_t    m_NodeType;
+    };
+
+    /**
+     * Vertices of a node from the last time it was rendered, stored in the cached vertices of the component
+     */
+    struct GuiNodeVertexCache
+    {
+        GuiNodeVertexKey m_Key;
+        uint32_t         m_VertexStart;
+        uint32_t         m_VertexCount;
+        /// Number of vertices reserved for the node, 0 if nothing is cached
+        uint32_t         m_VertexCapacity;
+    };
+
+    struct GuiComponent
+    {
+        GuiSceneResource*       m_Resource;
+        dmGui::HScene           m_Scene;
+        dmGameObject::HInstance m_Instance;
+        dmRender::HMaterial     m_Material;
+        /// Per node vertex cache, indexed by node index
+        dmArray<GuiNodeVertexCache> m_NodeVertexCache;
+        dmArray<BoxVertex>      m_CachedVertices;
+        /// Number of cached vertices used when the scene was last rendered
+        uint32_t                m_UsedCachedVertexCount;
+        uint16_t                m_ComponentIndex;
+        uint8_t                 m_Enabled : 1;
+        uint8_t                 m_AddedToUpdate : 1;
+    };
+
     struct GuiRenderObject
     {
         dmRender::RenderObject m_RenderObject;
@@ -112,6 +148,8 @@ namespace dmGameSystem
 
     dmGameObject::CreateResult CompGuiAddToUpdate(const dmGameObject::ComponentAddToUpdateParams& params);
 
+    void* CompGuiGetComponent(const dmGameObject::ComponentGetParams& params);
+
     dmGameObject::UpdateResult CompGuiUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result);
 
     dmGameObject::UpdateResult CompGuiRender(const dmGameObject::ComponentsRenderParams& params);
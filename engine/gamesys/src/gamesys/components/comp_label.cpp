@@ -52,6 +52,8 @@ namespace dmGameSystem
         Vector4                     m_Outline;
         Vector4                     m_Shadow;
         Matrix4                     m_World;
+        // Radius of the text in text space, used for frustum culling. Negative when it needs to be recalculated
+        float                       m_TextRadius;
         uint32_t                    m_Pivot;
         // Hash of the components properties. Hash is used to be compatible with 64-bit arch as a 32-bit value is used for sorting
         // See GenerateKeys
@@ -228,6 +230,7 @@ namespace dmGameSystem
         component->m_ComponentIndex = params.m_ComponentIndex;
         component->m_Enabled = 1;
         component->m_Text = ddf->m_Text;
+        component->m_TextRadius = -1.0f;
         component->m_UserAllocatedText = 0;
         component->m_ReHash = 1;
 
@@ -394,6 +397,26 @@ namespace dmGameSystem
         }
     }
 
+    // Radius of the sphere around the label position that contains the text, used for frustum culling
+    static float GetBoundingRadius(LabelComponent* component)
+    {
+        if (component->m_TextRadius < 0.0f)
+        {
+            dmGameSystemDDF::LabelDesc* ddf = component->m_Resource->m_DDF;
+            dmRender::TextMetrics metrics;
+            dmRender::GetTextMetrics(GetFontMap(component, component->m_Resource), component->m_Text, component->m_Size.getX(),
+                                        ddf->m_LineBreak, ddf->m_Leading, ddf->m_Tracking, &metrics);
+            // The text is aligned within the text area, a line height of margin covers the glyph padding, outline and shadow
+            float line_height = metrics.m_MaxAscent + metrics.m_MaxDescent;
+            float width = component->m_Size.getX() + metrics.m_Width + line_height;
+            float height = component->m_Size.getY() + metrics.m_Height + 2.0f * line_height;
+            component->m_TextRadius = sqrtf(width * width + height * height);
+        }
+        const Matrix4& w = component->m_World;
+        float scale = dmMath::Max(length(w.getCol(0).getXYZ()), length(w.getCol(1).getXYZ()));
+        return component->m_TextRadius * scale;
+    }
+
     dmGameObject::UpdateResult CompLabelRender(const dmGameObject::ComponentsRenderParams& params)
     {
         LabelContext* label_context = (LabelContext*)params.m_Context;
@@ -421,6 +444,7 @@ namespace dmGameSystem
 
             dmRender::DrawTextParams params;
             CreateDrawTextParams(component, params);
+            params.m_BoundingRadius = GetBoundingRadius(component);
 
             assert( component->m_RenderConstants.m_ConstantCount <= dmRender::MAX_FONT_RENDER_CONSTANTS );
             params.m_NumRenderConstants = component->m_RenderConstants.m_ConstantCount;
@@ -474,6 +498,7 @@ namespace dmGameSystem
                 free((void*)component->m_Text);
             }
             component->m_Text = strdup(textmsg->m_Text);
+            component->m_TextRadius = -1.0f;
             component->m_UserAllocatedText = 1;
         }
 
@@ -482,7 +507,9 @@ namespace dmGameSystem
 
     void CompLabelOnReload(const dmGameObject::ComponentOnReloadParams& params)
     {
-        (void)params;
+        LabelWorld* world = (LabelWorld*)params.m_World;
+        LabelComponent* component = &world->m_Components.Get(*params.m_UserData);
+        component->m_TextRadius = -1.0f;
     }
 
     void* CompLabelGetComponent(const dmGameObject::ComponentGetParams& params)
@@ -558,6 +585,7 @@ namespace dmGameSystem
         }
         else if (IsReferencingProperty(LABEL_PROP_SIZE, set_property))
         {
+            component->m_TextRadius = -1.0f;
             return SetProperty(set_property, params.m_Value, component->m_Size, LABEL_PROP_SIZE);
         }
         else if (IsReferencingProperty(LABEL_PROP_COLOR, set_property))
@@ -582,6 +610,7 @@ namespace dmGameSystem
         {
             dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, FONT_EXT_HASH, (void**)&component->m_FontMap);
             component->m_ReHash |= res == dmGameObject::PROPERTY_RESULT_OK;
+            component->m_TextRadius = -1.0f;
             return res;
         }
         return SetMaterialConstant(GetMaterial(component, component->m_Resource), set_property, params.m_Value, CompLabelSetConstantCallback, component);
@@ -64,6 +64,8 @@ namespace dmGameSystem
         /// Added to update or not
         uint8_t                     m_AddedToUpdate : 1;
         uint8_t                     m_ReHash : 1;
+        /// Drawn (not frustum culled) in a render pass since the last render
+        uint8_t                     m_Visible : 1;
     };
 
     struct ModelWorld
@@ -76,9 +78,18 @@ namespace dmGameSystem
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance> m_ScratchInstances;
         dmRig::HRigContext              m_RigContext;
+        /// Per-instance world transforms of the instanced batches, one buffer per batch
+        dmGraphics::HVertexDeclaration  m_InstanceDeclaration;
+        dmArray<dmGraphics::HVertexBuffer> m_InstanceBuffers;
+        dmArray<Matrix4>                m_InstanceData;
+        /// Number of instance buffers used since the last dispatch begin
+        uint32_t                        m_InstanceBufferCount;
         uint32_t                        m_MaxElementsVertices;
         uint32_t                        m_VertexBufferSwapChainIndex;
         uint32_t                        m_VertexBufferSwapChainSize;
+        uint8_t                         m_InstancingSupported : 1;
+        /// Dispatched by a render pass since the last render. The rigs are only culled when the components were drawn at all.
+        uint8_t                         m_Dispatched : 1;
     };
 
     static const uint32_t VERTEX_BUFFER_MAX_BATCHES = 16;     // Max dmRender::RenderListEntry.m_MinorOrder (4 bits)
@@ -90,6 +101,11 @@ namespace dmGameSystem
 
     static const uint32_t MAX_TEXTURE_COUNT = dmRender::RenderObject::MAX_TEXTURE_COUNT;
 
+    /// Local vertex space materials whose vertex program reads the world transform from these per-instance
+    /// attributes (one matrix column each) are drawn with one instanced draw call per batch
+    static const char* INSTANCE_WORLD_ATTRIBUTES[] = { "mtx_world_0", "mtx_world_1", "mtx_world_2", "mtx_world_3" };
+    static const dmhash_t INSTANCE_WORLD_ATTRIBUTE_HASH = dmHashString64(INSTANCE_WORLD_ATTRIBUTES[0]);
+
     static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params);
     static void DestroyComponent(ModelWorld* world, uint32_t index);
 
@@ -102,6 +118,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxModelCount;
+        rig_params.m_WorkerPool = context->m_WorkerPool;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -120,6 +137,19 @@ namespace dmGameSystem
         };
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
+
+        dmGraphics::VertexElement ive[] =
+        {
+                {INSTANCE_WORLD_ATTRIBUTES[0], 0, 4, dmGraphics::TYPE_FLOAT, false},
+                {INSTANCE_WORLD_ATTRIBUTES[1], 1, 4, dmGraphics::TYPE_FLOAT, false},
+                {INSTANCE_WORLD_ATTRIBUTES[2], 2, 4, dmGraphics::TYPE_FLOAT, false},
+                {INSTANCE_WORLD_ATTRIBUTES[3], 3, 4, dmGraphics::TYPE_FLOAT, false},
+        };
+        world->m_InstanceDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ive, sizeof(ive) / sizeof(dmGraphics::VertexElement), sizeof(Matrix4));
+        dmGraphics::SetVertexDeclarationStepFunction(world->m_InstanceDeclaration, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+        world->m_InstanceBufferCount = 0;
+        world->m_InstancingSupported = dmGraphics::IsInstancingSupported(graphics_context);
+
         world->m_MaxElementsVertices = dmGraphics::GetMaxElementsVertices(graphics_context);
         world->m_VertexBuffers = new dmGraphics::HVertexBuffer[VERTEX_BUFFER_MAX_BATCHES];
         world->m_VertexBufferData = new dmArray<dmRig::RigModelVertex>[VERTEX_BUFFER_MAX_BATCHES];
@@ -143,6 +173,11 @@ namespace dmGameSystem
         {
             dmGraphics::DeleteVertexBuffer(world->m_VertexBuffers[i]);
         }
+        dmGraphics::DeleteVertexDeclaration(world->m_InstanceDeclaration);
+        for(uint32_t i = 0; i < world->m_InstanceBuffers.Size(); ++i)
+        {
+            dmGraphics::DeleteVertexBuffer(world->m_InstanceBuffers[i]);
+        }
 
         dmResource::UnregisterResourceReloadedCallback(((ModelContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
 
@@ -362,6 +397,8 @@ namespace dmGameSystem
         component->m_Enabled = 1;
         component->m_World = Matrix4::identity();
         component->m_DoRender = 0;
+        // Sample the pose until the component has been through a render pass
+        component->m_Visible = 1;
 
         // Create GO<->bone representation
         // We need to make sure that bone GOs are created before we start the default animation.
@@ -387,6 +424,7 @@ namespace dmGameSystem
         RigSceneResource* rig_resource = resource->m_RigScene;
         create_params.m_BindPose         = &rig_resource->m_BindPose;
         create_params.m_AnimationSet     = rig_resource->m_AnimationSetRes == 0x0 ? 0x0 : rig_resource->m_AnimationSetRes->m_AnimationSet;
+        create_params.m_CompressedAnimationSet = rig_resource->m_AnimationSetRes == 0x0 ? 0x0 : rig_resource->m_AnimationSetRes->m_CompressedAnimationSet;
         create_params.m_Skeleton         = rig_resource->m_SkeletonRes == 0x0 ? 0x0 : rig_resource->m_SkeletonRes->m_Skeleton;
         create_params.m_MeshSet          = rig_resource->m_MeshSetRes->m_MeshSet;
         create_params.m_PoseIdxToInfluence = &rig_resource->m_PoseIdxToInfluence;
@@ -488,6 +526,78 @@ namespace dmGameSystem
         }
     }
 
+    static bool IsInstancedMaterial(ModelWorld* world, dmRender::HMaterial material)
+    {
+        return world->m_InstancingSupported && dmRender::GetMaterialAttributeLocation(material, INSTANCE_WORLD_ATTRIBUTE_HASH, INSTANCE_WORLD_ATTRIBUTES[0]) != -1;
+    }
+
+    // All components of a batch share resource, material, textures and constants (see ReHash), and are drawn
+    // as the instances of one render object. The world transform of the render object is identity.
+    static inline void RenderBatchInstancedLocalVS(ModelWorld* world, dmRender::HMaterial material, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(Model, "RenderBatchInstanced");
+
+        const ModelComponent* first = (ModelComponent*) buf[*begin].m_UserData;
+        const ModelResource* mr = first->m_Resource;
+        assert(mr->m_VertexBuffer);
+
+        uint32_t instance_count = end - begin;
+        dmArray<Matrix4>& instance_data = world->m_InstanceData;
+        if (instance_data.Capacity() < instance_count)
+            instance_data.SetCapacity(instance_count);
+        instance_data.SetSize(0);
+        for (uint32_t *i=begin;i!=end;i++)
+        {
+            const ModelComponent* c = (ModelComponent*) buf[*i].m_UserData;
+            instance_data.Push(c->m_World);
+        }
+
+        if (world->m_InstanceBufferCount == world->m_InstanceBuffers.Size())
+        {
+            if (world->m_InstanceBuffers.Full())
+                world->m_InstanceBuffers.OffsetCapacity(4);
+            world->m_InstanceBuffers.Push(dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(render_context), 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW));
+        }
+        dmGraphics::HVertexBuffer instance_buffer = world->m_InstanceBuffers[world->m_InstanceBufferCount++];
+        dmGraphics::SetVertexBufferData(instance_buffer, sizeof(Matrix4) * instance_count, instance_data.Begin(), dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+
+        dmRender::RenderObject& ro = *world->m_RenderObjects.End();
+        world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+
+        ro.Init();
+        ro.m_VertexDeclaration = world->m_VertexDeclaration;
+        ro.m_VertexBuffer = mr->m_VertexBuffer;
+        ro.m_InstanceDeclaration = world->m_InstanceDeclaration;
+        ro.m_InstanceBuffer = instance_buffer;
+        ro.m_InstanceCount = instance_count;
+        ro.m_Material = GetMaterial(first, mr);
+        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+        ro.m_VertexStart = 0;
+        ro.m_VertexCount = mr->m_ElementCount;
+        ro.m_WorldTransform = Matrix4::identity();
+
+        if(mr->m_IndexBuffer)
+        {
+            ro.m_IndexBuffer = mr->m_IndexBuffer;
+            ro.m_IndexType = mr->m_IndexBufferElementType;
+        }
+
+        for(uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i)
+        {
+            ro.m_Textures[i] = GetTexture(first, mr, i);
+        }
+
+        const CompRenderConstants& constants = first->m_RenderConstants;
+        for (uint32_t i = 0; i < constants.m_ConstantCount; ++i)
+        {
+            const dmRender::Constant& c = constants.m_RenderConstants[i];
+            dmRender::EnableRenderObjectConstant(&ro, c.m_NameHash, c.m_Value);
+        }
+
+        dmRender::AddToRender(render_context, &ro);
+        DM_COUNTER("ModelInstances", instance_count);
+    }
+
     static inline void RenderBatchWorldVS(ModelWorld* world, dmRender::HMaterial material, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE(Model, "RenderBatchWorld");
@@ -572,7 +682,10 @@ namespace dmGameSystem
             break;
 
             case dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL:
-                RenderBatchLocalVS(world, material, render_context, buf, begin, end);
+                if (IsInstancedMaterial(world, GetMaterial(first, first->m_Resource)))
+                    RenderBatchInstancedLocalVS(world, material, render_context, buf, begin, end);
+                else
+                    RenderBatchLocalVS(world, material, render_context, buf, begin, end);
             break;
 
             default:
@@ -620,10 +733,27 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // Rigs of components that were frustum culled in all render passes of the last frame skip the pose sampling
+    static void UpdateCulling(ModelWorld* world)
+    {
+        dmArray<ModelComponent*>& components = world->m_Components.m_Objects;
+        const uint32_t count = components.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ModelComponent& component = *components[i];
+            if (dmRig::IsValid(component.m_RigInstance))
+            {
+                dmRig::SetCulled(component.m_RigInstance, world->m_Dispatched && !component.m_Visible);
+            }
+        }
+    }
+
     dmGameObject::UpdateResult CompModelUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
     {
         ModelWorld* world = (ModelWorld*)params.m_World;
 
+        UpdateCulling(world);
+
         dmRig::Result rig_res = dmRig::Update(world->m_RigContext, params.m_UpdateContext->m_DT);
 
         dmArray<ModelComponent*>& components = world->m_Components.m_Objects;
@@ -649,6 +779,14 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    // The bind pose bounds, animations that move the meshes further from the origin may be culled too early
+    static float GetBoundingRadius(const ModelComponent* component)
+    {
+        const Matrix4& w = component->m_World;
+        float scale = dmMath::Max(dmMath::Max(length(w.getCol(0).getXYZ()), length(w.getCol(1).getXYZ())), length(w.getCol(2).getXYZ()));
+        return component->m_Resource->m_RigScene->m_BoundingRadius * scale;
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         ModelWorld *world = (ModelWorld *) params.m_UserData;
@@ -657,7 +795,9 @@ namespace dmGameSystem
         {
             case dmRender::RENDER_LIST_OPERATION_BEGIN:
             {
+                world->m_Dispatched = 1;
                 world->m_RenderObjects.SetSize(0);
+                world->m_InstanceBufferCount = 0;
                 for (uint32_t batch_index = 0; batch_index < VERTEX_BUFFER_MAX_BATCHES; ++batch_index)
                 {
                     world->m_VertexBufferData[batch_index].SetSize(0);
@@ -666,6 +806,10 @@ namespace dmGameSystem
             }
             case dmRender::RENDER_LIST_OPERATION_BATCH:
             {
+                for (uint32_t *i = params.m_Begin; i != params.m_End; ++i)
+                {
+                    ((ModelComponent*) params.m_Buf[*i].m_UserData)->m_Visible = 1;
+                }
                 RenderBatch(world, params.m_Context, params.m_Buf, params.m_Begin, params.m_End);
                 break;
             }
@@ -712,12 +856,15 @@ namespace dmGameSystem
         const uint32_t max_elements_vertices = world->m_MaxElementsVertices;
         uint32_t minor_order = 0; // Will translate to vb index.
         uint32_t vertex_count_total = 0;
+        world->m_Dispatched = 0;
         for (uint32_t i = 0; i < count; ++i)
         {
             ModelComponent& component = *components[i];
             if (!component.m_DoRender)
                 continue;
 
+            component.m_Visible = 0;
+
             uint32_t vertex_count = dmRig::GetVertexCount(component.m_RigInstance);
             if(vertex_count_total + vertex_count >= max_elements_vertices)
             {
@@ -728,6 +875,7 @@ namespace dmGameSystem
 
             const Vector4 trans = component.m_World.getCol(3);
             write_ptr->m_WorldPosition = Point3(trans.getX(), trans.getY(), trans.getZ());
+            write_ptr->m_BoundingRadius = GetBoundingRadius(&component);
             write_ptr->m_UserData = (uintptr_t) &component;
             write_ptr->m_BatchKey = component.m_MixedHash;
             write_ptr->m_TagMask = dmRender::GetMaterialTagMask(GetMaterial(&component, component.m_Resource));
@@ -845,6 +993,7 @@ namespace dmGameSystem
         RigSceneResource* rig_resource = component->m_Resource->m_RigScene;
         create_params.m_BindPose         = &rig_resource->m_BindPose;
         create_params.m_AnimationSet     = rig_resource->m_AnimationSetRes == 0x0 ? 0x0 : rig_resource->m_AnimationSetRes->m_AnimationSet;
+        create_params.m_CompressedAnimationSet = rig_resource->m_AnimationSetRes == 0x0 ? 0x0 : rig_resource->m_AnimationSetRes->m_CompressedAnimationSet;
         create_params.m_Skeleton         = rig_resource->m_SkeletonRes == 0x0 ? 0x0 : rig_resource->m_SkeletonRes->m_Skeleton;
         create_params.m_MeshSet          = rig_resource->m_MeshSetRes->m_MeshSet;
         create_params.m_PoseIdxToInfluence = &rig_resource->m_PoseIdxToInfluence;
@@ -863,6 +1012,7 @@ namespace dmGameSystem
         }
 
         component->m_ReHash = 1;
+        component->m_Visible = 1;
 
         return true;
     }
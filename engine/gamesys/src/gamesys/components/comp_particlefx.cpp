@@ -67,10 +67,33 @@ namespace dmGameSystem
         dmParticle::HParticleContext m_ParticleContext;
         dmGraphics::HVertexBuffer m_VertexBuffer;
         dmArray<dmParticle::Vertex> m_VertexBufferData;
+        dmArray<const dmParticle::EmitterRenderData*> m_BatchEmitters;
         dmGraphics::HVertexDeclaration m_VertexDeclaration;
+        /// Per-vertex quad corners and per-instance particle records of the batches drawn with a compact material,
+        /// one instance buffer per batch
+        dmGraphics::HVertexBuffer m_CornerVertexBuffer;
+        dmGraphics::HVertexDeclaration m_CornerDeclaration;
+        dmGraphics::HVertexDeclaration m_CompactDeclaration;
+        dmArray<dmGraphics::HVertexBuffer> m_CompactBuffers;
+        dmArray<dmParticle::ParticleCompactVertex> m_CompactBufferData;
+        /// Number of compact buffers used since the last dispatch begin
+        uint32_t m_CompactBufferCount;
         uint32_t m_EmitterCount;
         float m_DT;
         uint32_t m_WarnOutOfROs : 1;
+        uint32_t m_InstancingSupported : 1;
+    };
+
+    /// Materials whose vertex program reads this per-vertex attribute expand one dmParticle::ParticleCompactVertex
+    /// per particle into a quad (see builtins/materials/particlefx_compact.vp), and are drawn instanced
+    static const char* COMPACT_CORNER_ATTRIBUTE = "corner";
+    static const dmhash_t COMPACT_CORNER_ATTRIBUTE_HASH = dmHashString64(COMPACT_CORNER_ATTRIBUTE);
+
+    /// Corners of the two triangles of a particle quad, in the order of the vertices written for PARTICLE_GO
+    static const float COMPACT_CORNERS[] =
+    {
+        -1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f,
+         1.0f,  1.0f,   1.0f,-1.0f, -1.0f,-1.0f,
     };
 
     dmGameObject::CreateResult CompParticleFXNewWorld(const dmGameObject::ComponentNewWorldParams& params)
@@ -82,6 +105,7 @@ namespace dmGameSystem
         world->m_Context = ctx;
         uint32_t particle_fx_count = ctx->m_MaxParticleFXCount;
         world->m_ParticleContext = dmParticle::CreateContext(particle_fx_count, ctx->m_MaxParticleCount);
+        dmParticle::SetWorkerPool(world->m_ParticleContext, ctx->m_WorkerPool);
         world->m_Components.SetCapacity(particle_fx_count);
         world->m_RenderObjects.SetCapacity(particle_fx_count);
         world->m_Prototypes.SetCapacity(particle_fx_count);
@@ -99,6 +123,27 @@ namespace dmGameSystem
             {"texcoord0", 2, 2, dmGraphics::TYPE_FLOAT, true},
         };
         world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(dmRender::GetGraphicsContext(ctx->m_RenderContext), ve, 3);
+
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(ctx->m_RenderContext);
+        dmGraphics::VertexElement corner_ve[] =
+        {
+            {COMPACT_CORNER_ATTRIBUTE, 0, 2, dmGraphics::TYPE_FLOAT, false},
+        };
+        world->m_CornerDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, corner_ve, 1);
+        world->m_CornerVertexBuffer = dmGraphics::NewVertexBuffer(graphics_context, sizeof(COMPACT_CORNERS), COMPACT_CORNERS, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+        dmGraphics::VertexElement compact_ve[] =
+        {
+            {"position",   0, 3, dmGraphics::TYPE_FLOAT, false},
+            {"rotation",   1, 4, dmGraphics::TYPE_FLOAT, false},
+            {"size",       2, 2, dmGraphics::TYPE_FLOAT, false},
+            {"uv_rect",    3, 4, dmGraphics::TYPE_FLOAT, false},
+            {"color",      4, 4, dmGraphics::TYPE_UNSIGNED_BYTE, true},
+            {"uv_rotated", 5, 1, dmGraphics::TYPE_UNSIGNED_BYTE, true},
+        };
+        world->m_CompactDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, compact_ve, sizeof(compact_ve) / sizeof(dmGraphics::VertexElement), sizeof(dmParticle::ParticleCompactVertex));
+        dmGraphics::SetVertexDeclarationStepFunction(world->m_CompactDeclaration, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+        world->m_CompactBufferCount = 0;
+        world->m_InstancingSupported = dmGraphics::IsInstancingSupported(graphics_context);
         *params.m_World = world;
         return dmGameObject::CREATE_RESULT_OK;
     }
@@ -115,6 +160,13 @@ namespace dmGameSystem
         dmParticle::DestroyContext(pfx_world->m_ParticleContext);
         dmGraphics::DeleteVertexBuffer(pfx_world->m_VertexBuffer);
         dmGraphics::DeleteVertexDeclaration(pfx_world->m_VertexDeclaration);
+        dmGraphics::DeleteVertexBuffer(pfx_world->m_CornerVertexBuffer);
+        dmGraphics::DeleteVertexDeclaration(pfx_world->m_CornerDeclaration);
+        dmGraphics::DeleteVertexDeclaration(pfx_world->m_CompactDeclaration);
+        for (uint32_t i = 0; i < pfx_world->m_CompactBuffers.Size(); ++i)
+        {
+            dmGraphics::DeleteVertexBuffer(pfx_world->m_CompactBuffers[i]);
+        }
         delete pfx_world;
         return dmGameObject::CREATE_RESULT_OK;
     }
@@ -222,9 +274,93 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    static bool IsCompactMaterial(ParticleFXWorld* pfx_world, dmRender::HMaterial material)
+    {
+        return pfx_world->m_InstancingSupported && dmRender::GetMaterialAttributeLocation(material, COMPACT_CORNER_ATTRIBUTE_HASH, COMPACT_CORNER_ATTRIBUTE) != -1;
+    }
+
+    static void SetBatchEmitters(ParticleFXWorld* pfx_world, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        dmArray<const dmParticle::EmitterRenderData*>& emitters = pfx_world->m_BatchEmitters;
+        uint32_t emitter_count = end - begin;
+        if (emitters.Capacity() < emitter_count)
+        {
+            emitters.SetCapacity(emitter_count);
+        }
+        emitters.SetSize(0);
+        for (uint32_t *i = begin; i != end; ++i)
+        {
+            emitters.Push((dmParticle::EmitterRenderData*) buf[*i].m_UserData);
+        }
+    }
+
+    static void SetBatchRenderState(dmRender::RenderObject* ro, const dmParticle::EmitterRenderData* first)
+    {
+        ro->m_Material = (dmRender::HMaterial)first->m_Material;
+        ro->m_Textures[0] = (dmGraphics::HTexture)first->m_Texture;
+        ro->m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+        ro->m_SetBlendFactors = 1;
+        SetBlendFactors(ro, first->m_BlendMode);
+        SetRenderConstants(ro, first->m_RenderConstants, first->m_RenderConstantsSize);
+    }
+
+    // One record per particle in an instance buffer of its own, drawn as instances of the six quad corners
+    static void RenderBatchCompact(ParticleFXWorld* pfx_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(ParticleFX, "RenderBatchCompact");
+
+        const dmParticle::EmitterRenderData* first = (dmParticle::EmitterRenderData*) buf[*begin].m_UserData;
+        ParticleFXContext* pfx_context = pfx_world->m_Context;
+
+        dmArray<dmParticle::ParticleCompactVertex>& data = pfx_world->m_CompactBufferData;
+        if (data.Capacity() < pfx_context->m_MaxParticleCount)
+        {
+            data.SetCapacity(pfx_context->m_MaxParticleCount);
+        }
+
+        SetBatchEmitters(pfx_world, buf, begin, end);
+        uint32_t vb_size = 0;
+        uint32_t vb_max_size = dmParticle::GetVertexBufferSize(pfx_context->m_MaxParticleCount, dmParticle::PARTICLE_GO_COMPACT);
+        dmParticle::GenerateVertexData(pfx_world->m_ParticleContext, pfx_world->m_DT, pfx_world->m_BatchEmitters.Begin(), end - begin, Vector4(1,1,1,1), (void*)data.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO_COMPACT);
+
+        uint32_t instance_count = vb_size / sizeof(dmParticle::ParticleCompactVertex);
+        if (instance_count == 0)
+            return;
+
+        if (pfx_world->m_CompactBufferCount == pfx_world->m_CompactBuffers.Size())
+        {
+            if (pfx_world->m_CompactBuffers.Full())
+                pfx_world->m_CompactBuffers.OffsetCapacity(4);
+            pfx_world->m_CompactBuffers.Push(dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(render_context), 0, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW));
+        }
+        dmGraphics::HVertexBuffer instance_buffer = pfx_world->m_CompactBuffers[pfx_world->m_CompactBufferCount++];
+        dmGraphics::SetVertexBufferData(instance_buffer, vb_size, data.Begin(), dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+        DM_COUNTER("ParticleFXVertexBuffer", vb_size);
+
+        dmRender::RenderObject& ro = *pfx_world->m_RenderObjects.End();
+        pfx_world->m_RenderObjects.SetSize(pfx_world->m_RenderObjects.Size()+1);
+        ro.Init();
+        ro.m_VertexStart = 0;
+        ro.m_VertexCount = sizeof(COMPACT_CORNERS) / (2 * sizeof(float));
+        ro.m_VertexBuffer = pfx_world->m_CornerVertexBuffer;
+        ro.m_VertexDeclaration = pfx_world->m_CornerDeclaration;
+        ro.m_InstanceBuffer = instance_buffer;
+        ro.m_InstanceDeclaration = pfx_world->m_CompactDeclaration;
+        ro.m_InstanceCount = instance_count;
+        SetBatchRenderState(&ro, first);
+
+        dmRender::AddToRender(render_context, &ro);
+    }
+
     static void RenderBatch(ParticleFXWorld* pfx_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
     {
         const dmParticle::EmitterRenderData* first = (dmParticle::EmitterRenderData*) buf[*begin].m_UserData;
+        if (IsCompactMaterial(pfx_world, (dmRender::HMaterial)first->m_Material))
+        {
+            RenderBatchCompact(pfx_world, render_context, buf, begin, end);
+            return;
+        }
+
         ParticleFXContext* pfx_context = pfx_world->m_Context;
         dmParticle::HParticleContext particle_context = pfx_world->m_ParticleContext;
 
@@ -236,11 +372,8 @@ namespace dmGameSystem
         uint32_t vb_size = vb_size_init;
         uint32_t vb_max_size =  dmParticle::GetVertexBufferSize(pfx_context->m_MaxParticleCount, dmParticle::PARTICLE_GO);
 
-        for (uint32_t *i = begin; i != end; ++i)
-        {
-            const dmParticle::EmitterRenderData* emitter_render_data = (dmParticle::EmitterRenderData*) buf[*i].m_UserData;
-            dmParticle::GenerateVertexData(particle_context, pfx_world->m_DT, emitter_render_data->m_Instance, emitter_render_data->m_EmitterIndex, Vector4(1,1,1,1), (void*)vertex_buffer.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO);
-        }
+        SetBatchEmitters(pfx_world, buf, begin, end);
+        dmParticle::GenerateVertexData(particle_context, pfx_world->m_DT, pfx_world->m_BatchEmitters.Begin(), end - begin, Vector4(1,1,1,1), (void*)vertex_buffer.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO);
 
         vb_end = (vb_begin + (vb_size - vb_size_init) / sizeof(dmParticle::Vertex));
 
@@ -251,16 +384,11 @@ namespace dmGameSystem
         dmRender::RenderObject& ro = *pfx_world->m_RenderObjects.End();
         pfx_world->m_RenderObjects.SetSize(pfx_world->m_RenderObjects.Size()+1);
         ro.Init();
-        ro.m_Material = (dmRender::HMaterial)first->m_Material;
-        ro.m_Textures[0] = (dmGraphics::HTexture)first->m_Texture;
         ro.m_VertexStart = vb_begin - vertex_buffer.Begin();
         ro.m_VertexCount = ro_vertex_count;
         ro.m_VertexBuffer = pfx_world->m_VertexBuffer;
         ro.m_VertexDeclaration = pfx_world->m_VertexDeclaration;
-        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
-        ro.m_SetBlendFactors = 1;
-        SetBlendFactors(&ro, first->m_BlendMode);
-        SetRenderConstants(&ro, first->m_RenderConstants, first->m_RenderConstantsSize);
+        SetBatchRenderState(&ro, first);
 
         dmRender::AddToRender(render_context, &ro);
     }
@@ -274,6 +402,7 @@ namespace dmGameSystem
             dmGraphics::SetVertexBufferData(pfx_world->m_VertexBuffer, 0, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
             pfx_world->m_VertexBufferData.SetSize(0);
             pfx_world->m_RenderObjects.SetSize(0);
+            pfx_world->m_CompactBufferCount = 0;
         }
         else if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
         {
@@ -318,6 +447,7 @@ namespace dmGameSystem
                     dmParticle::GetEmitterRenderData(particle_context, c.m_ParticleInstance, j, &render_data);
 
                     write_ptr->m_WorldPosition = Point3(render_data->m_Transform.getTranslation());
+                    write_ptr->m_BoundingRadius = render_data->m_BoundingRadius;
                     write_ptr->m_UserData = (uintptr_t) render_data;
                     write_ptr->m_BatchKey = render_data->m_MixedHash;
                     write_ptr->m_TagMask = dmRender::GetMaterialTagMask((dmRender::HMaterial)render_data->m_Material);
@@ -76,6 +76,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxSpineModelCount;
+        rig_params.m_WorkerPool = context->m_WorkerPool;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -343,6 +344,8 @@ namespace dmGameSystem
         component->m_Enabled = 1;
         component->m_World = Matrix4::identity();
         component->m_DoRender = 0;
+        // Sample the pose until the component has been through a render pass
+        component->m_Visible = 1;
 
         // Create GO<->bone representation
         // We need to make sure that bone GOs are created before we start the default animation.
@@ -370,6 +373,7 @@ namespace dmGameSystem
         create_params.m_Skeleton         = rig_resource->m_SkeletonRes->m_Skeleton;
         create_params.m_MeshSet          = rig_resource->m_MeshSetRes->m_MeshSet;
         create_params.m_AnimationSet     = rig_resource->m_AnimationSetRes->m_AnimationSet;
+        create_params.m_CompressedAnimationSet = rig_resource->m_AnimationSetRes->m_CompressedAnimationSet;
         create_params.m_PoseIdxToInfluence = &rig_resource->m_PoseIdxToInfluence;
         create_params.m_TrackIdxToPose     = &rig_resource->m_TrackIdxToPose;
         create_params.m_MeshId           = dmHashString64(component->m_Resource->m_Model->m_Skin);
@@ -538,10 +542,27 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // Rigs of components that were frustum culled in all render passes of the last frame skip the pose sampling
+    static void UpdateCulling(SpineModelWorld* world)
+    {
+        dmArray<SpineModelComponent*>& components = world->m_Components.m_Objects;
+        const uint32_t count = components.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SpineModelComponent& component = *components[i];
+            if (dmRig::IsValid(component.m_RigInstance))
+            {
+                dmRig::SetCulled(component.m_RigInstance, world->m_Dispatched && !component.m_Visible);
+            }
+        }
+    }
+
     dmGameObject::UpdateResult CompSpineModelUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
     {
         SpineModelWorld* world = (SpineModelWorld*)params.m_World;
 
+        UpdateCulling(world);
+
         dmRig::Result rig_res = dmRig::Update(world->m_RigContext, params.m_UpdateContext->m_DT);
 
         dmArray<SpineModelComponent*>& components = world->m_Components.m_Objects;
@@ -567,6 +588,14 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    // The bind pose bounds, animations that move the meshes further from the origin may be culled too early
+    static float GetBoundingRadius(const SpineModelComponent* component)
+    {
+        const Matrix4& w = component->m_World;
+        float scale = dmMath::Max(length(w.getCol(0).getXYZ()), length(w.getCol(1).getXYZ()));
+        return component->m_Resource->m_RigScene->m_BoundingRadius * scale;
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         SpineModelWorld *world = (SpineModelWorld *) params.m_UserData;
@@ -575,6 +604,7 @@ namespace dmGameSystem
         {
             case dmRender::RENDER_LIST_OPERATION_BEGIN:
             {
+                world->m_Dispatched = 1;
                 dmGraphics::SetVertexBufferData(world->m_VertexBuffer, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
                 world->m_RenderObjects.SetSize(0);
                 dmArray<dmRig::RigSpineModelVertex>& vertex_buffer = world->m_VertexBufferData;
@@ -583,6 +613,10 @@ namespace dmGameSystem
             }
             case dmRender::RENDER_LIST_OPERATION_BATCH:
             {
+                for (uint32_t *i = params.m_Begin; i != params.m_End; ++i)
+                {
+                    ((SpineModelComponent*) params.m_Buf[*i].m_UserData)->m_Visible = 1;
+                }
                 RenderBatch(world, params.m_Context, params.m_Buf, params.m_Begin, params.m_End);
                 break;
             }
@@ -615,14 +649,18 @@ namespace dmGameSystem
         dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, world);
         dmRender::RenderListEntry* write_ptr = render_list;
 
+        world->m_Dispatched = 0;
         for (uint32_t i = 0; i < count; ++i)
         {
             SpineModelComponent& component = *components[i];
             if (!component.m_DoRender || !component.m_Enabled)
                 continue;
 
+            component.m_Visible = 0;
+
             const Vector4 trans = component.m_World.getCol(3);
             write_ptr->m_WorldPosition = Point3(trans.getX(), trans.getY(), trans.getZ());
+            write_ptr->m_BoundingRadius = GetBoundingRadius(&component);
             write_ptr->m_UserData = (uintptr_t) &component;
             write_ptr->m_BatchKey = component.m_MixedHash;
             write_ptr->m_TagMask = dmRender::GetMaterialTagMask(GetMaterial(&component, component.m_Resource));
@@ -751,6 +789,7 @@ namespace dmGameSystem
         create_params.m_Skeleton         = rig_resource->m_SkeletonRes->m_Skeleton;
         create_params.m_MeshSet          = rig_resource->m_MeshSetRes->m_MeshSet;
         create_params.m_AnimationSet     = rig_resource->m_AnimationSetRes->m_AnimationSet;
+        create_params.m_CompressedAnimationSet = rig_resource->m_AnimationSetRes->m_CompressedAnimationSet;
         create_params.m_PoseIdxToInfluence = &rig_resource->m_PoseIdxToInfluence;
         create_params.m_TrackIdxToPose     = &rig_resource->m_TrackIdxToPose;
         create_params.m_MeshId           = dmHashString64(component->m_Resource->m_Model->m_Skin);
@@ -767,6 +806,7 @@ namespace dmGameSystem
         }
 
         component->m_ReHash = 1;
+        component->m_Visible = 1;
 
         return true;
     }
@@ -46,6 +46,8 @@ namespace dmGameSystem
         /// Added to update or not
         uint8_t                     m_AddedToUpdate : 1;
         uint8_t                     m_ReHash : 1;
+        /// Drawn (not frustum culled) in a render pass since the last render
+        uint8_t                     m_Visible : 1;
     };
 
     struct SpineModelWorld
@@ -58,6 +60,8 @@ namespace dmGameSystem
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance>    m_ScratchInstances;
         dmRig::HRigContext                  m_RigContext;
+        /// Dispatched by a render pass since the last render. The rigs are only culled when the components were drawn at all.
+        uint8_t                             m_Dispatched : 1;
     };
 
     dmGameObject::CreateResult CompSpineModelNewWorld(const dmGameObject::ComponentNewWorldParams& params);
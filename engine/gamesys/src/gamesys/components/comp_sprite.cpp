@@ -24,6 +24,8 @@
 #include <dlib/dstrings.h>
 #include <dlib/object_pool.h>
 #include <dlib/math.h>
+#include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 #include <graphics/graphics.h>
 #include <render/render.h>
 #include <gameobject/gameobject_ddf.h>
@@ -36,6 +38,14 @@
 #include "sprite_ddf.h"
 #include "gamesys_ddf.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_SPRITE_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define DM_SPRITE_NEON
+    #include <arm_neon.h>
+#endif
+
 using namespace Vectormath::Aos;
 namespace dmGameSystem
 {
@@ -47,6 +57,8 @@ namespace dmGameSystem
         Vector3                     m_Scale;
         Vector3                     m_Size;     // The current size of the animation frame (in texels)
         Matrix4                     m_World;
+        /// Proxy in the spatial tree of the render context, moved when m_World changes
+        dmRender::HSpatialProxy     m_SpatialProxy;
         // Hash of the m_Resource-pointer. Hash is used to be compatible with 64-bit arch as a 32-bit value is used for sorting
         // See GenerateKeys
         uint32_t                    m_MixedHash;
@@ -86,10 +98,34 @@ namespace dmGameSystem
         float v;
     };
 
+    /**
+     * The state the vertices of a sprite were last written from, when the vertex buffer is persistent.
+     * Tint is a render constant and is not part of the vertex data.
+     */
+    struct SpriteVertexKey
+    {
+        float                       m_World[16];
+        const void*                 m_TextureSet;
+        uint32_t                    m_AnimationID;
+        uint32_t                    m_AnimationFrame;
+        uint16_t                    m_FlipHorizontal;
+        uint16_t                    m_FlipVertical;
+    };
+
     struct SpriteWorld
     {
         dmObjectPool<SpriteComponent>   m_Components;
         dmArray<dmRender::RenderObject> m_RenderObjects;
+        dmTransform::TransformSoA       m_LocalTransforms;
+        dmArray<const Matrix4*>         m_ParentTransforms;
+        dmArray<Matrix4>                m_WorldTransforms;
+        /// Per sprite in the batch being rendered, the first vertex and index relative to the batch (when using geometries)
+        dmArray<uint32_t>               m_GeometryVertexOffsets;
+        dmArray<uint32_t>               m_GeometryIndexOffsets;
+        /// Used to generate vertex data in parallel, may be 0
+        dmWorkerPool::HWorkerPool       m_WorkerPool;
+        /// Spatial tree of the render context, used for culling
+        dmRender::HSpatialTree          m_SpatialTree;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         dmGraphics::HVertexBuffer       m_VertexBuffer;
         SpriteVertex*                   m_VertexBufferData;
@@ -97,9 +133,16 @@ namespace dmGameSystem
         dmGraphics::HIndexBuffer        m_IndexBuffer;
         uint8_t*                        m_IndexBufferData;
         uint8_t*                        m_IndexBufferWritePtr;
+        /// Per component slot, the state its vertices were written from (when using a persistent vertex buffer)
+        dmArray<SpriteVertexKey>        m_VertexKeys;
+        /// Per component slot, if its vertices were rewritten since the last upload
+        dmArray<uint8_t>                m_DirtySlots;
+        /// Number of sprites dispatched since the last upload
+        uint32_t                        m_DispatchedCount;
         uint8_t                         m_Is16BitIndex : 1;
         uint8_t                         m_UseGeometries : 1;
         uint8_t                         m_ReallocBuffers : 1;
+        uint8_t                         m_PersistentVertices : 1;
     };
 
     DM_GAMESYS_PROP_VECTOR3(SPRITE_PROP_SCALE, scale, false);
@@ -114,8 +157,8 @@ namespace dmGameSystem
     static void SetPlaybackRate(SpriteComponent* component, float playback_rate);
 
     template<typename T>
-    void fillIndices(T* index, uint32_t indices_count) {
-        for(uint32_t i = 0, v = 0; i < indices_count; i += 6, v += 4)
+    void fillIndices(T* index, uint32_t indices_count, uint32_t first_vertex = 0) {
+        for(uint32_t i = 0, v = first_vertex; i < indices_count; i += 6, v += 4)
         {
             *index++ = v+0;
             *index++ = v+1;
@@ -166,6 +209,25 @@ namespace dmGameSystem
             sprite_world->m_IndexBuffer = dmGraphics::NewIndexBuffer(dmRender::GetGraphicsContext(render_context), indices_size, (void*)sprite_world->m_IndexBufferData, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
         }
 
+        if (sprite_world->m_PersistentVertices)
+        {
+            // Each component slot owns num_vertices_per_sprite vertices, which are uploaded in dirty ranges
+            uint32_t memsize = sizeof(SpriteVertex) * num_vertices_per_sprite * max_sprite_count;
+            memset(sprite_world->m_VertexBufferData, 0, memsize);
+            dmGraphics::SetVertexBufferData(sprite_world->m_VertexBuffer, memsize, sprite_world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+
+            // All keys are invalidated, the texture set of a key is never 0
+            sprite_world->m_VertexKeys.SetCapacity(max_sprite_count);
+            sprite_world->m_VertexKeys.SetSize(max_sprite_count);
+            sprite_world->m_DirtySlots.SetCapacity(max_sprite_count);
+            sprite_world->m_DirtySlots.SetSize(max_sprite_count);
+            if (max_sprite_count > 0)
+            {
+                memset(sprite_world->m_VertexKeys.Begin(), 0, sizeof(SpriteVertexKey) * max_sprite_count);
+                memset(sprite_world->m_DirtySlots.Begin(), 0, max_sprite_count);
+            }
+        }
+
         sprite_world->m_ReallocBuffers = 0;
     }
 
@@ -192,8 +254,12 @@ namespace dmGameSystem
         sprite_world->m_IndexBuffer = 0;
         sprite_world->m_IndexBufferData = 0;
 
+        sprite_world->m_WorkerPool = sprite_context->m_WorkerPool;
+        sprite_world->m_SpatialTree = dmRender::GetSpatialTree(render_context);
+        sprite_world->m_DispatchedCount = 0;
         sprite_world->m_UseGeometries = 0;
         sprite_world->m_ReallocBuffers = 1;
+        sprite_world->m_PersistentVertices = sprite_context->m_PersistentVertexBuffer;
 
         *params.m_World = sprite_world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -352,6 +418,7 @@ namespace dmGameSystem
         component->m_ComponentIndex = params.m_ComponentIndex;
         component->m_Enabled = 1;
         component->m_Scale = Vector3(1.0f);
+        component->m_SpatialProxy = dmRender::INVALID_SPATIAL_PROXY;
 
         component->m_ReHash = 1;
 
@@ -380,170 +447,385 @@ namespace dmGameSystem
         if (component->m_TextureSet) {
             dmResource::Release(factory, component->m_TextureSet);
         }
+        if (component->m_SpatialProxy != dmRender::INVALID_SPATIAL_PROXY) {
+            dmRender::DestroySpatialProxy(sprite_world->m_SpatialTree, component->m_SpatialProxy);
+        }
         sprite_world->m_Components.Free(index, true);
         return dmGameObject::CREATE_RESULT_OK;
     }
 
 
-    static void CreateVertexData(SpriteWorld* sprite_world, SpriteVertex** vb_where, uint8_t** ib_where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    // Minimal wrapper for the quad corner transform, one vertex position per register (x, y, z, w lanes).
+    // The scalar fallback uses the vector math library with the same operation order.
+#if defined(DM_SPRITE_SSE)
+    typedef __m128 SimdFloat;
+    static inline SimdFloat SimdLoad(const float* p)                { return _mm_loadu_ps(p); }
+    static inline SimdFloat SimdSet(float v)                        { return _mm_set1_ps(v); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return _mm_add_ps(a, b); }
+    static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)       { return _mm_sub_ps(a, b); }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return _mm_mul_ps(a, b); }
+    // Stores x, y, z without touching the float after
+    static inline void SimdStore3(float* p, SimdFloat v)
     {
-        DM_PROFILE(Sprite, "CreateVertexData");
+        _mm_storel_pi((__m64*)p, v);
+        _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+    }
+#elif defined(DM_SPRITE_NEON)
+    typedef float32x4_t SimdFloat;
+    static inline SimdFloat SimdLoad(const float* p)                { return vld1q_f32(p); }
+    static inline SimdFloat SimdSet(float v)                        { return vdupq_n_f32(v); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return vaddq_f32(a, b); }
+    static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)       { return vsubq_f32(a, b); }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return vmulq_f32(a, b); }
+    static inline void SimdStore3(float* p, SimdFloat v)
+    {
+        vst1_f32(p, vget_low_f32(v));
+        vst1q_lane_f32(p + 2, v, 2);
+    }
+#else
+    typedef Vector4 SimdFloat;
+    static inline SimdFloat SimdLoad(const float* p)                { return Vector4(p[0], p[1], p[2], p[3]); }
+    static inline SimdFloat SimdSet(float v)                        { return Vector4(v); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return a + b; }
+    static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)       { return a - b; }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return mulPerElem(a, b); }
+    static inline void SimdStore3(float* p, SimdFloat v)
+    {
+        p[0] = v.getX();
+        p[1] = v.getY();
+        p[2] = v.getZ();
+    }
+#endif
 
-        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
-        dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
-        uint32_t* frame_indices = texture_set_ddf->m_FrameIndices.m_Data;
+    // Writes the positions of the quad corners (-0.5,-0.5), (-0.5,0.5), (0.5,0.5) and (0.5,-0.5), same as w * Point3(x, y, 0)
+    static inline void TransformQuadCorners(const Matrix4& w, SpriteVertex* vertices)
+    {
+        const float* m = (const float*)&w;
+        const SimdFloat half = SimdSet(0.5f);
+        const SimdFloat x = SimdMul(SimdLoad(m), half);
+        const SimdFloat y = SimdMul(SimdLoad(m + 4), half);
+        const SimdFloat t = SimdLoad(m + 12);
+        SimdStore3(&vertices[0].x, SimdAdd(SimdSub(SimdSub(SimdSet(0.0f), x), y), t));
+        SimdStore3(&vertices[1].x, SimdAdd(SimdSub(y, x), t));
+        SimdStore3(&vertices[2].x, SimdAdd(SimdAdd(x, y), t));
+        SimdStore3(&vertices[3].x, SimdAdd(SimdSub(x, y), t));
+    }
 
-        SpriteVertex*   vertices = *vb_where;
-        uint8_t*        indices = *ib_where;
+    // Box that contains the quad corners, used for the spatial proxy of the sprite
+    static inline void GetBounds(const Matrix4& w, Point3& min, Point3& max)
+    {
+        const Vector3 half_extents = 0.5f * (absPerElem(w.getCol(0).getXYZ()) + absPerElem(w.getCol(1).getXYZ()));
+        const Point3 center(w.getCol3().getXYZ());
+        min = center - half_extents;
+        max = center + half_extents;
+    }
+
+    static inline bool IsSameTransform(const Matrix4& a, const Matrix4& b)
+    {
+        const float* fa = (const float*) &a;
+        const float* fb = (const float*) &b;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (fa[i] != fb[i])
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Vertex data of a batch of sprites, written in ranges of sprites by the worker pool.
+     */
+    struct CreateVertexDataContext
+    {
+        SpriteWorld*                m_World;
+        TextureSetResource*         m_TextureSet;
+        dmRender::RenderListEntry*  m_Buf;
+        uint32_t*                   m_Begin;
+        uint32_t                    m_Count;
+        /// First vertex and index of the batch
+        SpriteVertex*               m_Vertices;
+        uint8_t*                    m_Indices;
+        /// Index of the first vertex of the batch in the world vertex buffer
+        uint32_t                    m_VertexOffset;
+    };
+
+    /// Number of sprites per task when generating vertex data on the worker pool
+    static const uint32_t SPRITES_PER_TASK = 1024;
+
+    // Old version has always 4 vertices. New version has up to 8 vertices.
+    static inline uint32_t GetMaxVertexCountPerSprite(const SpriteWorld* sprite_world)
+    {
+        return sprite_world->m_UseGeometries ? 8 : 4;
+    }
+
+    // Returns true if the vertices of the sprite in the slot must be rewritten, and stores the new state of the slot
+    static bool UpdateVertexKey(SpriteWorld* sprite_world, uint32_t slot, const SpriteComponent* component, const void* texture_set)
+    {
+        SpriteVertexKey& key = sprite_world->m_VertexKeys[slot];
+        const float* world = (const float*)&component->m_World;
+        if (key.m_TextureSet == texture_set
+            && key.m_AnimationID == component->m_AnimationID
+            && key.m_AnimationFrame == component->m_CurrentAnimationFrame
+            && key.m_FlipHorizontal == component->m_FlipHorizontal
+            && key.m_FlipVertical == component->m_FlipVertical
+            && memcmp(key.m_World, world, sizeof(key.m_World)) == 0)
+        {
+            return false;
+        }
+        memcpy(key.m_World, world, sizeof(key.m_World));
+        key.m_TextureSet = texture_set;
+        key.m_AnimationID = component->m_AnimationID;
+        key.m_AnimationFrame = component->m_CurrentAnimationFrame;
+        key.m_FlipHorizontal = component->m_FlipHorizontal;
+        key.m_FlipVertical = component->m_FlipVertical;
+        sprite_world->m_DirtySlots[slot] = 1;
+        return true;
+    }
 
+    static void CreateGeometryVertexData(const CreateVertexDataContext* ctx, uint32_t start, uint32_t end)
+    {
+        SpriteWorld* sprite_world = ctx->m_World;
+        dmGameSystemDDF::TextureSet* texture_set_ddf = ctx->m_TextureSet->m_TextureSet;
+        dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
+        uint32_t* frame_indices = texture_set_ddf->m_FrameIndices.m_Data;
+        const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
+        const SpriteComponent* components = sprite_world->m_Components.m_Objects.Begin();
         uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
 
-        if (sprite_world->m_UseGeometries)
+        for (uint32_t s = start; s != end; ++s)
         {
-            const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
+            const SpriteComponent* component = (SpriteComponent*) ctx->m_Buf[ctx->m_Begin[s]].m_UserData;
 
-            // The offset for the indices
-            uint32_t vertex_offset = *vb_where - sprite_world->m_VertexBufferData;
+            const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
 
-            for (uint32_t* i = begin; i != end; ++i)
-            {
-                const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
+            uint32_t frame_index = frame_indices[animation_ddf->m_Start + component->m_CurrentAnimationFrame];
 
-                const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+            const dmGameSystemDDF::SpriteGeometry* geometry = &geometries[frame_index];
 
-                uint32_t frame_index = frame_indices[animation_ddf->m_Start + component->m_CurrentAnimationFrame];
+            const Matrix4& w = component->m_World;
 
-                const dmGameSystemDDF::SpriteGeometry* geometry = &geometries[frame_index];
+            uint32_t num_points = geometry->m_Vertices.m_Count / 2;
 
-                const Matrix4& w = component->m_World;
+            const float* points = geometry->m_Vertices.m_Data;
+            const float* uvs = geometry->m_Uvs.m_Data;
 
-                uint32_t num_points = geometry->m_Vertices.m_Count / 2;
+            // The vertices and indices of the sprite start where the ones of the previous sprite ended,
+            // unless the vertices are persistent in which case they are kept in the slot of the component
+            uint8_t* indices = ctx->m_Indices + sprite_world->m_GeometryIndexOffsets[s] * index_type_size;
+            uint32_t vertex_offset;
+            bool write_vertices = true;
+            if (sprite_world->m_PersistentVertices)
+            {
+                uint32_t slot = component - components;
+                vertex_offset = slot * GetMaxVertexCountPerSprite(sprite_world);
+                write_vertices = UpdateVertexKey(sprite_world, slot, component, texture_set_ddf);
+            }
+            else
+            {
+                vertex_offset = ctx->m_VertexOffset + sprite_world->m_GeometryVertexOffsets[s];
+            }
+            SpriteVertex* vertices = sprite_world->m_VertexBufferData + vertex_offset;
 
-                const float* points = geometry->m_Vertices.m_Data;
-                const float* uvs = geometry->m_Uvs.m_Data;
+            // Depending on the sprite is flipped or not, we loop the vertices forward or backward
+            // to respect face winding (and backface culling)
+            int flipx = animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal;
+            int flipy = animation_ddf->m_FlipVertical ^ component->m_FlipVertical;
+            int reverse = flipx ^ flipy;
 
-                // Depending on the sprite is flipped or not, we loop the vertices forward or backward
-                // to respect face winding (and backface culling)
-                int flipx = animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal;
-                int flipy = animation_ddf->m_FlipVertical ^ component->m_FlipVertical;
-                int reverse = flipx ^ flipy;
+            float scaleX = flipx ? -1 : 1;
+            float scaleY = flipy ? -1 : 1;
 
-                float scaleX = flipx ? -1 : 1;
-                float scaleY = flipy ? -1 : 1;
+            int step = reverse ? -2 : 2;
+            points = reverse ? points + num_points*2 - 2 : points;
+            uvs = reverse ? uvs + num_points*2 - 2 : uvs;
 
-                int step = reverse ? -2 : 2;
-                points = reverse ? points + num_points*2 - 2 : points;
-                uvs = reverse ? uvs + num_points*2 - 2 : uvs;
+            for (uint32_t vert = 0; write_vertices && vert < num_points; ++vert, ++vertices, points += step, uvs += step)
+            {
+                float x = points[0] * scaleX; // range -0.5,+0.5
+                float y = points[1] * scaleY;
+                float u = uvs[0];
+                float v = uvs[1];
+
+                Vector4 p0 = w * Point3(x, y, 0.0f);
+                vertices[0].x = ((float*)&p0)[0];
+                vertices[0].y = ((float*)&p0)[1];
+                vertices[0].z = ((float*)&p0)[2];
+                vertices[0].u = u;
+                vertices[0].v = v;
+            }
 
-                for (uint32_t vert = 0; vert < num_points; ++vert, ++vertices, points += step, uvs += step)
+            uint32_t index_count = geometry->m_Indices.m_Count;
+            uint32_t* geom_indices = geometry->m_Indices.m_Data;
+            if (sprite_world->m_Is16BitIndex)
+            {
+                for (uint32_t index = 0; index < index_count; ++index)
+                {
+                    ((uint16_t*)indices)[index] = vertex_offset + geom_indices[index];
+                }
+            }
+            else
+            {
+                for (uint32_t index = 0; index < index_count; ++index)
                 {
-                    float x = points[0] * scaleX; // range -0.5,+0.5
-                    float y = points[1] * scaleY;
-                    float u = uvs[0];
-                    float v = uvs[1];
-
-                    Vector4 p0 = w * Point3(x, y, 0.0f);
-                    vertices[0].x = ((float*)&p0)[0];
-                    vertices[0].y = ((float*)&p0)[1];
-                    vertices[0].z = ((float*)&p0)[2];
-                    vertices[0].u = u;
-                    vertices[0].v = v;
+                    ((uint32_t*)indices)[index] = vertex_offset + geom_indices[index];
                 }
+            }
+        }
+    }
+
+    // original path using quads
+    static void CreateQuadVertexData(const CreateVertexDataContext* ctx, uint32_t start, uint32_t end)
+    {
+        static int tex_coord_order[] = {
+            0,1,2,2,3,0,
+            3,2,1,1,0,3,    //h
+            1,0,3,3,2,1,    //v
+            2,3,0,0,1,2     //hv
+        };
+
+        dmGameSystemDDF::TextureSet* texture_set_ddf = ctx->m_TextureSet->m_TextureSet;
+        dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
+        const float* tex_coords = (const float*) texture_set_ddf->m_TexCoords.m_Data;
+
+        SpriteWorld* sprite_world = ctx->m_World;
+        const SpriteComponent* components = sprite_world->m_Components.m_Objects.Begin();
+        uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+        uint8_t* indices = ctx->m_Indices + start * 6 * index_type_size;
+
+        SpriteVertex* vertices = ctx->m_Vertices + start * 4;
+        for (uint32_t s = start; s != end; ++s, vertices += 4, indices += 6 * index_type_size)
+        {
+            const SpriteComponent* component = (SpriteComponent*) ctx->m_Buf[ctx->m_Begin[s]].m_UserData;
 
-                uint32_t index_count = geometry->m_Indices.m_Count;
-                uint32_t* geom_indices = geometry->m_Indices.m_Data;
+            if (sprite_world->m_PersistentVertices)
+            {
+                // The vertices are kept in the slot of the component, only the indices are written in render order
+                uint32_t slot = component - components;
+                uint32_t v = slot * 4;
                 if (sprite_world->m_Is16BitIndex)
                 {
-                    for (uint32_t index = 0; index < index_count; ++index)
-                    {
-                        ((uint16_t*)indices)[index] = vertex_offset + geom_indices[index];
-                    }
+                    fillIndices<uint16_t>((uint16_t*)indices, 6, v);
                 }
                 else
                 {
-                    for (uint32_t index = 0; index < index_count; ++index)
-                    {
-                        ((uint32_t*)indices)[index] = vertex_offset + geom_indices[index];
-                    }
+                    fillIndices<uint32_t>((uint32_t*)indices, 6, v);
                 }
-                indices += index_type_size * geometry->m_Indices.m_Count;
-                vertex_offset += num_points;
+
+                vertices = sprite_world->m_VertexBufferData + v;
+                if (!UpdateVertexKey(sprite_world, slot, component, texture_set_ddf))
+                    continue;
             }
-        }
-        else // original path using quads
-        {
-            static int tex_coord_order[] = {
-                0,1,2,2,3,0,
-                3,2,1,1,0,3,    //h
-                1,0,3,3,2,1,    //v
-                2,3,0,0,1,2     //hv
-            };
 
-            const float* tex_coords = (const float*) texture_set->m_TextureSet->m_TexCoords.m_Data;
+            dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+
+            uint32_t frame_index = animation_ddf->m_Start + component->m_CurrentAnimationFrame;
+            const float* tc = &tex_coords[frame_index * 4 * 2];
+            uint32_t flip_flag = 0;
 
-            for (uint32_t *i = begin;i != end; ++i)
+            // ddf values are guaranteed to be 0 or 1 when saved by the editor
+            // component values are guaranteed to be 0 or 1
+            if (animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal)
             {
-                const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
+                flip_flag = 1;
+            }
+            if (animation_ddf->m_FlipVertical ^ component->m_FlipVertical)
+            {
+                flip_flag |= 2;
+            }
 
-                dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+            const int* tex_lookup = &tex_coord_order[flip_flag * 6];
+
+            TransformQuadCorners(component->m_World, vertices);
+            vertices[0].u = tc[tex_lookup[0] * 2];
+            vertices[0].v = tc[tex_lookup[0] * 2 + 1];
+            vertices[1].u = tc[tex_lookup[1] * 2];
+            vertices[1].v = tc[tex_lookup[1] * 2 + 1];
+            vertices[2].u = tc[tex_lookup[2] * 2];
+            vertices[2].v = tc[tex_lookup[2] * 2 + 1];
+            vertices[3].u = tc[tex_lookup[4] * 2];
+            vertices[3].v = tc[tex_lookup[4] * 2 + 1];
+        }
+    }
 
-                uint32_t frame_index = animation_ddf->m_Start + component->m_CurrentAnimationFrame;
-                const float* tc = &tex_coords[frame_index * 4 * 2];
-                uint32_t flip_flag = 0;
+    static void CreateVertexDataTask(void* context, uint32_t index)
+    {
+        const CreateVertexDataContext* ctx = (const CreateVertexDataContext*) context;
+        uint32_t start = index * SPRITES_PER_TASK;
+        uint32_t end = dmMath::Min(start + SPRITES_PER_TASK, ctx->m_Count);
+        if (ctx->m_World->m_UseGeometries)
+            CreateGeometryVertexData(ctx, start, end);
+        else
+            CreateQuadVertexData(ctx, start, end);
+    }
 
-                // ddf values are guaranteed to be 0 or 1 when saved by the editor
-                // component values are guaranteed to be 0 or 1
-                if (animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal)
-                {
-                    flip_flag = 1;
-                }
-                if (animation_ddf->m_FlipVertical ^ component->m_FlipVertical)
-                {
-                    flip_flag |= 2;
-                }
+    static void CreateVertexData(SpriteWorld* sprite_world, SpriteVertex** vb_where, uint8_t** ib_where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(Sprite, "CreateVertexData");
 
-                const int* tex_lookup = &tex_coord_order[flip_flag * 6];
-
-                const Matrix4& w = component->m_World;
-
-                Vector4 p0 = w * Point3(-0.5f, -0.5f, 0.0f);
-                vertices[0].x = p0.getX();
-                vertices[0].y = p0.getY();
-                vertices[0].z = p0.getZ();
-                vertices[0].u = tc[tex_lookup[0] * 2];
-                vertices[0].v = tc[tex_lookup[0] * 2 + 1];
-
-                Vector4 p1 = w * Point3(-0.5f, 0.5f, 0.0f);
-                vertices[1].x = p1.getX();
-                vertices[1].y = p1.getY();
-                vertices[1].z = p1.getZ();
-                vertices[1].u = tc[tex_lookup[1] * 2];
-                vertices[1].v = tc[tex_lookup[1] * 2 + 1];
-
-                Vector4 p2 = w * Point3(0.5f, 0.5f, 0.0f);
-                vertices[2].x = p2.getX();
-                vertices[2].y = p2.getY();
-                vertices[2].z = p2.getZ();
-                vertices[2].u = tc[tex_lookup[2] * 2];
-                vertices[2].v = tc[tex_lookup[2] * 2 + 1];
-
-                Vector4 p3 = w * Point3(0.5f, -0.5f, 0.0f);
-                vertices[3].x = p3.getX();
-                vertices[3].y = p3.getY();
-                vertices[3].z = p3.getZ();
-                vertices[3].u = tc[tex_lookup[4] * 2];
-                vertices[3].v = tc[tex_lookup[4] * 2 + 1];
-
-                // for (int f = 0; f < 4; ++f)
-                //     printf("  %u: %.2f, %.2f\t%.2f, %.2f\n", f, vertices[f].x, vertices[f].y, vertices[f].u, vertices[f].v );
-
-                vertices += 4;
-                indices += 6 * index_type_size;
+        CreateVertexDataContext ctx;
+        ctx.m_World = sprite_world;
+        ctx.m_TextureSet = texture_set;
+        ctx.m_Buf = buf;
+        ctx.m_Begin = begin;
+        ctx.m_Count = end - begin;
+        ctx.m_Vertices = *vb_where;
+        ctx.m_Indices = *ib_where;
+        ctx.m_VertexOffset = *vb_where - sprite_world->m_VertexBufferData;
+
+        uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+        uint32_t vertex_count;
+        uint32_t index_count;
+
+        if (sprite_world->m_UseGeometries)
+        {
+            // Each sprite writes its vertices and indices after the ones of the previous sprite,
+            // the offsets are calculated up front for the sprites to be written in any order
+            dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+            dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
+            uint32_t* frame_indices = texture_set_ddf->m_FrameIndices.m_Data;
+            const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
+
+            dmArray<uint32_t>& vertex_offsets = sprite_world->m_GeometryVertexOffsets;
+            dmArray<uint32_t>& index_offsets = sprite_world->m_GeometryIndexOffsets;
+            if (vertex_offsets.Capacity() < ctx.m_Count)
+            {
+                vertex_offsets.SetCapacity(ctx.m_Count);
+                index_offsets.SetCapacity(ctx.m_Count);
+            }
+            vertex_offsets.SetSize(ctx.m_Count);
+            index_offsets.SetSize(ctx.m_Count);
+
+            vertex_count = 0;
+            index_count = 0;
+            for (uint32_t s = 0; s < ctx.m_Count; ++s)
+            {
+                const SpriteComponent* component = (SpriteComponent*) buf[begin[s]].m_UserData;
+                const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+                const dmGameSystemDDF::SpriteGeometry* geometry = &geometries[frame_indices[animation_ddf->m_Start + component->m_CurrentAnimationFrame]];
+                vertex_offsets[s] = vertex_count;
+                index_offsets[s] = index_count;
+                vertex_count += geometry->m_Vertices.m_Count / 2;
+                index_count += geometry->m_Indices.m_Count;
             }
         }
+        else
+        {
+            vertex_count = ctx.m_Count * 4;
+            index_count = ctx.m_Count * 6;
+        }
+
+        uint32_t task_count = (ctx.m_Count + SPRITES_PER_TASK - 1) / SPRITES_PER_TASK;
+        if (task_count > 1)
+        {
+            dmWorkerPool::Run(sprite_world->m_WorkerPool, CreateVertexDataTask, &ctx, task_count);
+        }
+        else if (task_count == 1)
+        {
+            CreateVertexDataTask(&ctx, 0);
+        }
 
-        *vb_where = vertices;
-        *ib_where = indices;
+        *vb_where = ctx.m_Vertices + vertex_count;
+        *ib_where = ctx.m_Indices + index_count * index_type_size;
     }
 
     static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
@@ -566,6 +848,7 @@ namespace dmGameSystem
         SpriteVertex* vb_iter = vb_begin;
         uint8_t* ib_iter = ib_begin;
         CreateVertexData(sprite_world, &vb_iter, &ib_iter, texture_set, buf, begin, end);
+        sprite_world->m_DispatchedCount += end - begin;
 
         sprite_world->m_VertexBufferWritePtr = vb_iter;
         sprite_world->m_IndexBufferWritePtr = ib_iter;
@@ -643,37 +926,65 @@ namespace dmGameSystem
 
         // Note: We update all sprites, even though they might be disabled, or not added to update
 
-        if (scale_along_z) {
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                SpriteComponent* c = &components[i];
-                Matrix4 local = dmTransform::ToMatrix4(dmTransform::Transform(c->m_Position, c->m_Rotation, 1.0f));
-                Matrix4 world = dmGameObject::GetWorldMatrix(c->m_Instance);
-                Vector3 size( c->m_Size.getX() * c->m_Scale.getX(), c->m_Size.getY() * c->m_Scale.getY(), 1);
-                c->m_World = appendScale(world * local, size);
-            }
-        } else
+        // The sprite size and scale are folded into the local scale, appendScale(world * local, size) == world * (local * scale(size))
+        dmTransform::TransformSoA& locals = sprite_world->m_LocalTransforms;
+        locals.SetSize(n);
+        if (sprite_world->m_WorldTransforms.Capacity() < n)
         {
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                SpriteComponent* c = &components[i];
-                Matrix4 local = dmTransform::ToMatrix4(dmTransform::Transform(c->m_Position, c->m_Rotation, 1.0f));
-                Matrix4 world = dmGameObject::GetWorldMatrix(c->m_Instance);
-                Matrix4 w = dmTransform::MulNoScaleZ(world, local);
-                Vector3 size( c->m_Size.getX() * c->m_Scale.getX(), c->m_Size.getY() * c->m_Scale.getY(), 1);
-                c->m_World = appendScale(w, size);
-            }
+            sprite_world->m_WorldTransforms.SetCapacity(n);
+            sprite_world->m_ParentTransforms.SetCapacity(n);
+        }
+        sprite_world->m_WorldTransforms.SetSize(n);
+        sprite_world->m_ParentTransforms.SetSize(n);
+        Matrix4* world_transforms = sprite_world->m_WorldTransforms.Begin();
+        const Matrix4** parent_transforms = sprite_world->m_ParentTransforms.Begin();
+
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            SpriteComponent* c = &components[i];
+            Vector3 size( c->m_Size.getX() * c->m_Scale.getX(), c->m_Size.getY() * c->m_Scale.getY(), 1);
+            locals.Set(i, c->m_Position, c->m_Rotation, size);
+            parent_transforms[i] = &dmGameObject::GetWorldMatrix(c->m_Instance);
+        }
+
+        dmTransform::ToMatrix4(locals, world_transforms);
+        if (scale_along_z) {
+            dmTransform::Mul(parent_transforms, world_transforms, world_transforms, n);
+        } else {
+            dmTransform::MulNoScaleZ(parent_transforms, world_transforms, world_transforms, n);
         }
 
         // The "sub_pixels" is set by default
         if (!sub_pixels) {
             for (uint32_t i = 0; i < n; ++i) {
-                SpriteComponent* c = &components[i];
-                Vector4 position = c->m_World.getCol3();
+                Vector4 position = world_transforms[i].getCol3();
                 position.setX((int) position.getX());
                 position.setY((int) position.getY());
-                c->m_World.setCol3(position);
+                world_transforms[i].setCol3(position);
+            }
+        }
+
+        // Only the proxies of sprites that changed transform are moved in the spatial tree
+        dmRender::HSpatialTree tree = sprite_world->m_SpatialTree;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            SpriteComponent* c = &components[i];
+            const Matrix4& world = world_transforms[i];
+            if (c->m_SpatialProxy != dmRender::INVALID_SPATIAL_PROXY && IsSameTransform(c->m_World, world))
+                continue;
+
+            Point3 min, max;
+            GetBounds(world, min, max);
+            if (c->m_SpatialProxy == dmRender::INVALID_SPATIAL_PROXY)
+            {
+                c->m_SpatialProxy = dmRender::CreateSpatialProxy(tree, min, max, (uintptr_t) c->m_Instance);
+            }
+            else
+            {
+                const Vector3 displacement = (world.getCol3() - c->m_World.getCol3()).getXYZ();
+                dmRender::MoveSpatialProxy(tree, c->m_SpatialProxy, min, max, displacement);
             }
+            c->m_World = world;
         }
     }
 
@@ -840,6 +1151,52 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    /// Dirty slots separated by at most this many clean slots are uploaded as one range
+    static const uint32_t MAX_CLEAN_SLOTS_IN_RANGE = 16;
+
+    // Uploads the vertices of the slots rewritten since the last upload, returns the number of rewritten slots
+    static uint32_t UploadDirtySlots(SpriteWorld* world)
+    {
+        DM_PROFILE(Sprite, "UploadDirtySlots");
+
+        uint32_t vertex_count = GetMaxVertexCountPerSprite(world);
+        uint32_t slot_size = sizeof(SpriteVertex) * vertex_count;
+        uint8_t* dirty = world->m_DirtySlots.Begin();
+        // Only slots of live components are written
+        uint32_t n = world->m_Components.m_Objects.Size();
+        uint32_t rewritten = 0;
+        uint32_t uploaded = 0;
+
+        uint32_t i = 0;
+        while (i < n)
+        {
+            if (!dirty[i])
+            {
+                ++i;
+                continue;
+            }
+
+            uint32_t first = i;
+            uint32_t last = i;
+            for (; i < n && i - last <= MAX_CLEAN_SLOTS_IN_RANGE; ++i)
+            {
+                if (dirty[i])
+                {
+                    dirty[i] = 0;
+                    last = i;
+                    ++rewritten;
+                }
+            }
+
+            uint32_t size = (last + 1 - first) * slot_size;
+            dmGraphics::SetVertexBufferSubData(world->m_VertexBuffer, first * slot_size, size, world->m_VertexBufferData + first * vertex_count);
+            uploaded += size;
+        }
+
+        DM_COUNTER("SpriteVertexBuffer", uploaded);
+        return rewritten;
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         SpriteWorld* world = (SpriteWorld*) params.m_UserData;
@@ -850,8 +1207,21 @@ namespace dmGameSystem
                 world->m_VertexBufferWritePtr = world->m_VertexBufferData;
                 world->m_IndexBufferWritePtr = world->m_IndexBufferData;
                 world->m_RenderObjects.SetSize(0);
+                world->m_DispatchedCount = 0;
                 break;
             case dmRender::RENDER_LIST_OPERATION_END:
+                if (world->m_PersistentVertices)
+                {
+                    uint32_t rewritten = UploadDirtySlots(world);
+                    DM_COUNTER("SpriteRewritten", rewritten);
+                    DM_COUNTER("SpriteReused", world->m_DispatchedCount - rewritten);
+
+                    uint32_t index_size = (world->m_IndexBufferWritePtr - world->m_IndexBufferData);
+                    dmGraphics::SetIndexBufferData(world->m_IndexBuffer, index_size, world->m_IndexBufferData, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+                    DM_COUNTER("SpriteIndexBuffer", index_size);
+                    break;
+                }
+
                 dmGraphics::SetVertexBufferData(world->m_VertexBuffer, sizeof(SpriteVertex) * (world->m_VertexBufferWritePtr - world->m_VertexBufferData),
                                                 world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
 
@@ -887,9 +1257,8 @@ namespace dmGameSystem
 
         if (sprite_world->m_ReallocBuffers)
         {
-            // Old version has always 4 vertices. New version has up to 8 vertices.
-            // We will allocate for this upper bound
-            uint32_t num_vertices_per_sprite = sprite_world->m_UseGeometries ? 8 : 4;
+            // We will allocate for the upper bound of vertices per sprite
+            uint32_t num_vertices_per_sprite = GetMaxVertexCountPerSprite(sprite_world);
             uint32_t num_indices_per_sprite = (num_vertices_per_sprite - 2) * 3;
             ReAllocateBuffers(sprite_world, render_context, sprite_context->m_MaxSpriteCount, num_vertices_per_sprite, num_indices_per_sprite);
         }
@@ -912,6 +1281,8 @@ namespace dmGameSystem
 
             const Vector4 trans = component.m_World.getCol(3);
             write_ptr->m_WorldPosition = Point3(trans.getX(), trans.getY(), trans.getZ());
+            write_ptr->m_SpatialProxy = component.m_SpatialProxy;
+            write_ptr->m_HasSpatialProxy = 1;
             write_ptr->m_UserData = (uintptr_t) &component;
             write_ptr->m_BatchKey = component.m_MixedHash;
             write_ptr->m_TagMask = dmRender::GetMaterialTagMask(GetMaterial(&component, component.m_Resource));
@@ -979,46 +1350,44 @@ namespace dmGameSystem
         return component->m_PlaybackRate;
     }
 
-    dmGameObject::UpdateResult CompSpriteOnMessage(const dmGameObject::ComponentOnMessageParams& params)
+    static void OnMessage(SpriteComponent* component, dmMessage::Message* message)
     {
-        SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
-        SpriteComponent* component = &sprite_world->m_Components.Get(*params.m_UserData);
-        if (params.m_Message->m_Id == dmGameObjectDDF::Enable::m_DDFDescriptor->m_NameHash)
+        if (message->m_Id == dmGameObjectDDF::Enable::m_DDFDescriptor->m_NameHash)
         {
             component->m_Enabled = 1;
         }
-        else if (params.m_Message->m_Id == dmGameObjectDDF::Disable::m_DDFDescriptor->m_NameHash)
+        else if (message->m_Id == dmGameObjectDDF::Disable::m_DDFDescriptor->m_NameHash)
         {
             component->m_Enabled = 0;
         }
-        else if (params.m_Message->m_Descriptor != 0x0)
+        else if (message->m_Descriptor != 0x0)
         {
-            if (params.m_Message->m_Id == dmGameSystemDDF::PlayAnimation::m_DDFDescriptor->m_NameHash)
+            if (message->m_Id == dmGameSystemDDF::PlayAnimation::m_DDFDescriptor->m_NameHash)
             {
-                dmGameSystemDDF::PlayAnimation* ddf = (dmGameSystemDDF::PlayAnimation*)params.m_Message->m_Data;
+                dmGameSystemDDF::PlayAnimation* ddf = (dmGameSystemDDF::PlayAnimation*)message->m_Data;
                 if (PlayAnimation(component, ddf->m_Id, ddf->m_Offset, ddf->m_PlaybackRate))
                 {
-                    component->m_Listener = params.m_Message->m_Sender;
+                    component->m_Listener = message->m_Sender;
                 }
             }
-            else if (params.m_Message->m_Id == dmGameSystemDDF::SetFlipHorizontal::m_DDFDescriptor->m_NameHash)
+            else if (message->m_Id == dmGameSystemDDF::SetFlipHorizontal::m_DDFDescriptor->m_NameHash)
             {
-                dmGameSystemDDF::SetFlipHorizontal* ddf = (dmGameSystemDDF::SetFlipHorizontal*)params.m_Message->m_Data;
+                dmGameSystemDDF::SetFlipHorizontal* ddf = (dmGameSystemDDF::SetFlipHorizontal*)message->m_Data;
                 component->m_FlipHorizontal = ddf->m_Flip != 0 ? 1 : 0;
             }
-            else if (params.m_Message->m_Id == dmGameSystemDDF::SetFlipVertical::m_DDFDescriptor->m_NameHash)
+            else if (message->m_Id == dmGameSystemDDF::SetFlipVertical::m_DDFDescriptor->m_NameHash)
             {
-                dmGameSystemDDF::SetFlipVertical* ddf = (dmGameSystemDDF::SetFlipVertical*)params.m_Message->m_Data;
+                dmGameSystemDDF::SetFlipVertical* ddf = (dmGameSystemDDF::SetFlipVertical*)message->m_Data;
                 component->m_FlipVertical = ddf->m_Flip != 0 ? 1 : 0;
             }
-            else if (params.m_Message->m_Id == dmGameSystemDDF::SetConstant::m_DDFDescriptor->m_NameHash)
+            else if (message->m_Id == dmGameSystemDDF::SetConstant::m_DDFDescriptor->m_NameHash)
             {
-                dmGameSystemDDF::SetConstant* ddf = (dmGameSystemDDF::SetConstant*)params.m_Message->m_Data;
+                dmGameSystemDDF::SetConstant* ddf = (dmGameSystemDDF::SetConstant*)message->m_Data;
                 dmGameObject::PropertyResult result = dmGameSystem::SetMaterialConstant(GetMaterial(component, component->m_Resource), ddf->m_NameHash,
                         dmGameObject::PropertyVar(ddf->m_Value), CompSpriteSetConstantCallback, component);
                 if (result == dmGameObject::PROPERTY_RESULT_NOT_FOUND)
                 {
-                    dmMessage::URL& receiver = params.m_Message->m_Receiver;
+                    dmMessage::URL& receiver = message->m_Receiver;
                     dmLogError("'%s:%s#%s' has no constant named '%s'",
                             dmMessage::GetSocketName(receiver.m_Socket),
                             dmHashReverseSafe64(receiver.m_Path),
@@ -1026,21 +1395,68 @@ namespace dmGameSystem
                             dmHashReverseSafe64(ddf->m_NameHash));
                 }
             }
-            else if (params.m_Message->m_Id == dmGameSystemDDF::ResetConstant::m_DDFDescriptor->m_NameHash)
+            else if (message->m_Id == dmGameSystemDDF::ResetConstant::m_DDFDescriptor->m_NameHash)
             {
-                dmGameSystemDDF::ResetConstant* ddf = (dmGameSystemDDF::ResetConstant*)params.m_Message->m_Data;
+                dmGameSystemDDF::ResetConstant* ddf = (dmGameSystemDDF::ResetConstant*)message->m_Data;
                 if (dmGameSystem::ClearRenderConstant(&component->m_RenderConstants, ddf->m_NameHash))
                 {
                     component->m_ReHash = 1;
                 }
             }
-            else if (params.m_Message->m_Id == dmGameSystemDDF::SetScale::m_DDFDescriptor->m_NameHash)
+            else if (message->m_Id == dmGameSystemDDF::SetScale::m_DDFDescriptor->m_NameHash)
             {
-                dmGameSystemDDF::SetScale* ddf = (dmGameSystemDDF::SetScale*)params.m_Message->m_Data;
+                dmGameSystemDDF::SetScale* ddf = (dmGameSystemDDF::SetScale*)message->m_Data;
                 component->m_Scale = ddf->m_Scale;
             }
         }
+    }
+
+    dmGameObject::UpdateResult CompSpriteOnMessage(const dmGameObject::ComponentOnMessageParams& params)
+    {
+        SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
+        SpriteComponent* component = &sprite_world->m_Components.Get(*params.m_UserData);
+        OnMessage(component, params.m_Message);
+        return dmGameObject::UPDATE_RESULT_OK;
+    }
+
+    dmGameObject::UpdateResult CompSpriteOnMessages(const dmGameObject::ComponentOnMessagesParams& params)
+    {
+        SpriteWorld* sprite_world = (SpriteWorld*)params.m_World;
+        SpriteComponent* component = &sprite_world->m_Components.Get(*params.m_UserData);
+
+        // Only the last play_animation of the group decides the animation state, as long as it refers to an existing animation.
+        // The earlier ones are then only checked for unknown animation ids, to report the same errors as one-by-one dispatch.
+        uint32_t last_play = params.m_MessageCount;
+        for (uint32_t i = params.m_MessageCount; i > 0; --i)
+        {
+            dmMessage::Message* message = params.m_Messages[i - 1];
+            if (message->m_Descriptor != 0x0 && message->m_Id == dmGameSystemDDF::PlayAnimation::m_DDFDescriptor->m_NameHash)
+            {
+                dmGameSystemDDF::PlayAnimation* ddf = (dmGameSystemDDF::PlayAnimation*)message->m_Data;
+                if (GetTextureSet(component, component->m_Resource)->m_AnimationIds.Get(ddf->m_Id))
+                {
+                    last_play = i - 1;
+                }
+                break;
+            }
+        }
 
+        for (uint32_t i = 0; i < params.m_MessageCount; ++i)
+        {
+            dmMessage::Message* message = params.m_Messages[i];
+            if (i < last_play && last_play != params.m_MessageCount
+                && message->m_Descriptor != 0x0 && message->m_Id == dmGameSystemDDF::PlayAnimation::m_DDFDescriptor->m_NameHash)
+            {
+                dmGameSystemDDF::PlayAnimation* ddf = (dmGameSystemDDF::PlayAnimation*)message->m_Data;
+                TextureSetResource* texture_set = GetTextureSet(component, component->m_Resource);
+                if (texture_set->m_AnimationIds.Get(ddf->m_Id) == 0x0)
+                {
+                    dmLogError("Unable to play animation '%s' from texture '%s' since it could not be found.", dmHashReverseSafe64(ddf->m_Id), dmHashReverseSafe64(texture_set->m_TexturePath));
+                }
+                continue;
+            }
+            OnMessage(component, message);
+        }
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
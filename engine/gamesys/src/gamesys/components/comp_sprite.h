@@ -33,6 +33,8 @@ namespace dmGameSystem
 
     dmGameObject::UpdateResult CompSpriteOnMessage(const dmGameObject::ComponentOnMessageParams& params);
 
+    dmGameObject::UpdateResult CompSpriteOnMessages(const dmGameObject::ComponentOnMessagesParams& params);
+
     void CompSpriteOnReload(const dmGameObject::ComponentOnReloadParams& params);
 
     dmGameObject::PropertyResult CompSpriteGetProperty(const dmGameObject::ComponentGetPropertyParams& params, dmGameObject::PropertyDesc& out_value);
@@ -715,6 +715,25 @@ namespace dmGameSystem
         return num_render_entries;
     }
 
+    // Calculates the radius of a sphere around the world space render position of a region in a layer that contains the region
+    static float CalculateRegionBoundingRadius(const TileGridComponent* component, uint32_t region_x, uint32_t region_y, float z, uint32_t tile_width, uint32_t tile_height, const Point3& position)
+    {
+        const TileGridResource* resource = component->m_Resource;
+        int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
+        int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
+        int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)resource->m_ColumnCount);
+        int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)resource->m_RowCount);
+
+        // The region is a convex parallelogram in world space, so the farthest corner bounds it
+        const Matrix4& w = component->m_World;
+        const Vector3 p = Vector3(position);
+        float radius = length((w * Point3(min_x * (float)tile_width, min_y * (float)tile_height, z)).getXYZ() - p);
+        radius = dmMath::Max(radius, length((w * Point3(max_x * (float)tile_width, min_y * (float)tile_height, z)).getXYZ() - p));
+        radius = dmMath::Max(radius, length((w * Point3(min_x * (float)tile_width, max_y * (float)tile_height, z)).getXYZ() - p));
+        radius = dmMath::Max(radius, length((w * Point3(max_x * (float)tile_width, max_y * (float)tile_height, z)).getXYZ() - p));
+        return radius;
+    }
+
     dmGameObject::UpdateResult CompTileGridRender(const dmGameObject::ComponentsRenderParams& params)
     {
         TilemapContext* context = (TilemapContext*)params.m_Context;
@@ -771,6 +790,7 @@ namespace dmGameSystem
                         Vector4 trans = component->m_World * Point3(x * tile_width, y * tile_height, layer_ddf->m_Z);
 
                         write_ptr->m_WorldPosition = Point3(trans.getXYZ());
+                        write_ptr->m_BoundingRadius = CalculateRegionBoundingRadius(component, x, y, layer_ddf->m_Z, tile_width, tile_height, write_ptr->m_WorldPosition);
                         write_ptr->m_UserData = EncodeRegionInfo(i, l, x, y);
                         write_ptr->m_TagMask = dmRender::GetMaterialTagMask(GetMaterial(component));
                         write_ptr->m_BatchKey = component->m_MixedHash;
@@ -144,6 +144,19 @@ namespace dmGameSystem
 
 #undef REGISTER_RESOURCE_TYPE
 
+        // These types only parse, copy or (animation sets) compress their data in Create, without the factory,
+        // so a preloader may create them on the load thread. Buffers are not included, dmBuffer::Create isn't thread safe.
+        const char* thread_safe_create[] = { "camerac", "lightc", "gamepadsc", "wavc", "oggc",
+                                             "collectionproxyc", "animationsetc", "meshsetc", "skeletonc" };
+        for (uint32_t i = 0; i < sizeof(thread_safe_create) / sizeof(thread_safe_create[0]); ++i)
+        {
+            e = dmResource::SetThreadSafeCreate(factory, thread_safe_create[i], true);
+            if (e != dmResource::RESULT_OK)
+            {
+                return e;
+            }
+        }
+
         return e;
     }
 
@@ -223,7 +236,7 @@ namespace dmGameSystem
 
         REGISTER_COMPONENT_TYPE("guic", 300, gui_context,
                 CompGuiNewWorld, CompGuiDeleteWorld,
-                CompGuiCreate, CompGuiDestroy, CompGuiInit, CompGuiFinal, CompGuiAddToUpdate, 0,
+                CompGuiCreate, CompGuiDestroy, CompGuiInit, CompGuiFinal, CompGuiAddToUpdate, CompGuiGetComponent,
                 CompGuiUpdate, CompGuiRender, 0, CompGuiOnMessage, CompGuiOnInput, CompGuiOnReload, CompGuiGetProperty, CompGuiSetProperty,
                 0);
 
@@ -292,6 +305,9 @@ namespace dmGameSystem
                 CompSpriteCreate, CompSpriteDestroy, 0, 0, CompSpriteAddToUpdate, 0,
                 CompSpriteUpdate, CompSpriteRender, 0, CompSpriteOnMessage, 0, CompSpriteOnReload, CompSpriteGetProperty, CompSpriteSetProperty,
                 1);
+        go_result = dmGameObject::SetOnMessagesFunction(regist, type, CompSpriteOnMessages);
+        if (go_result != dmGameObject::RESULT_OK)
+            return go_result;
 
         REGISTER_COMPONENT_TYPE(TILE_MAP_EXT, 1200, tilemap_context,
                 CompTileGridNewWorld, CompTileGridDeleteWorld,
@@ -14,6 +14,7 @@
 #define DM_GAMESYS_H
 
 #include <dlib/configfile.h>
+#include <dlib/worker_pool.h>
 
 #include <script/script.h>
 
@@ -86,6 +87,7 @@ namespace dmGameSystem
         dmRender::HRenderContext m_RenderContext;
         uint32_t m_MaxParticleFXCount;
         uint32_t m_MaxParticleCount;
+        dmWorkerPool::HWorkerPool m_WorkerPool;
         bool m_Debug;
     };
 
@@ -118,8 +120,11 @@ namespace dmGameSystem
             memset(this, 0, sizeof(*this));
         }
         dmRender::HRenderContext    m_RenderContext;
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxSpriteCount;
         uint32_t                    m_Subpixels : 1;
+        /// Keep the vertices of each sprite between frames and only rewrite the ones that changed
+        uint32_t                    m_PersistentVertexBuffer : 1;
     };
 
     struct SpineModelContext
@@ -130,6 +135,7 @@ namespace dmGameSystem
         }
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxSpineModelCount;
     };
 
@@ -141,6 +147,7 @@ namespace dmGameSystem
         }
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxModelCount;
     };
 
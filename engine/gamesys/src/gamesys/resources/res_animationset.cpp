@@ -20,11 +20,24 @@ namespace dmGameSystem
 
     dmResource::Result AcquireResources(dmResource::HFactory factory, AnimationSetResource* resource, const char* filename)
     {
+        resource->m_CompressedAnimationSet = dmRig::CompressAnimationSet(*resource->m_AnimationSet);
+
+        // The bone tracks are sampled from the compressed set, only keep the rest of the message resident
+        uint32_t size = 0;
+        dmRigDDF::AnimationSet* animation_set = dmRig::CopyAnimationSetWithoutBoneTracks(resource->m_AnimationSet, &size);
+        if (animation_set != 0x0)
+        {
+            dmDDF::FreeMessage(resource->m_AnimationSet);
+            resource->m_AnimationSet = animation_set;
+        }
         return dmResource::RESULT_OK;
     }
 
     static void ReleaseResources(dmResource::HFactory factory, AnimationSetResource* resource)
     {
+        if (resource->m_CompressedAnimationSet != 0x0)
+            dmRig::DeleteCompressedAnimationSet(resource->m_CompressedAnimationSet);
+        resource->m_CompressedAnimationSet = 0x0;
         if (resource->m_AnimationSet != 0x0)
             dmDDF::FreeMessage(resource->m_AnimationSet);
     }
@@ -16,6 +16,7 @@
 #include <stdint.h>
 
 #include <resource/resource.h>
+#include <rig/rig.h>
 #include <rig/rig_ddf.h>
 
 namespace dmGameSystem
@@ -23,6 +24,8 @@ namespace dmGameSystem
     struct AnimationSetResource
     {
         dmRigDDF::AnimationSet* m_AnimationSet;
+        /// Bone tracks of the animation set in the compressed runtime format
+        dmRig::CompressedAnimationSet* m_CompressedAnimationSet;
     };
 
     dmResource::Result ResAnimationSetPreload(const dmResource::ResourcePreloadParams& params);
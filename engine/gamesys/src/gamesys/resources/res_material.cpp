@@ -109,6 +109,7 @@ namespace dmGameSystem
             {
                 dmLogWarning("Reloading the material failed, some shaders might not have been correctly linked.");
             }
+            dmRender::ClearMaterialAttributeLocations(material);
         }
     }
 
@@ -13,11 +13,28 @@
 #include "res_rig_scene.h"
 
 #include <dlib/log.h>
+#include <dlib/math.h>
 
 namespace dmGameSystem
 {
     using namespace Vectormath::Aos;
 
+    static float GetBoundingRadius(const dmRigDDF::MeshSet* mesh_set)
+    {
+        float max_sq_length = 0.0f;
+        for (uint32_t mi = 0; mi < mesh_set->m_MeshAttachments.m_Count; ++mi)
+        {
+            const dmRigDDF::Mesh& mesh = mesh_set->m_MeshAttachments[mi];
+            const float* positions = mesh.m_Positions.m_Data;
+            const uint32_t vertex_count = mesh.m_Positions.m_Count / 3;
+            for (uint32_t vi = 0; vi < vertex_count; ++vi, positions += 3)
+            {
+                max_sq_length = dmMath::Max(max_sq_length, positions[0] * positions[0] + positions[1] * positions[1] + positions[2] * positions[2]);
+            }
+        }
+        return sqrtf(max_sq_length);
+    }
+
     dmResource::Result AcquireResources(dmResource::HFactory factory, RigSceneResource* resource, const char* filename, bool reload)
     {
         dmResource::Result result;
@@ -79,6 +96,8 @@ namespace dmGameSystem
                 return result;
         }
 
+        resource->m_BoundingRadius = GetBoundingRadius(resource->m_MeshSetRes->m_MeshSet);
+
         if (result == dmResource::RESULT_OK && resource->m_SkeletonRes)
         {
             dmRig::CreateBindPose(*resource->m_SkeletonRes->m_Skeleton, resource->m_BindPose);
@@ -39,6 +39,8 @@ namespace dmGameSystem
 
         dmArray<uint32_t>       m_PoseIdxToInfluence;
         dmArray<uint32_t>       m_TrackIdxToPose;
+        /// Radius of a sphere around the model space origin enclosing the mesh attachments in bind pose
+        float                   m_BoundingRadius;
     };
 
     dmResource::Result ResRigScenePreload(const dmResource::ResourcePreloadParams& params);
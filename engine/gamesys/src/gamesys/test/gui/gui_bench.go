@@ -0,0 +1,20 @@
+components {
+  id: "gui1"
+  component: "/gui/gui_bench.gui"
+}
+components {
+  id: "gui2"
+  component: "/gui/gui_bench.gui"
+}
+components {
+  id: "gui3"
+  component: "/gui/gui_bench.gui"
+}
+components {
+  id: "gui4"
+  component: "/gui/gui_bench.gui"
+}
+components {
+  id: "gui5"
+  component: "/gui/gui_bench.gui"
+}
@@ -0,0 +1,4 @@
+components {
+  id: "gui"
+  component: "/gui/gui_cache.gui"
+}
@@ -16,12 +16,14 @@
 #include "../../../../resource/src/resource_private.h"
 
 #include "gamesys/resources/res_textureset.h"
+#include "gamesys/components/comp_gui.h"
 
 #include <stdio.h>
 
 #include <dlib/dstrings.h>
 #include <dlib/time.h>
 #include <dlib/path.h>
+#include <dlib/profile.h>
 
 #include <ddf/ddf.h>
 #include <gameobject/gameobject_ddf.h>
@@ -550,6 +552,225 @@ TEST_F(SpriteAnimTest, GoDeletion)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+struct ProfileCounterQuery
+{
+    const char* m_Name;
+    uint32_t    m_Value;
+};
+
+static void GetProfileCounter(void* context, const dmProfile::CounterData* counter)
+{
+    ProfileCounterQuery* query = (ProfileCounterQuery*)context;
+    if (strcmp(counter->m_Counter->m_Name, query->m_Name) == 0)
+    {
+        query->m_Value = counter->m_Value;
+    }
+}
+
+// The value of a profile counter since the last dmProfile::Begin/Release
+static uint32_t ReadProfileCounter(const char* name)
+{
+    ProfileCounterQuery query = {name, 0};
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::IterateCounterData(profile, &query, GetProfileCounter);
+    dmProfile::Release(profile);
+    return query.m_Value;
+}
+
+// Renders 51200 sprites (3200 game objects with 16 sprites each) through the null graphics device, of which
+// a tenth move every frame. The vertex data is generated on the calling thread, on the worker pool and
+// with a persistent vertex buffer where only the moving sprites are rewritten
+TEST_F(SpriteBenchTest, BenchRender)
+{
+    const uint32_t instance_count = 3200;
+    const uint32_t moving_count = instance_count / 10;
+    const uint32_t sprite_count = instance_count * 16;
+    const uint32_t frame_count = 20;
+
+    dmWorkerPool::HWorkerPool worker_pool = dmWorkerPool::New("sprite_bench", 3);
+    dmWorkerPool::HWorkerPool worker_pools[] = { 0, worker_pool, worker_pool };
+    bool persistent[] = { false, false, true };
+    const char* names[] = { "calling thread", "worker pool", "persistent vertex buffer" };
+    uint64_t draw_counts[3];
+
+    dmArray<dmGameObject::HInstance> instances;
+    instances.SetCapacity(instance_count);
+    for (uint32_t p = 0; p < 3; ++p)
+    {
+        NewCollection(sprite_count, instance_count, worker_pools[p], persistent[p]);
+        SetViewProjection(64 * 16.0f, (instance_count / 64) * 16.0f + frame_count);
+        ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+        instances.SetSize(0);
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            char id[32];
+            dmSnPrintf(id, sizeof(id), "/bench%u", i);
+            Point3 position((float)(i % 64) * 16.0f, (float)(i / 64) * 16.0f, 0.0f);
+            dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/sprite/sprite_bench.goc", dmHashString64(id), 0, 0, position, Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+            ASSERT_NE((void*)0, go);
+            instances.Push(go);
+        }
+
+        uint64_t time = 0;
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            for (uint32_t i = 0; i < moving_count; ++i)
+            {
+                dmGameObject::SetPosition(instances[i], dmGameObject::GetPosition(instances[i]) + Vector3(0.0f, 1.0f, 0.0f));
+            }
+            ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+            dmProfile::Release(dmProfile::Begin());
+            uint64_t start = dmTime::GetTime();
+            dmRender::RenderListBegin(m_RenderContext);
+            dmGameObject::Render(m_Collection);
+            dmRender::RenderListEnd(m_RenderContext);
+            dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0);
+            time += dmTime::GetTime() - start;
+            draw_counts[p] = dmGraphics::GetDrawCount();
+            ASSERT_EQ(0u, ReadProfileCounter("RenderListCulled"));
+
+            ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+            dmGraphics::Flip(m_GraphicsContext);
+        }
+
+        printf("Render %u sprites, %s: %.2f ms/frame\n", sprite_count, names[p], time / 1000.0 / frame_count);
+
+        ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    }
+
+    ASSERT_EQ(draw_counts[0], draw_counts[1]);
+    ASSERT_EQ(draw_counts[0], draw_counts[2]);
+
+    NewCollection(32, 1024, 0, false);
+    dmWorkerPool::Delete(worker_pool);
+}
+
+// Renders the same frames with and without a persistent vertex buffer and compares the drawn vertices.
+// With the persistent vertex buffer, only the slots of moved, re-animated and respawned sprites are uploaded
+TEST_F(SpriteBenchTest, PersistentVertexBuffer)
+{
+    const uint32_t instance_count = 8;
+    // The sprite world is full, a spawned sprite can only use the slot of a deleted one
+    const uint32_t sprite_count = instance_count * 16 + 1;
+    const uint32_t frame_count = 7;
+
+    dmhash_t cursor_id = dmHashString64("/cursor");
+    dmhash_t sprite_comp_id = dmHashString64("sprite");
+
+    uint32_t hashes[2][frame_count];
+    uint64_t draw_counts[2][frame_count];
+    uint64_t upload_sizes[2][frame_count];
+
+    dmArray<dmGameObject::HInstance> instances;
+    instances.SetCapacity(instance_count);
+    for (uint32_t p = 0; p < 2; ++p)
+    {
+        NewCollection(sprite_count, 1024, 0, p == 1);
+        SetViewProjection(instance_count * 16.0f, 64.0f);
+        ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+        instances.SetSize(0);
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            char id[32];
+            dmSnPrintf(id, sizeof(id), "/bench%u", i);
+            Point3 position((float)i * 16.0f, 0.0f, 0.0f);
+            dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/sprite/sprite_bench.goc", dmHashString64(id), 0, 0, position, Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+            ASSERT_NE((void*)0, go);
+            instances.Push(go);
+        }
+        dmGameObject::HInstance cursor_go = Spawn(m_Factory, m_Collection, "/sprite/cursor.goc", cursor_id, 0, 0, Point3(0, 32.0f, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+        ASSERT_NE((void*)0, cursor_go);
+
+        dmMessage::URL msg_url;
+        dmMessage::ResetURL(msg_url);
+        msg_url.m_Socket = dmGameObject::GetMessageSocket(m_Collection);
+        msg_url.m_Path = cursor_id;
+        msg_url.m_Fragment = sprite_comp_id;
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            m_UpdateContext.m_DT = 0.0f;
+            switch (frame)
+            {
+                case 2:
+                    dmGameObject::SetPosition(instances[1], dmGameObject::GetPosition(instances[1]) + Vector3(0.0f, 1.0f, 0.0f));
+                    break;
+                case 3:
+                    // The flipbook advances one frame per second
+                    m_UpdateContext.m_DT = 1.0f;
+                    break;
+                case 4:
+                {
+                    dmGameSystemDDF::PlayAnimation msg;
+                    msg.m_Id = dmHashString64("anim_once_back");
+                    msg.m_Offset = 0.0f;
+                    msg.m_PlaybackRate = 1.0f;
+                    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&msg_url, &msg_url, dmGameSystemDDF::PlayAnimation::m_DDFDescriptor->m_NameHash, (uintptr_t)cursor_go, (uintptr_t)dmGameSystemDDF::PlayAnimation::m_DDFDescriptor, &msg, sizeof(msg), 0));
+                    break;
+                }
+                case 5:
+                    // The components of the last game object are moved into the freed slots
+                    dmGameObject::Delete(m_Collection, instances[2], false);
+                    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+                    break;
+                case 6:
+                {
+                    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/sprite/sprite_bench.goc", dmHashString64("/respawned"), 0, 0, Point3(0, 64.0f, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+                    ASSERT_NE((void*)0, go);
+                    break;
+                }
+            }
+            ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+            dmRender::RenderListBegin(m_RenderContext);
+            dmGameObject::Render(m_Collection);
+            dmRender::RenderListEnd(m_RenderContext);
+            dmProfile::Release(dmProfile::Begin());
+            dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0);
+            ASSERT_EQ(0u, ReadProfileCounter("RenderListCulled"));
+            hashes[p][frame] = dmGraphics::GetDrawVertexHash();
+            draw_counts[p][frame] = dmGraphics::GetDrawCount();
+            upload_sizes[p][frame] = dmGraphics::GetVertexUploadSize();
+
+            ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+            dmGraphics::Flip(m_GraphicsContext);
+        }
+
+        ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    }
+
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        ASSERT_EQ(draw_counts[0][frame], draw_counts[1][frame]);
+        ASSERT_EQ(hashes[0][frame], hashes[1][frame]);
+    }
+    // Every frame changes the drawn vertices, except the unchanged frame 1
+    for (uint32_t frame = 2; frame < frame_count; ++frame)
+    {
+        ASSERT_NE(hashes[1][frame - 1], hashes[1][frame]);
+    }
+    ASSERT_EQ(hashes[1][0], hashes[1][1]);
+
+    // Nothing is uploaded when nothing changed, the moved, re-animated and respawned sprites
+    // rewrite only their own slots
+    uint64_t* uploads = upload_sizes[1];
+    ASSERT_EQ(0u, uploads[1]);
+    for (uint32_t frame = 2; frame < frame_count; ++frame)
+    {
+        ASSERT_LT(0u, uploads[frame]);
+        ASSERT_GT(uploads[0], uploads[frame]);
+        ASSERT_GT(upload_sizes[0][frame], uploads[frame]);
+    }
+    // A single re-animated sprite rewrites less than the 16 sprites of a moved game object
+    ASSERT_GT(uploads[2], uploads[3]);
+    ASSERT_GT(uploads[2], uploads[4]);
+
+    NewCollection(32, 1024, 0, false);
+}
+
 static float GetFloatProperty(dmGameObject::HInstance go, dmhash_t component_id, dmhash_t property_id)
 {
     dmGameObject::PropertyDesc property_desc;
@@ -1110,6 +1331,298 @@ TEST_P(DrawCountTest, DrawCount)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+// An emitter with a compact particle material is drawn as one instanced draw call, one instance per particle
+TEST_F(ComponentTest, ParticleFXCompactInstanced)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/particlefx/compact_particlefx.goc", dmHashString64("/go"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    for (uint32_t frame = 0; frame < 10; ++frame)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    }
+
+    dmRender::RenderListBegin(m_RenderContext);
+    dmGameObject::Render(m_Collection);
+    dmRender::RenderListEnd(m_RenderContext);
+    dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0);
+
+    ASSERT_EQ(1u, dmGraphics::GetDrawCount());
+    ASSERT_EQ(1u, dmGraphics::GetInstancedDrawCount());
+    // The emitter spawns up to its max particle count of 8
+    ASSERT_EQ(8u, dmGraphics::GetDrawInstanceCount());
+    dmGraphics::Flip(m_GraphicsContext);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+// Models with a local vertex space material that reads the world transform per instance (mtx_world_0..3)
+// are drawn as one instanced draw call per batch, one instance per model
+TEST_F(ComponentTest, ModelInstanced)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    const uint32_t model_count = 5;
+    for (uint32_t i = 0; i < model_count; ++i)
+    {
+        char id[32];
+        dmSnPrintf(id, sizeof(id), "/go%u", i);
+        dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/model/instanced_model.goc", dmHashString64(id), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+        ASSERT_NE((void*)0, go);
+    }
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    dmRender::RenderListBegin(m_RenderContext);
+    dmGameObject::Render(m_Collection);
+    dmRender::RenderListEnd(m_RenderContext);
+    dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0);
+
+    ASSERT_EQ(1u, dmGraphics::GetDrawCount());
+    ASSERT_EQ(1u, dmGraphics::GetInstancedDrawCount());
+    ASSERT_EQ(model_count, dmGraphics::GetDrawInstanceCount());
+
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    dmGraphics::Flip(m_GraphicsContext);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+// Renders a static scene of 5000 gui nodes (5 components of 1000 nodes) through the null graphics device.
+// The first frame generates the vertices of all nodes, the following frames reuse them.
+TEST_F(ComponentTest, BenchGuiStaticScene)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/gui/gui_bench.goc", dmHashString64("/go"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    const uint32_t frame_count = 100;
+    uint64_t first_frame_time = 0;
+    uint64_t frame_time = 0;
+    uint64_t first_draw_count = 0;
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+        uint64_t start = dmTime::GetTime();
+        dmRender::RenderListBegin(m_RenderContext);
+        dmGameObject::Render(m_Collection);
+        dmRender::RenderListEnd(m_RenderContext);
+        dmRender::DrawRenderList(m_RenderContext, 0x0, 0x0);
+        uint64_t end = dmTime::GetTime();
+
+        if (frame == 0)
+        {
+            first_frame_time = end - start;
+            first_draw_count = dmGraphics::GetDrawCount();
+        }
+        else
+        {
+            frame_time += end - start;
+            ASSERT_EQ(first_draw_count, dmGraphics::GetDrawCount());
+        }
+
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+        dmGraphics::Flip(m_GraphicsContext);
+    }
+
+    printf("Render 5000 static gui nodes: first frame %.2f ms, %.2f ms/frame\n", first_frame_time / 1000.0, frame_time / 1000.0 / (frame_count - 1));
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+// Renders one frame, returns the number of gui nodes whose vertices were generated and the hash of the drawn vertices
+static void RenderGuiFrame(dmGameObject::HCollection collection, dmGameObject::UpdateContext* update_context, dmRender::HRenderContext render_context,
+                           dmGraphics::HContext graphics_context, uint32_t* generated_count, uint32_t* vertex_hash)
+{
+    ASSERT_TRUE(dmGameObject::Update(collection, update_context));
+
+    dmProfile::Release(dmProfile::Begin());
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    dmRender::DrawRenderList(render_context, 0x0, 0x0);
+
+    *generated_count = ReadProfileCounter("Gui.GeneratedNodes");
+    *vertex_hash = dmGraphics::GetDrawVertexHash();
+
+    ASSERT_TRUE(dmGameObject::PostUpdate(collection));
+    dmGraphics::Flip(graphics_context);
+}
+
+// Drops all cached node vertices, the next frame generates the vertices of all nodes
+static void ClearGuiNodeVertexCache(dmGameSystem::GuiComponent* component)
+{
+    component->m_CachedVertices.SetSize(0);
+    component->m_NodeVertexCache.SetSize(0);
+}
+
+// Changes one cached node at a time and compares the rendered vertices with the ones from a cold cache
+TEST_F(ComponentTest, GuiNodeVertexCache)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmhash_t go_id = dmHashString64("/go");
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/gui/gui_cache.goc", go_id, 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    dmMessage::URL url;
+    dmMessage::ResetURL(url);
+    url.m_Socket = dmGameObject::GetMessageSocket(m_Collection);
+    url.m_Path = go_id;
+    url.m_Fragment = dmHashString64("gui");
+    dmGameSystem::GuiComponent* component = (dmGameSystem::GuiComponent*)dmGameObject::GetComponentFromURL(url);
+    ASSERT_NE((void*)0, component);
+    dmGui::HScene scene = component->m_Scene;
+
+    dmGui::HNode box = dmGui::NewNode(scene, Point3(10, 10, 0), Vector3(20, 20, 0), dmGui::NODE_TYPE_BOX);
+    dmGui::HNode slice9 = dmGui::NewNode(scene, Point3(50, 10, 0), Vector3(40, 40, 0), dmGui::NODE_TYPE_BOX);
+    dmGui::SetNodeProperty(scene, slice9, dmGui::PROPERTY_SLICE9, Vector4(4, 4, 4, 4));
+    dmGui::HNode pie = dmGui::NewNode(scene, Point3(100, 10, 0), Vector3(20, 20, 0), dmGui::NODE_TYPE_PIE);
+    dmGui::SetNodePieFillAngle(scene, pie, 90.0f);
+    dmGui::HNode flipbook = dmGui::NewNode(scene, Point3(150, 10, 0), Vector3(32, 32, 0), dmGui::NODE_TYPE_BOX);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeTexture(scene, flipbook, "flipbook"));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::PlayNodeFlipbookAnim(scene, flipbook, "anim", 0.0f, 1.0f));
+    const uint32_t node_count = 4;
+
+    m_UpdateContext.m_DT = 0.0f;
+    uint32_t generated_count;
+    uint32_t hash;
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &hash);
+    ASSERT_EQ(node_count, generated_count);
+
+    uint32_t prev_hash = hash;
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &hash);
+    ASSERT_EQ(0u, generated_count);
+    ASSERT_EQ(prev_hash, hash);
+
+    for (uint32_t change = 0; change < 6; ++change)
+    {
+        switch (change)
+        {
+            case 0: dmGui::SetNodeProperty(scene, box, dmGui::PROPERTY_COLOR, Vector4(1.0f, 0.5f, 0.5f, 1.0f)); break;
+            case 1: dmGui::SetNodeProperty(scene, box, dmGui::PROPERTY_SIZE, Vector4(24, 20, 0, 0)); break;
+            case 2: dmGui::SetNodeProperty(scene, slice9, dmGui::PROPERTY_SLICE9, Vector4(8, 4, 8, 4)); break;
+            case 3: dmGui::SetNodePieFillAngle(scene, pie, 180.0f); break;
+            case 4: dmGui::SetNodeInnerRadius(scene, pie, 4.0f); break;
+            // The flipbook advances one frame per second
+            case 5: m_UpdateContext.m_DT = 1.0f; break;
+        }
+
+        RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &hash);
+        m_UpdateContext.m_DT = 0.0f;
+        ASSERT_EQ(1u, generated_count);
+        ASSERT_NE(prev_hash, hash);
+
+        uint32_t cold_hash;
+        ClearGuiNodeVertexCache(component);
+        RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &cold_hash);
+        ASSERT_EQ(node_count, generated_count);
+        ASSERT_EQ(cold_hash, hash);
+        prev_hash = hash;
+    }
+
+    // A new node that gets the index of a deleted node must not use the vertices cached for the deleted node
+    uint16_t box_index = dmGui::GetNodeIndex(scene, box);
+    dmGui::DeleteNode(scene, box, true);
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &hash);
+    ASSERT_EQ(0u, generated_count);
+
+    dmGui::HNode new_pie = dmGui::NewNode(scene, Point3(10, 10, 0), Vector3(20, 20, 0), dmGui::NODE_TYPE_PIE);
+    ASSERT_EQ(box_index, dmGui::GetNodeIndex(scene, new_pie));
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &hash);
+    ASSERT_EQ(1u, generated_count);
+
+    uint32_t cold_hash;
+    ClearGuiNodeVertexCache(component);
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &cold_hash);
+    ASSERT_EQ(node_count, generated_count);
+    ASSERT_EQ(cold_hash, hash);
+
+    // A new box in the place of the deleted pie, with the same transform as the pie
+    dmGui::DeleteNode(scene, new_pie, true);
+    dmGui::HNode new_box = dmGui::NewNode(scene, Point3(10, 10, 0), Vector3(20, 20, 0), dmGui::NODE_TYPE_BOX);
+    ASSERT_EQ(box_index, dmGui::GetNodeIndex(scene, new_box));
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &hash);
+    ASSERT_EQ(1u, generated_count);
+
+    ClearGuiNodeVertexCache(component);
+    RenderGuiFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &generated_count, &cold_hash);
+    ASSERT_EQ(node_count, generated_count);
+    ASSERT_EQ(cold_hash, hash);
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
+// Updates and renders one frame, returns the number of rigs that skipped the pose sampling in the update
+static uint32_t RenderSpineFrame(dmGameObject::HCollection collection, dmGameObject::UpdateContext* update_context, dmRender::HRenderContext render_context,
+                                 dmGraphics::HContext graphics_context, uint32_t* culled_count)
+{
+    dmProfile::Release(dmProfile::Begin());
+    bool updated = dmGameObject::Update(collection, update_context);
+    uint32_t skipped = ReadProfileCounter("Rig.SkippedInstances");
+
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    dmRender::DrawRenderList(render_context, 0x0, 0x0);
+    *culled_count = ReadProfileCounter("RenderListCulled");
+
+    updated &= dmGameObject::PostUpdate(collection);
+    dmGraphics::Flip(graphics_context);
+    EXPECT_TRUE(updated);
+    return skipped;
+}
+
+// A spine model outside the view frustum is not drawn, and its rig skips the pose sampling from the next update
+TEST_F(ComponentTest, SpineModelFrustumCulling)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/spine/valid_spine.goc", dmHashString64("/go"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    // The default view projection is identity, the clip space cube is visible
+    uint32_t culled_count = 0;
+    ASSERT_EQ(0u, RenderSpineFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &culled_count));
+    ASSERT_EQ(0u, culled_count);
+
+    // Culled in the draw, the update before it still samples the pose
+    dmGameObject::SetPosition(go, Point3(1000000.0f, 0.0f, 0.0f));
+    ASSERT_EQ(0u, RenderSpineFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &culled_count));
+    ASSERT_EQ(1u, culled_count);
+    ASSERT_EQ(1u, RenderSpineFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &culled_count));
+    ASSERT_EQ(1u, culled_count);
+
+    // Drawn from the last pose as soon as it is visible, and sampled again from the next update
+    dmGameObject::SetPosition(go, Point3(0.0f, 0.0f, 0.0f));
+    ASSERT_EQ(1u, RenderSpineFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &culled_count));
+    ASSERT_EQ(0u, culled_count);
+    ASSERT_EQ(0u, RenderSpineFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &culled_count));
+    ASSERT_EQ(0u, culled_count);
+
+    // Frames without render passes cull nothing
+    dmGameObject::SetPosition(go, Point3(1000000.0f, 0.0f, 0.0f));
+    ASSERT_EQ(0u, RenderSpineFrame(m_Collection, &m_UpdateContext, m_RenderContext, m_GraphicsContext, &culled_count));
+    dmProfile::Release(dmProfile::Begin());
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(1u, ReadProfileCounter("Rig.SkippedInstances"));
+    dmRender::RenderListBegin(m_RenderContext);
+    dmGameObject::Render(m_Collection);
+    dmRender::RenderListEnd(m_RenderContext);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    dmProfile::Release(dmProfile::Begin());
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(0u, ReadProfileCounter("Rig.SkippedInstances"));
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 /* Physics joints */
 TEST_F(ComponentTest, JointTest)
 {
@@ -2297,7 +2810,11 @@ int main(int argc, char **argv)
     dmHashEnableReverseHash(true);
     // Enable message descriptor translation when sending messages
     dmDDF::RegisterAllTypes();
+    // Counters are only registered when the profiler is initialized before they are first used
+    dmProfile::Initialize(256, 1024 * 16, 128);
 
     jc_test_init(&argc, argv);
-    return jc_test_run_all();
+    int ret = jc_test_run_all();
+    dmProfile::Finalize();
+    return ret;
 }
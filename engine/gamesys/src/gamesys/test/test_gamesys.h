@@ -148,6 +148,32 @@ public:
     virtual ~SpriteAnimTest() {}
 };
 
+// Renders many sprites, with the sprite world created for the configured sprite count and worker pool
+class SpriteBenchTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~SpriteBenchTest() {}
+
+protected:
+    void NewCollection(uint32_t max_sprite_count, uint32_t max_instance_count, dmWorkerPool::HWorkerPool worker_pool, bool persistent_vertex_buffer)
+    {
+        dmGameObject::DeleteCollection(m_Collection);
+        dmGameObject::PostUpdate(m_Register);
+        m_SpriteContext.m_MaxSpriteCount = max_sprite_count;
+        m_SpriteContext.m_WorkerPool = worker_pool;
+        m_SpriteContext.m_PersistentVertexBuffer = persistent_vertex_buffer;
+        m_Collection = dmGameObject::NewCollection("collection", m_Factory, m_Register, max_instance_count);
+    }
+
+    // Looks at the sprites spawned within (0, 0) - (width, height), so that none of them are frustum culled
+    void SetViewProjection(float width, float height)
+    {
+        const float margin = 64.0f;
+        dmRender::SetViewMatrix(m_RenderContext, Matrix4::identity());
+        dmRender::SetProjectionMatrix(m_RenderContext, Matrix4::orthographic(-margin, width + margin, -margin, height + margin, -1.0f, 1.0f));
+    }
+};
+
 class WindowEventTest : public GamesysTest<const char*>
 {
 public:
@@ -341,6 +341,22 @@ namespace dmGraphics
     {
         g_functions.m_Draw(context, prim_type, first, count);
     }
+    void SetVertexDeclarationStepFunction(HVertexDeclaration vertex_declaration, VertexStepFunction step_function)
+    {
+        g_functions.m_SetVertexDeclarationStepFunction(vertex_declaration, step_function);
+    }
+    bool IsInstancingSupported(HContext context)
+    {
+        return g_functions.m_IsInstancingSupported(context);
+    }
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        g_functions.m_DrawElementsInstanced(context, prim_type, first, count, instance_count, type, index_buffer);
+    }
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        g_functions.m_DrawInstanced(context, prim_type, first, count, instance_count);
+    }
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf)
     {
         return g_functions.m_NewVertexProgram(context, ddf);
@@ -401,6 +417,10 @@ namespace dmGraphics
     {
         return g_functions.m_GetUniformLocation(prog, name);
     }
+    int32_t  GetAttributeLocation(HProgram prog, const char* name)
+    {
+        return g_functions.m_GetAttributeLocation(prog, name);
+    }
     void SetConstantV4(HContext context, const Vectormath::Aos::Vector4* data, int base_register)
     {
         g_functions.m_SetConstantV4(context, data, base_register);
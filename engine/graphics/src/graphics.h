@@ -259,6 +259,13 @@ namespace dmGraphics
         BUFFER_ACCESS_READ_WRITE = 2,
     };
 
+    // Vertex step function, how often the streams of a vertex declaration advance
+    enum VertexStepFunction
+    {
+        VERTEX_STEP_FUNCTION_VERTEX   = 0,
+        VERTEX_STEP_FUNCTION_INSTANCE = 1,
+    };
+
     // Face type
     enum FaceType
     {
@@ -611,9 +618,48 @@ namespace dmGraphics
     void DisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration);
     void HashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration);
 
+    /**
+     * Set how often the streams of a vertex declaration advance. A declaration with step function
+     * VERTEX_STEP_FUNCTION_INSTANCE describes a per-instance buffer, enabled with EnableVertexDeclaration
+     * alongside the per-vertex declaration and consumed by DrawInstanced and DrawElementsInstanced.
+     * @param vertex_declaration Vertex declaration handle
+     * @param step_function Step function, VERTEX_STEP_FUNCTION_VERTEX by default
+     */
+    void SetVertexDeclarationStepFunction(HVertexDeclaration vertex_declaration, VertexStepFunction step_function);
+
     void DrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     void Draw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
 
+    /**
+     * Check if the context supports instanced draw calls
+     * @param context Graphics context
+     * @return True if DrawInstanced and DrawElementsInstanced are supported
+     */
+    bool IsInstancingSupported(HContext context);
+
+    /**
+     * Draw indexed geometry instance_count times. Streams of an enabled vertex declaration with step function
+     * VERTEX_STEP_FUNCTION_INSTANCE advance once per instance.
+     * @param context Graphics context
+     * @param prim_type Primitive type
+     * @param first Byte offset into the index buffer
+     * @param count Index count
+     * @param instance_count Instance count
+     * @param type Index type
+     * @param index_buffer Index buffer
+     */
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer);
+
+    /**
+     * Draw non-indexed geometry instance_count times, see DrawElementsInstanced
+     * @param context Graphics context
+     * @param prim_type Primitive type
+     * @param first First vertex
+     * @param count Vertex count
+     * @param instance_count Instance count
+     */
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
+
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf);
     HFragmentProgram NewFragmentProgram(HContext context, ShaderDesc::Shader* ddf);
     HProgram NewProgram(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -634,6 +680,14 @@ namespace dmGraphics
     uint32_t GetUniformCount(HProgram prog);
     int32_t  GetUniformLocation(HProgram prog, const char* name);
 
+    /**
+     * Get the location of a vertex attribute of a program
+     * @param prog Program handle
+     * @param name Attribute name
+     * @return Location of the attribute, or -1 if the vertex program doesn't use it
+     */
+    int32_t  GetAttributeLocation(HProgram prog, const char* name);
+
     void SetConstantV4(HContext context, const Vectormath::Aos::Vector4* data, int base_register);
     void SetConstantM4(HContext context, const Vectormath::Aos::Vector4* data, int base_register);
     void SetSampler(HContext context, int32_t location, int32_t unit);
@@ -92,6 +92,10 @@ namespace dmGraphics
     typedef void (*HashVertexDeclarationFn)(HashState32* state, HVertexDeclaration vertex_declaration);
     typedef void (*DrawElementsFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     typedef void (*DrawFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
+    typedef void (*SetVertexDeclarationStepFunctionFn)(HVertexDeclaration vertex_declaration, VertexStepFunction step_function);
+    typedef bool (*IsInstancingSupportedFn)(HContext context);
+    typedef void (*DrawElementsInstancedFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer);
+    typedef void (*DrawInstancedFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
     typedef HVertexProgram (*NewVertexProgramFn)(HContext context, ShaderDesc::Shader* ddf);
     typedef HFragmentProgram (*NewFragmentProgramFn)(HContext context, ShaderDesc::Shader* ddf);
     typedef HProgram (*NewProgramFn)(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -107,6 +111,7 @@ namespace dmGraphics
     typedef uint32_t (*GetUniformNameFn)(HProgram prog, uint32_t index, char* buffer, uint32_t buffer_size, Type* type);
     typedef uint32_t (*GetUniformCountFn)(HProgram prog);
     typedef int32_t (* GetUniformLocationFn)(HProgram prog, const char* name);
+    typedef int32_t (* GetAttributeLocationFn)(HProgram prog, const char* name);
     typedef void (*SetConstantV4Fn)(HContext context, const Vectormath::Aos::Vector4* data, int base_register);
     typedef void (*SetConstantM4Fn)(HContext context, const Vectormath::Aos::Vector4* data, int base_register);
     typedef void (*SetSamplerFn)(HContext context, int32_t location, int32_t unit);
@@ -197,6 +202,10 @@ namespace dmGraphics
         HashVertexDeclarationFn m_HashVertexDeclaration;
         DrawElementsFn m_DrawElements;
         DrawFn m_Draw;
+        SetVertexDeclarationStepFunctionFn m_SetVertexDeclarationStepFunction;
+        IsInstancingSupportedFn m_IsInstancingSupported;
+        DrawElementsInstancedFn m_DrawElementsInstanced;
+        DrawInstancedFn m_DrawInstanced;
         NewVertexProgramFn m_NewVertexProgram;
         NewFragmentProgramFn m_NewFragmentProgram;
         NewProgramFn m_NewProgram;
@@ -212,6 +221,7 @@ namespace dmGraphics
         GetUniformNameFn m_GetUniformName;
         GetUniformCountFn m_GetUniformCount;
         GetUniformLocationFn m_GetUniformLocation;
+        GetAttributeLocationFn m_GetAttributeLocation;
         SetConstantV4Fn m_SetConstantV4;
         SetConstantM4Fn m_SetConstantM4;
         SetSamplerFn m_SetSampler;
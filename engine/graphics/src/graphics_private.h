@@ -19,6 +19,13 @@
 namespace dmGraphics
 {
     uint64_t GetDrawCount();
+    // Instanced draw calls and the sum of their instance counts, since the first draw call after the last flip
+    uint64_t GetInstancedDrawCount();
+    uint64_t GetDrawInstanceCount();
+    // Hash of the vertices drawn by the indexed draw calls, in draw order, since the first draw call after the last flip
+    uint32_t GetDrawVertexHash();
+    // Bytes of vertex data uploaded since the first upload after the last flip
+    uint64_t GetVertexUploadSize();
     void SetForceFragmentReloadFail(bool should_fail);
     void SetForceVertexReloadFail(bool should_fail);
     uint32_t GetTextureFormatBPP(TextureFormat format);
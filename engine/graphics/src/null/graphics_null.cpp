@@ -16,6 +16,7 @@
 
 #include <dlib/array.h>
 #include <dlib/dstrings.h>
+#include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
 
@@ -28,7 +29,12 @@
 using namespace Vectormath::Aos;
 
 uint64_t g_DrawCount = 0;
+uint64_t g_InstancedDrawCount = 0;
+uint64_t g_DrawInstanceCount = 0;
 uint64_t g_Flipped = 0;
+uint64_t g_VertexUploadSize = 0;
+uint64_t g_UploadFlipped = 0;
+HashState32 g_DrawVertexHashState;
 
 // Used only for tests
 bool g_ForceFragmentReloadFail = false;
@@ -305,6 +311,7 @@ namespace dmGraphics
         }
 
         g_Flipped = 1;
+        g_UploadFlipped = 1;
     }
 
     static void NullSetSwapInterval(HContext /*context*/, uint32_t /*swap_interval*/)
@@ -353,6 +360,16 @@ namespace dmGraphics
         delete vb;
     }
 
+    static void AddVertexUploadSize(uint32_t size)
+    {
+        if (g_UploadFlipped)
+        {
+            g_UploadFlipped = 0;
+            g_VertexUploadSize = 0;
+        }
+        g_VertexUploadSize += size;
+    }
+
     static void NullSetVertexBufferData(HVertexBuffer buffer, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
         VertexBuffer* vb = (VertexBuffer*)buffer;
@@ -361,14 +378,20 @@ namespace dmGraphics
         vb->m_Buffer = new char[size];
         vb->m_Size = size;
         if (data != 0x0)
+        {
             memcpy(vb->m_Buffer, data, size);
+            AddVertexUploadSize(size);
+        }
     }
 
     static void NullSetVertexBufferSubData(HVertexBuffer buffer, uint32_t offset, uint32_t size, const void* data)
     {
         VertexBuffer* vb = (VertexBuffer*)buffer;
         if (offset + size <= vb->m_Size && data != 0x0)
+        {
             memcpy(&(vb->m_Buffer)[offset], data, size);
+            AddVertexUploadSize(size);
+        }
     }
 
     static void* NullMapVertexBuffer(HVertexBuffer buffer, BufferAccess access)
@@ -524,6 +547,16 @@ namespace dmGraphics
         uint16_t stride = 0;
         for (uint32_t i = 0; i < vertex_declaration->m_Count; ++i)
             stride += vertex_declaration->m_Elements[i].m_Size * TYPE_SIZE[vertex_declaration->m_Elements[i].m_Type - dmGraphics::TYPE_BYTE];
+
+        // Per-instance streams are only validated against the instance count when drawing
+        if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+        {
+            assert(context->m_InstanceBuffer == 0x0);
+            context->m_InstanceBuffer = vb;
+            context->m_InstanceStride = stride;
+            return;
+        }
+
         uint32_t offset = 0;
         for (uint16_t i = 0; i < vertex_declaration->m_Count; ++i)
         {
@@ -545,6 +578,12 @@ namespace dmGraphics
     {
         assert(context);
         assert(vertex_declaration);
+        if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+        {
+            context->m_InstanceBuffer = 0x0;
+            context->m_InstanceStride = 0;
+            return;
+        }
         for (uint32_t i = 0; i < vertex_declaration->m_Count; ++i)
             if (vertex_declaration->m_Elements[i].m_Size > 0)
                 DisableVertexStream(context, i);
@@ -562,6 +601,12 @@ namespace dmGraphics
             dmHashUpdateBuffer32(state, &vert_elem.m_Type, sizeof(vert_elem.m_Type));
             dmHashUpdateBuffer32(state, &vert_elem.m_Normalize, sizeof(vert_elem.m_Normalize));
         }
+        dmHashUpdateBuffer32(state, &vertex_declaration->m_StepFunction, sizeof(vertex_declaration->m_StepFunction));
+    }
+
+    static void NullSetVertexDeclarationStepFunction(HVertexDeclaration vertex_declaration, VertexStepFunction step_function)
+    {
+        vertex_declaration->m_StepFunction = step_function;
     }
 
     static uint32_t GetIndex(Type type, HIndexBuffer ib, uint32_t index)
@@ -628,8 +673,18 @@ namespace dmGraphics
         {
             g_Flipped = 0;
             g_DrawCount = 0;
+            g_InstancedDrawCount = 0;
+            g_DrawInstanceCount = 0;
+            dmHashInit32(&g_DrawVertexHashState, false);
         }
         g_DrawCount++;
+
+        for (uint32_t i = 0; i < MAX_VERTEX_STREAM_COUNT; ++i)
+        {
+            VertexStream& vs = context->m_VertexStreams[i];
+            if (vs.m_Size > 0)
+                dmHashUpdateBuffer32(&g_DrawVertexHashState, vs.m_Buffer, vs.m_Size * count);
+        }
     }
 
     static void NullDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
@@ -640,16 +695,71 @@ namespace dmGraphics
         {
             g_Flipped = 0;
             g_DrawCount = 0;
+            g_InstancedDrawCount = 0;
+            g_DrawInstanceCount = 0;
+            dmHashInit32(&g_DrawVertexHashState, false);
         }
         g_DrawCount++;
     }
 
+    static bool NullIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
+    static void ValidateInstanceBuffer(HContext context, uint32_t instance_count)
+    {
+        assert(instance_count > 0);
+        if (context->m_InstanceBuffer)
+        {
+            assert(instance_count * context->m_InstanceStride <= context->m_InstanceBuffer->m_Size);
+        }
+    }
+
+    static void NullDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        ValidateInstanceBuffer(context, instance_count);
+        NullDrawElements(context, prim_type, first, count, type, index_buffer);
+        g_InstancedDrawCount++;
+        g_DrawInstanceCount += instance_count;
+    }
+
+    static void NullDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        ValidateInstanceBuffer(context, instance_count);
+        NullDraw(context, prim_type, first, count);
+        g_InstancedDrawCount++;
+        g_DrawInstanceCount += instance_count;
+    }
+
     // For tests
     uint64_t GetDrawCount()
     {
         return g_DrawCount;
     }
 
+    uint64_t GetInstancedDrawCount()
+    {
+        return g_InstancedDrawCount;
+    }
+
+    uint64_t GetDrawInstanceCount()
+    {
+        return g_DrawInstanceCount;
+    }
+
+    uint32_t GetDrawVertexHash()
+    {
+        HashState32 state;
+        dmHashClone32(&state, &g_DrawVertexHashState, false);
+        return dmHashFinal32(&state);
+    }
+
+    uint64_t GetVertexUploadSize()
+    {
+        return g_VertexUploadSize;
+    }
+
     struct VertexProgram
     {
         char* m_Data;
@@ -838,6 +948,36 @@ namespace dmGraphics
         return -1;
     }
 
+    // Attributes are numbered in the order they are declared in the vertex program
+    static int32_t NullGetAttributeLocation(HProgram prog, const char* name)
+    {
+        Program* program = (Program*)prog;
+        if (program->m_VP == 0x0)
+            return -1;
+
+        int32_t location = 0;
+        const char* line = program->m_VP->m_Data;
+        while (line && *line)
+        {
+            while (*line == ' ' || *line == '\t')
+                ++line;
+            const char* end = strchr(line, ';');
+            const char* line_end = strchr(line, '\n');
+            if (strncmp(line, "attribute ", 10) == 0 && end && (line_end == 0x0 || end < line_end))
+            {
+                const char* attribute_name = end;
+                while (attribute_name > line && attribute_name[-1] != ' ')
+                    --attribute_name;
+                uint32_t length = (uint32_t) (end - attribute_name);
+                if (strlen(name) == length && strncmp(attribute_name, name, length) == 0)
+                    return location;
+                ++location;
+            }
+            line = line_end ? line_end + 1 : 0x0;
+        }
+        return -1;
+    }
+
     static void NullSetViewport(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
     {
         assert(context);
@@ -1256,6 +1396,10 @@ namespace dmGraphics
         fn_table.m_HashVertexDeclaration = NullHashVertexDeclaration;
         fn_table.m_DrawElements = NullDrawElements;
         fn_table.m_Draw = NullDraw;
+        fn_table.m_SetVertexDeclarationStepFunction = NullSetVertexDeclarationStepFunction;
+        fn_table.m_IsInstancingSupported = NullIsInstancingSupported;
+        fn_table.m_DrawElementsInstanced = NullDrawElementsInstanced;
+        fn_table.m_DrawInstanced = NullDrawInstanced;
         fn_table.m_NewVertexProgram = NullNewVertexProgram;
         fn_table.m_NewFragmentProgram = NullNewFragmentProgram;
         fn_table.m_NewProgram = NullNewProgram;
@@ -1271,6 +1415,7 @@ namespace dmGraphics
         fn_table.m_GetUniformName = NullGetUniformName;
         fn_table.m_GetUniformCount = NullGetUniformCount;
         fn_table.m_GetUniformLocation = NullGetUniformLocation;
+        fn_table.m_GetAttributeLocation = NullGetAttributeLocation;
         fn_table.m_SetConstantV4 = NullSetConstantV4;
         fn_table.m_SetConstantM4 = NullSetConstantM4;
         fn_table.m_SetSampler = NullSetSampler;
@@ -50,8 +50,9 @@ namespace dmGraphics
 
     struct VertexDeclaration
     {
-        uint32_t        m_Count;
-        VertexElement   m_Elements[MAX_VERTEX_STREAM_COUNT];
+        uint32_t            m_Count;
+        VertexElement       m_Elements[MAX_VERTEX_STREAM_COUNT];
+        VertexStepFunction  m_StepFunction;
     };
 
     struct VertexBuffer
@@ -80,6 +81,9 @@ namespace dmGraphics
         Context(const ContextParams& params);
 
         VertexStream                m_VertexStreams[MAX_VERTEX_STREAM_COUNT];
+        // Enabled per-instance buffer, see VERTEX_STEP_FUNCTION_INSTANCE
+        VertexBuffer*               m_InstanceBuffer;
+        uint32_t                    m_InstanceStride;
         Vectormath::Aos::Vector4    m_ProgramRegisters[MAX_REGISTER_COUNT];
         HTexture                    m_Textures[MAX_TEXTURE_COUNT];
         FrameBuffer                 m_MainFrameBuffer;
@@ -301,6 +301,12 @@ static void LogFrameBufferError(GLenum status)
     // The alternative is a matrix of conditional typedefs, linked statically/dynamically or core. OpenGL function prototypes does not change, so this is safe.
     typedef void (* DM_PFNGLINVALIDATEFRAMEBUFFERPROC) (GLenum target, GLsizei numAttachments, const GLenum *attachments);
     DM_PFNGLINVALIDATEFRAMEBUFFERPROC PFN_glInvalidateFramebuffer = NULL;
+    typedef void (* DM_PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+    DM_PFNGLVERTEXATTRIBDIVISORPROC PFN_glVertexAttribDivisor = NULL;
+    typedef void (* DM_PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+    DM_PFNGLDRAWARRAYSINSTANCEDPROC PFN_glDrawArraysInstanced = NULL;
+    typedef void (* DM_PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei instancecount);
+    DM_PFNGLDRAWELEMENTSINSTANCEDPROC PFN_glDrawElementsInstanced = NULL;
 
     Context* g_Context = 0x0;
 
@@ -548,14 +554,14 @@ static void LogFrameBufferError(GLenum status)
         return false;
     }
 
-static uintptr_t GetExtProcAddress(const char* name, const char* extension_name, const char* core_name, const GLubyte* extensions)
+static uintptr_t GetExtProcAddress(const char* name, const char* extension_name, const char* core_name, const GLubyte* extensions, bool is_gles3)
 {
     /*
         Check in order
         1) ARB - Extensions officially approved by the OpenGL Architecture Review Board
         2) EXT - Extensions agreed upon by multiple OpenGL vendors
         3) OES - Vendor specific code for the OpenGL ES working group
-        4) Optionally check as core function (if not GLES and core_name is set)
+        4) Optionally check as core function (if not GLES, or GLES 3, and core_name is set)
     */
     uintptr_t func = 0x0;
     static const char* ext_name_prefix_str[] = {"GL_ARB_", "GL_EXT_", "GL_OES_"};
@@ -582,13 +588,19 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         // On OpenGL, optionally check for core driver support if extension wasn't found (i.e extension has become part of core OpenGL)
         func = (uintptr_t) glfwGetProcAddress(core_name);
     }
+#elif !defined(__EMSCRIPTEN__)
+    if(func == 0 && core_name && is_gles3)
+    {
+        // On an OpenGL ES 3 context, the extension may have become part of core OpenGL ES
+        func = (uintptr_t) glfwGetProcAddress(core_name);
+    }
 #endif
     return func;
 }
 
-#define DMGRAPHICS_GET_PROC_ADDRESS_EXT(function, name, extension_name, core_name, type, extensions)\
+#define DMGRAPHICS_GET_PROC_ADDRESS_EXT(function, name, extension_name, core_name, type, extensions, is_gles3)\
     if (function == 0x0)\
-        function = (type) GetExtProcAddress(name, extension_name, core_name, extensions);
+        function = (type) GetExtProcAddress(name, extension_name, core_name, extensions, is_gles3);
 
     static bool ValidateAsyncJobProcessing(HContext context)
     {
@@ -855,7 +867,20 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         const GLubyte* extensions = glGetString(GL_EXTENSIONS);
 #endif
 
-        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glInvalidateFramebuffer, "glDiscardFramebuffer", "discard_framebuffer", "glInvalidateFramebuffer", DM_PFNGLINVALIDATEFRAMEBUFFERPROC, extensions);
+#if defined(GL_ES_VERSION_2_0)
+        const char* version = (const char*) glGetString(GL_VERSION);
+        context->m_IsGles3Version = version != 0x0 && strstr(version, "OpenGL ES 3") != 0x0;
+#endif
+
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glInvalidateFramebuffer, "glDiscardFramebuffer", "discard_framebuffer", "glInvalidateFramebuffer", DM_PFNGLINVALIDATEFRAMEBUFFERPROC, extensions, context->m_IsGles3Version);
+
+        // Instanced draw calls are in ARB/EXT_draw_instanced on desktop, in EXT_instanced_arrays on OpenGL ES 2 and core on OpenGL ES 3
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glVertexAttribDivisor, "glVertexAttribDivisor", "instanced_arrays", "glVertexAttribDivisor", DM_PFNGLVERTEXATTRIBDIVISORPROC, extensions, context->m_IsGles3Version);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawArraysInstanced, "glDrawArraysInstanced", "draw_instanced", "glDrawArraysInstanced", DM_PFNGLDRAWARRAYSINSTANCEDPROC, extensions, context->m_IsGles3Version);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawArraysInstanced, "glDrawArraysInstanced", "instanced_arrays", 0x0, DM_PFNGLDRAWARRAYSINSTANCEDPROC, extensions, context->m_IsGles3Version);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawElementsInstanced, "glDrawElementsInstanced", "draw_instanced", "glDrawElementsInstanced", DM_PFNGLDRAWELEMENTSINSTANCEDPROC, extensions, context->m_IsGles3Version);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawElementsInstanced, "glDrawElementsInstanced", "instanced_arrays", 0x0, DM_PFNGLDRAWELEMENTSINSTANCEDPROC, extensions, context->m_IsGles3Version);
+        context->m_InstancingSupport = PFN_glVertexAttribDivisor != 0x0 && PFN_glDrawArraysInstanced != 0x0 && PFN_glDrawElementsInstanced != 0x0;
 
         if (IsExtensionSupported("GL_IMG_texture_compression_pvrtc", extensions))
         {
@@ -1328,12 +1353,30 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
         CHECK_GL_ERROR;
 
+        // Per-vertex streams are at the logical locations. Per-instance streams follow the streams
+        // of the per-vertex declaration enabled before them. The locations are kept as physical
+        // indices until the declaration is disabled, and must be rebound when used with a program.
+        const bool instance_step = vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE;
+        if (instance_step)
+        {
+            for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+            {
+                vertex_declaration->m_Streams[i].m_PhysicalIndex = context->m_VertexStreamCount + vertex_declaration->m_Streams[i].m_LogicalIndex;
+            }
+            vertex_declaration->m_BoundForProgram = 0;
+        }
+        else
+        {
+            context->m_VertexStreamCount = vertex_declaration->m_StreamCount;
+        }
+
         for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
         {
-            glEnableVertexAttribArray(vertex_declaration->m_Streams[i].m_LogicalIndex);
+            GLuint location = instance_step ? vertex_declaration->m_Streams[i].m_PhysicalIndex : vertex_declaration->m_Streams[i].m_LogicalIndex;
+            glEnableVertexAttribArray(location);
             CHECK_GL_ERROR;
             glVertexAttribPointer(
-                    vertex_declaration->m_Streams[i].m_LogicalIndex,
+                    location,
                     vertex_declaration->m_Streams[i].m_Size,
                     GetOpenGLType(vertex_declaration->m_Streams[i].m_Type),
                     vertex_declaration->m_Streams[i].m_Normalize,
@@ -1341,6 +1384,12 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             BUFFER_OFFSET(vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
 
             CHECK_GL_ERROR;
+
+            if (instance_step)
+            {
+                PFN_glVertexAttribDivisor(location, 1);
+                CHECK_GL_ERROR;
+            }
         }
 
         #undef BUFFER_OFFSET
@@ -1402,6 +1451,12 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
                 BUFFER_OFFSET(vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
 
                 CHECK_GL_ERROR;
+
+                if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+                {
+                    PFN_glVertexAttribDivisor(vertex_declaration->m_Streams[i].m_PhysicalIndex, 1);
+                    CHECK_GL_ERROR;
+                }
             }
         }
 
@@ -1413,6 +1468,27 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         assert(context);
         assert(vertex_declaration);
 
+        if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+        {
+            // The per-instance attributes are not at the first locations, and the divisor
+            // must be reset before the locations are used by a per-vertex declaration
+            for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+            {
+                int16_t index = vertex_declaration->m_Streams[i].m_PhysicalIndex;
+                if (index == -1)
+                    continue;
+                GLuint location = index;
+                PFN_glVertexAttribDivisor(location, 0);
+                CHECK_GL_ERROR;
+                glDisableVertexAttribArray(location);
+                CHECK_GL_ERROR;
+            }
+
+            glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+            CHECK_GL_ERROR;
+            return;
+        }
+
         for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
         {
             glDisableVertexAttribArray(i);
@@ -1442,6 +1518,12 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             dmHashUpdateBuffer32(state, &stream.m_Type, sizeof(stream.m_Type));
             dmHashUpdateBuffer32(state, &stream.m_Normalize, sizeof(stream.m_Normalize));
         }
+        dmHashUpdateBuffer32(state, &vertex_declaration->m_StepFunction, sizeof(vertex_declaration->m_StepFunction));
+    }
+
+    static void OpenGLSetVertexDeclarationStepFunction(HVertexDeclaration vertex_declaration, VertexStepFunction step_function)
+    {
+        vertex_declaration->m_StepFunction = step_function;
     }
 
 
@@ -1468,6 +1550,36 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR
     }
 
+    static bool OpenGLIsInstancingSupported(HContext context)
+    {
+        return context->m_InstancingSupport;
+    }
+
+    static void OpenGLDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        assert(context);
+        assert(index_buffer);
+        assert(context->m_InstancingSupport);
+        DM_PROFILE(Graphics, "DrawElementsInstanced");
+        DM_COUNTER("DrawCalls", 1);
+
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        CHECK_GL_ERROR;
+
+        PFN_glDrawElementsInstanced(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first, instance_count);
+        CHECK_GL_ERROR
+    }
+
+    static void OpenGLDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(context);
+        assert(context->m_InstancingSupport);
+        DM_PROFILE(Graphics, "DrawInstanced");
+        DM_COUNTER("DrawCalls", 1);
+        PFN_glDrawArraysInstanced(GetOpenGLPrimitiveType(prim_type), first, count, instance_count);
+        CHECK_GL_ERROR
+    }
+
     static uint32_t CreateShader(GLenum type, const void* program, uint32_t program_size)
     {
         GLuint s = glCreateShader(type);
@@ -1734,6 +1846,17 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return (uint32_t) location;
     }
 
+    static int32_t OpenGLGetAttributeLocation(HProgram prog, const char* name)
+    {
+        GLint location = glGetAttribLocation(prog, name);
+        if (location == -1)
+        {
+            // Clear error if attribute isn't found
+            CLEAR_GL_ERROR
+        }
+        return (int32_t) location;
+    }
+
     static void OpenGLSetViewport(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
     {
         assert(context);
@@ -2794,6 +2917,10 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_HashVertexDeclaration = OpenGLHashVertexDeclaration;
         fn_table.m_DrawElements = OpenGLDrawElements;
         fn_table.m_Draw = OpenGLDraw;
+        fn_table.m_SetVertexDeclarationStepFunction = OpenGLSetVertexDeclarationStepFunction;
+        fn_table.m_IsInstancingSupported = OpenGLIsInstancingSupported;
+        fn_table.m_DrawElementsInstanced = OpenGLDrawElementsInstanced;
+        fn_table.m_DrawInstanced = OpenGLDrawInstanced;
         fn_table.m_NewVertexProgram = OpenGLNewVertexProgram;
         fn_table.m_NewFragmentProgram = OpenGLNewFragmentProgram;
         fn_table.m_NewProgram = OpenGLNewProgram;
@@ -2809,6 +2936,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_GetUniformName = OpenGLGetUniformName;
         fn_table.m_GetUniformCount = OpenGLGetUniformCount;
         fn_table.m_GetUniformLocation = OpenGLGetUniformLocation;
+        fn_table.m_GetAttributeLocation = OpenGLGetAttributeLocation;
         fn_table.m_SetConstantV4 = OpenGLSetConstantV4;
         fn_table.m_SetConstantM4 = OpenGLSetConstantM4;
         fn_table.m_SetSampler = OpenGLSetSampler;
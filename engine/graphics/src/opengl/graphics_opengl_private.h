@@ -51,11 +51,16 @@ namespace dmGraphics
         uint32_t                m_IndexBufferFormatSupport;
         uint32_t                m_DepthBufferBits;
         uint32_t                m_FrameBufferInvalidateBits;
+        // Attribute locations used by the last per-vertex declaration enabled without a program,
+        // per-instance streams enabled without a program are placed after them
+        uint16_t                m_VertexStreamCount;
         uint8_t                 m_FrameBufferInvalidateAttachments : 1;
         uint8_t                 m_PackedDepthStencil : 1;
         uint8_t                 m_WindowOpened : 1;
         uint8_t                 m_VerifyGraphicsCalls : 1;
         uint8_t                 m_RenderDocSupport : 1;
+        uint8_t                 m_InstancingSupport : 1;
+        uint8_t                 m_IsGles3Version : 1;
     };
 
     static inline void IncreaseModificationVersion(Context* context)
@@ -93,11 +98,12 @@ namespace dmGraphics
             bool        m_Normalize;
         };
 
-        Stream      m_Streams[8];
-        uint16_t    m_StreamCount;
-        uint16_t    m_Stride;
-        HProgram    m_BoundForProgram;
-        uint32_t    m_ModificationVersion;
+        Stream              m_Streams[8];
+        uint16_t            m_StreamCount;
+        uint16_t            m_Stride;
+        HProgram            m_BoundForProgram;
+        uint32_t            m_ModificationVersion;
+        VertexStepFunction  m_StepFunction;
 
     };
     // TODO: Why this one here!? Not used?
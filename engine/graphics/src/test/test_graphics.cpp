@@ -327,6 +327,122 @@ TEST_F(dmGraphicsTest, Drawing)
     dmGraphics::DeleteVertexDeclaration(vd);
 }
 
+TEST_F(dmGraphicsTest, InstancedDrawing)
+{
+    ASSERT_TRUE(dmGraphics::IsInstancingSupported(m_Context));
+
+    float v[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    uint32_t i[] = { 0, 1, 2 };
+    float offsets[] = { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f };
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 3, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::VertexElement instance_ve[] =
+    {
+        {"offset", 0, 4, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_Context, ve, 1);
+    dmGraphics::HVertexDeclaration instance_vd = dmGraphics::NewVertexDeclaration(m_Context, instance_ve, 1);
+    dmGraphics::SetVertexDeclarationStepFunction(instance_vd, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(v), v, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    dmGraphics::HVertexBuffer instance_vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(offsets), offsets, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_Context, sizeof(i), i, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+
+    // The hash must differ from the per-vertex declaration with the same streams
+    HashState32 vd_state, instance_vd_state;
+    dmHashInit32(&vd_state, false);
+    dmHashInit32(&instance_vd_state, false);
+    dmGraphics::HashVertexDeclaration(&vd_state, vd);
+    dmGraphics::SetVertexDeclarationStepFunction(vd, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+    dmGraphics::HashVertexDeclaration(&instance_vd_state, vd);
+    dmGraphics::SetVertexDeclarationStepFunction(vd, dmGraphics::VERTEX_STEP_FUNCTION_VERTEX);
+    ASSERT_NE(dmHashFinal32(&vd_state), dmHashFinal32(&instance_vd_state));
+
+    dmGraphics::Flip(m_Context);
+
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableVertexDeclaration(m_Context, instance_vd, instance_vb);
+    // The per-instance streams don't replace the per-vertex streams
+    ASSERT_EQ(3 * sizeof(float), m_Context->m_VertexStreams[0].m_Size);
+    ASSERT_EQ(0u, m_Context->m_VertexStreams[1].m_Size);
+    ASSERT_EQ(4 * sizeof(float), m_Context->m_InstanceStride);
+
+    dmGraphics::DrawElementsInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, 4, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DrawInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, 2);
+    dmGraphics::DisableVertexDeclaration(m_Context, instance_vd);
+    ASSERT_EQ((void*)0x0, (void*)m_Context->m_InstanceBuffer);
+
+    dmGraphics::DrawElements(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+
+    ASSERT_EQ(3u, dmGraphics::GetDrawCount());
+    ASSERT_EQ(2u, dmGraphics::GetInstancedDrawCount());
+    ASSERT_EQ(6u, dmGraphics::GetDrawInstanceCount());
+
+    dmGraphics::Flip(m_Context);
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::Draw(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+    ASSERT_EQ(1u, dmGraphics::GetDrawCount());
+    ASSERT_EQ(0u, dmGraphics::GetInstancedDrawCount());
+    ASSERT_EQ(0u, dmGraphics::GetDrawInstanceCount());
+
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(instance_vb);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(instance_vd);
+    dmGraphics::DeleteVertexDeclaration(vd);
+}
+
+// The vertex hash only depends on the drawn vertices, not on where they are in the vertex buffer
+TEST_F(dmGraphicsTest, DrawVertexHash)
+{
+    float v[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    float v_offset[] = { 9.0f, 9.0f, 9.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    uint32_t i[] = { 0, 1, 2 };
+    uint32_t i_offset[] = { 1, 2, 3 };
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 3, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_Context, ve, 1);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_Context, 0, 0x0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_Context, sizeof(i), i, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+
+    dmGraphics::Flip(m_Context);
+    dmGraphics::SetVertexBufferData(vb, sizeof(v), v, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    ASSERT_EQ(sizeof(v), dmGraphics::GetVertexUploadSize());
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::DrawElements(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+    uint32_t hash = dmGraphics::GetDrawVertexHash();
+
+    dmGraphics::Flip(m_Context);
+    dmGraphics::SetVertexBufferData(vb, sizeof(v_offset), v_offset, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    dmGraphics::SetIndexBufferData(ib, sizeof(i_offset), i_offset, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::DrawElements(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+    ASSERT_EQ(hash, dmGraphics::GetDrawVertexHash());
+
+    // Moving a vertex changes the hash, the upload size only counts the written bytes
+    dmGraphics::Flip(m_Context);
+    v_offset[4] = 1.0f;
+    dmGraphics::SetVertexBufferSubData(vb, 3 * sizeof(float), 3 * sizeof(float), &v_offset[3]);
+    ASSERT_EQ(3 * sizeof(float), dmGraphics::GetVertexUploadSize());
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::DrawElements(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+    ASSERT_NE(hash, dmGraphics::GetDrawVertexHash());
+
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(vd);
+}
+
 static inline dmGraphics::ShaderDesc::Shader MakeDDFShader(const char* data, uint32_t count)
 {
     dmGraphics::ShaderDesc::Shader ddf;
@@ -379,6 +495,10 @@ TEST_F(dmGraphicsTest, TestProgram)
     ASSERT_EQ(1, dmGraphics::GetUniformLocation(program, "world"));
     ASSERT_EQ(2, dmGraphics::GetUniformLocation(program, "texture_sampler"));
     ASSERT_EQ(3, dmGraphics::GetUniformLocation(program, "tint"));
+    ASSERT_EQ(0, dmGraphics::GetAttributeLocation(program, "position"));
+    ASSERT_EQ(1, dmGraphics::GetAttributeLocation(program, "texcoord0"));
+    ASSERT_EQ(-1, dmGraphics::GetAttributeLocation(program, "texcoord"));
+    ASSERT_EQ(-1, dmGraphics::GetAttributeLocation(program, "var_texcoord0"));
     char buffer[64];
     dmGraphics::Type type;
     dmGraphics::GetUniformName(program, 0, buffer, 64, &type);
@@ -122,6 +122,8 @@ namespace dmGraphics
         RenderTarget*                   m_CurrentRenderTarget;
         DeviceBuffer*                   m_CurrentVertexBuffer;
         VertexDeclaration*              m_CurrentVertexDeclaration;
+        DeviceBuffer*                   m_CurrentInstanceBuffer;
+        VertexDeclaration*              m_CurrentInstanceDeclaration;
         Program*                        m_CurrentProgram;
         // Misc state
         TextureFilter                   m_DefaultTextureMinFilter;
@@ -1582,13 +1584,17 @@ bail:
 
     static Pipeline* GetOrCreatePipeline(VkDevice vk_device, VkSampleCountFlagBits vk_sample_count,
         const PipelineState pipelineState, PipelineCache& pipelineCache,
-        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration)
+        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceDeclaration)
     {
         HashState64 pipeline_hash_state;
         dmHashInit64(&pipeline_hash_state, false);
         dmHashUpdateBuffer64(&pipeline_hash_state, &program->m_Hash, sizeof(program->m_Hash));
         dmHashUpdateBuffer64(&pipeline_hash_state, &pipelineState, sizeof(pipelineState));
         dmHashUpdateBuffer64(&pipeline_hash_state, &vertexDeclaration->m_Hash, sizeof(vertexDeclaration->m_Hash));
+        if (instanceDeclaration)
+        {
+            dmHashUpdateBuffer64(&pipeline_hash_state, &instanceDeclaration->m_Hash, sizeof(instanceDeclaration->m_Hash));
+        }
         dmHashUpdateBuffer64(&pipeline_hash_state, &rt->m_Id, sizeof(rt->m_Id));
         dmHashUpdateBuffer64(&pipeline_hash_state, &vk_sample_count, sizeof(vk_sample_count));
         uint64_t pipeline_hash = dmHashFinal64(&pipeline_hash_state);
@@ -1605,7 +1611,7 @@ bail:
             vk_scissor.offset.x = 0;
             vk_scissor.offset.y = 0;
 
-            VkResult res = CreatePipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, rt->m_RenderPass, &new_pipeline);
+            VkResult res = CreatePipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, instanceDeclaration, rt->m_RenderPass, &new_pipeline);
             CHECK_VK_ERROR(res);
 
             if (pipelineCache.Full())
@@ -1880,6 +1886,12 @@ bail:
 
     static void VulkanEnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer)
     {
+        if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+        {
+            context->m_CurrentInstanceBuffer      = (DeviceBuffer*) vertex_buffer;
+            context->m_CurrentInstanceDeclaration = (VertexDeclaration*) vertex_declaration;
+            return;
+        }
         context->m_CurrentVertexBuffer      = (DeviceBuffer*) vertex_buffer;
         context->m_CurrentVertexDeclaration = (VertexDeclaration*) vertex_declaration;
     }
@@ -1910,9 +1922,20 @@ bail:
 
     static void VulkanDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
     {
+        if (vertex_declaration->m_StepFunction == VERTEX_STEP_FUNCTION_INSTANCE)
+        {
+            context->m_CurrentInstanceBuffer      = 0;
+            context->m_CurrentInstanceDeclaration = 0;
+            return;
+        }
         context->m_CurrentVertexDeclaration = 0;
     }
 
+    static void VulkanSetVertexDeclarationStepFunction(HVertexDeclaration vertex_declaration, VertexStepFunction step_function)
+    {
+        vertex_declaration->m_StepFunction = step_function;
+    }
+
     static inline bool IsUniformTextureSampler(ShaderResourceBinding uniform)
     {
         return uniform.m_Type == ShaderDesc::SHADER_TYPE_SAMPLER2D ||
@@ -2188,7 +2211,7 @@ bail:
         Pipeline* pipeline = GetOrCreatePipeline(vk_device, vk_sample_count,
             context->m_PipelineState, context->m_PipelineCache,
             program_ptr, context->m_CurrentRenderTarget,
-            vertex_buffer, context->m_CurrentVertexDeclaration);
+            vertex_buffer, context->m_CurrentVertexDeclaration, context->m_CurrentInstanceDeclaration);
         vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
 
 
@@ -2206,10 +2229,16 @@ bail:
             vkCmdBindIndexBuffer(vk_command_buffer, indexBuffer->m_Handle.m_Buffer, 0, vk_index_type);
         }
 
-        // Bind the vertex buffers
-        VkBuffer vk_vertex_buffer             = vertex_buffer->m_Handle.m_Buffer;
-        VkDeviceSize vk_vertex_buffer_offsets = 0;
-        vkCmdBindVertexBuffers(vk_command_buffer, 0, 1, &vk_vertex_buffer, &vk_vertex_buffer_offsets);
+        // Bind the vertex buffers, the per-instance buffer goes to the second binding
+        VkBuffer vk_vertex_buffers[2]             = { vertex_buffer->m_Handle.m_Buffer, VK_NULL_HANDLE };
+        VkDeviceSize vk_vertex_buffer_offsets[2]  = { 0, 0 };
+        uint32_t vk_vertex_buffer_count           = 1;
+        if (context->m_CurrentInstanceDeclaration)
+        {
+            vk_vertex_buffers[1]   = context->m_CurrentInstanceBuffer->m_Handle.m_Buffer;
+            vk_vertex_buffer_count = 2;
+        }
+        vkCmdBindVertexBuffers(vk_command_buffer, 0, vk_vertex_buffer_count, vk_vertex_buffers, vk_vertex_buffer_offsets);
     }
 
     void VulkanHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
@@ -2223,6 +2252,7 @@ bail:
             dmHashUpdateBuffer32(state, &stream.m_Offset, sizeof(stream.m_Offset));
             dmHashUpdateBuffer32(state, &stream.m_Format, sizeof(stream.m_Format));
         }
+        dmHashUpdateBuffer32(state, &vertex_declaration->m_StepFunction, sizeof(vertex_declaration->m_StepFunction));
     }
 
     static void VulkanDrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer)
@@ -2249,6 +2279,33 @@ bail:
         vkCmdDraw(vk_command_buffer, count, 1, first, 0);
     }
 
+    static bool VulkanIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
+    static void VulkanDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        assert(context->m_FrameBegun);
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type);
+
+        uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
+        vkCmdDrawIndexed(vk_command_buffer, count, instance_count, index_offset, 0, 0);
+    }
+
+    static void VulkanDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(context->m_FrameBegun);
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
+        vkCmdDraw(vk_command_buffer, count, instance_count, first, 0);
+    }
+
     static void CreateShaderResourceBindings(ShaderModule* shader, ShaderDesc::Shader* ddf, uint32_t dynamicAlignment)
     {
         if (ddf->m_Uniforms.m_Count > 0)
@@ -2694,6 +2751,22 @@ bail:
         return -1;
     }
 
+    static int32_t VulkanGetAttributeLocation(HProgram prog, const char* name)
+    {
+        assert(prog);
+        Program* program_ptr = (Program*) prog;
+        ShaderModule* vs     = program_ptr->m_VertexModule;
+        dmhash_t name_hash   = dmHashString64(name);
+        for (uint32_t i=0; i < vs->m_AttributeCount; i++)
+        {
+            if (vs->m_Attributes[i].m_NameHash == name_hash)
+            {
+                return vs->m_Attributes[i].m_Binding;
+            }
+        }
+        return -1;
+    }
+
     static void VulkanSetConstantV4(HContext context, const Vectormath::Aos::Vector4* data, int base_register)
     {
         assert(context->m_CurrentProgram);
@@ -3617,6 +3690,10 @@ bail:
         fn_table.m_HashVertexDeclaration = VulkanHashVertexDeclaration;
         fn_table.m_DrawElements = VulkanDrawElements;
         fn_table.m_Draw = VulkanDraw;
+        fn_table.m_SetVertexDeclarationStepFunction = VulkanSetVertexDeclarationStepFunction;
+        fn_table.m_IsInstancingSupported = VulkanIsInstancingSupported;
+        fn_table.m_DrawElementsInstanced = VulkanDrawElementsInstanced;
+        fn_table.m_DrawInstanced = VulkanDrawInstanced;
         fn_table.m_NewVertexProgram = VulkanNewVertexProgram;
         fn_table.m_NewFragmentProgram = VulkanNewFragmentProgram;
         fn_table.m_NewProgram = VulkanNewProgram;
@@ -3632,6 +3709,7 @@ bail:
         fn_table.m_GetUniformName = VulkanGetUniformName;
         fn_table.m_GetUniformCount = VulkanGetUniformCount;
         fn_table.m_GetUniformLocation = VulkanGetUniformLocation;
+        fn_table.m_GetAttributeLocation = VulkanGetAttributeLocation;
         fn_table.m_SetConstantV4 = VulkanSetConstantV4;
         fn_table.m_SetConstantM4 = VulkanSetConstantM4;
         fn_table.m_SetSampler = VulkanSetSampler;
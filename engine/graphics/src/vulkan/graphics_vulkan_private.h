@@ -135,10 +135,11 @@ namespace dmGraphics
             // bool        m_Normalize;
         };
 
-        uint64_t    m_Hash;
-        Stream      m_Streams[DM_MAX_VERTEX_STREAM_COUNT];
-        uint16_t    m_StreamCount;
-        uint16_t    m_Stride;
+        uint64_t            m_Hash;
+        Stream              m_Streams[DM_MAX_VERTEX_STREAM_COUNT];
+        uint16_t            m_StreamCount;
+        uint16_t            m_Stride;
+        VertexStepFunction  m_StepFunction;
     };
 
     struct ScratchBuffer
@@ -404,7 +405,7 @@ namespace dmGraphics
         const void* source, uint32_t sourceSize, ShaderModule* shaderModuleOut);
     VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         const PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
-        HVertexDeclaration vertexDeclaration, const VkRenderPass vk_render_pass, Pipeline* pipelineOut);
+        HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceDeclaration, const VkRenderPass vk_render_pass, Pipeline* pipelineOut);
     // Reset functions
     void           ResetScratchBuffer(VkDevice vk_device, ScratchBuffer* scratchBuffer);
     // Destroy funcions
@@ -322,6 +322,7 @@ namespace dmGui
     void SetSceneAdjustReference(HScene scene, AdjustReference adjust_reference)
     {
         scene->m_AdjustReference = adjust_reference;
+        scene->m_DirtyRenderEntries = 1;
     }
 
     void SetDefaultNewSceneParams(NewSceneParams* params)
@@ -406,6 +407,7 @@ namespace dmGui
         scene->m_RigEventDataCallback = params->m_RigEventDataCallback;
         scene->m_OnWindowResizeCallback = params->m_OnWindowResizeCallback;
         scene->m_ScriptWorld = params->m_ScriptWorld;
+        scene->m_DirtyRenderEntries = 1;
 
         scene->m_Layers.Put(DEFAULT_LAYER, scene->m_NextLayerIndex++);
 
@@ -809,6 +811,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             if (nodes[i].m_Node.m_LayerHash == layer_hash)
                 nodes[i].m_Node.m_LayerIndex = index;
         }
+        scene->m_DirtyRenderEntries = 1;
         return RESULT_OK;
     }
 
@@ -908,6 +911,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             set_node_callback(scene, GetNodeHandle(n), n->m_Node.m_NodeDescTable[index]);
             n->m_Node.m_DirtyLocal = 1;
         }
+        scene->m_DirtyRenderEntries = 1;
         return RESULT_OK;
     }
 
@@ -1389,88 +1393,150 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         CollectRenderEntries(scene, scene->m_RenderHead, 0, 0x0, clippers, render_entries);
     }
 
-    void RenderScene(HScene scene, const RenderSceneParams& params, void* context)
+    static void CollectStencilScopes(HScene scene)
     {
-        Context* c = scene->m_Context;
-
-        UpdateDynamicTextures(scene, params, context);
-        DeferredDeleteDynamicTextures(scene, params, context);
-
-        c->m_RenderNodes.SetSize(0);
-        c->m_RenderTransforms.SetSize(0);
-        c->m_RenderOpacities.SetSize(0);
-        c->m_StencilClippingNodes.SetSize(0);
-        c->m_StencilScopes.SetSize(0);
-        c->m_StencilScopeIndices.SetSize(0);
-        uint32_t capacity = scene->m_NodePool.Size() * 2;
-        if (capacity > c->m_RenderNodes.Capacity())
-        {
-            c->m_RenderNodes.SetCapacity(capacity);
-            c->m_RenderTransforms.SetCapacity(capacity);
-            c->m_RenderOpacities.SetCapacity(capacity);
-            c->m_SceneTraversalCache.m_Data.SetCapacity(capacity);
-            c->m_SceneTraversalCache.m_Data.SetSize(capacity);
-            c->m_StencilClippingNodes.SetCapacity(capacity);
-            c->m_StencilScopes.SetCapacity(capacity);
-            c->m_StencilScopeIndices.SetCapacity(capacity);
-        }
-
-        c->m_SceneTraversalCache.m_NodeIndex = 0;
-        if(++c->m_SceneTraversalCache.m_Version == INVALID_INDEX)
-        {
-            c->m_SceneTraversalCache.m_Version = 0;
-        }
-
-        Matrix4 node_transform;
-        CollectNodes(scene, c->m_StencilClippingNodes, c->m_RenderNodes);
-        uint32_t node_count = c->m_RenderNodes.Size();
-        std::sort(c->m_RenderNodes.Begin(), c->m_RenderNodes.End(), RenderEntrySortPred(scene));
-        Matrix4 transform;
-
-        if (c->m_RenderNodes.Capacity() > c->m_RenderTransforms.Capacity())
-        {
-            uint32_t new_capacity = c->m_RenderNodes.Capacity();
-            c->m_RenderTransforms.SetCapacity(new_capacity);
-            c->m_RenderOpacities.SetCapacity(new_capacity);
-            c->m_SceneTraversalCache.m_Data.SetCapacity(new_capacity);
-            c->m_SceneTraversalCache.m_Data.SetSize(new_capacity);
-            c->m_StencilClippingNodes.SetCapacity(new_capacity);
-            c->m_StencilScopes.SetCapacity(new_capacity);
-            c->m_StencilScopeIndices.SetCapacity(new_capacity);
-        }
-
+        const dmArray<RenderEntry>& render_entries = scene->m_RenderNodes;
+        dmArray<InternalClippingNode>& clippers = scene->m_StencilClippingNodes;
+        dmArray<StencilScope*>& scopes = scene->m_StencilScopes;
+        uint32_t node_count = render_entries.Size();
         for (uint32_t i = 0; i < node_count; ++i)
         {
-            const RenderEntry& entry = c->m_RenderNodes[i];
+            const RenderEntry& entry = render_entries[i];
             uint16_t index = entry.m_Node & 0xffff;
             InternalNode* n = &scene->m_Nodes[index];
-            float opacity = 1.0f;
-            CalculateNodeSize(n);
-            CalculateNodeTransformAndAlphaCached(scene, n, CalculateNodeTransformFlags(CALCULATE_NODE_INCLUDE_SIZE | CALCULATE_NODE_RESET_PIVOT), transform, opacity);
-            c->m_RenderTransforms.Push(transform);
-            c->m_RenderOpacities.Push(opacity);
             if (n->m_ClipperIndex != INVALID_INDEX) {
-                InternalClippingNode* clipper = &c->m_StencilClippingNodes[n->m_ClipperIndex];
+                InternalClippingNode* clipper = &clippers[n->m_ClipperIndex];
                 if (clipper->m_NodeIndex == index) {
                     if (clipper->m_VisibleRenderKey == entry.m_RenderKey) {
                         StencilScope* scope = 0x0;
                         if (clipper->m_ParentIndex != INVALID_INDEX) {
-                            scope = &c->m_StencilClippingNodes[clipper->m_ParentIndex].m_ChildScope;
+                            scope = &clippers[clipper->m_ParentIndex].m_ChildScope;
                         }
-                        c->m_StencilScopes.Push(scope);
+                        scopes.Push(scope);
                     } else {
-                        c->m_StencilScopes.Push(&clipper->m_Scope);
+                        scopes.Push(&clipper->m_Scope);
                     }
                 } else {
-                    c->m_StencilScopes.Push(&clipper->m_ChildScope);
+                    scopes.Push(&clipper->m_ChildScope);
                 }
             } else {
-                c->m_StencilScopes.Push(0x0);
+                scopes.Push(0x0);
+            }
+        }
+    }
+
+    // Flags the enabled nodes that changed since the scene was last rendered, and their children, as dirty.
+    // Returns the number of dirty nodes.
+    static uint32_t FlagDirtyRenderNodes(HScene scene, uint16_t start_index, bool parent_dirty)
+    {
+        uint32_t dirty_count = 0;
+        uint16_t index = start_index;
+        while (index != INVALID_INDEX)
+        {
+            InternalNode* n = &scene->m_Nodes[index];
+            if (n->m_Node.m_Enabled)
+            {
+                bool dirty = parent_dirty || n->m_DirtyRender || n->m_Node.m_DirtyLocal;
+                if (n->m_Node.m_SizeMode != SIZE_MODE_MANUAL)
+                {
+                    // The size follows the flipbook animation
+                    Vector4 size = n->m_Node.m_Properties[PROPERTY_SIZE];
+                    CalculateNodeSize(n);
+                    const Vector4& new_size = n->m_Node.m_Properties[PROPERTY_SIZE];
+                    dirty = dirty || size.getX() != new_size.getX() || size.getY() != new_size.getY();
+                }
+                n->m_DirtyRender = dirty;
+                dirty_count += dirty ? 1 : 0;
+                dirty_count += FlagDirtyRenderNodes(scene, n->m_ChildHead, dirty);
+            }
+            index = n->m_NextIndex;
+        }
+        return dirty_count;
+    }
+
+    void RenderScene(HScene scene, const RenderSceneParams& params, void* context)
+    {
+        Context* c = scene->m_Context;
+
+        UpdateDynamicTextures(scene, params, context);
+        DeferredDeleteDynamicTextures(scene, params, context);
+
+        // The render entries of particlefx nodes depend on the emitters alive, which change without the scene knowing
+        bool collect = scene->m_DirtyRenderEntries || !scene->m_AliveParticlefxs.Empty();
+        if (collect)
+        {
+            scene->m_RenderNodes.SetSize(0);
+            scene->m_StencilClippingNodes.SetSize(0);
+            scene->m_StencilScopes.SetSize(0);
+            uint32_t capacity = scene->m_NodePool.Size() * 2;
+            if (capacity > scene->m_RenderNodes.Capacity())
+            {
+                scene->m_RenderNodes.SetCapacity(capacity);
+                scene->m_StencilClippingNodes.SetCapacity(capacity);
             }
+
+            CollectNodes(scene, scene->m_StencilClippingNodes, scene->m_RenderNodes);
+            std::sort(scene->m_RenderNodes.Begin(), scene->m_RenderNodes.End(), RenderEntrySortPred(scene));
+
+            uint32_t node_count = scene->m_RenderNodes.Size();
+            if (node_count > scene->m_StencilScopes.Capacity())
+            {
+                scene->m_StencilScopes.SetCapacity(scene->m_RenderNodes.Capacity());
+            }
+            CollectStencilScopes(scene);
+
+            scene->m_RenderTransforms.SetCapacity(scene->m_RenderNodes.Capacity());
+            scene->m_RenderTransforms.SetSize(node_count);
+            scene->m_RenderOpacities.SetCapacity(scene->m_RenderNodes.Capacity());
+            scene->m_RenderOpacities.SetSize(node_count);
+            scene->m_DirtyRenderEntries = 0;
         }
 
+        uint32_t node_count = scene->m_RenderNodes.Size();
+        bool update_all = collect || scene->m_ResChanged;
+        uint32_t dirty_count = update_all ? node_count : FlagDirtyRenderNodes(scene, scene->m_RenderHead, false);
+        if (dirty_count > 0)
+        {
+            uint32_t cache_capacity = dmMath::Max((uint32_t)scene->m_NodePool.Size() * 2, scene->m_RenderNodes.Capacity());
+            if (cache_capacity > c->m_SceneTraversalCache.m_Data.Size())
+            {
+                c->m_SceneTraversalCache.m_Data.SetCapacity(cache_capacity);
+                c->m_SceneTraversalCache.m_Data.SetSize(cache_capacity);
+            }
+            c->m_SceneTraversalCache.m_NodeIndex = 0;
+            if(++c->m_SceneTraversalCache.m_Version == INVALID_INDEX)
+            {
+                c->m_SceneTraversalCache.m_Version = 0;
+            }
+
+            Matrix4 transform;
+            for (uint32_t i = 0; i < node_count; ++i)
+            {
+                const RenderEntry& entry = scene->m_RenderNodes[i];
+                InternalNode* n = &scene->m_Nodes[entry.m_Node & 0xffff];
+                if (!update_all && !n->m_DirtyRender)
+                    continue;
+                float opacity = 1.0f;
+                if (update_all)
+                {
+                    CalculateNodeSize(n);
+                }
+                CalculateNodeTransformAndAlphaCached(scene, n, CalculateNodeTransformFlags(CALCULATE_NODE_INCLUDE_SIZE | CALCULATE_NODE_RESET_PIVOT), transform, opacity);
+                scene->m_RenderTransforms[i] = transform;
+                scene->m_RenderOpacities[i] = opacity;
+            }
+
+            // Nodes can have more than one render entry, so the flags are cleared once all transforms are calculated
+            for (uint32_t i = 0; i < node_count; ++i)
+            {
+                scene->m_Nodes[scene->m_RenderNodes[i].m_Node & 0xffff].m_DirtyRender = 0;
+            }
+        }
+
+        DM_COUNTER("Gui.DirtyRenderNodes", dirty_count);
+
         scene->m_ResChanged = 0;
-        params.m_RenderNodes(scene, c->m_RenderNodes.Begin(), c->m_RenderTransforms.Begin(), c->m_RenderOpacities.Begin(), (const StencilScope**)c->m_StencilScopes.Begin(), c->m_RenderNodes.Size(), context);
+        params.m_RenderNodes(scene, scene->m_RenderNodes.Begin(), scene->m_RenderTransforms.Begin(), scene->m_RenderOpacities.Begin(), (const StencilScope**)scene->m_StencilScopes.Begin(), node_count, context);
     }
 
     void RenderScene(HScene scene, RenderNodes render_nodes, void* context)
@@ -1977,6 +2043,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             dmParticle::DestroyInstance(scene->m_ParticlefxContext, c->m_Instance);
         }
         scene->m_AliveParticlefxs.SetSize(0);
+        scene->m_DirtyRenderEntries = 1;
 
         ClearLayouts(scene);
         return result;
@@ -2066,6 +2133,8 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
                 dmParticle::DestroyInstance(scene->m_ParticlefxContext, c->m_Instance);
                 scene->m_AliveParticlefxs.EraseSwap(i);
+                // The cached render entries point into the emitters of the destroyed instance
+                scene->m_DirtyRenderEntries = 1;
                 --count;
             }
             else
@@ -2285,6 +2354,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
     static void AddToNodeList(HScene scene, InternalNode* n, InternalNode* parent_n, InternalNode* prev_n)
     {
+        scene->m_DirtyRenderEntries = 1;
         uint16_t* head = &scene->m_RenderHead, * tail = &scene->m_RenderTail;
         uint16_t parent_index = INVALID_INDEX;
         if (parent_n != 0x0)
@@ -2329,6 +2399,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
 
     static void RemoveFromNodeList(HScene scene, InternalNode* n)
     {
+        scene->m_DirtyRenderEntries = 1;
         // Remove from list
         if (n->m_PrevIndex != INVALID_INDEX)
             scene->m_Nodes[n->m_PrevIndex].m_NextIndex = n->m_NextIndex;
@@ -2387,6 +2458,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
                         dmParticle::DestroyInstance(scene->m_ParticlefxContext, comp_n->m_Node.m_ParticleInstance);
                         n->m_Node.m_ParticleInstance = dmParticle::INVALID_INSTANCE;
                         scene->m_AliveParticlefxs.EraseSwap(i);
+                        scene->m_DirtyRenderEntries = 1;
                         --count;
                     }
                     else
@@ -2456,6 +2528,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         scene->m_RenderTail = INVALID_INDEX;
         scene->m_NodePool.Clear();
         scene->m_Animations.SetSize(0);
+        scene->m_DirtyRenderEntries = 1;
     }
 
     static Vector4 ApplyAdjustOnReferenceScale(const Vector4& reference_scale, uint32_t adjust_mode)
@@ -2557,6 +2630,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         }
 
         node.m_DirtyLocal = 0;
+        n->m_DirtyRender = 1;
     }
 
     void ResetNodes(HScene scene)
@@ -2573,6 +2647,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             }
         }
         scene->m_Animations.SetSize(0);
+        scene->m_DirtyRenderEntries = 1;
     }
 
     uint16_t GetRenderOrder(HScene scene)
@@ -2586,6 +2661,12 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         return (NodeType)n->m_Node.m_NodeType;
     }
 
+    uint16_t GetNodeIndex(HScene scene, HNode node)
+    {
+        InternalNode* n = GetNode(scene, node);
+        return n->m_Index;
+    }
+
     Point3 GetNodePosition(HScene scene, HNode node)
     {
         InternalNode* n = GetNode(scene, node);
@@ -2742,6 +2823,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             {
                 n->m_Node.m_Properties[PROPERTY_SIZE][0] = texture_info->m_OriginalWidth;
                 n->m_Node.m_Properties[PROPERTY_SIZE][1] = texture_info->m_OriginalHeight;
+                n->m_Node.m_DirtyLocal = 1;
             }
             return RESULT_OK;
         } else if (DynamicTexture* texture = scene->m_DynamicTextures.Get(texture_id)) {
@@ -2752,6 +2834,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             {
                 n->m_Node.m_Properties[PROPERTY_SIZE][0] = texture->m_Width;
                 n->m_Node.m_Properties[PROPERTY_SIZE][1] = texture->m_Height;
+                n->m_Node.m_DirtyLocal = 1;
             }
             return RESULT_OK;
         }
@@ -2858,6 +2941,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         create_params.m_Skeleton         = rig_data.m_Skeleton;
         create_params.m_MeshSet          = rig_data.m_MeshSet;
         create_params.m_AnimationSet     = rig_data.m_AnimationSet;
+        create_params.m_CompressedAnimationSet = rig_data.m_CompressedAnimationSet;
         create_params.m_PoseIdxToInfluence = rig_data.m_PoseIdxToInfluence;
         create_params.m_TrackIdxToPose     = rig_data.m_TrackIdxToPose;
         create_params.m_MeshId           = skin_id;
@@ -3130,6 +3214,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
             InternalNode* n = GetNode(scene, node);
             n->m_Node.m_LayerHash = layer_id;
             n->m_Node.m_LayerIndex = *layer_index;
+            scene->m_DirtyRenderEntries = 1;
             return RESULT_OK;
         }
         else
@@ -3153,6 +3238,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_InheritAlpha = inherit_alpha;
+        n->m_Node.m_DirtyLocal = 1;
     }
 
     float GetNodeFlipbookCursor(HScene scene, HNode node)
@@ -3433,6 +3519,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_ClippingMode = mode;
+        scene->m_DirtyRenderEntries = 1;
     }
 
     ClippingMode GetNodeClippingMode(HScene scene, HNode node)
@@ -3445,6 +3532,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_ClippingVisible = (uint32_t) visible;
+        scene->m_DirtyRenderEntries = 1;
     }
 
     bool GetNodeClippingVisible(HScene scene, HNode node)
@@ -3457,6 +3545,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_ClippingInverted = (uint32_t) inverted;
+        scene->m_DirtyRenderEntries = 1;
     }
 
     bool GetNodeClippingInverted(HScene scene, HNode node)
@@ -3577,6 +3666,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_Pivot = (uint32_t) pivot;
+        n->m_Node.m_DirtyLocal = 1;
     }
 
     bool GetNodeIsBone(HScene scene, HNode node)
@@ -3609,12 +3699,14 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
                 {
                     n->m_Node.m_Properties[PROPERTY_SIZE][0] = texture_info->m_OriginalWidth;
                     n->m_Node.m_Properties[PROPERTY_SIZE][1] = texture_info->m_OriginalHeight;
+                    n->m_Node.m_DirtyLocal = 1;
                 }
             }
             else if (DynamicTexture* texture = scene->m_DynamicTextures.Get(n->m_Node.m_TextureHash))
             {
                 n->m_Node.m_Properties[PROPERTY_SIZE][0] = texture->m_Width;
                 n->m_Node.m_Properties[PROPERTY_SIZE][1] = texture->m_Height;
+                n->m_Node.m_DirtyLocal = 1;
             }
         }
     }
@@ -4052,6 +4144,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
     {
         InternalNode* n = GetNode(scene, node);
         n->m_Node.m_Enabled = enabled;
+        scene->m_DirtyRenderEntries = 1;
         if(enabled)
         {
             SetDirtyLocalRecursive(scene, node);
@@ -141,6 +141,7 @@ namespace dmGui
         dmRigDDF::Skeleton*      m_Skeleton;
         dmRigDDF::MeshSet*       m_MeshSet;
         dmRigDDF::AnimationSet*  m_AnimationSet;
+        const dmRig::CompressedAnimationSet* m_CompressedAnimationSet;
         const dmArray<uint32_t>* m_PoseIdxToInfluence;
         const dmArray<uint32_t>* m_TrackIdxToPose;
         void*                    m_Texture;
@@ -899,6 +900,15 @@ namespace dmGui
 
     NodeType GetNodeType(HScene scene, HNode node);
 
+    /**
+     * Get the index of the node in the scene. The index is unique among the nodes
+     * alive in the scene and is reused when the node is deleted.
+     * @param scene
+     * @param node
+     * @return index less than the max node count of the scene
+     */
+    uint16_t GetNodeIndex(HScene scene, HNode node);
+
     Point3 GetNodePosition(HScene scene, HNode node);
 
     Vector4 GetNodeSlice9(HScene scene, HNode node);
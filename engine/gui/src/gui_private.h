@@ -88,12 +88,6 @@ namespace dmGui
         uint32_t                        m_DefaultProjectHeight;
         uint32_t                        m_Dpi;
         dmArray<HScene>                 m_Scenes;
-        dmArray<RenderEntry>            m_RenderNodes;
-        dmArray<Matrix4>                m_RenderTransforms;
-        dmArray<float>                	m_RenderOpacities;
-        dmArray<InternalClippingNode>   m_StencilClippingNodes;
-        dmArray<StencilScope*>          m_StencilScopes;
-        dmArray<uint16_t>               m_StencilScopeIndices;
         dmArray<HNode>                  m_ScratchBoneNodes;
         dmHID::HContext                 m_HidContext;
         void*                           m_DefaultFont;
@@ -180,7 +174,8 @@ namespace dmGui
         uint16_t        m_SceneTraversalCacheVersion;
         uint16_t        m_ClipperIndex;
         uint16_t        m_Deleted : 1; // Set to true for deferred deletion
-        uint16_t        m_Padding : 15;
+        uint16_t        m_DirtyRender : 1; // Set when the render transform might have changed since the scene was rendered
+        uint16_t        m_Padding : 14;
     };
 
     struct NodeProxy
@@ -302,6 +297,7 @@ namespace dmGui
         uint16_t                m_RenderOrder; // For the render-key
         uint16_t                m_NextLayerIndex;
         uint16_t                m_ResChanged : 1;
+        uint16_t                m_DirtyRenderEntries : 1; // Set when the render entries need to be collected and sorted
         uint32_t                m_Width;
         uint32_t                m_Height;
         dmScript::ScriptWorld*  m_ScriptWorld;
@@ -309,6 +305,13 @@ namespace dmGui
         FetchRigSceneDataCallback m_FetchRigSceneDataCallback;
         RigEventDataCallback    m_RigEventDataCallback;
         OnWindowResizeCallback   m_OnWindowResizeCallback;
+        /// Sorted render entries with their transforms and stencil scopes, kept between frames
+        /// and only recalculated for the parts of the scene that changed
+        dmArray<RenderEntry>            m_RenderNodes;
+        dmArray<Matrix4>                m_RenderTransforms;
+        dmArray<float>                  m_RenderOpacities;
+        dmArray<InternalClippingNode>   m_StencilClippingNodes;
+        dmArray<StencilScope*>          m_StencilScopes;
     };
 
     InternalNode* GetNode(HScene scene, HNode node);
@@ -5672,6 +5672,53 @@ TEST_F(dmGuiTest, KeepParticlefxOnNodeDeletion)
     UnloadParticlefxPrototype(prototype);
 }
 
+static void CountParticlefxEmitterEntries(dmGui::HScene scene, const dmGui::RenderEntry* nodes, const Vectormath::Aos::Matrix4* node_transforms, const float* node_opacities,
+        const dmGui::StencilScope** stencil_scopes, uint32_t node_count, void* context)
+{
+    uint32_t* count = (uint32_t*)context;
+    *count = 0;
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+        if (nodes[i].m_RenderData != 0x0)
+            ++*count;
+    }
+}
+
+// The cached render entries must be collected again when a sleeping particlefx instance is pruned,
+// since the emitter entries point into the destroyed instance
+TEST_F(dmGuiTest, RenderAfterParticlefxSleeps)
+{
+    dmParticle::HPrototype prototype;
+    const char* particlefx_name = "once.particlefxc";
+    ASSERT_TRUE(LoadParticlefxPrototype(particlefx_name, &prototype));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::AddParticlefx(m_Scene, particlefx_name, (void*)prototype));
+
+    dmGui::HNode node_pfx = dmGui::NewNode(m_Scene, Point3(0,0,0), Vector3(1,1,1), dmGui::NODE_TYPE_PARTICLEFX);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeParticlefx(m_Scene, node_pfx, dmHashString64(particlefx_name)));
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::PlayNodeParticlefx(m_Scene, node_pfx, 0));
+
+    dmGui::RenderSceneParams rp;
+    rp.m_RenderNodes = CountParticlefxEmitterEntries;
+    uint32_t emitter_entries = 0;
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::UpdateScene(m_Scene, 1.0f / 60.0f));
+    dmGui::RenderScene(m_Scene, rp, &emitter_entries);
+    ASSERT_EQ(1U, emitter_entries);
+
+    // Spawning & Postspawn, then sleeping and pruned by UpdateScene
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        dmParticle::Update(m_Scene->m_ParticlefxContext, 1.2f, 0);
+        ASSERT_EQ(dmGui::RESULT_OK, dmGui::UpdateScene(m_Scene, 1.2f));
+    }
+    ASSERT_EQ(0U, dmGui::GetParticlefxCount(m_Scene));
+
+    dmGui::RenderScene(m_Scene, rp, &emitter_entries);
+    ASSERT_EQ(0U, emitter_entries);
+
+    dmGui::DeleteNode(m_Scene, node_pfx, true);
+    UnloadParticlefxPrototype(prototype);
+}
+
 TEST_F(dmGuiTest, PlayNodeParticlefx)
 {
     uint32_t width = 100;
@@ -6199,6 +6246,105 @@ TEST_F(dmGuiTest, InheritAlpha)
     ASSERT_EQ(dmGui::RESULT_OK, r);
 }
 
+struct RenderedNode
+{
+    Matrix4 m_Transform;
+    float   m_Opacity;
+};
+
+static void RenderNodesCapture(dmGui::HScene scene, const dmGui::RenderEntry* nodes, const Vectormath::Aos::Matrix4* node_transforms, const float* node_opacities,
+        const dmGui::StencilScope** stencil_scopes, uint32_t node_count, void* context)
+{
+    std::map<dmGui::HNode, RenderedNode>* rendered = (std::map<dmGui::HNode, RenderedNode>*)context;
+    rendered->clear();
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+        RenderedNode& r = (*rendered)[nodes[i].m_Node];
+        r.m_Transform = node_transforms[i];
+        r.m_Opacity = node_opacities[i];
+    }
+}
+
+// Renders the scene incrementally, then with all render entries rebuilt, and verifies that both produce the same result
+static void AssertIncrementalRender(dmGui::HScene scene)
+{
+    std::map<dmGui::HNode, RenderedNode> incremental;
+    std::map<dmGui::HNode, RenderedNode> full;
+    dmGui::RenderScene(scene, &RenderNodesCapture, &incremental);
+    scene->m_DirtyRenderEntries = 1;
+    dmGui::RenderScene(scene, &RenderNodesCapture, &full);
+
+    ASSERT_EQ(full.size(), incremental.size());
+    std::map<dmGui::HNode, RenderedNode>::iterator it = full.begin();
+    for (; it != full.end(); ++it)
+    {
+        ASSERT_TRUE(incremental.find(it->first) != incremental.end());
+        const RenderedNode& a = incremental[it->first];
+        const RenderedNode& b = it->second;
+        ASSERT_EQ(b.m_Opacity, a.m_Opacity);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            for (uint32_t r = 0; r < 4; ++r)
+            {
+                ASSERT_EQ(b.m_Transform.getElem(c, r), a.m_Transform.getElem(c, r));
+            }
+        }
+    }
+}
+
+TEST_F(dmGuiTest, IncrementalRender)
+{
+    Vector3 size(10, 10, 0);
+    dmGui::AddLayer(m_Scene, "layer1");
+
+    dmGui::HNode root = dmGui::NewNode(m_Scene, Point3(10, 10, 0), size, dmGui::NODE_TYPE_BOX);
+    dmGui::HNode child = dmGui::NewNode(m_Scene, Point3(5, 0, 0), size, dmGui::NODE_TYPE_BOX);
+    dmGui::HNode grand_child = dmGui::NewNode(m_Scene, Point3(0, 5, 0), size, dmGui::NODE_TYPE_BOX);
+    dmGui::HNode other = dmGui::NewNode(m_Scene, Point3(20, 20, 0), size, dmGui::NODE_TYPE_BOX);
+    dmGui::SetNodeParent(m_Scene, child, root, false);
+    dmGui::SetNodeParent(m_Scene, grand_child, child, false);
+    AssertIncrementalRender(m_Scene);
+
+    // Unchanged scene reuses the render entries
+    std::map<dmGui::HNode, RenderedNode> rendered;
+    dmGui::RenderScene(m_Scene, &RenderNodesCapture, &rendered);
+    ASSERT_EQ(0U, m_Scene->m_DirtyRenderEntries);
+    ASSERT_EQ(4U, rendered.size());
+    ASSERT_EQ(4U, m_Scene->m_RenderNodes.Size());
+
+    // Transform and color of a parent propagates to the subtree
+    float child_x = rendered[child].m_Transform.getTranslation().getX();
+    dmGui::SetNodePosition(m_Scene, root, Point3(30, 10, 0));
+    AssertIncrementalRender(m_Scene);
+    dmGui::RenderScene(m_Scene, &RenderNodesCapture, &rendered);
+    ASSERT_NEAR(child_x + 20.0f, rendered[child].m_Transform.getTranslation().getX(), EPSILON);
+
+    dmGui::SetNodeProperty(m_Scene, child, dmGui::PROPERTY_COLOR, Vector4(1, 1, 1, 0.5f));
+    AssertIncrementalRender(m_Scene);
+    dmGui::SetNodePivot(m_Scene, grand_child, dmGui::PIVOT_SW);
+    AssertIncrementalRender(m_Scene);
+
+    // Structural changes
+    dmGui::SetNodeParent(m_Scene, grand_child, other, false);
+    AssertIncrementalRender(m_Scene);
+    dmGui::SetNodeEnabled(m_Scene, child, false);
+    AssertIncrementalRender(m_Scene);
+    dmGui::RenderScene(m_Scene, &RenderNodesCapture, &rendered);
+    ASSERT_EQ(3U, rendered.size());
+    dmGui::SetNodeEnabled(m_Scene, child, true);
+    AssertIncrementalRender(m_Scene);
+    ASSERT_EQ(dmGui::RESULT_OK, dmGui::SetNodeLayer(m_Scene, root, "layer1"));
+    AssertIncrementalRender(m_Scene);
+
+    dmGui::HNode new_node = dmGui::NewNode(m_Scene, Point3(1, 2, 0), size, dmGui::NODE_TYPE_BOX);
+    dmGui::SetNodeParent(m_Scene, new_node, child, false);
+    AssertIncrementalRender(m_Scene);
+    dmGui::DeleteNode(m_Scene, other, true);
+    AssertIncrementalRender(m_Scene);
+    dmGui::RenderScene(m_Scene, &RenderNodesCapture, &rendered);
+    ASSERT_EQ(3U, rendered.size());
+}
+
 int main(int argc, char **argv)
 {
     dmDDF::RegisterAllTypes();
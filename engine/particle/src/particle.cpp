@@ -17,6 +17,7 @@
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/vmath.h>
 #include <dlib/profile.h>
 #include <dlib/time.h>
@@ -24,6 +25,14 @@
 #include "particle.h"
 #include "particle_private.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_PARTICLE_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define DM_PARTICLE_NEON
+    #include <arm_neon.h>
+#endif
+
 namespace dmParticle
 {
     using namespace dmParticleDDF;
@@ -97,6 +106,11 @@ namespace dmParticle
         context->m_MaxParticleCount = max_particle_count;
     }
 
+    void SetWorkerPool(HParticleContext context, dmWorkerPool::HWorkerPool pool)
+    {
+        context->m_WorkerPool = pool;
+    }
+
     static Instance* GetInstance(HParticleContext context, HInstance instance)
     {
         if (instance == INVALID_INSTANCE)
@@ -157,19 +171,12 @@ namespace dmParticle
         return GetValue(segments, segment_index, t);
     }
 
-    void SampleProperty(const dmParticleDDF::SplinePoint* segments, uint32_t segments_count, LinearSegment* out_segments)
+    // Samples the spline at PROPERTY_SAMPLE_COUNT + 1 evenly spaced points, stride is the distance between the samples in floats
+    static void BakeProperty(const dmParticleDDF::SplinePoint* segments, uint32_t segments_count, float* out_samples, uint32_t stride)
     {
-        float dx = 1.0f / PROPERTY_SAMPLE_COUNT;
-        float x0 = 0.0f;
-        float y0 = GetY(segments, segments_count, x0);
-        for (uint32_t j = 0; j < PROPERTY_SAMPLE_COUNT; ++j)
+        for (uint32_t j = 0; j <= PROPERTY_SAMPLE_COUNT; ++j)
         {
-            float y1 = GetY(segments, segments_count, x0 + dx);
-            out_segments[j].m_X = x0;
-            out_segments[j].m_Y = y0;
-            out_segments[j].m_K = (y1 - y0) * PROPERTY_SAMPLE_COUNT;
-            x0 += dx;
-            y0 = y1;
+            out_samples[j * stride] = GetY(segments, segments_count, j / (float)PROPERTY_SAMPLE_COUNT);
         }
     }
 
@@ -259,6 +266,24 @@ namespace dmParticle
         delete i;
     }
 
+    static void NotifyEmitterStateChanged(Instance* instance, Emitter* emitter, EmitterState state)
+    {
+        if(state == EMITTER_STATE_PRESPAWN)
+        {
+            instance->m_NumAwakeEmitters += 1;
+        }
+        else if(state == EMITTER_STATE_SLEEPING)
+        {
+            instance->m_NumAwakeEmitters -= 1;
+        }
+
+        instance->m_EmitterStateChangedData.m_StateChangedCallback(
+            instance->m_NumAwakeEmitters,
+            emitter->m_Id,
+            state,
+            instance->m_EmitterStateChangedData.m_UserData);
+    }
+
     void SetEmitterState(Instance* instance, Emitter* emitter, EmitterState state)
     {
         EmitterState old_emitter_state = emitter->m_State;
@@ -266,21 +291,24 @@ namespace dmParticle
 
         if(state != old_emitter_state && instance->m_EmitterStateChangedData.m_UserData != 0x0)
         {
-            if(state == EMITTER_STATE_PRESPAWN)
-            {
-                instance->m_NumAwakeEmitters += 1;
-            }
-            else if(state == EMITTER_STATE_SLEEPING)
+            // The callback isn't thread safe, it is invoked by FlushEmitterStateChanges once the worker threads are done
+            if (emitter->m_DeferStateChanges)
             {
-                instance->m_NumAwakeEmitters -= 1;
+                assert(emitter->m_DeferredStateCount < MAX_DEFERRED_STATE_COUNT);
+                emitter->m_DeferredStates[emitter->m_DeferredStateCount++] = state;
+                return;
             }
+            NotifyEmitterStateChanged(instance, emitter, state);
+        }
+    }
 
-            instance->m_EmitterStateChangedData.m_StateChangedCallback(
-                instance->m_NumAwakeEmitters,
-                emitter->m_Id,
-                emitter->m_State,
-                instance->m_EmitterStateChangedData.m_UserData);
+    static void FlushEmitterStateChanges(Instance* instance, Emitter* emitter)
+    {
+        for (uint32_t i = 0; i < emitter->m_DeferredStateCount; ++i)
+        {
+            NotifyEmitterStateChanged(instance, emitter, emitter->m_DeferredStates[i]);
         }
+        emitter->m_DeferredStateCount = 0;
     }
 
     static bool IsSleeping(Emitter* emitter);
@@ -576,11 +604,9 @@ namespace dmParticle
     static void UpdateParticles(Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt);
     static void UpdateEmitterState(Instance* instance, Emitter* emitter, EmitterPrototype* emitter_prototype, dmParticleDDF::Emitter* emitter_ddf, float dt);
     static void EvaluateEmitterProperties(Emitter* emitter, Property* emitter_properties, float duration, float properties[EMITTER_KEY_COUNT]);
-    static void EvaluateParticleProperties(Emitter* emitter, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt);
     static uint32_t UpdateRenderData(HParticleContext context, Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* ddf, const Vector4& color, uint32_t vertex_index, void* vertex_buffer, uint32_t vertex_buffer_size, float dt, ParticleVertexFormat format);
     static void GenerateKeys(Emitter* emitter, float max_particle_life_time);
     static void SortParticles(Emitter* emitter);
-    static void Simulate(Instance* instance, Emitter* emitter, EmitterPrototype* prototype, dmParticleDDF::Emitter* ddf, float dt);
 
     static void UpdateEmitter(Prototype* prototype, Instance* instance, EmitterPrototype* emitter_prototype, Emitter* emitter, dmParticleDDF::Emitter* emitter_ddf, float dt)
     {
@@ -618,6 +644,21 @@ namespace dmParticle
         emitter->m_LastPosition = world_position;
     }
 
+    static uint32_t GetVertexSize(ParticleVertexFormat vertex_format)
+    {
+        switch (vertex_format)
+        {
+        case PARTICLE_GUI:          return sizeof(ParticleGuiVertex);
+        case PARTICLE_GO_COMPACT:   return sizeof(ParticleCompactVertex);
+        default:                    return sizeof(Vertex);
+        }
+    }
+
+    static uint32_t GetVertexCountPerParticle(ParticleVertexFormat vertex_format)
+    {
+        return vertex_format == PARTICLE_GO_COMPACT ? 1 : 6;
+    }
+
     void GenerateVertexData(HParticleContext context, float dt, HInstance instance, uint32_t emitter_index, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format)
     {
         DM_PROFILE(Particle, "GenerateVertexData");
@@ -629,12 +670,7 @@ namespace dmParticle
         if (IsSleeping(inst))
             return;
 
-        uint32_t vertex_size = sizeof(Vertex);
-
-        if (vertex_format == PARTICLE_GUI)
-        {
-            vertex_size = sizeof(ParticleGuiVertex);
-        }
+        uint32_t vertex_size = GetVertexSize(vertex_format);
 
         // vertex buffer index for each emitter
         uint32_t vertex_index = 0;
@@ -651,13 +687,213 @@ namespace dmParticle
         *out_vertex_buffer_size = vertex_index * vertex_size;
 
 
-        context->m_Stats.m_Particles = vertex_index / 6; // Debug data for editor playback
+        context->m_Stats.m_Particles = vertex_index / GetVertexCountPerParticle(vertex_format); // Debug data for editor playback
+    }
+
+    struct GenerateVertexDataContext
+    {
+        HParticleContext        m_Context;
+        EmitterTask*            m_Tasks;
+        Vector4                 m_Color;
+        void*                   m_VertexBuffer;
+        uint32_t                m_VertexBufferSize;
+        float                   m_DT;
+        ParticleVertexFormat    m_VertexFormat;
+    };
+
+    static void GenerateVertexDataTask(void* _ctx, uint32_t index)
+    {
+        GenerateVertexDataContext* ctx = (GenerateVertexDataContext*)_ctx;
+        EmitterTask* task = &ctx->m_Tasks[index];
+        Instance* inst = task->m_Instance;
+        Emitter* emitter = &inst->m_Emitters[task->m_EmitterIndex];
+        dmParticleDDF::Emitter* emitter_ddf = &inst->m_Prototype->m_DDF->m_Emitters[task->m_EmitterIndex];
+        UpdateRenderData(ctx->m_Context, inst, emitter, emitter_ddf, ctx->m_Color, task->m_VertexIndex, ctx->m_VertexBuffer, ctx->m_VertexBufferSize, ctx->m_DT, ctx->m_VertexFormat);
+    }
+
+    void GenerateVertexData(HParticleContext context, float dt, const EmitterRenderData** emitters, uint32_t emitter_count, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format)
+    {
+        DM_PROFILE(Particle, "GenerateVertexData");
+
+        uint32_t vertex_size = GetVertexSize(vertex_format);
+
+        uint32_t vertex_count_per_particle = GetVertexCountPerParticle(vertex_format);
+        uint32_t vertex_index = *out_vertex_buffer_size / vertex_size;
+        uint32_t max_vertex_count = vertex_buffer_size / vertex_size;
+
+        dmArray<EmitterTask>& tasks = context->m_EmitterTasks;
+        tasks.SetSize(0);
+        if (tasks.Capacity() < emitter_count)
+        {
+            tasks.SetCapacity(emitter_count);
+        }
+
+        // Assign each emitter the range of vertices it would have been given when generated in order
+        for (uint32_t i = 0; i < emitter_count; ++i)
+        {
+            HInstance instance = emitters[i]->m_Instance;
+            if (instance == INVALID_INSTANCE)
+                continue;
+
+            Instance* inst = GetInstance(context, instance);
+            if (IsSleeping(inst) || vertex_buffer == 0x0 || vertex_buffer_size == 0)
+                continue;
+
+            EmitterTask task;
+            task.m_Instance = inst;
+            task.m_InstanceHandle = instance;
+            task.m_EmitterIndex = emitters[i]->m_EmitterIndex;
+            task.m_VertexIndex = vertex_index;
+            tasks.Push(task);
+
+            uint32_t particle_count = inst->m_Emitters[task.m_EmitterIndex].m_Particles.Size();
+            uint32_t max_particle_count = vertex_index < max_vertex_count ? (max_vertex_count - vertex_index) / vertex_count_per_particle : 0;
+            vertex_index += dmMath::Min(particle_count, max_particle_count) * vertex_count_per_particle;
+        }
+
+        GenerateVertexDataContext ctx;
+        ctx.m_Context = context;
+        ctx.m_Tasks = tasks.Begin();
+        ctx.m_Color = color;
+        ctx.m_VertexBuffer = vertex_buffer;
+        ctx.m_VertexBufferSize = vertex_buffer_size;
+        ctx.m_DT = dt;
+        ctx.m_VertexFormat = vertex_format;
+        dmWorkerPool::Run(context->m_WorkerPool, GenerateVertexDataTask, &ctx, tasks.Size());
+
+        *out_vertex_buffer_size = vertex_index * vertex_size;
+
+        context->m_Stats.m_Particles = vertex_index / GetVertexCountPerParticle(vertex_format); // Debug data for editor playback
+    }
+
+    static void UpdateSleepingInstance(Instance* instance, float dt)
+    {
+        // update velocity and clear vertex count (don't render)
+        uint32_t emitter_count = instance->m_Emitters.Size();
+        for (uint32_t emitter_i = 0; emitter_i < emitter_count; ++emitter_i)
+        {
+            Emitter* emitter = &instance->m_Emitters[emitter_i];
+            emitter->m_VertexCount = 0;
+            dmParticleDDF::Emitter* emitter_ddf = &instance->m_Prototype->m_DDF->m_Emitters[emitter_i];
+            UpdateEmitterVelocity(instance, emitter, emitter_ddf, dt);
+        }
+    }
+
+    // The parts of the emitter update that invoke callbacks, these are always run on the calling thread
+    static uint32_t FinishEmitterUpdate(HInstance instance_handle, Instance* instance, uint32_t emitter_i, FetchAnimationCallback fetch_animation_callback)
+    {
+        Prototype* prototype = instance->m_Prototype;
+        Emitter* emitter = &instance->m_Emitters[emitter_i];
+        EmitterPrototype* emitter_prototype = &prototype->m_Emitters[emitter_i];
+        dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[emitter_i];
+
+        FetchAnimation(emitter, emitter_prototype, fetch_animation_callback);
+        UpdateEmitterRenderData(instance_handle, emitter_i, instance, emitter, emitter_ddf);
+
+        if (emitter->m_ReHash)
+            ReHashEmitter(emitter);
+        return (uint32_t)emitter->m_Particles.Size();
+    }
+
+    struct UpdateEmittersContext
+    {
+        EmitterTask*    m_Tasks;
+        float           m_DT;
+    };
+
+    static void UpdateEmitterTask(void* _ctx, uint32_t index)
+    {
+        UpdateEmittersContext* ctx = (UpdateEmittersContext*)_ctx;
+        EmitterTask* task = &ctx->m_Tasks[index];
+        Instance* instance = task->m_Instance;
+        Prototype* prototype = instance->m_Prototype;
+        uint32_t emitter_i = task->m_EmitterIndex;
+        Emitter* emitter = &instance->m_Emitters[emitter_i];
+
+        emitter->m_DeferStateChanges = 1;
+        UpdateEmitter(prototype, instance, &prototype->m_Emitters[emitter_i], emitter, &prototype->m_DDF->m_Emitters[emitter_i], ctx->m_DT);
+        emitter->m_DeferStateChanges = 0;
+    }
+
+    // Simulates the emitters on the worker pool. Each emitter only touches its own particles and seed,
+    // so the result is the same as when updating serially.
+    static void UpdateParallel(HParticleContext context, float dt, FetchAnimationCallback fetch_animation_callback)
+    {
+        dmArray<EmitterTask>& tasks = context->m_EmitterTasks;
+        tasks.SetSize(0);
+
+        uint32_t size = context->m_Instances.Size();
+        for (uint32_t i = 0; i < size; i++)
+        {
+            Instance* instance = context->m_Instances[i];
+
+            // empty slot
+            if (instance == 0x0) continue;
+            // don't update sleeping instances
+            if (IsSleeping(instance))
+            {
+                UpdateSleepingInstance(instance, dt);
+                continue;
+            }
+            uint32_t instance_handle = instance->m_VersionNumber << 16 | i;
+            instance->m_PlayTime += dt;
+            uint32_t emitter_count = instance->m_Emitters.Size();
+            if (tasks.Remaining() < emitter_count)
+            {
+                tasks.OffsetCapacity(dmMath::Max(emitter_count, 32u));
+            }
+            for (uint32_t emitter_i = 0; emitter_i < emitter_count; ++emitter_i)
+            {
+                Emitter* emitter = &instance->m_Emitters[emitter_i];
+                dmParticleDDF::Emitter* emitter_ddf = &instance->m_Prototype->m_DDF->m_Emitters[emitter_i];
+                UpdateEmitterVelocity(instance, emitter, emitter_ddf, dt);
+
+                EmitterTask task;
+                task.m_Instance = instance;
+                task.m_InstanceHandle = instance_handle;
+                task.m_EmitterIndex = emitter_i;
+                task.m_VertexIndex = 0;
+                tasks.Push(task);
+            }
+        }
+
+        uint32_t task_count = tasks.Size();
+        if (task_count == 0)
+        {
+            DM_COUNTER("Particles alive", 0);
+            return;
+        }
+
+        UpdateEmittersContext ctx;
+        ctx.m_Tasks = tasks.Begin();
+        ctx.m_DT = dt;
+        {
+            DM_PROFILE(Particle, "UpdateEmitters");
+            dmWorkerPool::Run(context->m_WorkerPool, UpdateEmitterTask, &ctx, task_count);
+        }
+
+        uint32_t TotalAliveParticles = 0;
+        for (uint32_t i = 0; i < task_count; ++i)
+        {
+            EmitterTask* task = &tasks[i];
+            Instance* instance = task->m_Instance;
+            FlushEmitterStateChanges(instance, &instance->m_Emitters[task->m_EmitterIndex]);
+            TotalAliveParticles += FinishEmitterUpdate(task->m_InstanceHandle, instance, task->m_EmitterIndex, fetch_animation_callback);
+        }
+
+        DM_COUNTER("Particles alive", TotalAliveParticles);
     }
 
     void Update(HParticleContext context, float dt, FetchAnimationCallback fetch_animation_callback)
     {
         DM_PROFILE(Particle, "Update");
 
+        if (dmWorkerPool::GetThreadCount(context->m_WorkerPool) > 0)
+        {
+            UpdateParallel(context, dt, fetch_animation_callback);
+            return;
+        }
+
         uint32_t size = context->m_Instances.Size();
         uint32_t TotalAliveParticles = 0;
         for (uint32_t i = 0; i < size; i++)
@@ -669,15 +905,7 @@ namespace dmParticle
             // don't update sleeping instances
             if (IsSleeping(instance))
             {
-                // update velocity and clear vertex count (don't render)
-                uint32_t emitter_count = instance->m_Emitters.Size();
-                for (uint32_t emitter_i = 0; emitter_i < emitter_count; ++emitter_i)
-                {
-                    Emitter* emitter = &instance->m_Emitters[emitter_i];
-                    emitter->m_VertexCount = 0;
-                    dmParticleDDF::Emitter* emitter_ddf = &instance->m_Prototype->m_DDF->m_Emitters[emitter_i];
-                    UpdateEmitterVelocity(instance, emitter, emitter_ddf, dt);
-                }
+                UpdateSleepingInstance(instance, dt);
                 continue;
             }
             uint32_t instance_handle = instance->m_VersionNumber << 16 | i;
@@ -692,12 +920,7 @@ namespace dmParticle
 
                 UpdateEmitterVelocity(instance, emitter, emitter_ddf, dt);
                 UpdateEmitter(prototype, instance, emitter_prototype, emitter, emitter_ddf, dt);
-                TotalAliveParticles += (uint32_t)emitter->m_Particles.Size();
-                FetchAnimation(emitter, emitter_prototype, fetch_animation_callback);
-                UpdateEmitterRenderData(instance_handle, emitter_i, instance, emitter, emitter_ddf);
-
-                if (emitter->m_ReHash)
-                    ReHashEmitter(emitter);
+                TotalAliveParticles += FinishEmitterUpdate(instance_handle, instance, emitter_i, fetch_animation_callback);
             }
         }
 
@@ -1015,10 +1238,8 @@ namespace dmParticle
             2,3,0,0,1,2		//hv
         };
 
-        uint32_t vertex_size = sizeof(Vertex);
-
-        if (format == PARTICLE_GUI)
-            vertex_size = sizeof(ParticleGuiVertex);
+        uint32_t vertex_size = GetVertexSize(format);
+        uint32_t vertex_count_per_particle = GetVertexCountPerParticle(format);
 
         emitter->m_VertexIndex = vertex_index;
         emitter->m_VertexCount = 0;
@@ -1084,7 +1305,7 @@ namespace dmParticle
             height_factor *= 0.5f;
         }
 
-        for (j = 0; j < particle_count && vertex_index + 6 <= max_vertex_count; j++)
+        for (j = 0; j < particle_count && vertex_index + vertex_count_per_particle <= max_vertex_count; j++)
         {
             Particle* particle = &emitter->m_Particles[j];
             // Evaluate anim frame
@@ -1136,14 +1357,6 @@ namespace dmParticle
             particle_transform.SetTranslation(Vector3(Apply(emission_transform, Point3(particle_transform.GetTranslation()))));
             particle_transform.SetScale(emission_transform.GetScale() * particle_transform.GetScale());
 
-            Vector3 x = dmTransform::Apply(particle_transform, Vector3(width_factor, 0.0f, 0.0f));
-            Vector3 y = dmTransform::Apply(particle_transform, Vector3(0.0f, height_factor, 0.0f));
-
-            Vector3 p0 = -x - y + particle_transform.GetTranslation();
-            Vector3 p1 = -x + y + particle_transform.GetTranslation();
-            Vector3 p2 = x - y + particle_transform.GetTranslation();
-            Vector3 p3 = x + y + particle_transform.GetTranslation();
-
             uint32_t flip_flag = 0;
             if (hFlip)
             {
@@ -1158,6 +1371,45 @@ namespace dmParticle
             Vector4 c = particle->GetColor();
             c = Vector4(mulPerElem(c.getXYZ(), color.getXYZ()), c.getW() * color.getW());
 
+            if (format == PARTICLE_GO_COMPACT)
+            {
+                // The quad is expanded by the vertex program, no per vertex transforms
+                ParticleCompactVertex* vertex = &((ParticleCompactVertex*)vertex_buffer)[vertex_index];
+                Vector3 translation = particle_transform.GetTranslation();
+                Quat rotation = particle_transform.GetRotation();
+                Vector3 scale = particle_transform.GetScale();
+                vertex->m_Position[0] = translation.getX();
+                vertex->m_Position[1] = translation.getY();
+                vertex->m_Position[2] = translation.getZ();
+                vertex->m_Rotation[0] = rotation.getX();
+                vertex->m_Rotation[1] = rotation.getY();
+                vertex->m_Rotation[2] = rotation.getZ();
+                vertex->m_Rotation[3] = rotation.getW();
+                vertex->m_Size[0] = width_factor * scale.getX();
+                vertex->m_Size[1] = height_factor * scale.getY();
+                vertex->m_UV[0] = tex_coord[tex_lookup[0] * 2];
+                vertex->m_UV[1] = tex_coord[tex_lookup[0] * 2 + 1];
+                vertex->m_UV[2] = tex_coord[tex_lookup[2] * 2];
+                vertex->m_UV[3] = tex_coord[tex_lookup[2] * 2 + 1];
+                vertex->m_Color[0] = (uint8_t)(dmMath::Clamp(c.getX(), 0.0f, 1.0f) * 255.0f + 0.5f);
+                vertex->m_Color[1] = (uint8_t)(dmMath::Clamp(c.getY(), 0.0f, 1.0f) * 255.0f + 0.5f);
+                vertex->m_Color[2] = (uint8_t)(dmMath::Clamp(c.getZ(), 0.0f, 1.0f) * 255.0f + 0.5f);
+                vertex->m_Color[3] = (uint8_t)(dmMath::Clamp(c.getW(), 0.0f, 1.0f) * 255.0f + 0.5f);
+                // The (-x, +y) corner shares u with the (-x, -y) corner, unless the tile is rotated
+                vertex->m_UVRotated = tex_coord[tex_lookup[1] * 2] != tex_coord[tex_lookup[0] * 2] ? 255 : 0;
+                vertex->m_Pad[0] = vertex->m_Pad[1] = vertex->m_Pad[2] = 0;
+                vertex_index += 1;
+                continue;
+            }
+
+            Vector3 x = dmTransform::Apply(particle_transform, Vector3(width_factor, 0.0f, 0.0f));
+            Vector3 y = dmTransform::Apply(particle_transform, Vector3(0.0f, height_factor, 0.0f));
+
+            Vector3 p0 = -x - y + particle_transform.GetTranslation();
+            Vector3 p1 = -x + y + particle_transform.GetTranslation();
+            Vector3 p2 = x - y + particle_transform.GetTranslation();
+            Vector3 p3 = x + y + particle_transform.GetTranslation();
+
             if (format == PARTICLE_GO)
             {
                 Vertex* vertex = &((Vertex*)vertex_buffer)[vertex_index];
@@ -1274,58 +1526,176 @@ namespace dmParticle
         std::sort(emitter->m_Particles.Begin(), emitter->m_Particles.End(), SortPred());
     }
 
-#define SAMPLE_PROP(segment, x, target)\
-    {\
-        const LinearSegment* s = &segment;\
-        target = (x - s->m_X) * s->m_K + s->m_Y;\
-    }\
+    static inline float EvaluateProperty(const Property& property, float x)
+    {
+        return EvaluatePropertySamples(property.m_Samples, 1, x);
+    }
+
+    static inline float EvaluateParticleProperty(const ParticlePropertyTable* table, ParticleKey key, float x)
+    {
+        return EvaluatePropertySamples(&table->m_Samples[0][key], PARTICLE_KEY_COUNT, x);
+    }
 
     void EvaluateEmitterProperties(Emitter* emitter, Property* emitter_properties, float duration, float properties[EMITTER_KEY_COUNT])
     {
         float x = dmMath::Select(-duration, 0.0f, emitter->m_Timer / duration);
-        uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
+        float t;
+        uint32_t segment_index = GetPropertySegment(x, &t);
         for (uint32_t i = 0; i < EMITTER_KEY_COUNT; ++i)
         {
-            SAMPLE_PROP(emitter_properties[i].m_Segments[segment_index], x, properties[i])
-        }
-    }
+            const float* samples = emitter_properties[i].m_Samples;
+            properties[i] = samples[segment_index] + (samples[segment_index + 1] - samples[segment_index]) * t;
+        }
+    }
+
+    // Minimal wrapper for the particle simulation kernels, which process four particles at a time.
+    // The scalar fallback processes one particle at a time with the same operation order.
+#if defined(DM_PARTICLE_SSE)
+    typedef __m128 SimdFloat;
+    static const uint32_t SIMD_WIDTH = 4;
+    static inline SimdFloat SimdLoad(const float* p)                { return _mm_loadu_ps(p); }
+    static inline void SimdStore(float* p, SimdFloat v)             { _mm_storeu_ps(p, v); }
+    static inline SimdFloat SimdSet(float v)                        { return _mm_set1_ps(v); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return _mm_add_ps(a, b); }
+    static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)       { return _mm_sub_ps(a, b); }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return _mm_mul_ps(a, b); }
+    static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b)       { return _mm_min_ps(a, b); }
+    static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b)       { return _mm_max_ps(a, b); }
+    static inline SimdFloat SimdSqrt(SimdFloat v)                   { return _mm_sqrt_ps(v); }
+    static inline SimdFloat SimdRecip(SimdFloat v)                  { return _mm_div_ps(_mm_set1_ps(1.0f), v); }
+    // Same as dmMath::Select, per lane: x >= 0 ? a : b
+    static inline SimdFloat SimdSelect(SimdFloat x, SimdFloat a, SimdFloat b)
+    {
+        __m128 mask = _mm_cmpge_ps(x, _mm_setzero_ps());
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+#elif defined(DM_PARTICLE_NEON)
+    typedef float32x4_t SimdFloat;
+    static const uint32_t SIMD_WIDTH = 4;
+    static inline SimdFloat SimdLoad(const float* p)                { return vld1q_f32(p); }
+    static inline void SimdStore(float* p, SimdFloat v)             { vst1q_f32(p, v); }
+    static inline SimdFloat SimdSet(float v)                        { return vdupq_n_f32(v); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return vaddq_f32(a, b); }
+    static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)       { return vsubq_f32(a, b); }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return vmulq_f32(a, b); }
+    static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b)       { return vminq_f32(a, b); }
+    static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b)       { return vmaxq_f32(a, b); }
+#if defined(__aarch64__)
+    static inline SimdFloat SimdSqrt(SimdFloat v)                   { return vsqrtq_f32(v); }
+    static inline SimdFloat SimdRecip(SimdFloat v)                  { return vdivq_f32(vdupq_n_f32(1.0f), v); }
+#else
+    static inline SimdFloat SimdRecip(SimdFloat v)
+    {
+        float32x4_t r = vrecpeq_f32(v);
+        r = vmulq_f32(vrecpsq_f32(v, r), r);
+        return vmulq_f32(vrecpsq_f32(v, r), r);
+    }
+    static inline SimdFloat SimdSqrt(SimdFloat v)
+    {
+        float32x4_t r = vrsqrteq_f32(v);
+        r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, r), r), r);
+        r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, r), r), r);
+        // sqrt(0) would otherwise be 0 * inf
+        uint32x4_t zero_mask = vceqq_f32(v, vdupq_n_f32(0.0f));
+        return vbslq_f32(zero_mask, vdupq_n_f32(0.0f), vmulq_f32(v, r));
+    }
+#endif
+    // Same as dmMath::Select, per lane: x >= 0 ? a : b
+    static inline SimdFloat SimdSelect(SimdFloat x, SimdFloat a, SimdFloat b)
+    {
+        return vbslq_f32(vcgeq_f32(x, vdupq_n_f32(0.0f)), a, b);
+    }
+#else
+    typedef float SimdFloat;
+    static const uint32_t SIMD_WIDTH = 1;
+    static inline SimdFloat SimdLoad(const float* p)                { return *p; }
+    static inline void SimdStore(float* p, SimdFloat v)             { *p = v; }
+    static inline SimdFloat SimdSet(float v)                        { return v; }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return a + b; }
+    static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)       { return a - b; }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return a * b; }
+    static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b)       { return dmMath::Min(a, b); }
+    static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b)       { return dmMath::Max(a, b); }
+    static inline SimdFloat SimdSqrt(SimdFloat v)                   { return sqrtf(v); }
+    static inline SimdFloat SimdRecip(SimdFloat v)                  { return 1.0f / v; }
+    static inline SimdFloat SimdSelect(SimdFloat x, SimdFloat a, SimdFloat b) { return dmMath::Select(x, a, b); }
+#endif
+
+    /// Number of particles simulated at a time, small enough for the streams to stay in the L1 cache
+    static const uint32_t PARTICLE_BLOCK_SIZE = 64;
+
+    /// Simulation streams of a block of particles, gathered from the particles and scattered back when simulated
+    struct ParticleStreams
+    {
+        float m_LifeT[PARTICLE_BLOCK_SIZE];
+        float m_PositionX[PARTICLE_BLOCK_SIZE];
+        float m_PositionY[PARTICLE_BLOCK_SIZE];
+        float m_PositionZ[PARTICLE_BLOCK_SIZE];
+        float m_VelocityX[PARTICLE_BLOCK_SIZE];
+        float m_VelocityY[PARTICLE_BLOCK_SIZE];
+        float m_VelocityZ[PARTICLE_BLOCK_SIZE];
+        // Only gathered when the emitter has a radial modifier
+        float m_DirX[PARTICLE_BLOCK_SIZE];
+        float m_DirY[PARTICLE_BLOCK_SIZE];
+        float m_DirZ[PARTICLE_BLOCK_SIZE];
+        float m_SpreadFactor[PARTICLE_BLOCK_SIZE];
+        // Source values when gathered, evaluated by EvaluateParticleProperties
+        float m_Red[PARTICLE_BLOCK_SIZE];
+        float m_Green[PARTICLE_BLOCK_SIZE];
+        float m_Blue[PARTICLE_BLOCK_SIZE];
+        float m_Alpha[PARTICLE_BLOCK_SIZE];
+        float m_StretchFactorX[PARTICLE_BLOCK_SIZE];
+        float m_StretchFactorY[PARTICLE_BLOCK_SIZE];
+        float m_Scale[PARTICLE_BLOCK_SIZE];
+        float m_ScaleX[PARTICLE_BLOCK_SIZE];
+        float m_ScaleY[PARTICLE_BLOCK_SIZE];
+    };
 
-    void EvaluateParticleProperties(Emitter* emitter, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    static void EvaluateParticleProperties(ParticleStreams& s, uint32_t count, const ParticlePropertyTable* particle_properties)
     {
-        float properties[PARTICLE_KEY_COUNT];
-        // TODO Optimize this
-        dmArray<Particle>& particles = emitter->m_Particles;
-        uint32_t count = particles.Size();
-        for (uint32_t i = 0; i < count; ++i)
+        const SimdFloat zero = SimdSet(0.0f);
+        const SimdFloat one = SimdSet(1.0f);
+        for (uint32_t i = 0; i < count; i += SIMD_WIDTH)
         {
-            Particle* particle = &particles[i];
-            float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-            uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_SCALE].m_Segments[segment_index], x, properties[PARTICLE_KEY_SCALE])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_RED].m_Segments[segment_index], x, properties[PARTICLE_KEY_RED])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_GREEN].m_Segments[segment_index], x, properties[PARTICLE_KEY_GREEN])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_BLUE].m_Segments[segment_index], x, properties[PARTICLE_KEY_BLUE])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_ALPHA].m_Segments[segment_index], x, properties[PARTICLE_KEY_ALPHA])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_X].m_Segments[segment_index], x, properties[PARTICLE_KEY_STRETCH_FACTOR_X])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_Y].m_Segments[segment_index], x, properties[PARTICLE_KEY_STRETCH_FACTOR_Y])
-            Vector4 c = particle->GetSourceColor();
-            particle->SetScale(Vector3(properties[PARTICLE_KEY_SCALE]));
-            particle->SetColor(Vector4(dmMath::Clamp(c.getX() * properties[PARTICLE_KEY_RED], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getY() * properties[PARTICLE_KEY_GREEN], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getZ() * properties[PARTICLE_KEY_BLUE], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getW() * properties[PARTICLE_KEY_ALPHA], 0.0f, 1.0f)));
-            particle->m_StretchFactorX = particle->m_SourceStretchFactorX + (properties[PARTICLE_KEY_STRETCH_FACTOR_X]);
-            particle->m_StretchFactorY = particle->m_SourceStretchFactorY + (properties[PARTICLE_KEY_STRETCH_FACTOR_Y]);
+            // All properties of a particle are interpolated from two adjacent rows of the table
+            float properties[PARTICLE_KEY_COUNT][SIMD_WIDTH];
+            for (uint32_t lane = 0; lane < SIMD_WIDTH; ++lane)
+            {
+                float t;
+                uint32_t segment_index = GetPropertySegment(s.m_LifeT[i + lane], &t);
+                const float* y0 = particle_properties->m_Samples[segment_index];
+                const float* y1 = particle_properties->m_Samples[segment_index + 1];
+                for (uint32_t key = 0; key < PARTICLE_KEY_COUNT; ++key)
+                {
+                    properties[key][lane] = y0[key] + (y1[key] - y0[key]) * t;
+                }
+            }
+
+            SimdStore(&s.m_Scale[i], SimdLoad(properties[PARTICLE_KEY_SCALE]));
+            // The color streams hold the source color until they are evaluated
+            SimdFloat red = SimdMul(SimdLoad(&s.m_Red[i]), SimdLoad(properties[PARTICLE_KEY_RED]));
+            SimdFloat green = SimdMul(SimdLoad(&s.m_Green[i]), SimdLoad(properties[PARTICLE_KEY_GREEN]));
+            SimdFloat blue = SimdMul(SimdLoad(&s.m_Blue[i]), SimdLoad(properties[PARTICLE_KEY_BLUE]));
+            SimdFloat alpha = SimdMul(SimdLoad(&s.m_Alpha[i]), SimdLoad(properties[PARTICLE_KEY_ALPHA]));
+            SimdStore(&s.m_Red[i], SimdMin(SimdMax(red, zero), one));
+            SimdStore(&s.m_Green[i], SimdMin(SimdMax(green, zero), one));
+            SimdStore(&s.m_Blue[i], SimdMin(SimdMax(blue, zero), one));
+            SimdStore(&s.m_Alpha[i], SimdMin(SimdMax(alpha, zero), one));
+            // Likewise for the stretch factors
+            SimdStore(&s.m_StretchFactorX[i], SimdAdd(SimdLoad(&s.m_StretchFactorX[i]), SimdLoad(properties[PARTICLE_KEY_STRETCH_FACTOR_X])));
+            SimdStore(&s.m_StretchFactorY[i], SimdAdd(SimdLoad(&s.m_StretchFactorY[i]), SimdLoad(properties[PARTICLE_KEY_STRETCH_FACTOR_Y])));
         }
+    }
 
+    static void EvaluateParticleRotations(Particle* particles, uint32_t count, const ParticlePropertyTable* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt)
+    {
+        float properties[PARTICLE_KEY_COUNT];
         if (emitter_ddf->m_ParticleOrientation == PARTICLE_ORIENTATION_MOVEMENT_DIRECTION) {
             for (uint32_t i = 0; i < count; ++i)
             {
                 Particle* particle = &particles[i];
                 float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ROTATION].m_Segments[segment_index], x, properties[PARTICLE_KEY_ROTATION])
+                properties[PARTICLE_KEY_ROTATION] = EvaluateParticleProperty(particle_properties, PARTICLE_KEY_ROTATION, x);
                 particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
                 if (lengthSqr(particle->m_Velocity) > EPSILON)
                 {
@@ -1343,8 +1713,7 @@ namespace dmParticle
             {
                 Particle* particle = &particles[i];
                 float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ANGULAR_VELOCITY].m_Segments[segment_index], x, properties[PARTICLE_KEY_ANGULAR_VELOCITY])
+                properties[PARTICLE_KEY_ANGULAR_VELOCITY] = EvaluateParticleProperty(particle_properties, PARTICLE_KEY_ANGULAR_VELOCITY, x);
                 particle->SetRotation(particle->GetRotation() * Quat::rotationZ(DEG_RAD * (particle->m_SourceAngularVelocity * (properties[PARTICLE_KEY_ANGULAR_VELOCITY])) * dt));
             }
 
@@ -1353,128 +1722,272 @@ namespace dmParticle
             {
                 Particle* particle = &particles[i];
                 float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ROTATION].m_Segments[segment_index], x, properties[PARTICLE_KEY_ROTATION])
+                properties[PARTICLE_KEY_ROTATION] = EvaluateParticleProperty(particle_properties, PARTICLE_KEY_ROTATION, x);
                 particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
             }
         }
+    }
 
+    static float SampleModifierMagnitude(Property* modifier_properties, float emitter_t)
+    {
+        return EvaluateProperty(modifier_properties[MODIFIER_KEY_MAGNITUDE], emitter_t);
     }
 
-    void ApplyAcceleration(dmArray<Particle>& particles, Property* modifier_properties, const Quat& rotation, float scale, float emitter_t, float dt)
+    static void ApplyAcceleration(ParticleStreams& s, uint32_t count, Property* modifier_properties, const Quat& rotation, float scale, float emitter_t, float dt)
     {
-        uint32_t particle_count = particles.Size();
         Vector3 acc_step = rotate(rotation, ACCELERATION_LOCAL_DIR) * dt * scale;
-        const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
-        uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-        float magnitude;
-        SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
-        for (uint32_t i = 0; i < particle_count; ++i)
+        const SimdFloat acc_x = SimdSet(acc_step.getX());
+        const SimdFloat acc_y = SimdSet(acc_step.getY());
+        const SimdFloat acc_z = SimdSet(acc_step.getZ());
+        const SimdFloat magnitude = SimdSet(SampleModifierMagnitude(modifier_properties, emitter_t));
+        const SimdFloat mag_spread = SimdSet(modifier_properties[MODIFIER_KEY_MAGNITUDE].m_Spread);
+        for (uint32_t i = 0; i < count; i += SIMD_WIDTH)
         {
-            Particle* particle = &particles[i];
-            particle->SetVelocity(particle->GetVelocity() + acc_step * (magnitude + mag_spread * particle->GetSpreadFactor()));
+            SimdFloat a = SimdAdd(magnitude, SimdMul(mag_spread, SimdLoad(&s.m_SpreadFactor[i])));
+            SimdStore(&s.m_VelocityX[i], SimdAdd(SimdLoad(&s.m_VelocityX[i]), SimdMul(acc_x, a)));
+            SimdStore(&s.m_VelocityY[i], SimdAdd(SimdLoad(&s.m_VelocityY[i]), SimdMul(acc_y, a)));
+            SimdStore(&s.m_VelocityZ[i], SimdAdd(SimdLoad(&s.m_VelocityZ[i]), SimdMul(acc_z, a)));
         }
     }
 
-    void ApplyDrag(dmArray<Particle>& particles, Property* modifier_properties, dmParticleDDF::Modifier* modifier_ddf, const Quat& rotation, float emitter_t, float dt)
+    static void ApplyDrag(ParticleStreams& s, uint32_t count, Property* modifier_properties, dmParticleDDF::Modifier* modifier_ddf, const Quat& rotation, float emitter_t, float dt)
     {
-        uint32_t particle_count = particles.Size();
         Vector3 direction = rotate(rotation, DRAG_LOCAL_DIR);
-        const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
-        uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-        float magnitude;
-        SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
-        for (uint32_t i = 0; i < particle_count; ++i)
-        {
-            Particle* particle = &particles[i];
-            Vector3 v = particle->GetVelocity();
-            if (modifier_ddf->m_UseDirection)
-                v = projection(Point3(particle->GetVelocity()), direction) * direction;
+        const SimdFloat dir_x = SimdSet(direction.getX());
+        const SimdFloat dir_y = SimdSet(direction.getY());
+        const SimdFloat dir_z = SimdSet(direction.getZ());
+        const SimdFloat magnitude = SimdSet(SampleModifierMagnitude(modifier_properties, emitter_t));
+        const SimdFloat mag_spread = SimdSet(modifier_properties[MODIFIER_KEY_MAGNITUDE].m_Spread);
+        const SimdFloat dt_v = SimdSet(dt);
+        const SimdFloat one = SimdSet(1.0f);
+        bool use_direction = modifier_ddf->m_UseDirection != 0;
+        for (uint32_t i = 0; i < count; i += SIMD_WIDTH)
+        {
+            SimdFloat vel_x = SimdLoad(&s.m_VelocityX[i]);
+            SimdFloat vel_y = SimdLoad(&s.m_VelocityY[i]);
+            SimdFloat vel_z = SimdLoad(&s.m_VelocityZ[i]);
+            SimdFloat v_x = vel_x;
+            SimdFloat v_y = vel_y;
+            SimdFloat v_z = vel_z;
+            if (use_direction)
+            {
+                SimdFloat projection = SimdAdd(SimdAdd(SimdMul(vel_x, dir_x), SimdMul(vel_y, dir_y)), SimdMul(vel_z, dir_z));
+                v_x = SimdMul(dir_x, projection);
+                v_y = SimdMul(dir_y, projection);
+                v_z = SimdMul(dir_z, projection);
+            }
             // Applied drag > 1 means the particle would travel in the reverse direction
-            float applied_drag = dmMath::Min((magnitude + mag_spread * particle->GetSpreadFactor()) * dt, 1.0f);
-            particle->SetVelocity(particle->GetVelocity() - v * applied_drag);
+            SimdFloat applied_drag = SimdMin(SimdMul(SimdAdd(magnitude, SimdMul(mag_spread, SimdLoad(&s.m_SpreadFactor[i]))), dt_v), one);
+            SimdStore(&s.m_VelocityX[i], SimdSub(vel_x, SimdMul(v_x, applied_drag)));
+            SimdStore(&s.m_VelocityY[i], SimdSub(vel_y, SimdMul(v_y, applied_drag)));
+            SimdStore(&s.m_VelocityZ[i], SimdSub(vel_z, SimdMul(v_z, applied_drag)));
         }
     }
 
-    static Vector3 GetParticleDir(Particle* particle)
+    static void ApplyRadial(ParticleStreams& s, uint32_t count, Property* modifier_properties, const Point3& position, float scale, float emitter_t, float dt)
     {
-        return rotate(particle->GetRotation(), PARTICLE_LOCAL_BASE_DIR);
-    }
-
-    static Vector3 NonZeroVector3(Vector3 v, float sq_length, Vector3 fallback)
-    {
-        Vector3 result;
-        float neg_sq_length = -sq_length;
-        result.setX(dmMath::Select(neg_sq_length, fallback.getX(), v.getX()));
-        result.setY(dmMath::Select(neg_sq_length, fallback.getY(), v.getY()));
-        result.setZ(dmMath::Select(neg_sq_length, fallback.getZ(), v.getZ()));
-        return result;
-    }
-
-    void ApplyRadial(dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, float scale, float emitter_t, float dt)
-    {
-        uint32_t particle_count = particles.Size();
-        const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
         const Property& max_distance_property = modifier_properties[MODIFIER_KEY_MAX_DISTANCE];
-        uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-        float magnitude;
-        SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
+        const SimdFloat magnitude = SimdSet(SampleModifierMagnitude(modifier_properties, emitter_t));
+        const SimdFloat mag_spread = SimdSet(modifier_properties[MODIFIER_KEY_MAGNITUDE].m_Spread);
         // We temporarily only sample the first frame until we have decided what to animate over
-        float max_distance = max_distance_property.m_Segments[0].m_Y * scale;
-        float max_sq_distance = max_distance * max_distance;
-        float applied_factor = dt * scale;
-        for (uint32_t i = 0; i < particle_count; ++i)
-        {
-            Particle* particle = &particles[i];
-            Vector3 delta = particle->GetPosition() - position;
-            float delta_sq_len = lengthSqr(delta);
-            float applied_magnitude = magnitude + mag_spread * particle->GetSpreadFactor();
+        float max_distance = max_distance_property.m_Samples[0] * scale;
+        const SimdFloat max_sq_distance = SimdSet(max_distance * max_distance);
+        const SimdFloat applied_factor = SimdSet(dt * scale);
+        const SimdFloat pos_x = SimdSet(position.getX());
+        const SimdFloat pos_y = SimdSet(position.getY());
+        const SimdFloat pos_z = SimdSet(position.getZ());
+        const SimdFloat zero = SimdSet(0.0f);
+        for (uint32_t i = 0; i < count; i += SIMD_WIDTH)
+        {
+            SimdFloat delta_x = SimdSub(SimdLoad(&s.m_PositionX[i]), pos_x);
+            SimdFloat delta_y = SimdSub(SimdLoad(&s.m_PositionY[i]), pos_y);
+            SimdFloat delta_z = SimdSub(SimdLoad(&s.m_PositionZ[i]), pos_z);
+            SimdFloat delta_sq_len = SimdAdd(SimdAdd(SimdMul(delta_x, delta_x), SimdMul(delta_y, delta_y)), SimdMul(delta_z, delta_z));
+            SimdFloat applied_magnitude = SimdAdd(magnitude, SimdMul(mag_spread, SimdLoad(&s.m_SpreadFactor[i])));
             // 0 acc delta lies outside max dist
-            float a = dmMath::Select(max_sq_distance - delta_sq_len, applied_magnitude, 0.0f);
-            Vector3 dir = normalize(NonZeroVector3(delta, delta_sq_len, GetParticleDir(particle)));
-            particle->SetVelocity(particle->GetVelocity() + dir * a * applied_factor);
+            SimdFloat a = SimdSelect(SimdSub(max_sq_distance, delta_sq_len), applied_magnitude, zero);
+            // Particles at the modifier position are pushed along their own direction
+            SimdFloat neg_sq_len = SimdSub(zero, delta_sq_len);
+            SimdFloat dir_x = SimdSelect(neg_sq_len, SimdLoad(&s.m_DirX[i]), delta_x);
+            SimdFloat dir_y = SimdSelect(neg_sq_len, SimdLoad(&s.m_DirY[i]), delta_y);
+            SimdFloat dir_z = SimdSelect(neg_sq_len, SimdLoad(&s.m_DirZ[i]), delta_z);
+            SimdFloat dir_sq_len = SimdAdd(SimdAdd(SimdMul(dir_x, dir_x), SimdMul(dir_y, dir_y)), SimdMul(dir_z, dir_z));
+            SimdFloat len_inv = SimdRecip(SimdSqrt(dir_sq_len));
+            SimdStore(&s.m_VelocityX[i], SimdAdd(SimdLoad(&s.m_VelocityX[i]), SimdMul(SimdMul(SimdMul(dir_x, len_inv), a), applied_factor)));
+            SimdStore(&s.m_VelocityY[i], SimdAdd(SimdLoad(&s.m_VelocityY[i]), SimdMul(SimdMul(SimdMul(dir_y, len_inv), a), applied_factor)));
+            SimdStore(&s.m_VelocityZ[i], SimdAdd(SimdLoad(&s.m_VelocityZ[i]), SimdMul(SimdMul(SimdMul(dir_z, len_inv), a), applied_factor)));
         }
     }
 
-    void ApplyVortex(dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, const Quat& rotation, float scale, float emitter_t, float dt)
+    static void ApplyVortex(ParticleStreams& s, uint32_t count, Property* modifier_properties, const Point3& position, const Quat& rotation, float scale, float emitter_t, float dt)
     {
-        uint32_t particle_count = particles.Size();
-        const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
         const Property& max_distance_property = modifier_properties[MODIFIER_KEY_MAX_DISTANCE];
-        uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-        float magnitude;
-        SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
+        const SimdFloat magnitude = SimdSet(SampleModifierMagnitude(modifier_properties, emitter_t));
+        const SimdFloat mag_spread = SimdSet(modifier_properties[MODIFIER_KEY_MAGNITUDE].m_Spread);
         // We temporarily only sample the first frame until we have decided what to animate over
-        float max_distance = max_distance_property.m_Segments[0].m_Y * scale;
-        float max_sq_distance = max_distance * max_distance;
+        float max_distance = max_distance_property.m_Samples[0] * scale;
+        const SimdFloat max_sq_distance = SimdSet(max_distance * max_distance);
         Vector3 axis = rotate(rotation, VORTEX_LOCAL_AXIS);
         Vector3 start = rotate(rotation, VORTEX_LOCAL_START_DIR);
-        float applied_factor = dt * scale;
-        for (uint32_t i = 0; i < particle_count; ++i)
+        const SimdFloat axis_x = SimdSet(axis.getX());
+        const SimdFloat axis_y = SimdSet(axis.getY());
+        const SimdFloat axis_z = SimdSet(axis.getZ());
+        const SimdFloat start_x = SimdSet(start.getX());
+        const SimdFloat start_y = SimdSet(start.getY());
+        const SimdFloat start_z = SimdSet(start.getZ());
+        const SimdFloat applied_factor = SimdSet(dt * scale);
+        const SimdFloat pos_x = SimdSet(position.getX());
+        const SimdFloat pos_y = SimdSet(position.getY());
+        const SimdFloat pos_z = SimdSet(position.getZ());
+        const SimdFloat zero = SimdSet(0.0f);
+        for (uint32_t i = 0; i < count; i += SIMD_WIDTH)
         {
-            Particle* particle = &particles[i];
             // delta from vortex position
-            Vector3 delta = particle->GetPosition() - position;
+            SimdFloat delta_x = SimdSub(SimdLoad(&s.m_PositionX[i]), pos_x);
+            SimdFloat delta_y = SimdSub(SimdLoad(&s.m_PositionY[i]), pos_y);
+            SimdFloat delta_z = SimdSub(SimdLoad(&s.m_PositionZ[i]), pos_z);
             // normal from vortex axis (non-unit)
-            Vector3 normal = delta - projection(Point3(delta), axis) * axis;
+            SimdFloat projection = SimdAdd(SimdAdd(SimdMul(delta_x, axis_x), SimdMul(delta_y, axis_y)), SimdMul(delta_z, axis_z));
+            SimdFloat normal_x = SimdSub(delta_x, SimdMul(axis_x, projection));
+            SimdFloat normal_y = SimdSub(delta_y, SimdMul(axis_y, projection));
+            SimdFloat normal_z = SimdSub(delta_z, SimdMul(axis_z, projection));
             // tangent is the direction of the vortex acceleration
-            Vector3 tangent = cross(axis, normal);
+            SimdFloat tangent_x = SimdSub(SimdMul(axis_y, normal_z), SimdMul(axis_z, normal_y));
+            SimdFloat tangent_y = SimdSub(SimdMul(axis_z, normal_x), SimdMul(axis_x, normal_z));
+            SimdFloat tangent_z = SimdSub(SimdMul(axis_x, normal_y), SimdMul(axis_y, normal_x));
             // In case the particle is directed along the axis, give it a guaranteed orthogonal start
-            tangent = NonZeroVector3(tangent, lengthSqr(tangent), start);
+            SimdFloat neg_sq_len = SimdSub(zero, SimdAdd(SimdAdd(SimdMul(tangent_x, tangent_x), SimdMul(tangent_y, tangent_y)), SimdMul(tangent_z, tangent_z)));
+            tangent_x = SimdSelect(neg_sq_len, start_x, tangent_x);
+            tangent_y = SimdSelect(neg_sq_len, start_y, tangent_y);
+            tangent_z = SimdSelect(neg_sq_len, start_z, tangent_z);
             // tangent is now guaranteed to be non-zero
-            tangent = normalize(tangent);
+            SimdFloat len_inv = SimdRecip(SimdSqrt(SimdAdd(SimdAdd(SimdMul(tangent_x, tangent_x), SimdMul(tangent_y, tangent_y)), SimdMul(tangent_z, tangent_z))));
             // use normal for max distance test
-            float normal_sq_len = lengthSqr(normal);
-            float acceleration = dmMath::Select(max_sq_distance - normal_sq_len, magnitude + mag_spread * particle->GetSpreadFactor(), 0.0f);
-            particle->SetVelocity(particle->GetVelocity() + tangent * acceleration * applied_factor);
+            SimdFloat normal_sq_len = SimdAdd(SimdAdd(SimdMul(normal_x, normal_x), SimdMul(normal_y, normal_y)), SimdMul(normal_z, normal_z));
+            SimdFloat acceleration = SimdSelect(SimdSub(max_sq_distance, normal_sq_len), SimdAdd(magnitude, SimdMul(mag_spread, SimdLoad(&s.m_SpreadFactor[i]))), zero);
+            SimdStore(&s.m_VelocityX[i], SimdAdd(SimdLoad(&s.m_VelocityX[i]), SimdMul(SimdMul(SimdMul(tangent_x, len_inv), acceleration), applied_factor)));
+            SimdStore(&s.m_VelocityY[i], SimdAdd(SimdLoad(&s.m_VelocityY[i]), SimdMul(SimdMul(SimdMul(tangent_y, len_inv), acceleration), applied_factor)));
+            SimdStore(&s.m_VelocityZ[i], SimdAdd(SimdLoad(&s.m_VelocityZ[i]), SimdMul(SimdMul(SimdMul(tangent_z, len_inv), acceleration), applied_factor)));
         }
     }
 
-#undef SAMPLE_PROP
+    static void Integrate(ParticleStreams& s, uint32_t count, bool stretch_with_velocity, float dt)
+    {
+        const SimdFloat dt_v = SimdSet(dt);
+        const SimdFloat stretch_scaling = SimdSet(STRETCH_SCALING);
+        for (uint32_t i = 0; i < count; i += SIMD_WIDTH)
+        {
+            SimdFloat vel_x = SimdLoad(&s.m_VelocityX[i]);
+            SimdFloat vel_y = SimdLoad(&s.m_VelocityY[i]);
+            SimdFloat vel_z = SimdLoad(&s.m_VelocityZ[i]);
+            // NOTE This velocity integration has a larger error than normal since we don't use the velocity at the
+            // beginning of the frame, but it's ok since particle movement does not need to be very exact
+            SimdStore(&s.m_PositionX[i], SimdAdd(SimdLoad(&s.m_PositionX[i]), SimdMul(vel_x, dt_v)));
+            SimdStore(&s.m_PositionY[i], SimdAdd(SimdLoad(&s.m_PositionY[i]), SimdMul(vel_y, dt_v)));
+            SimdStore(&s.m_PositionZ[i], SimdAdd(SimdLoad(&s.m_PositionZ[i]), SimdMul(vel_z, dt_v)));
+
+            SimdFloat scale = SimdLoad(&s.m_Scale[i]);
+            SimdStore(&s.m_ScaleX[i], SimdAdd(scale, SimdMul(scale, SimdLoad(&s.m_StretchFactorX[i]))));
+            SimdFloat stretch_y = SimdMul(scale, SimdLoad(&s.m_StretchFactorY[i]));
+            if (stretch_with_velocity)
+            {
+                SimdFloat speed = SimdSqrt(SimdAdd(SimdAdd(SimdMul(vel_x, vel_x), SimdMul(vel_y, vel_y)), SimdMul(vel_z, vel_z)));
+                stretch_y = SimdMul(SimdMul(stretch_y, speed), stretch_scaling);
+            }
+            SimdStore(&s.m_ScaleY[i], SimdAdd(scale, stretch_y));
+        }
+    }
+
+    // Copies the simulated state of the particles into streams, padded with zeros to a multiple of four particles
+    static void GatherParticleStreams(const Particle* particles, uint32_t count, bool gather_dir, ParticleStreams* s)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Particle* particle = &particles[i];
+            s->m_LifeT[i] = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
+            s->m_PositionX[i] = particle->m_Position.getX();
+            s->m_PositionY[i] = particle->m_Position.getY();
+            s->m_PositionZ[i] = particle->m_Position.getZ();
+            s->m_VelocityX[i] = particle->m_Velocity.getX();
+            s->m_VelocityY[i] = particle->m_Velocity.getY();
+            s->m_VelocityZ[i] = particle->m_Velocity.getZ();
+            s->m_SpreadFactor[i] = particle->m_SpreadFactor;
+            s->m_Red[i] = particle->m_SourceColor.getX();
+            s->m_Green[i] = particle->m_SourceColor.getY();
+            s->m_Blue[i] = particle->m_SourceColor.getZ();
+            s->m_Alpha[i] = particle->m_SourceColor.getW();
+            s->m_StretchFactorX[i] = particle->m_SourceStretchFactorX;
+            s->m_StretchFactorY[i] = particle->m_SourceStretchFactorY;
+        }
+        if (gather_dir)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                Vector3 dir = rotate(particles[i].GetRotation(), PARTICLE_LOCAL_BASE_DIR);
+                s->m_DirX[i] = dir.getX();
+                s->m_DirY[i] = dir.getY();
+                s->m_DirZ[i] = dir.getZ();
+            }
+        }
+        uint32_t padded_count = (count + 3) & ~3u;
+        for (uint32_t i = count; i < padded_count; ++i)
+        {
+            s->m_LifeT[i] = 0.0f;
+            s->m_PositionX[i] = s->m_PositionY[i] = s->m_PositionZ[i] = 0.0f;
+            s->m_VelocityX[i] = s->m_VelocityY[i] = s->m_VelocityZ[i] = 0.0f;
+            s->m_DirX[i] = s->m_DirY[i] = s->m_DirZ[i] = 0.0f;
+            s->m_SpreadFactor[i] = 0.0f;
+            s->m_Red[i] = s->m_Green[i] = s->m_Blue[i] = s->m_Alpha[i] = 0.0f;
+            s->m_StretchFactorX[i] = s->m_StretchFactorY[i] = 0.0f;
+        }
+    }
+
+    // Bounds of the particle positions in emission space, and the max particle scale and size, used to cull the emitter when rendering
+    struct ParticleBounds
+    {
+        ParticleBounds()
+        : m_Min(FLT_MAX)
+        , m_Max(-FLT_MAX)
+        , m_MaxScale(0.0f)
+        , m_MaxSize(0.0f)
+        {
+        }
+
+        Vector3 m_Min;
+        Vector3 m_Max;
+        float   m_MaxScale;
+        float   m_MaxSize;
+    };
+
+    // Writes the streams back to the particles and grows the bounds while the particles are in the cache
+    static void ScatterParticleStreams(const ParticleStreams& s, Particle* particles, uint32_t count, ParticleBounds* bounds)
+    {
+        Vector3 bounds_min = bounds->m_Min;
+        Vector3 bounds_max = bounds->m_Max;
+        float max_scale = bounds->m_MaxScale;
+        float max_size = bounds->m_MaxSize;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Particle* particle = &particles[i];
+            particle->m_Position = Point3(s.m_PositionX[i], s.m_PositionY[i], s.m_PositionZ[i]);
+            particle->m_Velocity = Vector3(s.m_VelocityX[i], s.m_VelocityY[i], s.m_VelocityZ[i]);
+            particle->m_Scale = Vector3(s.m_ScaleX[i], s.m_ScaleY[i], s.m_Scale[i]);
+            particle->m_Color = Vector4(s.m_Red[i], s.m_Green[i], s.m_Blue[i], s.m_Alpha[i]);
+            particle->m_StretchFactorX = s.m_StretchFactorX[i];
+            particle->m_StretchFactorY = s.m_StretchFactorY[i];
+
+            const Vector3 position(s.m_PositionX[i], s.m_PositionY[i], s.m_PositionZ[i]);
+            bounds_min = minPerElem(bounds_min, position);
+            bounds_max = maxPerElem(bounds_max, position);
+            float scale = dmMath::Max(dmMath::Abs(s.m_ScaleX[i]), dmMath::Abs(s.m_ScaleY[i]));
+            max_scale = dmMath::Max(max_scale, scale);
+            max_size = dmMath::Max(max_size, scale * particle->m_SourceSize);
+        }
+        bounds->m_Min = bounds_min;
+        bounds->m_Max = bounds_max;
+        bounds->m_MaxScale = max_scale;
+        bounds->m_MaxSize = max_size;
+    }
 
     static Point3 CalculateModifierPosition(Instance* instance, dmParticleDDF::Emitter* emitter_ddf, dmParticleDDF::Modifier* modifier_ddf)
     {
@@ -1500,60 +2013,71 @@ namespace dmParticle
         DM_PROFILE(Particle, "Simulate");
 
         dmArray<Particle>& particles = emitter->m_Particles;
-        EvaluateParticleProperties(emitter, prototype->m_ParticleProperties, ddf, dt);
         float emitter_t = dmMath::Select(-ddf->m_Duration, 0.0f, emitter->m_Timer / ddf->m_Duration);
         float scale = 1.0f;
         if (ddf->m_Space == EMISSION_SPACE_WORLD)
             scale = instance->m_WorldTransform.GetScale();
-        // Apply modifiers
         uint32_t modifier_count = prototype->m_Modifiers.Size();
+        // The radial modifier falls back to the particle direction for particles at the modifier position
+        bool gather_dir = false;
         for (uint32_t i = 0; i < modifier_count; ++i)
         {
-            ModifierPrototype* modifier = &prototype->m_Modifiers[i];
-            dmParticleDDF::Modifier* modifier_ddf = &ddf->m_Modifiers[i];
-            switch (modifier_ddf->m_Type)
+            gather_dir |= ddf->m_Modifiers[i].m_Type == dmParticleDDF::MODIFIER_TYPE_RADIAL;
+        }
+        bool stretch_with_velocity = ddf->m_StretchWithVelocity != 0;
+
+        ParticleStreams streams;
+        ParticleBounds bounds;
+        uint32_t particle_count = particles.Size();
+        for (uint32_t block_start = 0; block_start < particle_count; block_start += PARTICLE_BLOCK_SIZE)
+        {
+            Particle* block = &particles[block_start];
+            uint32_t count = dmMath::Min(particle_count - block_start, PARTICLE_BLOCK_SIZE);
+            EvaluateParticleRotations(block, count, prototype->m_ParticleProperties, ddf, dt);
+            GatherParticleStreams(block, count, gather_dir, &streams);
+            EvaluateParticleProperties(streams, count, prototype->m_ParticleProperties);
+            // Apply modifiers
+            for (uint32_t i = 0; i < modifier_count; ++i)
             {
-            case dmParticleDDF::MODIFIER_TYPE_ACCELERATION:
-                {
-                    Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
-                    ApplyAcceleration(particles, modifier->m_Properties, rotation, scale, emitter_t, dt);
-                }
-                break;
-            case dmParticleDDF::MODIFIER_TYPE_DRAG:
-                {
-                    Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
-                    ApplyDrag(particles, modifier->m_Properties, modifier_ddf, rotation, emitter_t, dt);
-                }
-                break;
-            case dmParticleDDF::MODIFIER_TYPE_RADIAL:
+                ModifierPrototype* modifier = &prototype->m_Modifiers[i];
+                dmParticleDDF::Modifier* modifier_ddf = &ddf->m_Modifiers[i];
+                switch (modifier_ddf->m_Type)
                 {
-                    Point3 position = CalculateModifierPosition(instance, ddf, modifier_ddf);
-                    ApplyRadial(particles, modifier->m_Properties, position, scale, emitter_t, dt);
-                }
-                break;
-            case dmParticleDDF::MODIFIER_TYPE_VORTEX:
-                {
-                    Point3 position = CalculateModifierPosition(instance, ddf, modifier_ddf);
-                    Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
-                    ApplyVortex(particles, modifier->m_Properties, position, rotation, scale, emitter_t, dt);
+                case dmParticleDDF::MODIFIER_TYPE_ACCELERATION:
+                    {
+                        Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
+                        ApplyAcceleration(streams, count, modifier->m_Properties, rotation, scale, emitter_t, dt);
+                    }
+                    break;
+                case dmParticleDDF::MODIFIER_TYPE_DRAG:
+                    {
+                        Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
+                        ApplyDrag(streams, count, modifier->m_Properties, modifier_ddf, rotation, emitter_t, dt);
+                    }
+                    break;
+                case dmParticleDDF::MODIFIER_TYPE_RADIAL:
+                    {
+                        Point3 position = CalculateModifierPosition(instance, ddf, modifier_ddf);
+                        ApplyRadial(streams, count, modifier->m_Properties, position, scale, emitter_t, dt);
+                    }
+                    break;
+                case dmParticleDDF::MODIFIER_TYPE_VORTEX:
+                    {
+                        Point3 position = CalculateModifierPosition(instance, ddf, modifier_ddf);
+                        Quat rotation = CalculateModifierRotation(instance, ddf, modifier_ddf);
+                        ApplyVortex(streams, count, modifier->m_Properties, position, rotation, scale, emitter_t, dt);
+                    }
+                    break;
                 }
-                break;
             }
+            Integrate(streams, count, stretch_with_velocity, dt);
+            ScatterParticleStreams(streams, block, count, &bounds);
         }
-        uint32_t particle_count = particles.Size();
-        for (uint32_t i = 0; i < particle_count; ++i)
-        {
-            Particle* p = &particles[i];
-            // NOTE This velocity integration has a larger error than normal since we don't use the velocity at the
-            // beginning of the frame, but it's ok since particle movement does not need to be very exact
-            p->SetPosition(p->GetPosition() + p->m_Velocity * dt);
 
-            p->m_Scale[0] += p->m_Scale[0] * p->m_StretchFactorX;
-            if (!ddf->m_StretchWithVelocity)
-                p->m_Scale[1] += p->m_Scale[1] * p->m_StretchFactorY;
-            else
-                p->m_Scale[1] += p->m_Scale[1] * p->m_StretchFactorY * length(p->m_Velocity) * STRETCH_SCALING;
-        }
+        emitter->m_BoundsMin = bounds.m_Min;
+        emitter->m_BoundsMax = bounds.m_Max;
+        emitter->m_MaxParticleScale = bounds.m_MaxScale;
+        emitter->m_MaxParticleSize = bounds.m_MaxSize;
     }
 
     void DebugRender(HParticleContext context, void* user_context, RenderLineCallback render_line_callback)
@@ -1667,6 +2191,21 @@ namespace dmParticle
         }
     }
 
+    static void FreeEmitterPrototypes(Prototype* prototype)
+    {
+        uint32_t emitter_count = prototype->m_Emitters.Size();
+        for (uint32_t i = 0; i < emitter_count; ++i)
+        {
+            EmitterPrototype* emitter = &prototype->m_Emitters[i];
+            emitter->m_Modifiers.SetCapacity(0);
+            if (emitter->m_ParticleProperties != 0x0)
+            {
+                dmMemory::AlignedFree(emitter->m_ParticleProperties);
+                emitter->m_ParticleProperties = 0x0;
+            }
+        }
+    }
+
     void LoadResources(Prototype* prototype, dmParticleDDF::ParticleFX* ddf)
     {
         uint32_t emitter_count = ddf->m_Emitters.m_Count;
@@ -1675,6 +2214,7 @@ namespace dmParticle
             dmDDF::FreeMessage(prototype->m_DDF);
         }
         prototype->m_DDF = ddf;
+        FreeEmitterPrototypes(prototype);
         prototype->m_Emitters.SetCapacity(emitter_count);
         prototype->m_Emitters.SetSize(emitter_count);
 
@@ -1688,9 +2228,10 @@ namespace dmParticle
             EmitterPrototype* emitter = &prototype->m_Emitters[i];
             emitter->m_Animation = dmHashString64(emitter_ddf->m_Animation);
             emitter->m_BlendMode = emitter_ddf->m_BlendMode;
-            // Approximate splines with linear segments
+            // Approximate splines with lookup tables
             memset(emitter->m_Properties, 0, sizeof(emitter->m_Properties));
-            memset(emitter->m_ParticleProperties, 0, sizeof(emitter->m_ParticleProperties));
+            dmMemory::AlignedMalloc((void**)&emitter->m_ParticleProperties, 64, sizeof(ParticlePropertyTable));
+            memset(emitter->m_ParticleProperties, 0, sizeof(ParticlePropertyTable));
             uint32_t prop_count = emitter_ddf->m_Properties.m_Count;
             for (uint32_t j = 0; j < prop_count; ++j)
             {
@@ -1698,7 +2239,7 @@ namespace dmParticle
                 if (p.m_Key < dmParticleDDF::EMITTER_KEY_COUNT)
                 {
                     Property& property = emitter->m_Properties[p.m_Key];
-                    SampleProperty(p.m_Points.m_Data, p.m_Points.m_Count, property.m_Segments);
+                    BakeProperty(p.m_Points.m_Data, p.m_Points.m_Count, property.m_Samples, 1);
                     property.m_Spread = p.m_Spread;
                 }
                 else
@@ -1709,10 +2250,9 @@ namespace dmParticle
             // Calculate max life time
             const Property& life_time = emitter->m_Properties[dmParticleDDF::EMITTER_KEY_PARTICLE_LIFE_TIME];
             float max_life_time = 0.0f;
-            for (uint32_t j = 0; j < PROPERTY_SAMPLE_COUNT; ++j)
+            for (uint32_t j = 0; j <= PROPERTY_SAMPLE_COUNT; ++j)
             {
-                const LinearSegment& s = life_time.m_Segments[j];
-                max_life_time = dmMath::Max(dmMath::Select(s.m_K, s.m_Y + s.m_K, s.m_Y), max_life_time);
+                max_life_time = dmMath::Max(life_time.m_Samples[j], max_life_time);
             }
             emitter->m_MaxParticleLifeTime = max_life_time;
             // particle properties
@@ -1722,7 +2262,7 @@ namespace dmParticle
                 const dmParticleDDF::Emitter::ParticleProperty& p = emitter_ddf->m_ParticleProperties[i];
                 if (p.m_Key < dmParticleDDF::PARTICLE_KEY_COUNT)
                 {
-                    SampleProperty(p.m_Points.m_Data, p.m_Points.m_Count, emitter->m_ParticleProperties[p.m_Key].m_Segments);
+                    BakeProperty(p.m_Points.m_Data, p.m_Points.m_Count, &emitter->m_ParticleProperties->m_Samples[0][p.m_Key], PARTICLE_KEY_COUNT);
                 }
                 else
                 {
@@ -1744,7 +2284,7 @@ namespace dmParticle
                     if (p.m_Key < dmParticleDDF::MODIFIER_KEY_COUNT)
                     {
                         Property& property = modifier.m_Properties[p.m_Key];
-                        SampleProperty(p.m_Points.m_Data, p.m_Points.m_Count, property.m_Segments);
+                        BakeProperty(p.m_Points.m_Data, p.m_Points.m_Count, property.m_Samples, 1);
                         property.m_Spread = p.m_Spread;
                     }
                     else
@@ -1777,11 +2317,7 @@ namespace dmParticle
 
     void DeletePrototype(HPrototype prototype)
     {
-        uint32_t emitter_count = prototype->m_Emitters.Size();
-        for (uint32_t i = 0; i < emitter_count; ++i)
-        {
-            prototype->m_Emitters[i].m_Modifiers.SetCapacity(0);
-        }
+        FreeEmitterPrototypes(prototype);
         dmDDF::FreeMessage(prototype->m_DDF);
         delete prototype;
     }
@@ -1844,6 +2380,38 @@ namespace dmParticle
         render_emitter_callback(user_context, emitter_proto->m_Material, emitter->m_AnimationData.m_Texture, world, emitter_proto->m_BlendMode, emitter->m_VertexIndex, emitter->m_VertexCount, emitter->m_RenderConstants.Begin(), emitter->m_RenderConstants.Size());
     }
 
+    // Radius of the sphere around the emitter position that contains the particle quads, as they are generated in UpdateRenderData
+    static float CalculateBoundingRadius(Instance* instance, Emitter* emitter, dmParticleDDF::Emitter* ddf, const Point3& position)
+    {
+        if (emitter->m_Particles.Empty())
+            return 0.0f;
+
+        // Largest distance from a particle position to a quad corner
+        const AnimationData& anim_data = emitter->m_AnimationData;
+        uint32_t tile_count = anim_data.m_EndTile - anim_data.m_StartTile;
+        bool anim_auto_size = (ddf->m_SizeMode == SIZE_MODE_AUTO) && (anim_data.m_TexDims != 0x0) && anim_data.m_Playback != ANIM_PLAYBACK_NONE && tile_count > 1;
+        float extent = emitter->m_MaxParticleSize * 0.70711f;
+        if (anim_auto_size)
+        {
+            float max_dim = 0.0f;
+            for (uint32_t tile = anim_data.m_StartTile; tile < anim_data.m_EndTile; ++tile)
+            {
+                const float* td = &anim_data.m_TexDims[tile << 1];
+                max_dim = dmMath::Max(max_dim, td[0] * td[0] + td[1] * td[1]);
+            }
+            extent = emitter->m_MaxParticleScale * 0.5f * sqrtf(max_dim);
+        }
+
+        Point3 center = Point3(0.5f * (emitter->m_BoundsMin + emitter->m_BoundsMax));
+        float radius = 0.5f * length(emitter->m_BoundsMax - emitter->m_BoundsMin) + extent;
+        if (ddf->m_Space == EMISSION_SPACE_EMITTER)
+        {
+            center = dmTransform::Apply(instance->m_WorldTransform, center);
+            radius *= instance->m_WorldTransform.GetScale();
+        }
+        return length(center - position) + radius;
+    }
+
     // Update render data for the emitter at the specified index
     void UpdateEmitterRenderData(HInstance instance, uint32_t emitter_index, Instance* inst, Emitter* emitter, dmParticleDDF::Emitter* ddf)
     {
@@ -1865,6 +2433,7 @@ namespace dmParticle
         render_data.m_RenderConstantsSize = emitter->m_RenderConstants.Size();
         render_data.m_Instance = instance;
         render_data.m_EmitterIndex = emitter_index;
+        render_data.m_BoundingRadius = CalculateBoundingRadius(inst, emitter, ddf, Point3(world.getTranslation()));
     }
 
     // Update render data for all emitters on an instance
@@ -2010,12 +2579,7 @@ namespace dmParticle
 
     uint32_t GetVertexBufferSize(uint32_t particle_count, ParticleVertexFormat vertex_format)
     {
-        uint32_t vertex_size = sizeof(Vertex);
-
-        if (vertex_format == PARTICLE_GUI)
-            vertex_size = sizeof(ParticleGuiVertex);
-
-        return particle_count * 6 * vertex_size;
+        return particle_count * GetVertexCountPerParticle(vertex_format) * GetVertexSize(vertex_format);
     }
 
     uint32_t GetMaxVertexBufferSize(HParticleContext context, ParticleVertexFormat vertex_format)
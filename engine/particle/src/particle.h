@@ -16,6 +16,7 @@
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 #include <dlib/configfile.h>
 #include <dlib/hash.h>
+#include <dlib/worker_pool.h>
 #include <ddf/ddf.h>
 #include "particle/particle_ddf.h"
 
@@ -130,6 +131,8 @@ namespace dmParticle
     {
         PARTICLE_GO = 0,
         PARTICLE_GUI = 1,
+        /// One ParticleCompactVertex per particle, expanded into a quad by the vertex program
+        PARTICLE_GO_COMPACT = 2,
     };
 
     struct EmitterRenderData
@@ -149,6 +152,7 @@ namespace dmParticle
         uint32_t                    m_EmitterIndex;
         uint32_t                    m_MixedHash;
         uint32_t                    m_MixedHashNoMaterial;
+        float                       m_BoundingRadius; // Radius of the sphere around the emitter position that contains the particles, 0 if there are none
     };
 
     /**
@@ -232,6 +236,29 @@ namespace dmParticle
         // Offset 36
     };
 
+    /**
+     * Compact particle vertex format, one per particle (see builtins/materials/particlefx_compact.vp)
+     * The quad corners are position + rotate(rotation, (+-size[0], +-size[1], 0)), which is the same
+     * quad as the six vertices written for PARTICLE_GO.
+     */
+    struct ParticleCompactVertex
+    {
+        // Offset 0, center of the particle
+        float    m_Position[3];
+        // Offset 12, rotation quaternion (x, y, z, w)
+        float    m_Rotation[4];
+        // Offset 28, half extents along the rotated x and y axes
+        float    m_Size[2];
+        // Offset 36, texture coordinates of the (-x, -y) corner and the (+x, +y) corner
+        float    m_UV[4];
+        // Offset 52
+        uint8_t  m_Color[4];
+        // Offset 56, 255 when the tile is rotated in the texture, i.e. u follows the y axis of the quad
+        uint8_t  m_UVRotated;
+        uint8_t  m_Pad[3];
+        // Offset 60
+    };
+
     // For tests
     Vector3 GetPosition(HParticleContext context, HInstance instance);
 
@@ -266,6 +293,15 @@ namespace dmParticle
      */
     DM_PARTICLE_PROTO(void, SetContextMaxParticleCount, HParticleContext context, uint32_t max_particle_count);
 
+    /**
+     * Set the worker pool used to update emitters and generate vertex data in parallel.
+     * When the pool has worker threads, emitter state changes are reported after all emitters have been updated,
+     * in the same order as when updating on the calling thread.
+     * @param context Context to update.
+     * @param pool Worker pool, or 0 to process all emitters on the calling thread
+     */
+    void SetWorkerPool(HParticleContext context, dmWorkerPool::HWorkerPool pool);
+
     /**
      * Create an instance from the supplied path and fetch resources using the supplied factory.
      * @param context Context in which to create the instance, must be valid.
@@ -380,6 +416,20 @@ namespace dmParticle
      */
     DM_PARTICLE_PROTO(void, GenerateVertexData, HParticleContext context, float dt, HInstance instance, uint32_t emitter_index, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format);
 
+    /**
+     * Generates vertex data for several emitters, distributed over the worker pool of the context.
+     * The result is the same as calling GenerateVertexData for each emitter in order.
+     * @param context Particle context
+     * @param dt Time step.
+     * @param emitters Render data of the emitters to generate vertex data for
+     * @param emitter_count Number of emitters
+     * @param vertex_buffer Vertex buffer into which to store the particle vertex data. If this is 0x0, no data will be generated.
+     * @param vertex_buffer_size Size in bytes of the supplied vertex buffer.
+     * @param out_vertex_buffer_size Size in bytes of the total data written to vertex buffer.
+     * @param vertex_format Which vertex format to use
+     */
+    void GenerateVertexData(HParticleContext context, float dt, const EmitterRenderData** emitters, uint32_t emitter_count, const Vector4& color, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format);
+
     /**
      * Debug render the status of the instances within the specified context.
      * @param context Context of the instances to render.
@@ -16,14 +16,25 @@
 
 #include <dlib/configfile.h>
 #include <dlib/index_pool.h>
+#include <dlib/math.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include "particle/particle_ddf.h"
 
 namespace dmParticle
 {
-    /// Number of samples per property (spline => linear segments)
-    static const uint32_t PROPERTY_SAMPLE_COUNT     = 64;
+    /// Number of segments per property (spline => lookup table). Build option, e.g. -DDM_PARTICLE_PROPERTY_SAMPLE_COUNT=128 in CXXFLAGS.
+    /// Each property table holds DM_PARTICLE_PROPERTY_SAMPLE_COUNT + 1 floats, more samples follow sharp curves more closely.
+#if !defined(DM_PARTICLE_PROPERTY_SAMPLE_COUNT)
+    #define DM_PARTICLE_PROPERTY_SAMPLE_COUNT 64
+#endif
+#if DM_PARTICLE_PROPERTY_SAMPLE_COUNT < 1
+    #error "DM_PARTICLE_PROPERTY_SAMPLE_COUNT must be at least 1"
+#endif
+    static const uint32_t PROPERTY_SAMPLE_COUNT     = DM_PARTICLE_PROPERTY_SAMPLE_COUNT;
+    /// Max number of state changes of an emitter in a single update (prespawn -> spawning -> postspawn -> sleeping)
+    static const uint32_t MAX_DEFERRED_STATE_COUNT  = 3;
 
     struct EmitterPrototype;
     struct Prototype;
@@ -138,6 +149,14 @@ namespace dmParticle
         float                   m_StartDelay;
         /// Particle spawn rate spread, randomized on emitter creation and used for the duration of the emitter.
         float                   m_SpawnRateSpread;
+        /// Bounds of the particle positions in emission space, and the max particle scale and size, updated when simulated
+        Vector3                 m_BoundsMin;
+        Vector3                 m_BoundsMax;
+        float                   m_MaxParticleScale;
+        float                   m_MaxParticleSize;
+        /// State changes made while updated on a worker thread, reported on the calling thread after the update.
+        EmitterState            m_DeferredStates[MAX_DEFERRED_STATE_COUNT];
+        uint32_t                m_DeferredStateCount;
         /// If the user has been warned that all particles cannot be rendered.
         uint16_t                m_RenderWarning : 1;
         /// If the user has been warned that the emitters animation could not be fetched
@@ -147,6 +166,8 @@ namespace dmParticle
         uint16_t                m_Retiring : 1;
         /// If this emitter needs to be rehashed
         uint16_t                m_ReHash : 1;
+        /// If state changes should be deferred, set while the emitter is updated on a worker thread
+        uint16_t                m_DeferStateChanges : 1;
     };
 
     struct Instance
@@ -181,6 +202,18 @@ namespace dmParticle
         uint16_t                m_ScaleAlongZ : 1;
     };
 
+    /**
+     * Emitter processed by a worker thread.
+     */
+    struct EmitterTask
+    {
+        Instance*   m_Instance;
+        HInstance   m_InstanceHandle;
+        uint32_t    m_EmitterIndex;
+        /// Vertex index of the first vertex written by the emitter, when generating vertex data
+        uint32_t    m_VertexIndex;
+    };
+
     /**
      * Representation of a context to hold a set of emitters.
      */
@@ -190,6 +223,7 @@ namespace dmParticle
         : m_MaxParticleCount(max_particle_count)
         , m_NextVersionNumber(1)
         , m_InstanceSeeding(0)
+        , m_WorkerPool(0)
         {
             memset(&m_Stats, 0, sizeof(m_Stats));
             m_Instances.SetCapacity(max_instance_count);
@@ -218,19 +252,28 @@ namespace dmParticle
         uint16_t            m_InstanceSeeding;
         /// Stats
         Stats               m_Stats;
+        /// Emitters processed by the worker pool, reused between frames
+        dmArray<EmitterTask> m_EmitterTasks;
+        /// Worker pool used to update emitters and generate vertex data, may be 0
+        dmWorkerPool::HWorkerPool m_WorkerPool;
     };
 
-    struct LinearSegment
+    /**
+     * Property curve sampled at x = i / PROPERTY_SAMPLE_COUNT, evaluated by interpolating two adjacent samples.
+     */
+    struct Property
     {
-        float m_X;
-        float m_Y;
-        float m_K;
+        float m_Samples[PROPERTY_SAMPLE_COUNT + 1];
+        float m_Spread;
     };
 
-    struct Property
+    /**
+     * Particle property curves, interleaved per sample so that all properties of a particle are
+     * evaluated from two adjacent rows. Allocated cache line aligned and shared by all instances of the prototype.
+     */
+    struct ParticlePropertyTable
     {
-        LinearSegment m_Segments[PROPERTY_SAMPLE_COUNT];
-        float m_Spread;
+        float m_Samples[PROPERTY_SAMPLE_COUNT + 1][dmParticleDDF::PARTICLE_KEY_COUNT];
     };
 
     struct ModifierPrototype
@@ -241,12 +284,13 @@ namespace dmParticle
     /**
      * Representation of an emitter resource.
      *
-     * NOTE The size of the properties-arrays is roughly 10 kB.
+     * NOTE The size of the properties-arrays is roughly 4 kB, plus 2 kB for the particle property table.
      */
     struct EmitterPrototype
     {
         EmitterPrototype()
-        : m_TileSource(0)
+        : m_ParticleProperties(0)
+        , m_TileSource(0)
         , m_Material(0)
         {
 
@@ -255,7 +299,7 @@ namespace dmParticle
         /// Emitter properties
         Property                    m_Properties[dmParticleDDF::EMITTER_KEY_COUNT];
         /// Particle properties
-        Property                    m_ParticleProperties[dmParticleDDF::PARTICLE_KEY_COUNT];
+        ParticlePropertyTable*      m_ParticleProperties;
         dmArray<ModifierPrototype>  m_Modifiers;
         dmhash_t                    m_Animation;
         /// Tile source to use when rendering particles.
@@ -285,7 +329,31 @@ namespace dmParticle
         dmParticleDDF::ParticleFX*  m_DDF;
     };
 
+    // Finds the segment of the property tables for x, clamped to [0, 1], and the position within the segment
+    static inline uint32_t GetPropertySegment(float x, float* out_t)
+    {
+        float f = dmMath::Clamp(x, 0.0f, 1.0f) * PROPERTY_SAMPLE_COUNT;
+        uint32_t segment_index = dmMath::Min((uint32_t)f, PROPERTY_SAMPLE_COUNT - 1);
+        *out_t = f - segment_index;
+        return segment_index;
+    }
+
+    // Evaluates a property table, stride is the distance between the samples in floats
+    static inline float EvaluatePropertySamples(const float* samples, uint32_t stride, float x)
+    {
+        float t;
+        uint32_t segment_index = GetPropertySegment(x, &t);
+        float y0 = samples[segment_index * stride];
+        return y0 + (samples[(segment_index + 1) * stride] - y0) * t;
+    }
+
+    /// Evaluates the spline at x, the baked property tables hold it at x = i / PROPERTY_SAMPLE_COUNT
+    float GetY(const dmParticleDDF::SplinePoint* segments, uint32_t segment_count, float x);
+
     void UpdateRenderData(HParticleContext context, HInstance instance, uint32_t emitter_index);
+
+    /// Simulates the particles of the emitter: evaluates the particle properties, applies the modifiers and integrates.
+    void Simulate(Instance* instance, Emitter* emitter, EmitterPrototype* prototype, dmParticleDDF::Emitter* ddf, float dt);
 }
 
 #endif // DM_PARTICLE_PRIVATE_H
@@ -15,11 +15,14 @@
 #include <stdio.h>
 #include <algorithm>
 #include <map>
+#include <vector>
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/time.h>
 #include <dlib/vmath.h>
+#include <dlib/worker_pool.h>
 
 #include <ddf/ddf.h>
 
@@ -307,6 +310,232 @@ TEST_F(ParticleTest, CallbackCalledMultipleEmitters)
     dmParticle::DestroyInstance(m_Context, instance);
 }
 
+struct EmitterStateChange
+{
+    uint32_t                    m_NumAwakeEmitters;
+    dmhash_t                    m_EmitterId;
+    dmParticle::EmitterState    m_State;
+};
+
+// The user data is freed when the instance is destroyed
+struct EmitterStateChangeLog
+{
+    std::vector<EmitterStateChange>* m_Changes;
+};
+
+void RecordEmitterStateChangedCallback(uint32_t num_awake_emitters, dmhash_t emitter_id, dmParticle::EmitterState emitter_state, void* user_data)
+{
+    EmitterStateChangeLog* log = (EmitterStateChangeLog*) user_data;
+    EmitterStateChange change = {num_awake_emitters, emitter_id, emitter_state};
+    log->m_Changes->push_back(change);
+}
+
+dmParticle::EmitterStateChangedData* NewEmitterStateChangeLog(dmParticle::EmitterStateChangedData* data, std::vector<EmitterStateChange>* changes)
+{
+    EmitterStateChangeLog* log = (EmitterStateChangeLog*) malloc(sizeof(EmitterStateChangeLog));
+    log->m_Changes = changes;
+    data->m_StateChangedCallback = RecordEmitterStateChangedCallback;
+    data->m_UserData = log;
+    return data;
+}
+
+/**
+ * Verify that updating with a worker pool gives the same particles, vertex data and state changes as updating on the calling thread
+ */
+TEST_F(ParticleTest, WorkerPool)
+{
+    const uint32_t instance_count = 8;
+    const uint32_t emitter_count = 4;
+    float dt = 1.0f / 60.0f;
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New("particle", 4);
+    dmParticle::HParticleContext context = dmParticle::CreateContext(64, 1024);
+    dmParticle::SetWorkerPool(context, pool);
+    uint8_t* vertex_buffer = new uint8_t[m_VertexBufferSize];
+
+    std::vector<EmitterStateChange> serial_changes;
+    std::vector<EmitterStateChange> parallel_changes;
+    dmParticle::EmitterStateChangedData callback_data;
+
+    ASSERT_TRUE(LoadPrototype("worker_pool.particlefxc", &m_Prototype));
+    ASSERT_EQ(emitter_count, dmParticle::GetEmitterCount(m_Prototype));
+
+    dmParticle::HInstance serial_instances[instance_count];
+    dmParticle::HInstance parallel_instances[instance_count];
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        serial_instances[i] = dmParticle::CreateInstance(m_Context, m_Prototype, NewEmitterStateChangeLog(&callback_data, &serial_changes));
+        parallel_instances[i] = dmParticle::CreateInstance(context, m_Prototype, NewEmitterStateChangeLog(&callback_data, &parallel_changes));
+        // The seeds are based on the current time, use the same for both instances
+        for (uint32_t e = 0; e < emitter_count; ++e)
+        {
+            dmParticle::Emitter* serial_emitter = GetEmitter(m_Context, serial_instances[i], e);
+            dmParticle::Emitter* parallel_emitter = GetEmitter(context, parallel_instances[i], e);
+            parallel_emitter->m_OriginalSeed = serial_emitter->m_OriginalSeed;
+            parallel_emitter->m_Seed = serial_emitter->m_Seed;
+            parallel_emitter->m_Duration = serial_emitter->m_Duration;
+            parallel_emitter->m_StartDelay = serial_emitter->m_StartDelay;
+            parallel_emitter->m_SpawnRateSpread = serial_emitter->m_SpawnRateSpread;
+        }
+        dmParticle::SetPosition(m_Context, serial_instances[i], Point3((float)i, 0.0f, 0.0f));
+        dmParticle::SetPosition(context, parallel_instances[i], Point3((float)i, 0.0f, 0.0f));
+        dmParticle::StartInstance(m_Context, serial_instances[i]);
+        dmParticle::StartInstance(context, parallel_instances[i]);
+    }
+
+    for (uint32_t frame = 0; frame < 90; ++frame)
+    {
+        dmParticle::Update(m_Context, dt, 0x0);
+        dmParticle::Update(context, dt, 0x0);
+
+        uint32_t serial_size = 0;
+        std::vector<const dmParticle::EmitterRenderData*> render_data;
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            for (uint32_t e = 0; e < emitter_count; ++e)
+            {
+                dmParticle::Emitter* serial_emitter = GetEmitter(m_Context, serial_instances[i], e);
+                dmParticle::Emitter* parallel_emitter = GetEmitter(context, parallel_instances[i], e);
+                ASSERT_EQ(serial_emitter->m_State, parallel_emitter->m_State);
+                ASSERT_EQ(ParticleCount(serial_emitter), ParticleCount(parallel_emitter));
+                for (uint32_t p = 0; p < ParticleCount(serial_emitter); ++p)
+                {
+                    dmParticle::Particle* sp = &serial_emitter->m_Particles[p];
+                    dmParticle::Particle* pp = &parallel_emitter->m_Particles[p];
+                    ASSERT_EQ(sp->GetTimeLeft(), pp->GetTimeLeft());
+                    ASSERT_EQ(sp->GetPosition().getX(), pp->GetPosition().getX());
+                    ASSERT_EQ(sp->GetPosition().getY(), pp->GetPosition().getY());
+                    ASSERT_EQ(sp->GetPosition().getZ(), pp->GetPosition().getZ());
+                    ASSERT_EQ(sp->GetVelocity().getX(), pp->GetVelocity().getX());
+                    ASSERT_EQ(sp->GetVelocity().getY(), pp->GetVelocity().getY());
+                    ASSERT_EQ(sp->GetVelocity().getZ(), pp->GetVelocity().getZ());
+                }
+
+                dmParticle::GenerateVertexData(m_Context, dt, serial_instances[i], e, Vector4(1,1,1,1), (void*)m_VertexBuffer, m_VertexBufferSize, &serial_size, dmParticle::PARTICLE_GO);
+                dmParticle::EmitterRenderData* data;
+                dmParticle::GetEmitterRenderData(context, parallel_instances[i], e, &data);
+                render_data.push_back(data);
+            }
+        }
+
+        uint32_t parallel_size = 0;
+        dmParticle::GenerateVertexData(context, dt, &render_data[0], render_data.size(), Vector4(1,1,1,1), (void*)vertex_buffer, m_VertexBufferSize, &parallel_size, dmParticle::PARTICLE_GO);
+        ASSERT_EQ(serial_size, parallel_size);
+        ASSERT_EQ(0, memcmp(m_VertexBuffer, vertex_buffer, serial_size));
+    }
+
+    ASSERT_LT(0U, serial_changes.size());
+    ASSERT_EQ(serial_changes.size(), parallel_changes.size());
+    for (uint32_t i = 0; i < serial_changes.size(); ++i)
+    {
+        ASSERT_EQ(serial_changes[i].m_NumAwakeEmitters, parallel_changes[i].m_NumAwakeEmitters);
+        ASSERT_EQ(serial_changes[i].m_EmitterId, parallel_changes[i].m_EmitterId);
+        ASSERT_EQ(serial_changes[i].m_State, parallel_changes[i].m_State);
+    }
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        dmParticle::DestroyInstance(m_Context, serial_instances[i]);
+        dmParticle::DestroyInstance(context, parallel_instances[i]);
+    }
+    dmParticle::DestroyContext(context);
+    dmWorkerPool::Delete(pool);
+    delete [] vertex_buffer;
+}
+
+/**
+ * Verify that the bounding radius of each emitter contains all of its vertices, in world and emitter space
+ */
+TEST_F(ParticleTest, BoundingRadius)
+{
+    const uint32_t emitter_count = 4;
+    float dt = 1.0f / 60.0f;
+
+    ASSERT_TRUE(LoadPrototype("worker_pool.particlefxc", &m_Prototype));
+    ASSERT_EQ(emitter_count, dmParticle::GetEmitterCount(m_Prototype));
+
+    dmParticle::HInstance instance = dmParticle::CreateInstance(m_Context, m_Prototype, 0x0);
+    dmParticle::SetPosition(m_Context, instance, Point3(10.0f, 20.0f, 0.0f));
+    dmParticle::SetRotation(m_Context, instance, Quat::rotationZ(1.0f));
+    dmParticle::SetScale(m_Context, instance, 2.0f);
+    dmParticle::StartInstance(m_Context, instance);
+
+    for (uint32_t frame = 0; frame < 90; ++frame)
+    {
+        dmParticle::Update(m_Context, dt, 0x0);
+
+        for (uint32_t e = 0; e < emitter_count; ++e)
+        {
+            uint32_t size = 0;
+            dmParticle::GenerateVertexData(m_Context, dt, instance, e, Vector4(1,1,1,1), (void*)m_VertexBuffer, m_VertexBufferSize, &size, dmParticle::PARTICLE_GO);
+
+            dmParticle::EmitterRenderData* data;
+            dmParticle::GetEmitterRenderData(m_Context, instance, e, &data);
+            Point3 position(data->m_Transform.getTranslation());
+            uint32_t vertex_count = size / sizeof(dmParticle::Vertex);
+            if (vertex_count > 0)
+            {
+                ASSERT_LT(0.0f, data->m_BoundingRadius);
+            }
+            const dmParticle::Vertex* vertices = (const dmParticle::Vertex*)m_VertexBuffer;
+            for (uint32_t v = 0; v < vertex_count; ++v)
+            {
+                float distance = length(Point3(vertices[v].m_X, vertices[v].m_Y, vertices[v].m_Z) - position);
+                ASSERT_LE(distance, data->m_BoundingRadius * 1.0001f);
+            }
+        }
+    }
+
+    dmParticle::DestroyInstance(m_Context, instance);
+}
+
+/**
+ * Measure the update time of 100k particles, without modifiers and with each modifier type
+ */
+TEST_F(ParticleTest, BenchModifiers)
+{
+    const char* files[] = { "bench_none.particlefxc", "bench_acc.particlefxc", "bench_drag.particlefxc", "bench_radial.particlefxc", "bench_vortex.particlefxc" };
+    const char* names[] = { "none", "acceleration", "drag", "radial", "vortex" };
+    const uint32_t particle_count = 100000;
+    const uint32_t frame_count = 20;
+    float dt = 1.0f / 60.0f;
+
+    for (uint32_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+    {
+        dmParticle::HPrototype prototype;
+        ASSERT_TRUE(LoadPrototype(files[i], &prototype));
+        dmParticle::HInstance instance = dmParticle::CreateInstance(m_Context, prototype, 0x0);
+        dmParticle::StartInstance(m_Context, instance);
+        dmParticle::Update(m_Context, dt, 0x0);
+        ASSERT_EQ(particle_count, ParticleCount(GetEmitter(m_Context, instance, 0)));
+
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            dmParticle::Update(m_Context, dt, 0x0);
+        }
+        uint64_t end = dmTime::GetTime();
+        ASSERT_EQ(particle_count, ParticleCount(GetEmitter(m_Context, instance, 0)));
+        printf("Update %u particles, %s: %.2f ms/frame\n", particle_count, names[i], (end - start) / (1000.0 * frame_count));
+
+        // Simulation only, excluding spawning, sorting and render data
+        dmParticle::Instance* inst = m_Context->m_Instances[instance & 0xffff];
+        dmParticle::Emitter* emitter = &inst->m_Emitters[0];
+        dmParticle::EmitterPrototype* emitter_prototype = &prototype->m_Emitters[0];
+        dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[0];
+        start = dmTime::GetTime();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            dmParticle::Simulate(inst, emitter, emitter_prototype, emitter_ddf, dt);
+        }
+        end = dmTime::GetTime();
+        printf("Simulate %u particles, %s: %.2f ms/frame\n", particle_count, names[i], (end - start) / (1000.0 * frame_count));
+
+        dmParticle::DestroyInstance(m_Context, instance);
+        dmParticle::DeletePrototype(prototype);
+    }
+}
+
 /**
  * Verify creation/destruction, check leaks
  */
@@ -1444,6 +1673,174 @@ TEST_F(ParticleTest, Animation)
     dmParticle::DestroyInstance(m_Context, instance);
 }
 
+static uint32_t g_CompactStartTile = 0;
+static uint32_t g_CompactFlip = 0;
+
+dmParticle::FetchAnimationResult CompactFetchAnimationCallback(void* tile_source, dmhash_t animation, dmParticle::AnimationData* out_data)
+{
+    dmParticle::FetchAnimationResult result = FetchAnimationCallback(tile_source, animation, out_data);
+    out_data->m_StartTile = g_CompactStartTile;
+    out_data->m_EndTile = g_CompactStartTile + 2;
+    out_data->m_HFlip = g_CompactFlip & 1;
+    out_data->m_VFlip = (g_CompactFlip >> 1) & 1;
+    return result;
+}
+
+// Compares a baked property table with the spline it was baked from
+static void CheckBakedProperty(const dmParticleDDF::SplinePoint* points, uint32_t point_count, const float* samples, uint32_t stride)
+{
+    const uint32_t n = dmParticle::PROPERTY_SAMPLE_COUNT;
+    for (uint32_t i = 0; i <= n; ++i)
+    {
+        float x = i / (float)n;
+        ASSERT_EQ(dmParticle::GetY(points, point_count, x), samples[i * stride]);
+        ASSERT_EQ(samples[i * stride], dmParticle::EvaluatePropertySamples(samples, stride, x));
+    }
+    // Between two samples the table is interpolated linearly
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        float y0 = samples[i * stride];
+        float y1 = samples[(i + 1) * stride];
+        ASSERT_NEAR((y0 + y1) * 0.5f, dmParticle::EvaluatePropertySamples(samples, stride, (i + 0.5f) / n), 0.0001f);
+    }
+    // Out of range life is clamped to the first and last samples
+    ASSERT_EQ(samples[0], dmParticle::EvaluatePropertySamples(samples, stride, -0.5f));
+    ASSERT_EQ(samples[n * stride], dmParticle::EvaluatePropertySamples(samples, stride, 1.0f));
+    ASSERT_EQ(samples[n * stride], dmParticle::EvaluatePropertySamples(samples, stride, 1.5f));
+    ASSERT_EQ(dmParticle::GetY(points, point_count, 1.0f), dmParticle::EvaluatePropertySamples(samples, stride, 2.0f));
+}
+
+/**
+ * Verify that the emitter and particle property tables hold the splines at every sample point, x = 1 included
+ */
+TEST_F(ParticleTest, BakedPropertyTables)
+{
+    const char* files[] = { "emitter_spline.particlefxc", "particle_spline.particlefxc" };
+    for (uint32_t f = 0; f < sizeof(files) / sizeof(files[0]); ++f)
+    {
+        ASSERT_TRUE(LoadPrototype(files[f], &m_Prototype));
+        dmParticle::Prototype* prototype = (dmParticle::Prototype*)m_Prototype;
+        dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[0];
+        dmParticle::EmitterPrototype* emitter = &prototype->m_Emitters[0];
+
+        for (uint32_t i = 0; i < emitter_ddf->m_Properties.m_Count; ++i)
+        {
+            const dmParticleDDF::Emitter::Property& p = emitter_ddf->m_Properties[i];
+            CheckBakedProperty(p.m_Points.m_Data, p.m_Points.m_Count, emitter->m_Properties[p.m_Key].m_Samples, 1);
+        }
+        for (uint32_t i = 0; i < emitter_ddf->m_ParticleProperties.m_Count; ++i)
+        {
+            const dmParticleDDF::Emitter::ParticleProperty& p = emitter_ddf->m_ParticleProperties[i];
+            CheckBakedProperty(p.m_Points.m_Data, p.m_Points.m_Count, &emitter->m_ParticleProperties->m_Samples[0][p.m_Key], dmParticleDDF::PARTICLE_KEY_COUNT);
+        }
+
+        dmParticle::DeletePrototype(m_Prototype);
+        m_Prototype = 0x0;
+    }
+}
+
+// Expands the compact vertex the way particlefx_compact.vp does
+static void ExpandCompactVertex(const dmParticle::ParticleCompactVertex* v, Vector3 positions[6], float uvs[12])
+{
+    Vector3 center(v->m_Position[0], v->m_Position[1], v->m_Position[2]);
+    Quat rotation(v->m_Rotation[0], v->m_Rotation[1], v->m_Rotation[2], v->m_Rotation[3]);
+    Vector3 x = rotate(rotation, Vector3(v->m_Size[0], 0.0f, 0.0f));
+    Vector3 y = rotate(rotation, Vector3(0.0f, v->m_Size[1], 0.0f));
+    // Same corner order as the expanded vertices: (-x, -y), (-x, +y), (+x, +y), (+x, +y), (+x, -y), (-x, -y)
+    const int corners[6][2] = { {0, 0}, {0, 1}, {1, 1}, {1, 1}, {1, 0}, {0, 0} };
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        int tx = corners[i][0];
+        int ty = corners[i][1];
+        positions[i] = (tx ? x : -x) + (ty ? y : -y) + center;
+        if (v->m_UVRotated)
+        {
+            int tmp = tx;
+            tx = ty;
+            ty = tmp;
+        }
+        uvs[i * 2] = tx ? v->m_UV[2] : v->m_UV[0];
+        uvs[i * 2 + 1] = ty ? v->m_UV[3] : v->m_UV[1];
+    }
+}
+
+/**
+ * Verify that the compact vertex format describes the same quads as the expanded vertex format
+ */
+TEST_F(ParticleTest, CompactVertexFormat)
+{
+    float dt = 0.25f;
+
+    ASSERT_EQ(sizeof(dmParticle::ParticleCompactVertex), dmParticle::GetVertexBufferSize(1, dmParticle::PARTICLE_GO_COMPACT));
+
+    ASSERT_TRUE(LoadPrototype("anim.particlefxc", &m_Prototype));
+    dmParticle::HInstance instance = dmParticle::CreateInstance(m_Context, m_Prototype, 0x0);
+    dmParticle::SetPosition(m_Context, instance, Point3(10.0f, 20.0f, 0.0f));
+    dmParticle::SetRotation(m_Context, instance, Quat::rotationZ(0.5f));
+
+    const uint32_t type_count = 7;
+    TileSource tile_source;
+    for (uint32_t emitter_i = 0; emitter_i < type_count; ++emitter_i)
+        dmParticle::SetTileSource(m_Prototype, emitter_i, &tile_source);
+
+    uint32_t compact_buffer_size = dmParticle::GetVertexBufferSize(1024, dmParticle::PARTICLE_GO_COMPACT);
+    dmParticle::ParticleCompactVertex* compact_buffer = (dmParticle::ParticleCompactVertex*)malloc(compact_buffer_size);
+
+    // Unrotated and rotated tiles, with all combinations of flipping
+    const uint32_t start_tiles[] = { 0, 6 };
+    uint32_t checked_count = 0;
+    for (uint32_t start_i = 0; start_i < 2; ++start_i)
+    {
+        for (uint32_t flip = 0; flip < 4; ++flip)
+        {
+            g_CompactStartTile = start_tiles[start_i];
+            g_CompactFlip = flip;
+            dmParticle::ResetInstance(m_Context, instance);
+            dmParticle::StartInstance(m_Context, instance);
+
+            for (uint32_t it = 0; it < 3; ++it)
+            {
+                dmParticle::Update(m_Context, dt, CompactFetchAnimationCallback);
+                uint32_t vertex_buffer_size = 0;
+                uint32_t compact_size = 0;
+                for (uint32_t type = 0; type < type_count; ++type)
+                {
+                    dmParticle::GenerateVertexData(m_Context, dt, instance, type, Vector4(1,1,1,1), m_VertexBuffer, m_VertexBufferSize, &vertex_buffer_size, dmParticle::PARTICLE_GO);
+                    dmParticle::GenerateVertexData(m_Context, dt, instance, type, Vector4(1,1,1,1), compact_buffer, compact_buffer_size, &compact_size, dmParticle::PARTICLE_GO_COMPACT);
+                }
+                uint32_t particle_count = compact_size / sizeof(dmParticle::ParticleCompactVertex);
+                ASSERT_EQ(particle_count * 6 * sizeof(dmParticle::Vertex), vertex_buffer_size);
+
+                dmParticle::Vertex* vertex = (dmParticle::Vertex*)m_VertexBuffer;
+                for (uint32_t pi = 0; pi < particle_count; ++pi)
+                {
+                    const dmParticle::ParticleCompactVertex* cv = &compact_buffer[pi];
+                    Vector3 positions[6];
+                    float uvs[12];
+                    ExpandCompactVertex(cv, positions, uvs);
+                    for (uint32_t vi = 0; vi < 6; ++vi, ++vertex)
+                    {
+                        ASSERT_EQ(vertex->m_X, positions[vi].getX());
+                        ASSERT_EQ(vertex->m_Y, positions[vi].getY());
+                        ASSERT_EQ(vertex->m_Z, positions[vi].getZ());
+                        ASSERT_EQ(vertex->m_U, uvs[vi * 2]);
+                        ASSERT_EQ(vertex->m_V, uvs[vi * 2 + 1]);
+                        ASSERT_EQ((uint8_t)(vertex->m_Red * 255.0f + 0.5f), cv->m_Color[0]);
+                        ASSERT_EQ((uint8_t)(vertex->m_Green * 255.0f + 0.5f), cv->m_Color[1]);
+                        ASSERT_EQ((uint8_t)(vertex->m_Blue * 255.0f + 0.5f), cv->m_Color[2]);
+                        ASSERT_EQ((uint8_t)(vertex->m_Alpha * 255.0f + 0.5f), cv->m_Color[3]);
+                    }
+                }
+                checked_count += particle_count;
+            }
+        }
+    }
+    ASSERT_LT(0U, checked_count);
+
+    free(compact_buffer);
+    dmParticle::DestroyInstance(m_Context, instance);
+}
+
 TEST_F(ParticleTest, InvalidKeys)
 {
     ASSERT_TRUE(LoadPrototype("invalid_keys.particlefxc", &m_Prototype));
@@ -456,6 +456,7 @@ namespace dmRender
     , m_Align(TEXT_ALIGN_LEFT)
     , m_VAlign(TEXT_VALIGN_TOP)
     , m_StencilTestParamsSet(0)
+    , m_BoundingRadius(0.0f)
     {
         m_StencilTestParams.Init();
     }
@@ -529,6 +530,7 @@ namespace dmRender
         te.m_Height = params.m_Height;
         te.m_Leading = params.m_Leading;
         te.m_Tracking = params.m_Tracking;
+        te.m_BoundingRadius = params.m_BoundingRadius;
         te.m_LineBreak = params.m_LineBreak;
         te.m_Align = params.m_Align;
         te.m_VAlign = params.m_VAlign;
@@ -1054,6 +1056,7 @@ namespace dmRender
                 {
                     TextEntry& te = text_context.m_TextEntries[text_context.m_TextEntriesFlushed + i];
                     write_ptr->m_WorldPosition = Point3(te.m_Transform.getTranslation());
+                    write_ptr->m_BoundingRadius = te.m_BoundingRadius;
                     write_ptr->m_MinorOrder = 0;
                     write_ptr->m_MajorOrder = major_order;
                     write_ptr->m_Order = render_order;
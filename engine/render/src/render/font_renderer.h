@@ -217,6 +217,8 @@ namespace dmRender
         StencilTestParams m_StencilTestParams;
         /// Stencil parameters set or not
         uint8_t m_StencilTestParamsSet : 1;
+        /// Radius of the sphere around the world transform position that contains the text, 0 if the text should never be culled
+        float       m_BoundingRadius;
     };
 
     /**
@@ -399,6 +399,25 @@ namespace dmRender
             return -1;
     }
 
+    int32_t GetMaterialAttributeLocation(HMaterial material, dmhash_t name_hash, const char* name)
+    {
+        dmHashTable64<int32_t>& locations = material->m_AttributeLocations;
+        int32_t* location = locations.Get(name_hash);
+        if (location)
+            return *location;
+
+        if (locations.Full())
+            locations.SetCapacity(8, locations.Capacity() + 4);
+        int32_t new_location = dmGraphics::GetAttributeLocation(material->m_Program, name);
+        locations.Put(name_hash, new_location);
+        return new_location;
+    }
+
+    void ClearMaterialAttributeLocations(HMaterial material)
+    {
+        material->m_AttributeLocations.Clear();
+    }
+
     void SetMaterialSampler(HMaterial material, dmhash_t name_hash, uint32_t unit, dmGraphics::TextureWrap u_wrap, dmGraphics::TextureWrap v_wrap, dmGraphics::TextureFilter min_filter, dmGraphics::TextureFilter mag_filter)
     {
         dmArray<Sampler>& samplers = material->m_Samplers;
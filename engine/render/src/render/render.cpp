@@ -33,6 +33,9 @@ namespace dmRender
 
     const char* RENDER_SOCKET_NAME = "@render";
 
+    // Fat margin of the proxies in the spatial tree, in world units
+    static const float SPATIAL_TREE_MARGIN = 8.0f;
+
     StencilTestParams::StencilTestParams() {
         Init();
     }
@@ -139,6 +142,9 @@ namespace dmRender
 
         context->m_RenderListDispatch.SetCapacity(255);
 
+        context->m_SpatialTree = NewSpatialTree(SPATIAL_TREE_MARGIN);
+        context->m_SpatialQueryId = 0;
+
         dmMessage::Result r = dmMessage::NewSocket(RENDER_SOCKET_NAME, &context->m_Socket);
         assert(r == dmMessage::RESULT_OK);
 
@@ -154,6 +160,7 @@ namespace dmRender
         FinalizeDebugRenderer(render_context);
         FinalizeTextContext(render_context);
         dmMessage::DeleteSocket(render_context->m_Socket);
+        DeleteSpatialTree(render_context->m_SpatialTree);
         delete render_context;
 
         return RESULT_OK;
@@ -205,7 +212,13 @@ namespace dmRender
 
         uint32_t size = render_list.Size();
         render_list.SetSize(size + entries);
-        return (render_list.Begin() + size);
+        RenderListEntry* begin = render_list.Begin() + size;
+        for (uint32_t i = 0; i < entries; ++i)
+        {
+            begin[i].m_BoundingRadius = 0.0f;
+            begin[i].m_HasSpatialProxy = 0;
+        }
+        return begin;
     }
 
     // Submit a range of entries (pointers must be from a range allocated by RenderListAlloc, and not between two alloc calls).
@@ -231,17 +244,6 @@ namespace dmRender
         render_context->m_RenderListRanges.SetSize(0);
     }
 
-    struct RenderListSorter
-    {
-        bool operator()(uint32_t a, uint32_t b) const
-        {
-            const RenderListSortValue& u = values[a];
-            const RenderListSortValue& v = values[b];
-            return u.m_SortKey < v.m_SortKey;
-        }
-        RenderListSortValue* values;
-    };
-
     void RenderListEnd(HRenderContext render_context)
     {
         // Unflushed leftovers are assumed to be the debug rendering
@@ -286,6 +288,11 @@ namespace dmRender
         return render_context->m_GraphicsContext;
     }
 
+    HSpatialTree GetSpatialTree(HRenderContext render_context)
+    {
+        return render_context->m_SpatialTree;
+    }
+
     const Matrix4& GetViewProjectionMatrix(HRenderContext render_context)
     {
         return render_context->m_ViewProj;
@@ -406,23 +413,178 @@ namespace dmRender
         return false;
     }
 
-    // Compute new sort values for everything that matches tag_mask
-    static void MakeSortBuffer(HRenderContext context, uint32_t tag_mask)
+    static const uint32_t RADIX_BITS = 8;
+    static const uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+    static const uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+    void RadixSortRenderList(uint64_t* keys, uint32_t* indices, uint32_t count, uint64_t* scratch_keys, uint32_t* scratch_indices)
     {
-        DM_PROFILE(Render, "MakeSortBuffer");
+        if (count < 2)
+            return;
+
+        // Build all histograms in one go
+        uint32_t histograms[RADIX_PASSES][RADIX_SIZE];
+        memset(histograms, 0, sizeof(histograms));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t key = keys[i];
+            for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+            {
+                histograms[pass][key & (RADIX_SIZE-1)]++;
+                key >>= RADIX_BITS;
+            }
+        }
+
+        uint64_t* src_keys = keys;
+        uint32_t* src_indices = indices;
+        uint64_t* dst_keys = scratch_keys;
+        uint32_t* dst_indices = scratch_indices;
 
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+        {
+            uint32_t* histogram = histograms[pass];
+            const uint32_t shift = pass * RADIX_BITS;
+
+            // If all keys have the same digit, the pass wouldn't change the order
+            if (histogram[(src_keys[0] >> shift) & (RADIX_SIZE-1)] == count)
+                continue;
+
+            // Convert to offsets
+            uint32_t offset = 0;
+            for (uint32_t i = 0; i < RADIX_SIZE; ++i)
+            {
+                uint32_t c = histogram[i];
+                histogram[i] = offset;
+                offset += c;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint64_t key = src_keys[i];
+                uint32_t dst = histogram[(key >> shift) & (RADIX_SIZE-1)]++;
+                dst_keys[dst] = key;
+                dst_indices[dst] = src_indices[i];
+            }
+
+            uint64_t* tmp_keys = src_keys; src_keys = dst_keys; dst_keys = tmp_keys;
+            uint32_t* tmp_indices = src_indices; src_indices = dst_indices; dst_indices = tmp_indices;
+        }
+
+        if (src_indices != indices)
+        {
+            memcpy(keys, src_keys, sizeof(uint64_t) * count);
+            memcpy(indices, src_indices, sizeof(uint32_t) * count);
+        }
+    }
+
+    static void ReserveSortBuffers(HRenderContext context)
+    {
         const uint32_t required_capacity = context->m_RenderListSortIndices.Capacity();
         // SetCapacity does early out if they are the same, so just call anyway.
         context->m_RenderListSortBuffer.SetCapacity(required_capacity);
-        context->m_RenderListSortBuffer.SetSize(0);
         context->m_RenderListSortValues.SetCapacity(required_capacity);
-        context->m_RenderListSortValues.SetSize(context->m_RenderListSortIndices.Size());
+        context->m_RenderListSortDepths.SetCapacity(required_capacity);
+        context->m_RenderListSortKeys.SetCapacity(required_capacity);
+        context->m_RenderListSortScratchKeys.SetCapacity(required_capacity);
+        context->m_RenderListSortScratch.SetCapacity(required_capacity);
+    }
+
+    // Compute the parts of the sort values that doesn't depend on the view (once per frame)
+    static void MakeSortValues(HRenderContext context)
+    {
+        const uint32_t count = context->m_RenderList.Size();
+        context->m_RenderListSortValues.SetSize(count);
+        context->m_RenderListSortDepths.SetSize(count);
 
         RenderListSortValue* sort_values = context->m_RenderListSortValues.Begin();
+        const RenderListEntry* entries = context->m_RenderList.Begin();
+        for (uint32_t idx = 0; idx < count; ++idx)
+        {
+            const RenderListEntry* entry = &entries[idx];
+            RenderListSortValue& value = sort_values[idx];
+            value.m_SortKey = 0;
+            value.m_MajorOrder = entry->m_MajorOrder;
+            // World entries get their order from the depth, in MakeSortBuffer
+            value.m_Order = entry->m_MajorOrder == RENDER_ORDER_WORLD ? 0 : entry->m_Order;
+            value.m_MinorOrder = entry->m_MinorOrder;
+            value.m_BatchKey = entry->m_BatchKey & 0x00ffffff;
+            value.m_Dispatch = entry->m_Dispatch;
+        }
+    }
+
+    // The planes (a, b, c, d) of the clip space frustum of view_proj, normalized so that a*x + b*y + c*z + d is the
+    // signed distance to the plane, positive inside the frustum
+    void GetFrustumPlanes(const Matrix4& view_proj, Vector4 planes[6])
+    {
+        const Vector4 row0 = view_proj.getRow(0);
+        const Vector4 row1 = view_proj.getRow(1);
+        const Vector4 row2 = view_proj.getRow(2);
+        const Vector4 row3 = view_proj.getRow(3);
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // bottom
+        planes[3] = row3 - row1; // top
+        planes[4] = row3 + row2; // near
+        planes[5] = row3 - row2; // far
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            float length = Vectormath::Aos::length(planes[i].getXYZ());
+            // A degenerate plane never culls
+            planes[i] = length > 0.0f ? planes[i] / length : Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    bool IsSphereOutsideFrustum(const Vector4 planes[6], const Point3& center, float radius)
+    {
+        const Vector4 p(center);
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            if (dot(planes[i], p) < -radius)
+                return true;
+        }
+        return false;
+    }
+
+    // Compute new sort values for everything that matches tag_mask, world entries outside the view frustum are culled
+    static void MarkVisibleSpatialProxy(void* _context, HSpatialProxy proxy, uintptr_t user_data)
+    {
+        RenderContext* context = (RenderContext*) _context;
+        dmArray<uint32_t>& visibility = context->m_SpatialProxyVisibility;
+        if (proxy >= visibility.Size())
+        {
+            uint32_t size = visibility.Size();
+            if (proxy >= visibility.Capacity())
+                visibility.SetCapacity(dmMath::Max<uint32_t>(proxy + 1, visibility.Capacity() * 2));
+            visibility.SetSize(proxy + 1);
+            memset(visibility.Begin() + size, 0, (proxy + 1 - size) * sizeof(uint32_t));
+        }
+        visibility[proxy] = context->m_SpatialQueryId;
+    }
+
+    static inline bool IsSpatialProxyVisible(HRenderContext context, HSpatialProxy proxy)
+    {
+        return proxy < context->m_SpatialProxyVisibility.Size() && context->m_SpatialProxyVisibility[proxy] == context->m_SpatialQueryId;
+    }
+
+    void MakeSortBuffer(HRenderContext context, uint32_t tag_mask)
+    {
+        DM_PROFILE(Render, "MakeSortBuffer");
+
+        context->m_RenderListSortBuffer.SetSize(0);
+        context->m_RenderListSortKeys.SetSize(0);
+
+        RenderListSortValue* sort_values = context->m_RenderListSortValues.Begin();
+        float* sort_depths = context->m_RenderListSortDepths.Begin();
         RenderListEntry* entries = context->m_RenderList.Begin();
 
         const Matrix4& transform = context->m_ViewProj;
 
+        Vector4 frustum_planes[6];
+        GetFrustumPlanes(transform, frustum_planes);
+        uint32_t culled = 0;
+        // The spatial tree is queried once, on the first entry with a proxy
+        bool spatial_queried = false;
+
         float minZW = FLT_MAX;
         float maxZW = -FLT_MAX;
 
@@ -434,54 +596,67 @@ namespace dmRender
             if ( (range.m_TagMask & tag_mask) != tag_mask )
                 continue;
 
-            // Write z values...
+            // Cull and write z values...
             for (uint32_t i = range.m_Start; i < range.m_Start+range.m_Count; ++i)
             {
                 uint32_t idx = context->m_RenderListSortIndices[i];
                 RenderListEntry* entry = &entries[idx];
-                if (entry->m_MajorOrder != RENDER_ORDER_WORLD)
-                    continue; // Could perhaps break here, if we also sorted on the major order (cost more when I tested it /MAWE)
-
-                const Vector4 res = transform * entry->m_WorldPosition;
-                const float zw = res.getZ() / res.getW();
-                sort_values[idx].m_ZW = zw;
-                if (zw < minZW) minZW = zw;
-                if (zw > maxZW) maxZW = zw;
+                if (entry->m_MajorOrder == RENDER_ORDER_WORLD)
+                {
+                    if (entry->m_HasSpatialProxy)
+                    {
+                        if (!spatial_queried)
+                        {
+                            DM_PROFILE(Render, "QuerySpatialTree");
+                            // Zero marks a proxy never found, skip it on wrap around
+                            if (++context->m_SpatialQueryId == 0)
+                                ++context->m_SpatialQueryId;
+                            QuerySpatialTreeFrustum(context->m_SpatialTree, transform, MarkVisibleSpatialProxy, context);
+                            spatial_queried = true;
+                        }
+                        if (!IsSpatialProxyVisible(context, entry->m_SpatialProxy))
+                        {
+                            ++culled;
+                            continue;
+                        }
+                    }
+                    else if (entry->m_BoundingRadius > 0.0f && IsSphereOutsideFrustum(frustum_planes, entry->m_WorldPosition, entry->m_BoundingRadius))
+                    {
+                        ++culled;
+                        continue;
+                    }
+
+                    const Vector4 res = transform * entry->m_WorldPosition;
+                    const float zw = res.getZ() / res.getW();
+                    sort_depths[idx] = zw;
+                    if (zw < minZW) minZW = zw;
+                    if (zw > maxZW) maxZW = zw;
+                }
+                context->m_RenderListSortBuffer.Push(idx);
             }
         }
 
+        DM_COUNTER("RenderListCulled", culled);
+
         // ... and compute range
         float rc = 0;
         if (maxZW > minZW)
             rc = 1.0f / (maxZW - minZW);
 
-        for( uint32_t i = 0; i < num_ranges; ++i)
+        const uint32_t* sort_buffer = context->m_RenderListSortBuffer.Begin();
+        uint32_t count = context->m_RenderListSortBuffer.Size();
+        for (uint32_t i = 0; i < count; ++i)
         {
-            RenderListRange& range = ranges[i];
-            if ( (range.m_TagMask & tag_mask) != tag_mask )
-                continue;
+            uint32_t idx = sort_buffer[i];
+            RenderListSortValue& value = sort_values[idx];
 
-            for (uint32_t i = range.m_Start; i < range.m_Start+range.m_Count; ++i)
+            // The rest of the value is already set up in MakeSortValues
+            if (value.m_MajorOrder == RENDER_ORDER_WORLD)
             {
-                uint32_t idx = context->m_RenderListSortIndices[i];
-                RenderListEntry* entry = &entries[idx];
-
-                sort_values[idx].m_MajorOrder = entry->m_MajorOrder;
-                if (entry->m_MajorOrder == RENDER_ORDER_WORLD)
-                {
-                    const float z = sort_values[idx].m_ZW;
-                    sort_values[idx].m_Order = (uint32_t) (0xfffff8 - 0xfffff0 * rc * (z - minZW));
-                }
-                else
-                {
-                    // use the integer value provided.
-                    sort_values[idx].m_Order = entry->m_Order;
-                }
-                sort_values[idx].m_MinorOrder = entry->m_MinorOrder;
-                sort_values[idx].m_BatchKey = entry->m_BatchKey & 0x00ffffff;
-                sort_values[idx].m_Dispatch = entry->m_Dispatch;
-                context->m_RenderListSortBuffer.Push(idx);
+                const float z = sort_depths[idx];
+                value.m_Order = (uint32_t) (0xfffff8 - 0xfffff0 * rc * (z - minZW));
             }
+            context->m_RenderListSortKeys.Push(value.m_SortKey);
         }
     }
 
@@ -520,18 +695,28 @@ namespace dmRender
         FindRenderListRanges(first, high - first, size - (high - rangefirst), entries, comp, ctx, callback);
     }
 
-    static void SortRenderList(HRenderContext context)
+    void SortRenderList(HRenderContext context)
     {
         DM_PROFILE(Render, "SortRenderList");
 
         if (context->m_RenderList.Empty())
             return;
 
+        ReserveSortBuffers(context);
+        MakeSortValues(context);
+
         // First sort on the tag masks
         {
-            RenderListEntrySorter sort;
-            sort.m_Base = context->m_RenderList.Begin();
-            std::stable_sort(context->m_RenderListSortIndices.Begin(), context->m_RenderListSortIndices.End(), sort);
+            const uint32_t count = context->m_RenderListSortIndices.Size();
+            const RenderListEntry* entries = context->m_RenderList.Begin();
+            const uint32_t* indices = context->m_RenderListSortIndices.Begin();
+            context->m_RenderListSortKeys.SetSize(count);
+            uint64_t* keys = context->m_RenderListSortKeys.Begin();
+            for (uint32_t i = 0; i < count; ++i)
+                keys[i] = entries[indices[i]].m_TagMask;
+
+            RadixSortRenderList(keys, context->m_RenderListSortIndices.Begin(), count,
+                                context->m_RenderListSortScratchKeys.Begin(), context->m_RenderListSortScratch.Begin());
         }
         // Now find the ranges of tag masks
         {
@@ -568,9 +753,8 @@ namespace dmRender
 
         {
             DM_PROFILE(Render, "DrawRenderList_SORT");
-            RenderListSorter sort;
-            sort.values = context->m_RenderListSortValues.Begin();
-            std::stable_sort(context->m_RenderListSortBuffer.Begin(), context->m_RenderListSortBuffer.End(), sort);
+            RadixSortRenderList(context->m_RenderListSortKeys.Begin(), context->m_RenderListSortBuffer.Begin(), context->m_RenderListSortBuffer.Size(),
+                                context->m_RenderListSortScratchKeys.Begin(), context->m_RenderListSortScratch.Begin());
         }
 
         // Construct render objects
@@ -695,7 +879,22 @@ namespace dmRender
 
                 dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclaration, ro->m_VertexBuffer, GetMaterialProgram(material));
 
-                if (ro->m_IndexBuffer)
+                if (ro->m_InstanceCount > 0)
+                {
+                    if (ro->m_InstanceBuffer)
+                        dmGraphics::EnableVertexDeclaration(context, ro->m_InstanceDeclaration, ro->m_InstanceBuffer, GetMaterialProgram(material));
+
+                    if (ro->m_IndexBuffer)
+                        dmGraphics::DrawElementsInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount, ro->m_IndexType, ro->m_IndexBuffer);
+                    else
+                        dmGraphics::DrawInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount);
+
+                    if (ro->m_InstanceBuffer)
+                        dmGraphics::DisableVertexDeclaration(context, ro->m_InstanceDeclaration);
+
+                    DM_COUNTER("DrawInstances", ro->m_InstanceCount);
+                }
+                else if (ro->m_IndexBuffer)
                     dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer);
                 else
                     dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount);
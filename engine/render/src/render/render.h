@@ -21,6 +21,7 @@
 #include <script/lua_source_ddf.h>
 #include <graphics/graphics.h>
 #include "render/material_ddf.h"
+#include "render/spatial_tree.h"
 
 namespace dmRender
 {
@@ -134,6 +135,9 @@ namespace dmRender
         dmGraphics::HVertexBuffer       m_VertexBuffer;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         dmGraphics::HIndexBuffer        m_IndexBuffer;
+        /// Optional per-instance vertex buffer, its declaration must use dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE
+        dmGraphics::HVertexBuffer       m_InstanceBuffer;
+        dmGraphics::HVertexDeclaration  m_InstanceDeclaration;
         HMaterial                       m_Material;
         dmGraphics::HTexture            m_Textures[MAX_TEXTURE_COUNT];
         dmGraphics::PrimitiveType       m_PrimitiveType;
@@ -143,6 +147,9 @@ namespace dmRender
         StencilTestParams               m_StencilTestParams;
         uint32_t                        m_VertexStart;
         uint32_t                        m_VertexCount;
+        /// Number of instances drawn in one instanced draw call, 0 for a regular draw call.
+        /// Check dmGraphics::IsInstancingSupported before using it.
+        uint32_t                        m_InstanceCount;
         uint8_t                         m_VertexConstantMask;
         uint8_t                         m_FragmentConstantMask;
         uint8_t                         m_SetBlendFactors : 1;
@@ -182,6 +189,15 @@ namespace dmRender
     struct RenderListEntry
     {
         Point3 m_WorldPosition;
+        union
+        {
+            /// Radius of a sphere around m_WorldPosition enclosing the entry. World entries outside the view frustum
+            /// are culled in DrawRenderList. Set to 0 (default from RenderListAlloc) to never cull the entry.
+            float m_BoundingRadius;
+            /// Proxy in the spatial tree of the render context (see GetSpatialTree) enclosing the entry.
+            /// Used for culling instead of m_BoundingRadius when m_HasSpatialProxy is set.
+            HSpatialProxy m_SpatialProxy;
+        };
         uint32_t m_Order;
         uint32_t m_BatchKey;
         uint32_t m_TagMask;
@@ -189,6 +205,7 @@ namespace dmRender
         uint32_t m_MinorOrder:4;
         uint32_t m_MajorOrder:2;
         uint32_t m_Dispatch:8;
+        uint32_t m_HasSpatialProxy:1;
     };
 
     enum RenderListOperation
@@ -230,6 +247,15 @@ namespace dmRender
 
     dmGraphics::HContext GetGraphicsContext(HRenderContext render_context);
 
+    /**
+     * Get the spatial tree of the render context. Components keep a proxy per instance in it, moved
+     * when the instance transform changes, and pass the proxy in RenderListEntry::m_SpatialProxy so
+     * that the world entries of a frame are culled with a single frustum query.
+     * @param render_context Render context
+     * @return Spatial tree
+     */
+    HSpatialTree GetSpatialTree(HRenderContext render_context);
+
     const Matrix4& GetViewProjectionMatrix(HRenderContext render_context);
     void SetViewMatrix(HRenderContext render_context, const Matrix4& view);
     void SetProjectionMatrix(HRenderContext render_context, const Matrix4& projection);
@@ -339,6 +365,19 @@ namespace dmRender
     bool                            GetMaterialProgramConstantElement(HMaterial material, dmhash_t name_hash, uint32_t element_index, float& out_value);
     void                            SetMaterialProgramConstant(HMaterial material, dmhash_t name_hash, Vectormath::Aos::Vector4 constant);
     int32_t                         GetMaterialConstantLocation(HMaterial material, dmhash_t name_hash);
+
+    /** Retrieve the location of a vertex attribute in the program of the material
+     * The location is looked up in the program once per attribute and cached until ClearMaterialAttributeLocations.
+     * @param material Material to get the attribute location from
+     * @param name_hash Hash of the attribute name
+     * @param name Attribute name
+     * @return Location of the attribute, -1 if the program doesn't use it
+     */
+    int32_t                         GetMaterialAttributeLocation(HMaterial material, dmhash_t name_hash, const char* name);
+    /** Forget the cached attribute locations, when the program of the material has been reloaded
+     * @param material Material to clear the attribute locations of
+     */
+    void                            ClearMaterialAttributeLocations(HMaterial material);
     void                            SetMaterialSampler(HMaterial material, dmhash_t name_hash, uint32_t unit, dmGraphics::TextureWrap u_wrap, dmGraphics::TextureWrap v_wrap, dmGraphics::TextureFilter min_filter, dmGraphics::TextureFilter mag_filter);
     HRenderContext                  GetMaterialRenderContext(HMaterial material);
     dmRenderDDF::MaterialDesc::VertexSpace GetMaterialVertexSpace(HMaterial material);
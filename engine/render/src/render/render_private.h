@@ -78,6 +78,8 @@ namespace dmRender
         dmGraphics::HVertexProgram              m_VertexProgram;
         dmGraphics::HFragmentProgram            m_FragmentProgram;
         dmHashTable64<int32_t>                  m_NameHashToLocation;
+        // Vertex attribute locations looked up so far, see GetMaterialAttributeLocation
+        dmHashTable64<int32_t>                  m_AttributeLocations;
         dmArray<MaterialConstant>               m_Constants;
         dmArray<Sampler>                        m_Samplers;
         uint32_t                                m_TagMask;
@@ -137,6 +139,7 @@ namespace dmRender
         float               m_Height;
         float               m_Leading;
         float               m_Tracking;
+        float               m_BoundingRadius;
         int32_t             m_Next;
         int32_t             m_Tail;
         uint32_t            m_Align : 2;
@@ -193,8 +196,6 @@ namespace dmRender
                 uint32_t m_MajorOrder:4;        // currently only 2 bits used (dmRender::RenderOrder)
                 uint32_t m_MinorOrder:4;
             };
-            // only temporarily used
-            float m_ZW;
             // final sort value
             uint64_t m_SortKey;
         };
@@ -220,11 +221,19 @@ namespace dmRender
 
         dmArray<RenderListEntry>    m_RenderList;
         dmArray<RenderListDispatch> m_RenderListDispatch;
-        dmArray<RenderListSortValue>m_RenderListSortValues;
+        dmArray<RenderListSortValue>m_RenderListSortValues;     // Persistent per entry, only the world order is updated per predicate
+        dmArray<float>              m_RenderListSortDepths;     // Per entry z/w, for world entries
+        dmArray<uint64_t>           m_RenderListSortKeys;       // Keys matching m_RenderListSortBuffer (or m_RenderListSortIndices) while sorting
+        dmArray<uint64_t>           m_RenderListSortScratchKeys;
+        dmArray<uint32_t>           m_RenderListSortScratch;
         dmArray<uint32_t>           m_RenderListSortBuffer;
         dmArray<uint32_t>           m_RenderListSortIndices;
         dmArray<RenderListRange>    m_RenderListRanges;         // Maps tagmask to a range in the (sorted) render list
 
+        HSpatialTree                m_SpatialTree;
+        dmArray<uint32_t>           m_SpatialProxyVisibility;   // Per proxy, id of the last frustum query that found it
+        uint32_t                    m_SpatialQueryId;
+
         HFontMap                    m_SystemFontMap;
 
         Matrix4                     m_View;
@@ -274,12 +283,29 @@ namespace dmRender
         }
     };
 
+    // Stable LSD radix sort of the indices, using the keys that are stored in parallel to the indices.
+    // The scratch buffers need room for 'count' items each. Passes where all keys share the same
+    // digit are skipped, which is usually the case for the dispatch and major/minor order bits.
+    void RadixSortRenderList(uint64_t* keys, uint32_t* indices, uint32_t count, uint64_t* scratch_keys, uint32_t* scratch_indices);
+
+    // Sorts the render list on the tag masks and finds the tag mask ranges, once per frame
+    void SortRenderList(HRenderContext context);
+
+    // Collects the entries of a predicate in m_RenderListSortBuffer and their sort keys in m_RenderListSortKeys
+    void MakeSortBuffer(HRenderContext context, uint32_t tag_mask);
+
     typedef void (*RangeCallback)(void* ctx, uint32_t val, size_t start, size_t count);
 
     // Invokes the callback for each range. Two ranges are not guaranteed to preceed/succeed one another.
     void FindRenderListRanges(uint32_t* first, size_t offset, size_t size, RenderListEntry* entries, FindRangeComparator& comp, void* ctx, RangeCallback callback );
 
     bool FindTagMaskRange(RenderListRange* ranges, uint32_t num_ranges, uint32_t tag_mask, RenderListRange& range);
+
+    // Extracts the six normalized planes of the frustum of the view projection, with normals pointing inwards
+    void GetFrustumPlanes(const Matrix4& view_proj, Vector4 planes[6]);
+
+    // True if the sphere is completely outside one of the planes
+    bool IsSphereOutsideFrustum(const Vector4 planes[6], const Point3& center, float radius);
 }
 
 #endif
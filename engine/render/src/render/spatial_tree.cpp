@@ -0,0 +1,590 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <dlib/math.h>
+#include <dlib/profile.h>
+
+#include "spatial_tree.h"
+#include "spatial_tree_private.h"
+#include "render_private.h"
+
+// Dynamic AABB tree, based on b2DynamicTree in Box2D (physics/src/box2d), extended to 3D
+
+namespace dmRender
+{
+    /// Number of frames of movement the bounds of a moving proxy are extended by
+    static const float SPATIAL_TREE_DISPLACEMENT_MULTIPLIER = 16.0f;
+    /// Stored bounds larger than the needed bounds extended by this many margins are shrunk
+    static const float SPATIAL_TREE_HUGE_MARGIN_MULTIPLIER = 4.0f;
+
+    /// Set on stack entries of the frustum query whose parent is completely inside the frustum
+    static const uint32_t STACK_INSIDE_BIT = 0x80000000;
+
+    // Half of the surface area of the box, the cost metric when inserting
+    static inline float GetArea(const Vector3& min, const Vector3& max)
+    {
+        const Vector3 d = max - min;
+        return d.getX() * d.getY() + d.getY() * d.getZ() + d.getZ() * d.getX();
+    }
+
+    static inline float GetCombinedArea(const SpatialTreeNode* a, const SpatialTreeNode* b)
+    {
+        return GetArea(minPerElem(a->m_Min, b->m_Min), maxPerElem(a->m_Max, b->m_Max));
+    }
+
+    static inline void Combine(SpatialTreeNode* node, const SpatialTreeNode* a, const SpatialTreeNode* b)
+    {
+        node->m_Min = minPerElem(a->m_Min, b->m_Min);
+        node->m_Max = maxPerElem(a->m_Max, b->m_Max);
+    }
+
+    static inline bool Contains(const SpatialTreeNode* node, const Vector3& min, const Vector3& max)
+    {
+        return node->m_Min.getX() <= min.getX() && node->m_Min.getY() <= min.getY() && node->m_Min.getZ() <= min.getZ() &&
+               node->m_Max.getX() >= max.getX() && node->m_Max.getY() >= max.getY() && node->m_Max.getZ() >= max.getZ();
+    }
+
+    static inline bool Overlaps(const SpatialTreeNode* node, const Vector3& min, const Vector3& max)
+    {
+        return node->m_Min.getX() <= max.getX() && node->m_Min.getY() <= max.getY() && node->m_Min.getZ() <= max.getZ() &&
+               node->m_Max.getX() >= min.getX() && node->m_Max.getY() >= min.getY() && node->m_Max.getZ() >= min.getZ();
+    }
+
+    static inline bool IsLeaf(const SpatialTreeNode* node)
+    {
+        return node->m_Child1 == SPATIAL_TREE_NULL_NODE;
+    }
+
+    static void BuildFreeList(SpatialTree* tree, uint32_t first)
+    {
+        uint32_t capacity = tree->m_Nodes.Size();
+        for (uint32_t i = first; i < capacity; ++i)
+        {
+            tree->m_Nodes[i].m_Parent = i + 1 < capacity ? i + 1 : SPATIAL_TREE_NULL_NODE;
+            tree->m_Nodes[i].m_Height = -1;
+        }
+        tree->m_FreeList = first;
+    }
+
+    // Node pointers are invalidated when the node array grows
+    static uint32_t AllocateNode(SpatialTree* tree)
+    {
+        if (tree->m_FreeList == SPATIAL_TREE_NULL_NODE)
+        {
+            uint32_t capacity = tree->m_Nodes.Size();
+            assert(tree->m_NodeCount == capacity);
+            uint32_t new_capacity = capacity * 2;
+            assert(new_capacity < STACK_INSIDE_BIT);
+            tree->m_Nodes.SetCapacity(new_capacity);
+            tree->m_Nodes.SetSize(new_capacity);
+            BuildFreeList(tree, capacity);
+        }
+
+        uint32_t index = tree->m_FreeList;
+        SpatialTreeNode* node = &tree->m_Nodes[index];
+        tree->m_FreeList = node->m_Parent;
+        node->m_Parent = SPATIAL_TREE_NULL_NODE;
+        node->m_Child1 = SPATIAL_TREE_NULL_NODE;
+        node->m_Child2 = SPATIAL_TREE_NULL_NODE;
+        node->m_Height = 0;
+        node->m_UserData = 0;
+        ++tree->m_NodeCount;
+        return index;
+    }
+
+    static void FreeNode(SpatialTree* tree, uint32_t index)
+    {
+        assert(tree->m_NodeCount > 0);
+        SpatialTreeNode* node = &tree->m_Nodes[index];
+        node->m_Parent = tree->m_FreeList;
+        node->m_Height = -1;
+        tree->m_FreeList = index;
+        --tree->m_NodeCount;
+    }
+
+    // Perform a left or right rotation if node a is imbalanced, returns the new root of the sub tree
+    static uint32_t Balance(SpatialTree* tree, uint32_t ia)
+    {
+        SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+        SpatialTreeNode* a = &nodes[ia];
+        if (IsLeaf(a) || a->m_Height < 2)
+        {
+            return ia;
+        }
+
+        uint32_t ib = a->m_Child1;
+        uint32_t ic = a->m_Child2;
+        SpatialTreeNode* b = &nodes[ib];
+        SpatialTreeNode* c = &nodes[ic];
+
+        int32_t balance = c->m_Height - b->m_Height;
+
+        // Rotate c up
+        if (balance > 1)
+        {
+            uint32_t i_f = c->m_Child1;
+            uint32_t ig = c->m_Child2;
+            SpatialTreeNode* f = &nodes[i_f];
+            SpatialTreeNode* g = &nodes[ig];
+
+            // Swap a and c
+            c->m_Child1 = ia;
+            c->m_Parent = a->m_Parent;
+            a->m_Parent = ic;
+
+            // The old parent of a should point to c
+            if (c->m_Parent != SPATIAL_TREE_NULL_NODE)
+            {
+                SpatialTreeNode* parent = &nodes[c->m_Parent];
+                if (parent->m_Child1 == ia)
+                    parent->m_Child1 = ic;
+                else
+                    parent->m_Child2 = ic;
+            }
+            else
+            {
+                tree->m_Root = ic;
+            }
+
+            if (f->m_Height > g->m_Height)
+            {
+                c->m_Child2 = i_f;
+                a->m_Child2 = ig;
+                g->m_Parent = ia;
+                Combine(a, b, g);
+                Combine(c, a, f);
+                a->m_Height = 1 + dmMath::Max(b->m_Height, g->m_Height);
+                c->m_Height = 1 + dmMath::Max(a->m_Height, f->m_Height);
+            }
+            else
+            {
+                c->m_Child2 = ig;
+                a->m_Child2 = i_f;
+                f->m_Parent = ia;
+                Combine(a, b, f);
+                Combine(c, a, g);
+                a->m_Height = 1 + dmMath::Max(b->m_Height, f->m_Height);
+                c->m_Height = 1 + dmMath::Max(a->m_Height, g->m_Height);
+            }
+            return ic;
+        }
+
+        // Rotate b up
+        if (balance < -1)
+        {
+            uint32_t id = b->m_Child1;
+            uint32_t ie = b->m_Child2;
+            SpatialTreeNode* d = &nodes[id];
+            SpatialTreeNode* e = &nodes[ie];
+
+            // Swap a and b
+            b->m_Child1 = ia;
+            b->m_Parent = a->m_Parent;
+            a->m_Parent = ib;
+
+            // The old parent of a should point to b
+            if (b->m_Parent != SPATIAL_TREE_NULL_NODE)
+            {
+                SpatialTreeNode* parent = &nodes[b->m_Parent];
+                if (parent->m_Child1 == ia)
+                    parent->m_Child1 = ib;
+                else
+                    parent->m_Child2 = ib;
+            }
+            else
+            {
+                tree->m_Root = ib;
+            }
+
+            if (d->m_Height > e->m_Height)
+            {
+                b->m_Child2 = id;
+                a->m_Child1 = ie;
+                e->m_Parent = ia;
+                Combine(a, c, e);
+                Combine(b, a, d);
+                a->m_Height = 1 + dmMath::Max(c->m_Height, e->m_Height);
+                b->m_Height = 1 + dmMath::Max(a->m_Height, d->m_Height);
+            }
+            else
+            {
+                b->m_Child2 = ie;
+                a->m_Child1 = id;
+                d->m_Parent = ia;
+                Combine(a, c, d);
+                Combine(b, a, e);
+                a->m_Height = 1 + dmMath::Max(c->m_Height, d->m_Height);
+                b->m_Height = 1 + dmMath::Max(a->m_Height, e->m_Height);
+            }
+            return ib;
+        }
+
+        return ia;
+    }
+
+    // Walk up from index, rebalancing and refitting the bounds and heights of the ancestors
+    static void Refit(SpatialTree* tree, uint32_t index)
+    {
+        while (index != SPATIAL_TREE_NULL_NODE)
+        {
+            index = Balance(tree, index);
+
+            SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+            SpatialTreeNode* node = &nodes[index];
+            const SpatialTreeNode* child1 = &nodes[node->m_Child1];
+            const SpatialTreeNode* child2 = &nodes[node->m_Child2];
+            Combine(node, child1, child2);
+            node->m_Height = 1 + dmMath::Max(child1->m_Height, child2->m_Height);
+
+            index = node->m_Parent;
+        }
+    }
+
+    static void InsertLeaf(SpatialTree* tree, uint32_t leaf)
+    {
+        if (tree->m_Root == SPATIAL_TREE_NULL_NODE)
+        {
+            tree->m_Root = leaf;
+            tree->m_Nodes[leaf].m_Parent = SPATIAL_TREE_NULL_NODE;
+            return;
+        }
+
+        // Find the best sibling for the leaf, descending while it is cheaper than creating a new parent
+        uint32_t index = tree->m_Root;
+        {
+            const SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+            const SpatialTreeNode* leaf_node = &nodes[leaf];
+            while (!IsLeaf(&nodes[index]))
+            {
+                const SpatialTreeNode* node = &nodes[index];
+                const SpatialTreeNode* child1 = &nodes[node->m_Child1];
+                const SpatialTreeNode* child2 = &nodes[node->m_Child2];
+
+                float area = GetArea(node->m_Min, node->m_Max);
+                float combined_area = GetCombinedArea(node, leaf_node);
+
+                // Cost of creating a new parent for this node and the new leaf
+                float cost = 2.0f * combined_area;
+                // Minimum cost of pushing the leaf further down the tree
+                float inheritance_cost = 2.0f * (combined_area - area);
+
+                // Cost of descending into each child
+                float cost1 = GetCombinedArea(leaf_node, child1) + inheritance_cost;
+                if (!IsLeaf(child1))
+                    cost1 -= GetArea(child1->m_Min, child1->m_Max);
+                float cost2 = GetCombinedArea(leaf_node, child2) + inheritance_cost;
+                if (!IsLeaf(child2))
+                    cost2 -= GetArea(child2->m_Min, child2->m_Max);
+
+                if (cost < cost1 && cost < cost2)
+                    break;
+
+                index = cost1 < cost2 ? node->m_Child1 : node->m_Child2;
+            }
+        }
+
+        uint32_t sibling = index;
+        uint32_t new_parent = AllocateNode(tree);
+
+        SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+        uint32_t old_parent = nodes[sibling].m_Parent;
+        SpatialTreeNode* parent = &nodes[new_parent];
+        parent->m_Parent = old_parent;
+        Combine(parent, &nodes[leaf], &nodes[sibling]);
+        parent->m_Height = nodes[sibling].m_Height + 1;
+        parent->m_Child1 = sibling;
+        parent->m_Child2 = leaf;
+        nodes[sibling].m_Parent = new_parent;
+        nodes[leaf].m_Parent = new_parent;
+
+        if (old_parent != SPATIAL_TREE_NULL_NODE)
+        {
+            if (nodes[old_parent].m_Child1 == sibling)
+                nodes[old_parent].m_Child1 = new_parent;
+            else
+                nodes[old_parent].m_Child2 = new_parent;
+        }
+        else
+        {
+            tree->m_Root = new_parent;
+        }
+
+        Refit(tree, new_parent);
+    }
+
+    static void RemoveLeaf(SpatialTree* tree, uint32_t leaf)
+    {
+        if (leaf == tree->m_Root)
+        {
+            tree->m_Root = SPATIAL_TREE_NULL_NODE;
+            return;
+        }
+
+        SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+        uint32_t parent = nodes[leaf].m_Parent;
+        uint32_t grand_parent = nodes[parent].m_Parent;
+        uint32_t sibling = nodes[parent].m_Child1 == leaf ? nodes[parent].m_Child2 : nodes[parent].m_Child1;
+
+        // Destroy the parent and connect the sibling to the grand parent
+        nodes[sibling].m_Parent = grand_parent;
+        FreeNode(tree, parent);
+        if (grand_parent != SPATIAL_TREE_NULL_NODE)
+        {
+            if (nodes[grand_parent].m_Child1 == parent)
+                nodes[grand_parent].m_Child1 = sibling;
+            else
+                nodes[grand_parent].m_Child2 = sibling;
+            Refit(tree, grand_parent);
+        }
+        else
+        {
+            tree->m_Root = sibling;
+        }
+    }
+
+    HSpatialTree NewSpatialTree(float margin)
+    {
+        const uint32_t initial_capacity = 16;
+        SpatialTree* tree = new SpatialTree;
+        tree->m_Nodes.SetCapacity(initial_capacity);
+        tree->m_Nodes.SetSize(initial_capacity);
+        BuildFreeList(tree, 0);
+        tree->m_Stack.SetCapacity(64);
+        tree->m_Root = SPATIAL_TREE_NULL_NODE;
+        tree->m_NodeCount = 0;
+        tree->m_ProxyCount = 0;
+        tree->m_Margin = margin;
+        return tree;
+    }
+
+    void DeleteSpatialTree(HSpatialTree tree)
+    {
+        delete tree;
+    }
+
+    HSpatialProxy CreateSpatialProxy(HSpatialTree tree, const Point3& min, const Point3& max, uintptr_t user_data)
+    {
+        uint32_t proxy = AllocateNode(tree);
+        SpatialTreeNode* node = &tree->m_Nodes[proxy];
+        const Vector3 margin(tree->m_Margin);
+        node->m_Min = Vector3(min) - margin;
+        node->m_Max = Vector3(max) + margin;
+        node->m_UserData = user_data;
+        InsertLeaf(tree, proxy);
+        ++tree->m_ProxyCount;
+        return proxy;
+    }
+
+    void DestroySpatialProxy(HSpatialTree tree, HSpatialProxy proxy)
+    {
+        assert(IsLeaf(&tree->m_Nodes[proxy]) && tree->m_Nodes[proxy].m_Height == 0);
+        RemoveLeaf(tree, proxy);
+        FreeNode(tree, proxy);
+        --tree->m_ProxyCount;
+    }
+
+    bool MoveSpatialProxy(HSpatialTree tree, HSpatialProxy proxy, const Point3& min, const Point3& max, const Vector3& displacement)
+    {
+        SpatialTreeNode* node = &tree->m_Nodes[proxy];
+        assert(IsLeaf(node) && node->m_Height == 0);
+
+        // Extend the bounds by the margin, and by the predicted movement in the direction of the displacement
+        const Vector3 margin(tree->m_Margin);
+        const Vector3 d = displacement * SPATIAL_TREE_DISPLACEMENT_MULTIPLIER;
+        const Vector3 zero(0.0f);
+        const Vector3 fat_min = Vector3(min) - margin + minPerElem(d, zero);
+        const Vector3 fat_max = Vector3(max) + margin + maxPerElem(d, zero);
+
+        if (Contains(node, Vector3(min), Vector3(max)))
+        {
+            // Keep the stored bounds unless they are much larger than needed, e.g. after the proxy stopped moving fast.
+            // The bounds left behind by a steady movement are allowed, up to the predicted movement.
+            const Vector3 huge_margin = Vector3(SPATIAL_TREE_HUGE_MARGIN_MULTIPLIER * tree->m_Margin) + absPerElem(d);
+            const Vector3 huge_min = fat_min - huge_margin;
+            const Vector3 huge_max = fat_max + huge_margin;
+            if (huge_min.getX() <= node->m_Min.getX() && huge_min.getY() <= node->m_Min.getY() && huge_min.getZ() <= node->m_Min.getZ() &&
+                huge_max.getX() >= node->m_Max.getX() && huge_max.getY() >= node->m_Max.getY() && huge_max.getZ() >= node->m_Max.getZ())
+            {
+                return false;
+            }
+        }
+
+        RemoveLeaf(tree, proxy);
+        node = &tree->m_Nodes[proxy];
+        node->m_Min = fat_min;
+        node->m_Max = fat_max;
+        InsertLeaf(tree, proxy);
+        return true;
+    }
+
+    uintptr_t GetSpatialProxyUserData(HSpatialTree tree, HSpatialProxy proxy)
+    {
+        return tree->m_Nodes[proxy].m_UserData;
+    }
+
+    uint32_t GetSpatialProxyCount(HSpatialTree tree)
+    {
+        return tree->m_ProxyCount;
+    }
+
+    uint32_t GetSpatialTreeHeight(HSpatialTree tree)
+    {
+        return tree->m_Root != SPATIAL_TREE_NULL_NODE ? (uint32_t)tree->m_Nodes[tree->m_Root].m_Height : 0;
+    }
+
+    static inline void Push(dmArray<uint32_t>& stack, uint32_t value)
+    {
+        if (stack.Full())
+            stack.OffsetCapacity(stack.Capacity());
+        stack.Push(value);
+    }
+
+    void QuerySpatialTree(HSpatialTree tree, const Point3& min, const Point3& max, SpatialQueryCallback callback, void* context)
+    {
+        DM_PROFILE(Render, "QuerySpatialTree");
+
+        if (tree->m_Root == SPATIAL_TREE_NULL_NODE)
+            return;
+
+        const Vector3 query_min(min);
+        const Vector3 query_max(max);
+        const SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+        dmArray<uint32_t>& stack = tree->m_Stack;
+        stack.SetSize(0);
+        stack.Push(tree->m_Root);
+        while (!stack.Empty())
+        {
+            uint32_t index = stack.Back();
+            stack.Pop();
+            const SpatialTreeNode* node = &nodes[index];
+            if (!Overlaps(node, query_min, query_max))
+                continue;
+
+            if (IsLeaf(node))
+            {
+                callback(context, index, node->m_UserData);
+            }
+            else
+            {
+                Push(stack, node->m_Child1);
+                Push(stack, node->m_Child2);
+            }
+        }
+    }
+
+    void QuerySpatialTreeFrustum(HSpatialTree tree, const Matrix4& view_proj, SpatialQueryCallback callback, void* context)
+    {
+        DM_PROFILE(Render, "QuerySpatialTreeFrustum");
+
+        if (tree->m_Root == SPATIAL_TREE_NULL_NODE)
+            return;
+
+        Vector4 planes[6];
+        GetFrustumPlanes(view_proj, planes);
+        Vector3 normals[6];
+        Vector3 abs_normals[6];
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            normals[i] = planes[i].getXYZ();
+            abs_normals[i] = absPerElem(normals[i]);
+        }
+
+        const SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+        dmArray<uint32_t>& stack = tree->m_Stack;
+        stack.SetSize(0);
+        stack.Push(tree->m_Root);
+        while (!stack.Empty())
+        {
+            uint32_t entry = stack.Back();
+            stack.Pop();
+            uint32_t index = entry & ~STACK_INSIDE_BIT;
+            const SpatialTreeNode* node = &nodes[index];
+
+            // The children of a node completely inside the frustum are reported without testing
+            uint32_t inside_bit = entry & STACK_INSIDE_BIT;
+            if (!inside_bit)
+            {
+                const Vector3 center = (node->m_Min + node->m_Max) * 0.5f;
+                const Vector3 extent = (node->m_Max - node->m_Min) * 0.5f;
+                bool outside = false;
+                bool inside = true;
+                for (uint32_t i = 0; i < 6; ++i)
+                {
+                    float distance = dot(normals[i], center) + planes[i].getW();
+                    float radius = dot(abs_normals[i], extent);
+                    if (distance < -radius)
+                    {
+                        outside = true;
+                        break;
+                    }
+                    inside &= distance >= radius;
+                }
+                if (outside)
+                    continue;
+                inside_bit = inside ? STACK_INSIDE_BIT : 0;
+            }
+
+            if (IsLeaf(node))
+            {
+                callback(context, index, node->m_UserData);
+            }
+            else
+            {
+                Push(stack, node->m_Child1 | inside_bit);
+                Push(stack, node->m_Child2 | inside_bit);
+            }
+        }
+    }
+
+    static bool ValidateNode(SpatialTree* tree, uint32_t index, uint32_t parent, uint32_t* leaf_count)
+    {
+        const SpatialTreeNode* nodes = tree->m_Nodes.Begin();
+        const SpatialTreeNode* node = &nodes[index];
+        if (node->m_Parent != parent || node->m_Height < 0)
+            return false;
+
+        if (IsLeaf(node))
+        {
+            ++*leaf_count;
+            return node->m_Child2 == SPATIAL_TREE_NULL_NODE && node->m_Height == 0;
+        }
+
+        const SpatialTreeNode* child1 = &nodes[node->m_Child1];
+        const SpatialTreeNode* child2 = &nodes[node->m_Child2];
+        if (node->m_Height != 1 + dmMath::Max(child1->m_Height, child2->m_Height))
+            return false;
+        if (!Contains(node, child1->m_Min, child1->m_Max) || !Contains(node, child2->m_Min, child2->m_Max))
+            return false;
+        return ValidateNode(tree, node->m_Child1, index, leaf_count) && ValidateNode(tree, node->m_Child2, index, leaf_count);
+    }
+
+    bool ValidateSpatialTree(HSpatialTree tree)
+    {
+        uint32_t leaf_count = 0;
+        if (tree->m_Root != SPATIAL_TREE_NULL_NODE)
+        {
+            if (!ValidateNode(tree, tree->m_Root, SPATIAL_TREE_NULL_NODE, &leaf_count))
+                return false;
+        }
+        if (leaf_count != tree->m_ProxyCount)
+            return false;
+
+        // Every node is either in the tree or in the free list
+        uint32_t free_count = 0;
+        for (uint32_t index = tree->m_FreeList; index != SPATIAL_TREE_NULL_NODE; index = tree->m_Nodes[index].m_Parent)
+        {
+            ++free_count;
+        }
+        return free_count + tree->m_NodeCount == tree->m_Nodes.Size() && tree->m_NodeCount == (leaf_count > 0 ? 2 * leaf_count - 1 : 0);
+    }
+}
@@ -0,0 +1,130 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_RENDER_SPATIAL_TREE_H
+#define DM_RENDER_SPATIAL_TREE_H
+
+#include <stdint.h>
+#include <dmsdk/vectormath/cpp/vectormath_aos.h>
+
+namespace dmRender
+{
+    using namespace Vectormath::Aos;
+
+    /**
+     * Spatial tree handle. A dynamic AABB tree of render proxies, used to find the proxies
+     * overlapping a view frustum or a box without testing every proxy.
+     */
+    typedef struct SpatialTree* HSpatialTree;
+
+    /**
+     * Spatial proxy handle, stable for the life time of the proxy
+     */
+    typedef uint32_t HSpatialProxy;
+
+    const HSpatialProxy INVALID_SPATIAL_PROXY = 0xffffffff;
+
+    /**
+     * Called for each proxy found by a query
+     * @param context User context passed to the query
+     * @param proxy Proxy handle
+     * @param user_data User data of the proxy
+     */
+    typedef void (*SpatialQueryCallback)(void* context, HSpatialProxy proxy, uintptr_t user_data);
+
+    /**
+     * Create a new spatial tree
+     * @param margin Distance the proxy bounds are extended by when stored in the tree. A proxy that moves within
+     *               its extended bounds is not reinserted, larger values make moves cheaper and queries less exact.
+     * @return Spatial tree handle
+     */
+    HSpatialTree NewSpatialTree(float margin);
+
+    /**
+     * Delete a spatial tree
+     * @param tree Spatial tree handle
+     */
+    void DeleteSpatialTree(HSpatialTree tree);
+
+    /**
+     * Insert a proxy into the tree
+     * @param tree Spatial tree handle
+     * @param min Min corner of the proxy bounds
+     * @param max Max corner of the proxy bounds
+     * @param user_data User data passed to query callbacks
+     * @return Proxy handle
+     */
+    HSpatialProxy CreateSpatialProxy(HSpatialTree tree, const Point3& min, const Point3& max, uintptr_t user_data);
+
+    /**
+     * Remove a proxy from the tree
+     * @param tree Spatial tree handle
+     * @param proxy Proxy handle
+     */
+    void DestroySpatialProxy(HSpatialTree tree, HSpatialProxy proxy);
+
+    /**
+     * Update the bounds of a proxy. The proxy is only reinserted when the new bounds are outside of the extended bounds stored in the tree,
+     * or when the stored bounds have become much larger than needed. When reinserted, the bounds are also extended in the direction of
+     * the displacement, so that a proxy moving at a steady speed is only reinserted every few frames.
+     * @param tree Spatial tree handle
+     * @param proxy Proxy handle
+     * @param min Min corner of the proxy bounds
+     * @param max Max corner of the proxy bounds
+     * @param displacement Movement of the proxy since the last update
+     * @return True if the proxy was reinserted
+     */
+    bool MoveSpatialProxy(HSpatialTree tree, HSpatialProxy proxy, const Point3& min, const Point3& max, const Vector3& displacement);
+
+    /**
+     * Get the user data of a proxy
+     * @param tree Spatial tree handle
+     * @param proxy Proxy handle
+     * @return User data
+     */
+    uintptr_t GetSpatialProxyUserData(HSpatialTree tree, HSpatialProxy proxy);
+
+    /**
+     * Get the number of proxies in the tree
+     * @param tree Spatial tree handle
+     * @return Number of proxies
+     */
+    uint32_t GetSpatialProxyCount(HSpatialTree tree);
+
+    /**
+     * Get the height of the tree, 0 for an empty tree or a single proxy
+     * @param tree Spatial tree handle
+     * @return Height
+     */
+    uint32_t GetSpatialTreeHeight(HSpatialTree tree);
+
+    /**
+     * Find the proxies whose extended bounds overlap a box. For a 2D rect query, use a z range covering the scene.
+     * @param tree Spatial tree handle
+     * @param min Min corner of the box
+     * @param max Max corner of the box
+     * @param callback Called for each proxy found
+     * @param context User context passed to the callback
+     */
+    void QuerySpatialTree(HSpatialTree tree, const Point3& min, const Point3& max, SpatialQueryCallback callback, void* context);
+
+    /**
+     * Find the proxies whose extended bounds are not completely outside the frustum of a view projection
+     * @param tree Spatial tree handle
+     * @param view_proj View projection matrix
+     * @param callback Called for each proxy found
+     * @param context User context passed to the callback
+     */
+    void QuerySpatialTreeFrustum(HSpatialTree tree, const Matrix4& view_proj, SpatialQueryCallback callback, void* context);
+}
+
+#endif // DM_RENDER_SPATIAL_TREE_H
@@ -0,0 +1,57 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_RENDER_SPATIAL_TREE_PRIVATE_H
+#define DM_RENDER_SPATIAL_TREE_PRIVATE_H
+
+#include <dlib/array.h>
+
+#include "spatial_tree.h"
+
+namespace dmRender
+{
+    static const uint32_t SPATIAL_TREE_NULL_NODE = 0xffffffff;
+
+    /**
+     * Node of the spatial tree. Leaves are proxies, internal nodes always have two children.
+     */
+    struct SpatialTreeNode
+    {
+        /// Extended bounds for leaves, union of the children bounds for internal nodes
+        Vector3     m_Min;
+        Vector3     m_Max;
+        uintptr_t   m_UserData;
+        /// Parent node, or the next free node when the node is in the free list
+        uint32_t    m_Parent;
+        uint32_t    m_Child1;
+        uint32_t    m_Child2;
+        /// 0 for leaves, -1 for free nodes
+        int32_t     m_Height;
+    };
+
+    struct SpatialTree
+    {
+        dmArray<SpatialTreeNode>    m_Nodes;
+        /// Traversal stack of the queries, reused between queries
+        dmArray<uint32_t>           m_Stack;
+        uint32_t                    m_Root;
+        uint32_t                    m_FreeList;
+        uint32_t                    m_NodeCount;
+        uint32_t                    m_ProxyCount;
+        float                       m_Margin;
+    };
+
+    /// Checks the structure, heights and bounds of the tree, returns false if it is inconsistent
+    bool ValidateSpatialTree(HSpatialTree tree);
+}
+
+#endif // DM_RENDER_SPATIAL_TREE_PRIVATE_H
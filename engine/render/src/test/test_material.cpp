@@ -15,6 +15,7 @@
 #include <jc_test/jc_test.h>
 
 #include <dlib/hash.h>
+#include <dlib/dstrings.h>
 #include <dlib/math.h>
 #include <script/script.h>
 
@@ -110,6 +111,46 @@ TEST(dmMaterialTest, TestMaterialConstants)
     dmScript::DeleteContext(params.m_ScriptContext);
 }
 
+TEST(dmMaterialTest, TestMaterialAttributeLocations)
+{
+    dmGraphics::Initialize();
+    dmGraphics::HContext context = dmGraphics::NewContext(dmGraphics::ContextParams());
+    dmRender::RenderContextParams params;
+    params.m_ScriptContext = dmScript::NewContext(0, 0, true);
+    dmRender::HRenderContext render_context = dmRender::NewRenderContext(context, params);
+
+    const char* vp_source = "attribute vec4 position;\nattribute vec2 texcoord0;\n";
+    dmGraphics::ShaderDesc::Shader vp_shader = MakeDDFShader(vp_source, (uint32_t) strlen(vp_source));
+    dmGraphics::HVertexProgram vp = dmGraphics::NewVertexProgram(context, &vp_shader);
+    dmGraphics::ShaderDesc::Shader fp_shader = MakeDDFShader("foo", 3);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(context, &fp_shader);
+    dmRender::HMaterial material = dmRender::NewMaterial(render_context, vp, fp);
+
+    // Looked up in the program the first time, then from the cache
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        ASSERT_EQ(0, dmRender::GetMaterialAttributeLocation(material, dmHashString64("position"), "position"));
+        ASSERT_EQ(1, dmRender::GetMaterialAttributeLocation(material, dmHashString64("texcoord0"), "texcoord0"));
+        ASSERT_EQ(-1, dmRender::GetMaterialAttributeLocation(material, dmHashString64("corner"), "corner"));
+    }
+    // More attributes than the initial capacity of the cache
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        char name[16];
+        dmSnPrintf(name, sizeof(name), "attr%u", i);
+        ASSERT_EQ(-1, dmRender::GetMaterialAttributeLocation(material, dmHashString64(name), name));
+    }
+    dmRender::ClearMaterialAttributeLocations(material);
+    ASSERT_EQ(1, dmRender::GetMaterialAttributeLocation(material, dmHashString64("texcoord0"), "texcoord0"));
+
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+    dmRender::DeleteMaterial(render_context, material);
+    dmRender::DeleteRenderContext(render_context, 0);
+    dmGraphics::DeleteContext(context);
+    dmScript::DeleteContext(params.m_ScriptContext);
+}
+
 TEST(dmMaterialTest, TestMaterialConstantsOverride)
 {
     dmGraphics::Initialize();
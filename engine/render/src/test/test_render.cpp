@@ -11,12 +11,15 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdio.h>
+#include <float.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
 #include <dlib/hash.h>
 #include <dlib/math.h>
+#include <dlib/time.h>
 
 #include <script/script.h>
 #include <algorithm> // std::stable_sort
@@ -25,6 +28,8 @@
 #include "render/render_private.h"
 #include "render/font_renderer_private.h"
 
+#include "../../../graphics/src/graphics_private.h"
+
 const static uint32_t WIDTH = 600;
 const static uint32_t HEIGHT = 400;
 
@@ -172,6 +177,82 @@ TEST_F(dmRenderTest, TestRenderObjects)
     ASSERT_EQ(dmRender::RESULT_OK, AddToRender(m_Context, &ro));
 }
 
+TEST_F(dmRenderTest, TestDrawInstanced)
+{
+    const char* shader_src = "foo";
+    dmGraphics::ShaderDesc::Shader shader;
+    memset(&shader, 0, sizeof(shader));
+    shader.m_Source.m_Data  = (uint8_t*)shader_src;
+    shader.m_Source.m_Count = strlen(shader_src);
+    dmGraphics::HVertexProgram vp = dmGraphics::NewVertexProgram(m_GraphicsContext, &shader);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(m_GraphicsContext, &shader);
+    dmRender::HMaterial material = dmRender::NewMaterial(m_Context, vp, fp);
+
+    float v[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    uint16_t i[] = { 0, 1, 2 };
+    const uint32_t instance_count = 1000;
+    Matrix4* instance_data = new Matrix4[instance_count];
+    for (uint32_t n = 0; n < instance_count; ++n)
+        instance_data[n] = Matrix4::translation(Vector3((float)n, 0.0f, 0.0f));
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 3, dmGraphics::TYPE_FLOAT, false},
+    };
+    dmGraphics::VertexElement instance_ve[] =
+    {
+        {"mtx_world0", 0, 4, dmGraphics::TYPE_FLOAT, false},
+        {"mtx_world1", 1, 4, dmGraphics::TYPE_FLOAT, false},
+        {"mtx_world2", 2, 4, dmGraphics::TYPE_FLOAT, false},
+        {"mtx_world3", 3, 4, dmGraphics::TYPE_FLOAT, false},
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_GraphicsContext, ve, 1);
+    dmGraphics::HVertexDeclaration instance_vd = dmGraphics::NewVertexDeclaration(m_GraphicsContext, instance_ve, 4);
+    dmGraphics::SetVertexDeclarationStepFunction(instance_vd, dmGraphics::VERTEX_STEP_FUNCTION_INSTANCE);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_GraphicsContext, sizeof(v), v, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+    dmGraphics::HVertexBuffer instance_vb = dmGraphics::NewVertexBuffer(m_GraphicsContext, instance_count * sizeof(Matrix4), instance_data, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_GraphicsContext, sizeof(i), i, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+
+    dmRender::RenderObject ros[2];
+    for (uint32_t n = 0; n < 2; ++n)
+    {
+        dmRender::RenderObject& ro = ros[n];
+        ro.m_Material = material;
+        ro.m_VertexDeclaration = vd;
+        ro.m_VertexBuffer = vb;
+        ro.m_IndexBuffer = ib;
+        ro.m_IndexType = dmGraphics::TYPE_UNSIGNED_SHORT;
+        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+        ro.m_VertexCount = 3;
+    }
+    // One instanced draw call for all the instances, one regular draw call
+    ros[0].m_InstanceBuffer = instance_vb;
+    ros[0].m_InstanceDeclaration = instance_vd;
+    ros[0].m_InstanceCount = instance_count;
+
+    ASSERT_TRUE(dmGraphics::IsInstancingSupported(m_GraphicsContext));
+
+    dmGraphics::Flip(m_GraphicsContext);
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::AddToRender(m_Context, &ros[0]));
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::AddToRender(m_Context, &ros[1]));
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::Draw(m_Context, 0x0, 0));
+
+    ASSERT_EQ(2u, dmGraphics::GetDrawCount());
+    ASSERT_EQ(1u, dmGraphics::GetInstancedDrawCount());
+    ASSERT_EQ(instance_count, dmGraphics::GetDrawInstanceCount());
+
+    dmRender::ClearRenderObjects(m_Context);
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(instance_vb);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(instance_vd);
+    dmGraphics::DeleteVertexDeclaration(vd);
+    delete [] instance_data;
+    dmRender::DeleteMaterial(m_Context, material);
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+}
+
 TEST_F(dmRenderTest, TestSquare2d)
 {
     Square2d(m_Context, 10.0f, 20.0f, 30.0f, 40.0f, Vector4(0.1f, 0.2f, 0.3f, 0.4f));
@@ -464,6 +545,145 @@ TEST_F(dmRenderTest, TestRenderListDebug)
     dmRender::DrawDebug3d(m_Context);
 }
 
+static void TestRenderListCullingDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    uint32_t* drawn = (uint32_t*) params.m_UserData;
+    if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
+    {
+        for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+        {
+            *drawn |= 1 << params.m_Buf[*i].m_UserData;
+        }
+    }
+}
+
+TEST_F(dmRenderTest, TestRenderListCulling)
+{
+    Vectormath::Aos::Matrix4 view = Vectormath::Aos::Matrix4::identity();
+    Vectormath::Aos::Matrix4 proj = Vectormath::Aos::Matrix4::orthographic(0.0f, WIDTH, HEIGHT, 0.0f, 0.1f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, view);
+    dmRender::SetProjectionMatrix(m_Context, proj);
+
+    struct
+    {
+        Point3              m_Position;
+        float               m_Radius;
+        dmRender::RenderOrder m_MajorOrder;
+        bool                m_Drawn;
+    } entries[] = {
+        { Point3(WIDTH * 0.5f, HEIGHT * 0.5f, -0.5f), 10.0f, dmRender::RENDER_ORDER_WORLD, true },
+        { Point3(-100.0f, HEIGHT * 0.5f, -0.5f), 10.0f, dmRender::RENDER_ORDER_WORLD, false },     // left
+        { Point3(WIDTH + 100.0f, HEIGHT * 0.5f, -0.5f), 10.0f, dmRender::RENDER_ORDER_WORLD, false }, // right
+        { Point3(WIDTH * 0.5f, -100.0f, -0.5f), 10.0f, dmRender::RENDER_ORDER_WORLD, false },     // bottom
+        { Point3(WIDTH * 0.5f, HEIGHT + 100.0f, -0.5f), 10.0f, dmRender::RENDER_ORDER_WORLD, false }, // top
+        { Point3(WIDTH * 0.5f, HEIGHT * 0.5f, 10.0f), 1.0f, dmRender::RENDER_ORDER_WORLD, false },    // near
+        { Point3(WIDTH * 0.5f, HEIGHT * 0.5f, -10.0f), 1.0f, dmRender::RENDER_ORDER_WORLD, false },   // far
+        { Point3(-5.0f, HEIGHT * 0.5f, -0.5f), 10.0f, dmRender::RENDER_ORDER_WORLD, true },       // intersecting
+        { Point3(-100.0f, HEIGHT * 0.5f, -0.5f), 0.0f, dmRender::RENDER_ORDER_WORLD, true },      // unbounded
+        { Point3(-100.0f, HEIGHT * 0.5f, -0.5f), 10.0f, dmRender::RENDER_ORDER_AFTER_WORLD, true }, // not a world entry
+    };
+    const uint32_t n = sizeof(entries) / sizeof(entries[0]);
+
+    uint32_t drawn = 0;
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestRenderListCullingDispatch, &drawn);
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(0.0f, out[i].m_BoundingRadius);
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = entries[i].m_Position;
+        entry.m_BoundingRadius = entries[i].m_Radius;
+        entry.m_MajorOrder = entries[i].m_MajorOrder;
+        entry.m_MinorOrder = 0;
+        entry.m_TagMask = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = 0;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = i;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+    dmRender::RenderListEnd(m_Context);
+    dmRender::DrawRenderList(m_Context, 0, 0);
+
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(entries[i].m_Drawn, (drawn & (1 << i)) != 0);
+    }
+}
+
+TEST_F(dmRenderTest, TestRenderListCullingSpatialProxy)
+{
+    Vectormath::Aos::Matrix4 view = Vectormath::Aos::Matrix4::identity();
+    Vectormath::Aos::Matrix4 proj = Vectormath::Aos::Matrix4::orthographic(0.0f, WIDTH, HEIGHT, 0.0f, 0.1f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, view);
+    dmRender::SetProjectionMatrix(m_Context, proj);
+
+    dmRender::HSpatialTree tree = dmRender::GetSpatialTree(m_Context);
+    ASSERT_NE((dmRender::HSpatialTree) 0, tree);
+
+    const Vector3 extent(10.0f, 10.0f, 0.1f);
+    Point3 positions[] = {
+        Point3(WIDTH * 0.5f, HEIGHT * 0.5f, -0.5f),
+        Point3(-100.0f, HEIGHT * 0.5f, -0.5f),              // left
+        Point3(WIDTH * 0.5f, HEIGHT + 100.0f, -0.5f),       // top
+    };
+    const uint32_t n = sizeof(positions) / sizeof(positions[0]);
+    dmRender::HSpatialProxy proxies[n];
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        proxies[i] = dmRender::CreateSpatialProxy(tree, positions[i] - extent, positions[i] + extent, i);
+    }
+
+    for (uint32_t frame = 0; frame < 2; ++frame)
+    {
+        uint32_t drawn = 0;
+        dmRender::RenderListBegin(m_Context);
+        uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestRenderListCullingDispatch, &drawn);
+        dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ(0u, out[i].m_HasSpatialProxy);
+            dmRender::RenderListEntry& entry = out[i];
+            entry.m_WorldPosition = positions[i];
+            entry.m_SpatialProxy = proxies[i];
+            entry.m_HasSpatialProxy = 1;
+            entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+            entry.m_MinorOrder = 0;
+            entry.m_TagMask = 0;
+            entry.m_Order = 0;
+            entry.m_BatchKey = 0;
+            entry.m_Dispatch = dispatch;
+            entry.m_UserData = i;
+        }
+        dmRender::RenderListSubmit(m_Context, out, out + n);
+        dmRender::RenderListEnd(m_Context);
+        dmRender::DrawRenderList(m_Context, 0, 0);
+
+        if (frame == 0)
+        {
+            ASSERT_EQ(1u, drawn);
+
+            // Move the first proxy out of view and the second into view
+            Point3 center(WIDTH * 0.5f, HEIGHT * 0.5f, -0.5f);
+            Vector3 displacement = positions[1] - positions[0];
+            positions[0] = positions[1];
+            dmRender::MoveSpatialProxy(tree, proxies[0], positions[0] - extent, positions[0] + extent, displacement);
+            positions[1] = center;
+            dmRender::MoveSpatialProxy(tree, proxies[1], positions[1] - extent, positions[1] + extent, -displacement);
+        }
+        else
+        {
+            ASSERT_EQ(2u, drawn);
+        }
+    }
+
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::DestroySpatialProxy(tree, proxies[i]);
+    }
+}
+
 static float Metric(const char* text, int n)
 {
     return n * 4;
@@ -765,6 +985,301 @@ TEST_F(dmRenderTest, FindRanges)
     ASSERT_EQ(6, range.m_Count);
 }
 
+struct RenderListSortValueSorter
+{
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+        return m_Values[a].m_SortKey < m_Values[b].m_SortKey;
+    }
+    const dmRender::RenderListSortValue* m_Values;
+};
+
+static void MakeRandomSortValues(dmArray<dmRender::RenderListSortValue>& values, uint32_t count)
+{
+    values.SetCapacity(count);
+    values.SetSize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmRender::RenderListSortValue& value = values[i];
+        value.m_SortKey = 0;
+        value.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        value.m_MinorOrder = rand() % 2;
+        value.m_Order = rand() & 0xffffff;
+        value.m_BatchKey = rand() % 8;
+        value.m_Dispatch = rand() % 3;
+    }
+}
+
+// Sorts the indices of the values with the radix sort, and with std::stable_sort into 'expected'. Returns the time of each sort.
+static void SortValues(dmArray<dmRender::RenderListSortValue>& values, dmArray<uint32_t>& indices, dmArray<uint64_t>& keys, dmArray<uint32_t>& expected,
+                       uint64_t* time_stable_sort, uint64_t* time_radix_sort)
+{
+    const uint32_t count = values.Size();
+    expected.SetCapacity(count);
+    expected.SetSize(count);
+    indices.SetCapacity(count);
+    indices.SetSize(count);
+    keys.SetCapacity(count);
+    keys.SetSize(count);
+    dmArray<uint64_t> scratch_keys;
+    dmArray<uint32_t> scratch_indices;
+    scratch_keys.SetCapacity(count);
+    scratch_keys.SetSize(count);
+    scratch_indices.SetCapacity(count);
+    scratch_indices.SetSize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        expected[i] = i;
+        indices[i] = i;
+        keys[i] = values[i].m_SortKey;
+    }
+
+    uint64_t time_start = dmTime::GetTime();
+    RenderListSortValueSorter sort;
+    sort.m_Values = values.Begin();
+    std::stable_sort(expected.Begin(), expected.End(), sort);
+    *time_stable_sort = dmTime::GetTime() - time_start;
+
+    time_start = dmTime::GetTime();
+    dmRender::RadixSortRenderList(keys.Begin(), indices.Begin(), count, scratch_keys.Begin(), scratch_indices.Begin());
+    *time_radix_sort = dmTime::GetTime() - time_start;
+}
+
+// The radix sort of the packed keys gives the same order as the previous std::stable_sort of the indices
+TEST(dmRenderSort, RadixSort)
+{
+    const uint32_t sizes[] = { 0, 1, 2, 1000 };
+    for (uint32_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+    {
+        const uint32_t count = sizes[s];
+        dmArray<dmRender::RenderListSortValue> values;
+        MakeRandomSortValues(values, count);
+
+        dmArray<uint32_t> indices;
+        dmArray<uint64_t> keys;
+        dmArray<uint32_t> expected;
+        uint64_t time_stable_sort, time_radix_sort;
+        SortValues(values, indices, keys, expected, &time_stable_sort, &time_radix_sort);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(expected[i], indices[i]);
+            ASSERT_EQ(values[indices[i]].m_SortKey, keys[i]);
+        }
+    }
+}
+
+// Compares the previous std::stable_sort of the indices with the radix sort of the packed keys
+TEST(dmRenderSort, RadixSortPerformance)
+{
+    const uint32_t sizes[] = { 1000, 10000, 100000 };
+    for (uint32_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+    {
+        const uint32_t count = sizes[s];
+        dmArray<dmRender::RenderListSortValue> values;
+        MakeRandomSortValues(values, count);
+
+        dmArray<uint32_t> indices;
+        dmArray<uint64_t> keys;
+        dmArray<uint32_t> expected;
+        uint64_t time_stable_sort, time_radix_sort;
+        SortValues(values, indices, keys, expected, &time_stable_sort, &time_radix_sort);
+
+        printf("Sorting %u entries: std::stable_sort %.3f ms, radix sort %.3f ms\n", count, time_stable_sort / 1000.0f, time_radix_sort / 1000.0f);
+    }
+}
+
+static void CollectSortRange(void* _ctx, uint32_t tag_mask, size_t start, size_t count)
+{
+    dmArray<dmRender::RenderListRange>* ranges = (dmArray<dmRender::RenderListRange>*)_ctx;
+    if (ranges->Full())
+        ranges->OffsetCapacity(16);
+    dmRender::RenderListRange range;
+    range.m_TagMask = tag_mask;
+    range.m_Start = start;
+    range.m_Count = count;
+    ranges->Push(range);
+}
+
+// The sort of a frame with one predicate before the radix sort: the tag mask sort, the full sort values
+// built for each predicate and std::stable_sort of the indices
+static void SortRenderListStableSort(dmRender::HRenderContext context, uint32_t tag_mask, dmArray<uint32_t>& sort_buffer)
+{
+    dmArray<dmRender::RenderListEntry>& render_list = context->m_RenderList;
+    dmRender::RenderListEntry* entries = render_list.Begin();
+    const uint32_t count = render_list.Size();
+
+    dmArray<uint32_t> indices;
+    indices.SetCapacity(count);
+    indices.SetSize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        indices[i] = i;
+
+    dmRender::RenderListEntrySorter entry_sort;
+    entry_sort.m_Base = entries;
+    std::stable_sort(indices.Begin(), indices.End(), entry_sort);
+
+    dmArray<dmRender::RenderListRange> ranges;
+    dmRender::FindRangeComparator comp;
+    comp.m_Entries = entries;
+    dmRender::FindRenderListRanges(indices.Begin(), 0, count, entries, comp, &ranges, CollectSortRange);
+
+    dmArray<dmRender::RenderListSortValue> sort_values;
+    dmArray<float> sort_depths;
+    sort_values.SetCapacity(count);
+    sort_values.SetSize(count);
+    sort_depths.SetCapacity(count);
+    sort_depths.SetSize(count);
+    sort_buffer.SetCapacity(count);
+    sort_buffer.SetSize(0);
+
+    const Matrix4& transform = context->m_ViewProj;
+    float minZW = FLT_MAX;
+    float maxZW = -FLT_MAX;
+    for (uint32_t r = 0; r < ranges.Size(); ++r)
+    {
+        const dmRender::RenderListRange& range = ranges[r];
+        if ((range.m_TagMask & tag_mask) != tag_mask)
+            continue;
+        for (uint32_t i = range.m_Start; i < range.m_Start + range.m_Count; ++i)
+        {
+            uint32_t idx = indices[i];
+            const dmRender::RenderListEntry* entry = &entries[idx];
+            if (entry->m_MajorOrder != dmRender::RENDER_ORDER_WORLD)
+                continue;
+            const Vector4 res = transform * entry->m_WorldPosition;
+            const float zw = res.getZ() / res.getW();
+            sort_depths[idx] = zw;
+            if (zw < minZW) minZW = zw;
+            if (zw > maxZW) maxZW = zw;
+        }
+    }
+
+    float rc = 0;
+    if (maxZW > minZW)
+        rc = 1.0f / (maxZW - minZW);
+
+    for (uint32_t r = 0; r < ranges.Size(); ++r)
+    {
+        const dmRender::RenderListRange& range = ranges[r];
+        if ((range.m_TagMask & tag_mask) != tag_mask)
+            continue;
+        for (uint32_t i = range.m_Start; i < range.m_Start + range.m_Count; ++i)
+        {
+            uint32_t idx = indices[i];
+            const dmRender::RenderListEntry* entry = &entries[idx];
+            dmRender::RenderListSortValue& value = sort_values[idx];
+            value.m_MajorOrder = entry->m_MajorOrder;
+            if (entry->m_MajorOrder == dmRender::RENDER_ORDER_WORLD)
+                value.m_Order = (uint32_t) (0xfffff8 - 0xfffff0 * rc * (sort_depths[idx] - minZW));
+            else
+                value.m_Order = entry->m_Order;
+            value.m_MinorOrder = entry->m_MinorOrder;
+            value.m_BatchKey = entry->m_BatchKey & 0x00ffffff;
+            value.m_Dispatch = entry->m_Dispatch;
+            sort_buffer.Push(idx);
+        }
+    }
+
+    RenderListSortValueSorter sort;
+    sort.m_Values = sort_values.Begin();
+    std::stable_sort(sort_buffer.Begin(), sort_buffer.End(), sort);
+}
+
+static void NoOpDispatch(const dmRender::RenderListDispatchParams& params)
+{
+}
+
+// Submits 'count' random entries, 1/8 of them after the world
+static void SubmitRandomRenderList(dmRender::HRenderContext context, uint32_t count)
+{
+    dmRender::RenderListBegin(context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(context, NoOpDispatch, 0);
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(context, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = Point3(0.0f, 0.0f, (rand() % 1000) / 1000.0f - 0.5f);
+        entry.m_MajorOrder = (i % 8) == 0 ? dmRender::RENDER_ORDER_AFTER_WORLD : dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = rand() % 2;
+        entry.m_TagMask = 1 << (rand() % 3);
+        entry.m_Order = rand() & 0xffffff;
+        entry.m_BatchKey = rand() % 8;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = i;
+    }
+    dmRender::RenderListSubmit(context, out, out + count);
+    dmRender::RenderListEnd(context);
+}
+
+// The sort of DrawRenderList: SortRenderList, MakeSortBuffer and the radix sort, into the sort buffer of the context
+static dmArray<uint32_t>& SortRenderListRadixSort(dmRender::HRenderContext context, uint32_t tag_mask)
+{
+    dmRender::SortRenderList(context);
+    dmRender::MakeSortBuffer(context, tag_mask);
+    dmArray<uint32_t>& sort_buffer = context->m_RenderListSortBuffer;
+    dmRender::RadixSortRenderList(context->m_RenderListSortKeys.Begin(), sort_buffer.Begin(), sort_buffer.Size(),
+                                  context->m_RenderListSortScratchKeys.Begin(), context->m_RenderListSortScratch.Begin());
+    return sort_buffer;
+}
+
+// The sorted draw order of a frame is the same as with the previous std::stable_sort
+TEST_F(dmRenderTest, SortRenderList)
+{
+    dmRender::SetViewMatrix(m_Context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, Matrix4::orthographic(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f));
+
+    const uint32_t tag_masks[] = { 0, 1, 2 };
+    for (uint32_t t = 0; t < sizeof(tag_masks)/sizeof(tag_masks[0]); ++t)
+    {
+        const uint32_t count = 4000;
+        SubmitRandomRenderList(m_Context, count);
+
+        dmArray<uint32_t> expected;
+        SortRenderListStableSort(m_Context, tag_masks[t], expected);
+        dmArray<uint32_t>& sort_buffer = SortRenderListRadixSort(m_Context, tag_masks[t]);
+
+        ASSERT_LT(0U, sort_buffer.Size());
+        ASSERT_EQ(expected.Size(), sort_buffer.Size());
+        for (uint32_t i = 0; i < expected.Size(); ++i)
+        {
+            ASSERT_EQ(expected[i], sort_buffer[i]);
+        }
+    }
+}
+
+// Compares the full sort of a frame with one predicate, from the submitted entries to the sorted draw order,
+// before (std::stable_sort) and after (SortRenderList, MakeSortBuffer and the radix sort) the radix sort
+TEST_F(dmRenderTest, SortRenderListPerformance)
+{
+    dmRender::SetViewMatrix(m_Context, Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, Matrix4::orthographic(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f));
+
+    const uint32_t sizes[] = { 1000, 10000, 100000 };
+    for (uint32_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+    {
+        const uint32_t count = sizes[s];
+        SubmitRandomRenderList(m_Context, count);
+
+        dmArray<uint32_t> expected;
+        uint64_t time_start = dmTime::GetTime();
+        SortRenderListStableSort(m_Context, 0, expected);
+        uint64_t time_stable_sort = dmTime::GetTime() - time_start;
+
+        time_start = dmTime::GetTime();
+        dmArray<uint32_t>& sort_buffer = SortRenderListRadixSort(m_Context, 0);
+        uint64_t time_radix_sort = dmTime::GetTime() - time_start;
+
+        printf("Sorting a render list of %u entries: std::stable_sort %.3f ms, radix sort %.3f ms\n", count, time_stable_sort / 1000.0f, time_radix_sort / 1000.0f);
+
+        ASSERT_EQ(expected.Size(), sort_buffer.Size());
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(expected[i], sort_buffer[i]);
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
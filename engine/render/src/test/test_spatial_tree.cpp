@@ -0,0 +1,428 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <float.h>
+#include <algorithm>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+
+#include <dlib/array.h>
+#include <dlib/math.h>
+#include <dlib/time.h>
+
+#include "render/render.h"
+#include "render/render_private.h"
+#include "render/spatial_tree.h"
+#include "render/spatial_tree_private.h"
+
+using namespace Vectormath::Aos;
+
+struct Bounds
+{
+    Point3 m_Min;
+    Point3 m_Max;
+};
+
+static Bounds RandomBounds(uint32_t* seed, float world_size, float max_size)
+{
+    Bounds b;
+    Point3 p(dmMath::Rand01(seed) * world_size, dmMath::Rand01(seed) * world_size, -dmMath::Rand01(seed));
+    Vector3 half(dmMath::Rand01(seed) * max_size * 0.5f, dmMath::Rand01(seed) * max_size * 0.5f, 0.0f);
+    b.m_Min = p - half;
+    b.m_Max = p + half;
+    return b;
+}
+
+static void CollectProxy(void* context, dmRender::HSpatialProxy proxy, uintptr_t user_data)
+{
+    dmArray<uint32_t>* found = (dmArray<uint32_t>*)context;
+    if (found->Full())
+        found->OffsetCapacity(found->Capacity() + 64);
+    found->Push((uint32_t)user_data);
+}
+
+static void CountProxy(void* context, dmRender::HSpatialProxy proxy, uintptr_t user_data)
+{
+    ++*(uint32_t*)context;
+}
+
+static bool Overlaps(const Bounds& b, const Point3& min, const Point3& max)
+{
+    return b.m_Min.getX() <= max.getX() && b.m_Min.getY() <= max.getY() && b.m_Min.getZ() <= max.getZ() &&
+           b.m_Max.getX() >= min.getX() && b.m_Max.getY() >= min.getY() && b.m_Max.getZ() >= min.getZ();
+}
+
+static bool IsOutsideFrustum(const Bounds& b, const Vector4 planes[6])
+{
+    const Vector3 center = (Vector3(b.m_Min) + Vector3(b.m_Max)) * 0.5f;
+    const Vector3 extent = (Vector3(b.m_Max) - Vector3(b.m_Min)) * 0.5f;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        const Vector3 n = planes[i].getXYZ();
+        if (dot(n, center) + planes[i].getW() < -dot(absPerElem(n), extent))
+            return true;
+    }
+    return false;
+}
+
+// Compares the result of a query with the expected set of live proxies
+static bool SameProxies(dmArray<uint32_t>& found, const dmArray<uint32_t>& expected)
+{
+    if (found.Size() != expected.Size())
+        return false;
+    if (found.Empty())
+        return true;
+    std::sort(found.Begin(), found.End());
+    for (uint32_t i = 0; i < found.Size(); ++i)
+    {
+        if (found[i] != expected[i])
+            return false;
+    }
+    return true;
+}
+
+static const float WORLD_SIZE = 1000.0f;
+
+class dmSpatialTreeTest : public jc_test_base_class
+{
+protected:
+    virtual void SetUp()
+    {
+        m_Tree = dmRender::NewSpatialTree(0.0f);
+        m_Seed = 17;
+    }
+
+    virtual void TearDown()
+    {
+        dmRender::DeleteSpatialTree(m_Tree);
+    }
+
+    void CreateProxies(uint32_t count, float max_size)
+    {
+        m_Bounds.SetCapacity(count);
+        m_Proxies.SetCapacity(count);
+        m_Alive.SetCapacity(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Bounds b = RandomBounds(&m_Seed, WORLD_SIZE, max_size);
+            m_Bounds.Push(b);
+            m_Proxies.Push(dmRender::CreateSpatialProxy(m_Tree, b.m_Min, b.m_Max, i));
+            m_Alive.Push(1);
+        }
+    }
+
+    void ExpectedBox(const Point3& min, const Point3& max, dmArray<uint32_t>& expected)
+    {
+        expected.SetCapacity(m_Bounds.Size());
+        expected.SetSize(0);
+        for (uint32_t i = 0; i < m_Bounds.Size(); ++i)
+        {
+            if (m_Alive[i] && Overlaps(m_Bounds[i], min, max))
+                expected.Push(i);
+        }
+    }
+
+    void ExpectedFrustum(const Matrix4& view_proj, dmArray<uint32_t>& expected)
+    {
+        Vector4 planes[6];
+        dmRender::GetFrustumPlanes(view_proj, planes);
+        expected.SetCapacity(m_Bounds.Size());
+        expected.SetSize(0);
+        for (uint32_t i = 0; i < m_Bounds.Size(); ++i)
+        {
+            if (m_Alive[i] && !IsOutsideFrustum(m_Bounds[i], planes))
+                expected.Push(i);
+        }
+    }
+
+    dmRender::HSpatialTree              m_Tree;
+    dmArray<Bounds>                     m_Bounds;
+    dmArray<dmRender::HSpatialProxy>    m_Proxies;
+    dmArray<uint8_t>                    m_Alive;
+    uint32_t                            m_Seed;
+};
+
+TEST_F(dmSpatialTreeTest, Empty)
+{
+    ASSERT_EQ(0u, dmRender::GetSpatialProxyCount(m_Tree));
+    ASSERT_EQ(0u, dmRender::GetSpatialTreeHeight(m_Tree));
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+
+    uint32_t count = 0;
+    dmRender::QuerySpatialTree(m_Tree, Point3(-FLT_MAX), Point3(FLT_MAX), CountProxy, &count);
+    dmRender::QuerySpatialTreeFrustum(m_Tree, Matrix4::identity(), CountProxy, &count);
+    ASSERT_EQ(0u, count);
+}
+
+TEST_F(dmSpatialTreeTest, CreateDestroy)
+{
+    const uint32_t count = 1000;
+    CreateProxies(count, 20.0f);
+    ASSERT_EQ(count, dmRender::GetSpatialProxyCount(m_Tree));
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+    // The tree is balanced
+    ASSERT_GE(30u, dmRender::GetSpatialTreeHeight(m_Tree));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(i, dmRender::GetSpatialProxyUserData(m_Tree, m_Proxies[i]));
+    }
+
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        dmRender::DestroySpatialProxy(m_Tree, m_Proxies[i]);
+        m_Alive[i] = 0;
+    }
+    ASSERT_EQ(count / 2, dmRender::GetSpatialProxyCount(m_Tree));
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+
+    // Freed nodes are reused
+    uint32_t node_capacity = m_Tree->m_Nodes.Size();
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        m_Proxies[i] = dmRender::CreateSpatialProxy(m_Tree, m_Bounds[i].m_Min, m_Bounds[i].m_Max, i);
+        m_Alive[i] = 1;
+    }
+    ASSERT_EQ(node_capacity, m_Tree->m_Nodes.Size());
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmRender::DestroySpatialProxy(m_Tree, m_Proxies[i]);
+    }
+    ASSERT_EQ(0u, dmRender::GetSpatialProxyCount(m_Tree));
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+}
+
+TEST_F(dmSpatialTreeTest, QueryBox)
+{
+    CreateProxies(1000, 20.0f);
+
+    dmArray<uint32_t> found;
+    dmArray<uint32_t> expected;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        Bounds query = RandomBounds(&m_Seed, WORLD_SIZE, 200.0f);
+        ExpectedBox(query.m_Min, query.m_Max, expected);
+        found.SetSize(0);
+        dmRender::QuerySpatialTree(m_Tree, query.m_Min, query.m_Max, CollectProxy, &found);
+        ASSERT_TRUE(SameProxies(found, expected));
+    }
+
+    // A rect query covering everything
+    ExpectedBox(Point3(0.0f, 0.0f, -FLT_MAX), Point3(WORLD_SIZE, WORLD_SIZE, FLT_MAX), expected);
+    ASSERT_EQ(1000u, expected.Size());
+    found.SetSize(0);
+    dmRender::QuerySpatialTree(m_Tree, Point3(-100.0f, -100.0f, -FLT_MAX), Point3(WORLD_SIZE + 100.0f, WORLD_SIZE + 100.0f, FLT_MAX), CollectProxy, &found);
+    ASSERT_TRUE(SameProxies(found, expected));
+}
+
+TEST_F(dmSpatialTreeTest, QueryFrustum)
+{
+    CreateProxies(1000, 20.0f);
+
+    dmArray<uint32_t> found;
+    dmArray<uint32_t> expected;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        // 2D cameras at random positions, and perspective cameras looking down the z axis
+        float x = dmMath::Rand01(&m_Seed) * WORLD_SIZE;
+        float y = dmMath::Rand01(&m_Seed) * WORLD_SIZE;
+        Matrix4 view_proj = Matrix4::orthographic(x - 200.0f, x + 200.0f, y - 100.0f, y + 100.0f, 0.1f, 10.0f);
+        if (i & 1)
+        {
+            Matrix4 view = Matrix4::lookAt(Point3(x, y, 300.0f), Point3(x + 50.0f, y, 0.0f), Vector3::yAxis());
+            view_proj = Matrix4::perspective(0.8f, 1.5f, 1.0f, 1000.0f) * view;
+        }
+
+        ExpectedFrustum(view_proj, expected);
+        found.SetSize(0);
+        dmRender::QuerySpatialTreeFrustum(m_Tree, view_proj, CollectProxy, &found);
+        ASSERT_TRUE(SameProxies(found, expected));
+    }
+}
+
+TEST_F(dmSpatialTreeTest, Move)
+{
+    const uint32_t count = 1000;
+    dmRender::DeleteSpatialTree(m_Tree);
+    m_Tree = dmRender::NewSpatialTree(2.0f);
+    CreateProxies(count, 20.0f);
+
+    // Moves within the margin keep the proxy in place
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Bounds& b = m_Bounds[i];
+        ASSERT_FALSE(dmRender::MoveSpatialProxy(m_Tree, m_Proxies[i], b.m_Min + Vector3(1.0f, -1.0f, 0.0f), b.m_Max + Vector3(1.0f, -1.0f, 0.0f), Vector3(1.0f, -1.0f, 0.0f)));
+    }
+
+    dmArray<uint32_t> found;
+    dmArray<uint32_t> expected;
+    for (uint32_t frame = 0; frame < 10; ++frame)
+    {
+        for (uint32_t i = frame; i < count; i += 10)
+        {
+            m_Bounds[i] = RandomBounds(&m_Seed, WORLD_SIZE, 20.0f);
+            ASSERT_TRUE(dmRender::MoveSpatialProxy(m_Tree, m_Proxies[i], m_Bounds[i].m_Min, m_Bounds[i].m_Max, Vector3(0.0f)));
+        }
+        ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+        ASSERT_EQ(count, dmRender::GetSpatialProxyCount(m_Tree));
+
+        // The margin makes the query conservative, every proxy in the box must be found
+        Bounds query = RandomBounds(&m_Seed, WORLD_SIZE, 200.0f);
+        ExpectedBox(query.m_Min, query.m_Max, expected);
+        found.SetSize(0);
+        dmRender::QuerySpatialTree(m_Tree, query.m_Min, query.m_Max, CollectProxy, &found);
+        ASSERT_LE(expected.Size(), found.Size());
+        for (uint32_t i = 0; i < found.Size(); ++i)
+        {
+            Point3 margin_min = query.m_Min - Vector3(2.0f);
+            Point3 margin_max = query.m_Max + Vector3(2.0f);
+            ASSERT_TRUE(Overlaps(m_Bounds[found[i]], margin_min, margin_max));
+        }
+    }
+}
+
+// A proxy moving at a steady speed is extended in the direction of the movement, and shrunk again when it stops
+TEST_F(dmSpatialTreeTest, MoveDisplacement)
+{
+    dmRender::DeleteSpatialTree(m_Tree);
+    m_Tree = dmRender::NewSpatialTree(2.0f);
+    CreateProxies(100, 20.0f);
+
+    Bounds b = m_Bounds[0];
+    const Vector3 velocity(3.0f, 0.0f, 0.0f);
+    uint32_t reinserted = 0;
+    for (uint32_t frame = 0; frame < 40; ++frame)
+    {
+        b.m_Min += velocity;
+        b.m_Max += velocity;
+        reinserted += dmRender::MoveSpatialProxy(m_Tree, m_Proxies[0], b.m_Min, b.m_Max, velocity) ? 1 : 0;
+
+        // The proxy must always be found at its current bounds
+        dmArray<uint32_t> found;
+        dmRender::QuerySpatialTree(m_Tree, b.m_Min, b.m_Max, CollectProxy, &found);
+        bool found_proxy = false;
+        for (uint32_t i = 0; i < found.Size(); ++i)
+            found_proxy |= found[i] == 0;
+        ASSERT_TRUE(found_proxy);
+    }
+    // Without the displacement, a move of 3 units with a margin of 2 reinserts every frame
+    ASSERT_GE(10U, reinserted);
+
+    // Once stopped, the bounds ahead of the proxy are dropped
+    b.m_Min += velocity;
+    b.m_Max += velocity;
+    dmRender::MoveSpatialProxy(m_Tree, m_Proxies[0], b.m_Min, b.m_Max, velocity);
+    ASSERT_TRUE(dmRender::MoveSpatialProxy(m_Tree, m_Proxies[0], b.m_Min, b.m_Max, Vector3(0.0f)));
+    ASSERT_FALSE(dmRender::MoveSpatialProxy(m_Tree, m_Proxies[0], b.m_Min, b.m_Max, Vector3(0.0f)));
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+}
+
+/**
+ * Compare updating and querying a tree of 100k proxies, with 5% of them moving each frame, against testing every proxy
+ */
+TEST_F(dmSpatialTreeTest, Bench)
+{
+    const uint32_t count = 100000;
+    const uint32_t frame_count = 60;
+    const uint32_t move_count = count / 20;
+    const float world_size = 20000.0f;
+
+    dmRender::DeleteSpatialTree(m_Tree);
+    m_Tree = dmRender::NewSpatialTree(8.0f);
+
+    uint64_t start = dmTime::GetTime();
+    m_Bounds.SetCapacity(count);
+    m_Proxies.SetCapacity(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Bounds b = RandomBounds(&m_Seed, world_size, 64.0f);
+        m_Bounds.Push(b);
+        m_Proxies.Push(dmRender::CreateSpatialProxy(m_Tree, b.m_Min, b.m_Max, i));
+    }
+    uint64_t end = dmTime::GetTime();
+    printf("Create %u proxies: %.2f ms, height %u\n", count, (end - start) / 1000.0, dmRender::GetSpatialTreeHeight(m_Tree));
+
+    // The same proxies move every frame, each with its own velocity of up to 8 units per frame
+    dmArray<Vector3> velocities;
+    velocities.SetCapacity(move_count);
+    for (uint32_t i = 0; i < move_count; ++i)
+    {
+        velocities.Push(Vector3(dmMath::Rand11(&m_Seed) * 8.0f, dmMath::Rand11(&m_Seed) * 8.0f, 0.0f));
+    }
+
+    // A 1920x1080 view in the middle of the world
+    const float x = world_size * 0.5f;
+    const float y = world_size * 0.5f;
+    Matrix4 view_proj = Matrix4::orthographic(x - 960.0f, x + 960.0f, y - 540.0f, y + 540.0f, 0.1f, 10.0f);
+    Vector4 planes[6];
+    dmRender::GetFrustumPlanes(view_proj, planes);
+
+    uint64_t move_time = 0;
+    uint64_t query_time = 0;
+    uint64_t brute_force_time = 0;
+    uint32_t reinserted = 0;
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        // Both methods need the new bounds, only the tree update is timed
+        for (uint32_t i = 0; i < move_count; ++i)
+        {
+            Bounds& b = m_Bounds[i * 20];
+            b.m_Min += velocities[i];
+            b.m_Max += velocities[i];
+        }
+
+        start = dmTime::GetTime();
+        for (uint32_t i = 0; i < move_count; ++i)
+        {
+            uint32_t index = i * 20;
+            const Bounds& b = m_Bounds[index];
+            reinserted += dmRender::MoveSpatialProxy(m_Tree, m_Proxies[index], b.m_Min, b.m_Max, velocities[i]) ? 1 : 0;
+        }
+        end = dmTime::GetTime();
+        move_time += end - start;
+
+        uint32_t visible = 0;
+        start = dmTime::GetTime();
+        dmRender::QuerySpatialTreeFrustum(m_Tree, view_proj, CountProxy, &visible);
+        end = dmTime::GetTime();
+        query_time += end - start;
+
+        uint32_t brute_force_visible = 0;
+        start = dmTime::GetTime();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            brute_force_visible += IsOutsideFrustum(m_Bounds[i], planes) ? 0 : 1;
+        }
+        end = dmTime::GetTime();
+        brute_force_time += end - start;
+
+        // The extended bounds may make a few more proxies visible
+        ASSERT_LE(brute_force_visible, visible);
+    }
+    ASSERT_TRUE(dmRender::ValidateSpatialTree(m_Tree));
+
+    double move_ms = move_time / (1000.0 * frame_count);
+    double query_ms = query_time / (1000.0 * frame_count);
+    printf("Move %u proxies: %.3f ms/frame, %u reinserted\n", move_count, move_ms, reinserted / frame_count);
+    printf("Frustum query: %.3f ms/frame\n", query_ms);
+    printf("Move + query: %.3f ms/frame, brute force: %.3f ms/frame\n", move_ms + query_ms, brute_force_time / (1000.0 * frame_count));
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
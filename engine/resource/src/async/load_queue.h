@@ -35,6 +35,12 @@ namespace dmLoadQueue
         dmResource::FResourcePreload m_Function;
         dmResource::PreloadHintInfo m_HintInfo;
         void* m_Context;
+        // Set if the resource may be created on the load thread, see dmResource::SetThreadSafeCreate
+        dmResource::FResourceCreate m_CreateFunction;
+        void* m_ResourceType;
+        dmhash_t m_CanonicalPathHash;
+        // Requests with higher priority are loaded first
+        uint32_t m_Priority;
     };
 
     struct LoadResult
@@ -42,6 +48,27 @@ namespace dmLoadQueue
         dmResource::Result m_LoadResult;
         dmResource::Result m_PreloadResult;
         void* m_PreloadData;
+        // RESULT_PENDING unless the resource was created on the load thread
+        dmResource::Result m_CreateResult;
+        dmResource::SResourceDescriptor m_Resource;
+        // Set if the buffer points straight into the memory mapped archive, i.e. it was never copied
+        bool m_Mapped;
+    };
+
+    struct QueueStats
+    {
+        // Number of loader threads
+        uint32_t m_ThreadCount;
+        // Number of requests waiting for a loader thread, now and at most
+        uint32_t m_QueueDepth;
+        uint32_t m_MaxQueueDepth;
+        uint32_t m_RequestsLoaded;
+        uint64_t m_BytesLoaded;
+        // Time (us) spent loading and preloading, summed over all loader threads
+        uint64_t m_LoadTime;
+        // Time (us) from BeginLoad until the request was loaded, summed and max
+        uint64_t m_TotalLatency;
+        uint64_t m_MaxLatency;
     };
 
     HQueue CreateQueue(dmResource::HFactory factory);
@@ -56,6 +83,9 @@ namespace dmLoadQueue
 
     // Free once completed.
     void FreeLoad(HQueue queue, HRequest request);
+
+    // Accumulated statistics since the queue was created, used to tune the number of loader threads
+    void GetStats(HQueue queue, QueueStats* stats);
 } // namespace dmLoadQueue
 
 #endif
@@ -10,12 +10,15 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <string.h>
+
 #include "resource.h"
 #include "resource_private.h"
 #include "load_queue.h"
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dlib/time.h>
 
 namespace dmLoadQueue
 {
@@ -34,6 +37,7 @@ namespace dmLoadQueue
         dmResource::HFactory m_Factory;
         Request m_SingleBuffer;
         Request* m_ActiveRequest;
+        QueueStats m_Stats;
     };
 
     HQueue CreateQueue(dmResource::HFactory factory)
@@ -41,6 +45,7 @@ namespace dmLoadQueue
         Queue* q           = new Queue();
         q->m_ActiveRequest = 0;
         q->m_Factory       = factory;
+        memset(&q->m_Stats, 0, sizeof(q->m_Stats));
         return q;
     }
 
@@ -70,9 +75,11 @@ namespace dmLoadQueue
             return RESULT_INVALID_PARAM;
         }
 
-        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size);
+        uint64_t load_start          = dmTime::GetTime();
+        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size, &load_result->m_Mapped);
         load_result->m_PreloadResult = dmResource::RESULT_PENDING;
         load_result->m_PreloadData   = 0;
+        load_result->m_CreateResult  = dmResource::RESULT_PENDING;
 
         if (load_result->m_LoadResult == dmResource::RESULT_OK && request->m_PreloadInfo.m_Function)
         {
@@ -85,6 +92,16 @@ namespace dmLoadQueue
             params.m_PreloadData         = &load_result->m_PreloadData;
             load_result->m_PreloadResult = request->m_PreloadInfo.m_Function(params);
         }
+
+        uint64_t load_time = dmTime::GetTime() - load_start;
+        queue->m_Stats.m_RequestsLoaded++;
+        queue->m_Stats.m_BytesLoaded += load_result->m_LoadResult == dmResource::RESULT_OK ? *size : 0;
+        queue->m_Stats.m_LoadTime += load_time;
+        queue->m_Stats.m_TotalLatency += load_time;
+        if (load_time > queue->m_Stats.m_MaxLatency)
+        {
+            queue->m_Stats.m_MaxLatency = load_time;
+        }
         return RESULT_OK;
     }
 
@@ -94,4 +111,11 @@ namespace dmLoadQueue
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
     }
+
+    void GetStats(HQueue queue, QueueStats* stats)
+    {
+        *stats = queue->m_Stats;
+        stats->m_QueueDepth  = 0;
+        stats->m_ThreadCount = 0;
+    }
 } // namespace dmLoadQueue
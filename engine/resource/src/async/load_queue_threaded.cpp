@@ -10,6 +10,8 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <string.h>
+
 #include "resource.h"
 #include "resource_private.h"
 #include "load_queue.h"
@@ -24,7 +26,8 @@
 
 namespace dmLoadQueue
 {
-    // Implementation of dmLoadQueue with a thread that loads items in the order they are supplied,
+    // Implementation of dmLoadQueue with a pool of threads that load items by priority, and in the order they
+    // are supplied within the same priority. Requests may complete out of order when more than one thread is used.
 
     // Default to small buffers since a lot of what is loaded are just small objects anyway.
     // That way we can have more in flight, but throttle when max pending data grows too large anyway
@@ -34,14 +37,29 @@ namespace dmLoadQueue
     // This sets the bandwidth of the loader.
     const uint64_t MAX_PENDING_DATA = 4 * 1024 * 1024;
     const uint32_t QUEUE_SLOTS      = 16;
+    const uint32_t MAX_LOAD_THREADS = 8;
+
+    enum RequestState
+    {
+        REQUEST_STATE_FREE    = 0,
+        REQUEST_STATE_QUEUED  = 1,
+        REQUEST_STATE_LOADING = 2,
+        REQUEST_STATE_DONE    = 3,
+    };
 
     struct Request
     {
         const char* m_Name;
         const char* m_CanonicalPath;
         dmResource::LoadBufferType m_Buffer;
+        // The loaded data, either in m_Buffer or in place in the memory mapped archive
+        const void* m_Data;
+        uint32_t m_Size;
         PreloadInfo m_PreloadInfo;
         LoadResult m_Result;
+        uint64_t m_QueueTime;
+        uint32_t m_Sequence;
+        RequestState m_State;
     };
 
     struct Queue
@@ -49,17 +67,15 @@ namespace dmLoadQueue
         dmResource::HFactory m_Factory;
         dmMutex::HMutex m_Mutex;
         dmConditionVariable::HConditionVariable m_WakeupCond;
-        dmThread::Thread m_Thread;
+        dmThread::Thread m_Threads[MAX_LOAD_THREADS];
+        uint32_t m_ThreadCount;
         Request m_Request[QUEUE_SLOTS];
-        uint32_t m_Front, m_Back, m_Loaded;
+        // Number of requests in each state, except free
+        uint32_t m_Queued, m_Loading, m_Done;
+        uint32_t m_Sequence;
         uint64_t m_BytesWaiting;
+        QueueStats m_Stats;
         bool m_Shutdown;
-
-        // Circular queue with indexing as follow (exclusive end)
-        //
-        //          m_Back           m_Loaded   m_Front
-        // [N/A]   [loaded] [loaded] [to-load]  [N/A]
-        //
     };
 
     static Request* GetNextRequest(Queue* queue)
@@ -73,12 +89,49 @@ namespace dmLoadQueue
             return 0x0;
         }
 
-        if (queue->m_Loaded == queue->m_Front)
+        if (queue->m_Queued == 0)
         {
             return 0x0;
         }
 
-        return &queue->m_Request[queue->m_Loaded % QUEUE_SLOTS];
+        // Highest priority first, then oldest first
+        Request* best = 0x0;
+        for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
+        {
+            Request* r = &queue->m_Request[i];
+            if (r->m_State != REQUEST_STATE_QUEUED)
+            {
+                continue;
+            }
+            if (best == 0x0 || r->m_PreloadInfo.m_Priority > best->m_PreloadInfo.m_Priority ||
+                (r->m_PreloadInfo.m_Priority == best->m_PreloadInfo.m_Priority && (int32_t)(r->m_Sequence - best->m_Sequence) < 0))
+            {
+                best = r;
+            }
+        }
+        return best;
+    }
+
+    // The thread safe part of dmResource::CreateResource() in the preloader, the resource is registered on the main thread
+    static void CreateResource(Queue* queue, Request* request, LoadResult* result)
+    {
+        dmResource::SResourceDescriptor* resource = &result->m_Resource;
+        memset(resource, 0, sizeof(*resource));
+        resource->m_NameHash           = request->m_PreloadInfo.m_CanonicalPathHash;
+        resource->m_ReferenceCount     = 1;
+        resource->m_ResourceType       = request->m_PreloadInfo.m_ResourceType;
+        resource->m_ResourceSizeOnDisc = request->m_Size;
+        resource->m_ResourceSizeMapped = result->m_Mapped ? request->m_Size : 0;
+
+        dmResource::ResourceCreateParams params;
+        params.m_Factory     = queue->m_Factory;
+        params.m_Context     = request->m_PreloadInfo.m_Context;
+        params.m_PreloadData = result->m_PreloadData;
+        params.m_Resource    = resource;
+        params.m_Filename    = request->m_Name;
+        params.m_Buffer      = request->m_Data;
+        params.m_BufferSize  = request->m_Size;
+        result->m_CreateResult = request->m_PreloadInfo.m_CreateFunction(params);
     }
 
     static void LoadThread(void* arg)
@@ -86,16 +139,29 @@ namespace dmLoadQueue
         Queue* queue     = (Queue*)arg;
         Request* current = 0;
         LoadResult result;
+        uint64_t load_start = 0;
         while (true)
         {
             {
                 dmMutex::ScopedLock lk(queue->m_Mutex);
                 if (current != 0)
                 {
-                    // Just finished one (from previous iteratino)
+                    // Just finished one (from previous iteration)
+                    uint64_t now = dmTime::GetTime();
+                    uint64_t latency = now - current->m_QueueTime;
                     queue->m_BytesWaiting += current->m_Buffer.Capacity();
-                    queue->m_Loaded++;
+                    queue->m_Loading--;
+                    queue->m_Done++;
+                    queue->m_Stats.m_RequestsLoaded++;
+                    queue->m_Stats.m_BytesLoaded += current->m_Size;
+                    queue->m_Stats.m_LoadTime += now - load_start;
+                    queue->m_Stats.m_TotalLatency += latency;
+                    if (latency > queue->m_Stats.m_MaxLatency)
+                    {
+                        queue->m_Stats.m_MaxLatency = latency;
+                    }
                     current->m_Result = result;
+                    current->m_State  = REQUEST_STATE_DONE;
                     current           = 0;
                 }
                 if (queue->m_Shutdown)
@@ -104,58 +170,77 @@ namespace dmLoadQueue
                 }
 
                 current = GetNextRequest(queue);
-                if (current == 0x0)
+                while (current == 0x0)
                 {
-                    // Nothing to do, reset any buffers of inactive requests that are not at default capacity
-                    for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
+                    if (queue->m_Loading == 0)
                     {
-                        Request* r = &queue->m_Request[i];
-                        if (r->m_Buffer.Size() == 0)
+                        // Nothing to do, reset any buffers of inactive requests that are not at default capacity
+                        for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
                         {
-                            if (r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
+                            Request* r = &queue->m_Request[i];
+                            if (r->m_State == REQUEST_STATE_FREE)
                             {
-                                // Just free the memory here, no need to allocate while holding the mutex
-                                r->m_Buffer.SetCapacity(0);
+                                if (r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
+                                {
+                                    // Just free the memory here, no need to allocate while holding the mutex
+                                    r->m_Buffer.SetCapacity(0);
+                                }
                             }
                         }
                     }
                     dmConditionVariable::Wait(queue->m_WakeupCond, queue->m_Mutex);
+                    if (queue->m_Shutdown)
+                    {
+                        return;
+                    }
                     current = GetNextRequest(queue);
                 }
+
+                current->m_State = REQUEST_STATE_LOADING;
+                queue->m_Queued--;
+                queue->m_Loading++;
             }
 
-            if (current)
-            {
-                // We use the temporary result object here to fill in the data so it can be written with the mutex held.
-                uint32_t size;
+            // We use the temporary result object here to fill in the data so it can be written with the mutex held.
+            uint32_t size;
+            load_start = dmTime::GetTime();
 
-                assert(current->m_Buffer.Size() == 0);
-                if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+            assert(current->m_Buffer.Size() == 0);
+            if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+            {
+                current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+            }
+            const void* mapped_data = 0;
+            result.m_LoadResult    = DoLoadResource(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer, &mapped_data);
+            result.m_PreloadResult = dmResource::RESULT_PENDING;
+            result.m_PreloadData   = 0;
+            result.m_CreateResult  = dmResource::RESULT_PENDING;
+            result.m_Mapped        = mapped_data != 0;
+            current->m_Data        = mapped_data ? mapped_data : current->m_Buffer.Begin();
+            current->m_Size        = result.m_LoadResult == dmResource::RESULT_OK ? size : 0;
+
+            if (result.m_LoadResult == dmResource::RESULT_OK)
+            {
+                assert(mapped_data || current->m_Buffer.Size() == size);
+                if (current->m_PreloadInfo.m_Function)
+                {
+                    dmResource::ResourcePreloadParams params;
+                    params.m_Factory       = queue->m_Factory;
+                    params.m_Context       = current->m_PreloadInfo.m_Context;
+                    params.m_Buffer        = current->m_Data;
+                    params.m_BufferSize    = current->m_Size;
+                    params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
+                    params.m_PreloadData   = &result.m_PreloadData;
+                    result.m_PreloadResult = current->m_PreloadInfo.m_Function(params);
+                }
+                else
                 {
-                    current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+                    result.m_PreloadResult = dmResource::RESULT_OK;
                 }
-                result.m_LoadResult    = DoLoadResource(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
-                result.m_PreloadResult = dmResource::RESULT_PENDING;
-                result.m_PreloadData   = 0;
 
-                if (result.m_LoadResult == dmResource::RESULT_OK)
+                if (result.m_PreloadResult == dmResource::RESULT_OK && current->m_PreloadInfo.m_CreateFunction && current->m_PreloadInfo.m_HintInfo.m_HintCount == 0)
                 {
-                    assert(current->m_Buffer.Size() == size);
-                    if (current->m_PreloadInfo.m_Function)
-                    {
-                        dmResource::ResourcePreloadParams params;
-                        params.m_Factory       = queue->m_Factory;
-                        params.m_Context       = current->m_PreloadInfo.m_Context;
-                        params.m_Buffer        = current->m_Buffer.Begin();
-                        params.m_BufferSize    = current->m_Buffer.Size();
-                        params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
-                        params.m_PreloadData   = &result.m_PreloadData;
-                        result.m_PreloadResult = current->m_PreloadInfo.m_Function(params);
-                    }
-                    else
-                    {
-                        result.m_PreloadResult = dmResource::RESULT_OK;
-                    }
+                    CreateResource(queue, current, &result);
                 }
             }
         }
@@ -165,14 +250,30 @@ namespace dmLoadQueue
     {
         Queue* q          = new Queue();
         q->m_Factory      = factory;
-        q->m_Front        = 0;
-        q->m_Back         = 0;
-        q->m_Loaded       = 0;
+        q->m_Queued       = 0;
+        q->m_Loading      = 0;
+        q->m_Done         = 0;
+        q->m_Sequence     = 0;
         q->m_Shutdown     = false;
         q->m_BytesWaiting = 0;
+        memset(&q->m_Stats, 0, sizeof(q->m_Stats));
+        for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
+        {
+            q->m_Request[i].m_Name          = 0x0;
+            q->m_Request[i].m_CanonicalPath = 0x0;
+            q->m_Request[i].m_Data          = 0x0;
+            q->m_Request[i].m_Size          = 0;
+            q->m_Request[i].m_State         = REQUEST_STATE_FREE;
+        }
         q->m_Mutex        = dmMutex::New();
         q->m_WakeupCond   = dmConditionVariable::New();
-        q->m_Thread       = dmThread::New(&LoadThread, 65536, q, "AsyncLoad");
+
+        uint32_t thread_count = dmResource::GetLoadThreadCount(factory);
+        q->m_ThreadCount = thread_count < 1 ? 1 : (thread_count > MAX_LOAD_THREADS ? MAX_LOAD_THREADS : thread_count);
+        for (uint32_t i = 0; i < q->m_ThreadCount; ++i)
+        {
+            q->m_Threads[i] = dmThread::New(&LoadThread, 65536, q, "AsyncLoad");
+        }
 
         return q;
     }
@@ -182,10 +283,13 @@ namespace dmLoadQueue
         {
             dmMutex::ScopedLock lk(queue->m_Mutex);
             queue->m_Shutdown = true;
-            // Wake up the worker so it can exit and allow us to join
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            // Wake up the workers so they can exit and allow us to join
+            dmConditionVariable::Broadcast(queue->m_WakeupCond);
+        }
+        for (uint32_t i = 0; i < queue->m_ThreadCount; ++i)
+        {
+            dmThread::Join(queue->m_Threads[i]);
         }
-        dmThread::Join(queue->m_Thread);
         dmConditionVariable::Delete(queue->m_WakeupCond);
         dmMutex::Delete(queue->m_Mutex);
         delete queue;
@@ -201,33 +305,47 @@ namespace dmLoadQueue
         dmMutex::ScopedLock lk(queue->m_Mutex);
 
         // Refuse more if full.
-        if ((queue->m_Front - queue->m_Back) == QUEUE_SLOTS)
-            return 0;
-
-        if (queue->m_Loaded == queue->m_Front)
+        Request* req = 0x0;
+        for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
         {
-            // The worker is sleeping waiting for request, wake it up
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            if (queue->m_Request[i].m_State == REQUEST_STATE_FREE)
+            {
+                req = &queue->m_Request[i];
+                break;
+            }
         }
+        if (req == 0x0)
+            return 0;
 
-        Request* req         = &queue->m_Request[(queue->m_Front++) % QUEUE_SLOTS];
         req->m_Name          = name;
         req->m_CanonicalPath = canonical_path;
+        req->m_QueueTime     = dmTime::GetTime();
+        req->m_Sequence      = queue->m_Sequence++;
+        req->m_State         = REQUEST_STATE_QUEUED;
 
         req->m_PreloadInfo         = *info;
         req->m_Result.m_LoadResult = dmResource::RESULT_PENDING;
 
+        queue->m_Queued++;
+        if (queue->m_Queued > queue->m_Stats.m_MaxQueueDepth)
+        {
+            queue->m_Stats.m_MaxQueueDepth = queue->m_Queued;
+        }
+
+        // Wake up a sleeping worker, if any
+        dmConditionVariable::Signal(queue->m_WakeupCond);
+
         return req;
     }
 
     Result EndLoad(HQueue queue, HRequest request, void** buf, uint32_t* size, LoadResult* load_result)
     {
         dmMutex::ScopedLock lk(queue->m_Mutex);
-        if (request->m_Result.m_LoadResult == dmResource::RESULT_PENDING)
+        if (request->m_State != REQUEST_STATE_DONE)
             return RESULT_PENDING;
 
-        *buf         = request->m_Buffer.Begin();
-        *size        = request->m_Buffer.Size();
+        *buf         = (void*) request->m_Data;
+        *size        = request->m_Size;
         *load_result = request->m_Result;
 
         return RESULT_OK;
@@ -237,7 +355,7 @@ namespace dmLoadQueue
     {
         dmMutex::ScopedLock lk(queue->m_Mutex);
 
-        uint32_t old_bytes_waiting = queue->m_BytesWaiting;
+        uint64_t old_bytes_waiting = queue->m_BytesWaiting;
 
         // Make sure we don't copy any data if we reallocate the buffer
         request->m_Buffer.SetSize(0);
@@ -245,20 +363,27 @@ namespace dmLoadQueue
         uint32_t buffer_capacity = request->m_Buffer.Capacity();
         queue->m_BytesWaiting -= buffer_capacity;
         // If we either have blocked further processing by exceeding MAX_PENDING_DATA or
-        // the buffer has a non-default capacity, we want to wake up the worker
+        // the buffer has a non-default capacity, we want to wake up the workers
         if (buffer_capacity != DEFAULT_CAPACITY || (old_bytes_waiting >= MAX_PENDING_DATA && queue->m_BytesWaiting < MAX_PENDING_DATA))
         {
-            // Wake up thread, we can now fit a new request
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            // Wake up threads, we can now fit a new request
+            dmConditionVariable::Broadcast(queue->m_WakeupCond);
         }
 
         // Clean up picked up requests
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
+        request->m_Data          = 0x0;
+        request->m_Size          = 0;
+        request->m_State         = REQUEST_STATE_FREE;
+        queue->m_Done--;
+    }
 
-        while (queue->m_Back != queue->m_Loaded && queue->m_Request[queue->m_Back % QUEUE_SLOTS].m_Name == 0x0)
-        {
-            queue->m_Back++;
-        }
+    void GetStats(HQueue queue, QueueStats* stats)
+    {
+        dmMutex::ScopedLock lk(queue->m_Mutex);
+        *stats = queue->m_Stats;
+        stats->m_QueueDepth  = queue->m_Queued;
+        stats->m_ThreadCount = queue->m_ThreadCount;
     }
 } // namespace dmLoadQueue
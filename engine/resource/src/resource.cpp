@@ -127,6 +127,9 @@ struct SResourceFactory
     // Resource manifest
     Manifest*                                    m_Manifest;
     void*                                        m_ArchiveMountInfo;
+
+    // Number of preloader load threads
+    uint32_t                                     m_LoadThreadCount;
 };
 
 SResourceType* FindResourceType(SResourceFactory* factory, const char* extension)
@@ -187,6 +190,7 @@ void SetDefaultNewFactoryParams(struct NewFactoryParams* params)
 {
     params->m_MaxResources = 1024;
     params->m_Flags = RESOURCE_FACTORY_FLAGS_EMPTY;
+    params->m_LoadThreadCount = 1;
 
     params->m_ArchiveManifest.m_Data = 0;
     params->m_ArchiveManifest.m_Size = 0;
@@ -796,6 +800,7 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     }
 
     factory->m_ResourceTypesCount = 0;
+    factory->m_LoadThreadCount = params->m_LoadThreadCount;
 
     const uint32_t table_size = dmMath::Max(1u, (3 * params->m_MaxResources) / 4);
     factory->m_Resources = new dmHashTable<uint64_t, SResourceDescriptor>();
@@ -968,6 +973,16 @@ Result RegisterType(HFactory factory,
     return RESULT_OK;
 }
 
+Result SetThreadSafeCreate(HFactory factory, const char* extension, bool thread_safe_create)
+{
+    SResourceType* resource_type = FindResourceType(factory, extension);
+    if (resource_type == 0)
+        return RESULT_UNKNOWN_RESOURCE_TYPE;
+
+    resource_type->m_ThreadSafeCreate = thread_safe_create;
+    return RESULT_OK;
+}
+
 // Finds the specific entry in a sorted list of entries
 static int FindEntryIndex(const Manifest* manifest, dmhash_t path_hash)
 {
@@ -1025,7 +1040,8 @@ Result VerifyResourcesBundled(HFactory factory, Manifest* manifest)
     return VerifyResourcesBundled(entries, entry_count, factory->m_Manifest->m_ArchiveIndex);
 }
 
-static Result LoadFromManifest(const Manifest* manifest, const char* path, uint32_t* resource_size, LoadBufferType* buffer)
+// If mapped_data is set, uncompressed data in a memory mapped archive is returned in place instead of being copied to the buffer
+static Result LoadFromManifest(const Manifest* manifest, const char* path, uint32_t* resource_size, LoadBufferType* buffer, const void** mapped_data)
 {
     dmhash_t path_hash = dmHashString64(path);
 
@@ -1040,6 +1056,14 @@ static Result LoadFromManifest(const Manifest* manifest, const char* path, uint3
     if (res == dmResourceArchive::RESULT_OK)
     {
         uint32_t file_size = ed.m_ResourceSize;
+        if (mapped_data && dmResourceArchive::GetMappedData(manifest->m_ArchiveIndex, &ed, mapped_data) == dmResourceArchive::RESULT_OK)
+        {
+            DM_COUNTER("ResourceMappedBytes", file_size);
+            buffer->SetSize(0);
+            *resource_size = file_size;
+            return RESULT_OK;
+        }
+
         if (buffer->Capacity() < file_size)
         {
             buffer->SetCapacity(file_size);
@@ -1067,12 +1091,17 @@ static Result LoadFromManifest(const Manifest* manifest, const char* path, uint3
 }
 
 // Assumes m_LoadMutex is already held
-static Result DoLoadResourceLocked(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
+// If mapped_data is set and the resource could be used in place, *mapped_data is set and the buffer is left empty
+static Result DoLoadResourceLocked(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, const void** mapped_data)
 {
     DM_PROFILE(Resource, "LoadResource");
+    if (mapped_data)
+    {
+        *mapped_data = 0;
+    }
     if (factory->m_BuiltinsManifest)
     {
-        if (LoadFromManifest(factory->m_BuiltinsManifest, original_name, resource_size, buffer) == RESULT_OK)
+        if (LoadFromManifest(factory->m_BuiltinsManifest, original_name, resource_size, buffer, mapped_data) == RESULT_OK)
         {
             return RESULT_OK;
         }
@@ -1126,7 +1155,7 @@ static Result DoLoadResourceLocked(HFactory factory, const char* path, const cha
     }
     else if (factory->m_Manifest)
     {
-        Result r = LoadFromManifest(factory->m_Manifest, original_name, resource_size, buffer);
+        Result r = LoadFromManifest(factory->m_Manifest, original_name, resource_size, buffer, mapped_data);
         return r;
     }
     else
@@ -1161,25 +1190,27 @@ static Result DoLoadResourceLocked(HFactory factory, const char* path, const cha
 }
 
 // Takes the lock.
-Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
+Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, const void** mapped_data)
 {
     // Called from async queue so we wrap around a lock
     dmMutex::ScopedLock lk(factory->m_LoadMutex);
-    return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer);
+    return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer, mapped_data);
 }
 
 // Assumes m_LoadMutex is already held
-Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size)
+Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size, bool* mapped)
 {
     if (factory->m_Buffer.Capacity() != DEFAULT_BUFFER_SIZE) {
         factory->m_Buffer.SetCapacity(DEFAULT_BUFFER_SIZE);
     }
     factory->m_Buffer.SetSize(0);
-    Result r = DoLoadResourceLocked(factory, path, original_name, resource_size, &factory->m_Buffer);
+    const void* mapped_data = 0;
+    Result r = DoLoadResourceLocked(factory, path, original_name, resource_size, &factory->m_Buffer, &mapped_data);
     if (r == RESULT_OK)
-        *buffer = factory->m_Buffer.Begin();
+        *buffer = mapped_data ? (void*) mapped_data : factory->m_Buffer.Begin();
     else
         *buffer = 0;
+    *mapped = mapped_data != 0;
     return r;
 }
 
@@ -1244,7 +1275,8 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
 
         void *buffer;
         uint32_t file_size;
-        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+        bool mapped;
+        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, &mapped);
         if (result != RESULT_OK) {
             if (result == RESULT_RESOURCE_NOT_FOUND) {
                 dmLogWarning("Resource not found: %s", name);
@@ -1252,7 +1284,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
             return result;
         }
 
-        assert(buffer == factory->m_Buffer.Begin());
+        assert(mapped || buffer == factory->m_Buffer.Begin());
 
         // TODO: We should *NOT* allocate SResource dynamically...
         SResourceDescriptor tmp_resource;
@@ -1280,6 +1312,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
         if (create_error == RESULT_OK)
         {
             tmp_resource.m_ResourceSizeOnDisc = file_size;
+            tmp_resource.m_ResourceSizeMapped = mapped ? file_size : 0;
             tmp_resource.m_ResourceSize = 0; // Not everything will report a size (but instead rely on the disc size, sinze it's close enough)
 
             ResourceCreateParams params;
@@ -1444,10 +1477,11 @@ Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* res
 
     void* buffer;
     uint32_t file_size;
-    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+    bool mapped;
+    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, &mapped);
     if (result == RESULT_OK) {
         *resource = malloc(file_size);
-        assert(buffer == factory->m_Buffer.Begin());
+        assert(mapped || buffer == factory->m_Buffer.Begin());
         memcpy(*resource, buffer, file_size);
         *resource_size = file_size;
     }
@@ -1475,11 +1509,12 @@ static Result DoReloadResource(HFactory factory, const char* name, SResourceDesc
 
     void* buffer;
     uint32_t file_size;
-    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+    bool mapped;
+    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, &mapped);
     if (result != RESULT_OK)
         return result;
 
-    assert(buffer == factory->m_Buffer.Begin());
+    assert(mapped || buffer == factory->m_Buffer.Begin());
 
     ResourceRecreateParams params;
     params.m_Factory = factory;
@@ -1494,6 +1529,7 @@ static Result DoReloadResource(HFactory factory, const char* name, SResourceDesc
     if (create_result == RESULT_OK)
     {
         params.m_Resource->m_ResourceSizeOnDisc = file_size;
+        params.m_Resource->m_ResourceSizeMapped = mapped ? file_size : 0;
         if (factory->m_ResourceReloadedCallbacks)
         {
             for (uint32_t i = 0; i < factory->m_ResourceReloadedCallbacks->Size(); ++i)
@@ -1596,6 +1632,7 @@ Result SetResource(HFactory factory, uint64_t hashed_name, void* data, uint32_t
     Result create_result = resource_type->m_RecreateFunction(params);
     if (create_result == RESULT_OK)
     {
+        rd->m_ResourceSizeMapped = 0;
         if (factory->m_ResourceReloadedCallbacks)
         {
             for (uint32_t i = 0; i < factory->m_ResourceReloadedCallbacks->Size(); ++i)
@@ -1881,6 +1918,11 @@ dmMutex::HMutex GetLoadMutex(const dmResource::HFactory factory)
     return factory->m_LoadMutex;
 }
 
+uint32_t GetLoadThreadCount(HFactory factory)
+{
+    return factory->m_LoadThreadCount;
+}
+
 void ReleaseBuiltinsManifest(HFactory factory)
 {
     if (factory->m_BuiltinsManifest)
@@ -1909,6 +1951,7 @@ static void ResourceIteratorCallback(ResourceIteratorCallbackInfo* callback, con
     info.m_SizeOnDisc   = resource->m_ResourceSizeOnDisc;
     info.m_Size         = resource->m_ResourceSize ? resource->m_ResourceSize : resource->m_ResourceSizeOnDisc; // default to the size on disc if no in memory size was specified
     info.m_RefCount     = resource->m_ReferenceCount;
+    info.m_SizeMapped   = resource->m_ResourceSizeMapped;
 
     if (callback->m_ShouldContinue)
     {
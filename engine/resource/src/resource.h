@@ -115,6 +115,9 @@ namespace dmResource
         /// Resource size on disc
         uint32_t m_ResourceSizeOnDisc;
 
+        /// Size of the data the resource was created from in place in the memory mapped archive, i.e. never copied
+        uint32_t m_ResourceSizeMapped;
+
         /// For internal use only
         void*    m_ResourceType;        // For internal use.
 
@@ -349,7 +352,10 @@ namespace dmResource
         EmbeddedResource m_ArchiveData;
         EmbeddedResource m_ArchiveManifest;
 
-        uint32_t m_Reserved[5];
+        /// Number of threads used by the preloader to load resources. Default is 1
+        uint32_t m_LoadThreadCount;
+
+        uint32_t m_Reserved[4];
 
         NewFactoryParams()
         {
@@ -398,6 +404,19 @@ namespace dmResource
                                FResourceDestroy destroy_function,
                                FResourceRecreate recreate_function);
 
+    /**
+     * Allow the Create function of a resource type to run on a load thread. When such a resource
+     * is loaded by a preloader it is created on the load thread right after the Preload function,
+     * and only the registration of the resource and the PostCreate function run on the main thread.
+     * The Create function must not call into the factory and must use the context in a thread safe manner.
+     * Resources whose Preload function calls PreloadHint are always created on the main thread.
+     * @param factory Factory handle
+     * @param extension File extension for resource
+     * @param thread_safe_create True if the Create function may be called from a load thread
+     * @return RESULT_OK on success
+     */
+    Result SetThreadSafeCreate(HFactory factory, const char* extension, bool thread_safe_create);
+
     /**
      * Get a resource from factory
      * @param factory Factory handle
@@ -684,6 +703,7 @@ namespace dmResource
         uint32_t m_SizeOnDisc;  // The size on disc (i.e. in the .darc file)
         uint32_t m_Size;        // in memory size, may be 0
         uint32_t m_RefCount;    // The current ref count
+        uint32_t m_SizeMapped;  // The size that was used in place from the memory mapped archive instead of being copied
     };
 
     typedef bool (*FResourceIterator)(const IteratorResource& resource, void* user_ctx);
@@ -922,6 +922,20 @@ namespace dmResourceArchive
         }
     }
 
+    Result GetMappedData(HArchiveIndexContainer archive, const EntryData* entry_data, const void** data)
+    {
+        // Liveupdate data is appended to while the game is running, so only bundled data is used in place
+        const uint32_t flags = ENTRY_FLAG_ENCRYPTED | ENTRY_FLAG_LIVEUPDATE_DATA;
+        if (!archive->m_ResourcesMemMapped || (entry_data->m_Flags & flags) || entry_data->m_ResourceCompressedSize != 0xFFFFFFFF)
+        {
+            *data = 0;
+            return RESULT_NOT_FOUND;
+        }
+
+        *data = (const void*) ((uintptr_t)archive->m_ResourceData + entry_data->m_ResourceDataOffset);
+        return RESULT_OK;
+    }
+
     uint32_t GetEntryCount(HArchiveIndexContainer archive)
     {
         return JAVA_TO_C(archive->m_ArchiveIndex->m_EntryDataCount);
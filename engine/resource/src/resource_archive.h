@@ -134,6 +134,17 @@ namespace dmResourceArchive
      */
     Result Read(HArchiveIndexContainer archive, EntryData* entry_data, void* buffer);
 
+    /**
+     * Get the resource data in place, without copying it. Only possible for uncompressed and
+     * unencrypted entries in a memory mapped (or wrapped) bundled archive. The data is valid
+     * until the archive is deleted.
+     * @param archive archive index handle
+     * @param entry_data entry data
+     * @param data pointer to the resource data
+     * @return RESULT_OK on success, RESULT_NOT_FOUND if the entry must be read with Read()
+     */
+    Result GetMappedData(HArchiveIndexContainer archive, const EntryData* entry_data, const void** data);
+
     /**
      * Delete archive index. Only required for archives created with LoadArchive function
      * @param archive archive index handle
@@ -100,6 +100,8 @@ namespace dmResource
         // Set for items that are pending and waiting for children to complete
         void* m_Buffer;
         uint32_t m_BufferSize;
+        // Set if m_Buffer points into the memory mapped archive rather than being a copy
+        bool m_BufferMapped;
 
         // Set once preload function has run
         void* m_PreloadData;
@@ -506,55 +508,12 @@ namespace dmResource
         return NewPreloader(factory, names);
     }
 
-    // CreateResource operation ends either with
-    //   1) Having created the resource and free:d all buffers => RESULT_OK + m_Resource
-    //   2) Having failed, (or created and destroyed), leaving => RESULT_SOME_ERROR + everything free:d
-    //
-    // If buffer is null it means to use the items internal buffer
-    static void CreateResource(HPreloader preloader, PreloadRequest* req, void* buffer, uint32_t buffer_size)
+    // Registers a resource created by CreateResource, or by the load queue on the load thread
+    static void RegisterResource(HPreloader preloader, PreloadRequest* req, SResourceDescriptor* created_resource)
     {
-        assert(req->m_LoadResult == RESULT_PENDING);
-        assert(req->m_PendingChildCount == 0);
-
-        assert(req->m_PathDescriptor.m_ResourceType);
-
-        SResourceDescriptor tmp_resource;
-        memset(&tmp_resource, 0, sizeof(tmp_resource));
-
+        SResourceDescriptor& tmp_resource = *created_resource;
         SResourceType* resource_type = req->m_PathDescriptor.m_ResourceType;
 
-        // We must call CreateFunction if Preload function has been called, so always do this even when an error has occured
-        tmp_resource.m_NameHash       = req->m_PathDescriptor.m_CanonicalPathHash;
-        tmp_resource.m_ReferenceCount = 1;
-        tmp_resource.m_ResourceType   = (void*)resource_type;
-
-        ResourceCreateParams params;
-        params.m_Factory     = preloader->m_Factory;
-        params.m_Context     = resource_type->m_Context;
-        params.m_PreloadData = req->m_PreloadData;
-        params.m_Resource    = &tmp_resource;
-        params.m_Filename    = req->m_PathDescriptor.m_InternalizedName;
-
-        if (!buffer)
-        {
-            assert(req->m_Buffer);
-            tmp_resource.m_ResourceSizeOnDisc = req->m_BufferSize;
-            params.m_Buffer                   = req->m_Buffer;
-            params.m_BufferSize               = req->m_BufferSize;
-            req->m_LoadResult                 = resource_type->m_CreateFunction(params);
-
-            dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
-
-            req->m_Buffer = 0;
-        }
-        else
-        {
-            tmp_resource.m_ResourceSizeOnDisc = buffer_size;
-            params.m_Buffer                   = buffer;
-            params.m_BufferSize               = buffer_size;
-            req->m_LoadResult                 = resource_type->m_CreateFunction(params);
-        }
-
         if (req->m_LoadResult == RESULT_OK)
         {
             if (resource_type->m_PostCreateFunction)
@@ -664,6 +623,64 @@ namespace dmResource
         }
     }
 
+    // CreateResource operation ends either with
+    //   1) Having created the resource and free:d all buffers => RESULT_OK + m_Resource
+    //   2) Having failed, (or created and destroyed), leaving => RESULT_SOME_ERROR + everything free:d
+    //
+    // If buffer is null it means to use the items internal buffer
+    static void CreateResource(HPreloader preloader, PreloadRequest* req, void* buffer, uint32_t buffer_size, bool buffer_mapped)
+    {
+        assert(req->m_LoadResult == RESULT_PENDING);
+        assert(req->m_PendingChildCount == 0);
+
+        assert(req->m_PathDescriptor.m_ResourceType);
+
+        SResourceDescriptor tmp_resource;
+        memset(&tmp_resource, 0, sizeof(tmp_resource));
+
+        SResourceType* resource_type = req->m_PathDescriptor.m_ResourceType;
+
+        // We must call CreateFunction if Preload function has been called, so always do this even when an error has occured
+        tmp_resource.m_NameHash       = req->m_PathDescriptor.m_CanonicalPathHash;
+        tmp_resource.m_ReferenceCount = 1;
+        tmp_resource.m_ResourceType   = (void*)resource_type;
+
+        ResourceCreateParams params;
+        params.m_Factory     = preloader->m_Factory;
+        params.m_Context     = resource_type->m_Context;
+        params.m_PreloadData = req->m_PreloadData;
+        params.m_Resource    = &tmp_resource;
+        params.m_Filename    = req->m_PathDescriptor.m_InternalizedName;
+
+        if (!buffer)
+        {
+            assert(req->m_Buffer);
+            tmp_resource.m_ResourceSizeOnDisc = req->m_BufferSize;
+            tmp_resource.m_ResourceSizeMapped = req->m_BufferMapped ? req->m_BufferSize : 0;
+            params.m_Buffer                   = req->m_Buffer;
+            params.m_BufferSize               = req->m_BufferSize;
+            req->m_LoadResult                 = resource_type->m_CreateFunction(params);
+
+            if (!req->m_BufferMapped)
+            {
+                dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
+            }
+
+            req->m_Buffer       = 0;
+            req->m_BufferMapped = false;
+        }
+        else
+        {
+            tmp_resource.m_ResourceSizeOnDisc = buffer_size;
+            tmp_resource.m_ResourceSizeMapped = buffer_mapped ? buffer_size : 0;
+            params.m_Buffer                   = buffer;
+            params.m_BufferSize               = buffer_size;
+            req->m_LoadResult                 = resource_type->m_CreateFunction(params);
+        }
+
+        RegisterResource(preloader, req, &tmp_resource);
+    }
+
     // Try to create the resource of the parent if all the child requests has been
     // resolved. We continue up the parent chain until we find a parent where all
     // children are not resolved and we break
@@ -680,7 +697,7 @@ namespace dmResource
         {
             return false;
         }
-        CreateResource(preloader, parent_req, 0, 0);
+        CreateResource(preloader, parent_req, 0, 0, false);
         UnmarkPathInProgress(preloader, &parent_req->m_PathDescriptor);
         PreloaderTryPruneParent(preloader, parent_req);
         return true;
@@ -717,13 +734,26 @@ namespace dmResource
 
         bool created_resource = false;
 
+        if (req->m_LoadResult == RESULT_PENDING && load_result.m_CreateResult != RESULT_PENDING)
+        {
+            // Created on the load thread, only the registration remains
+            req->m_LoadResult = load_result.m_CreateResult;
+            RegisterResource(preloader, req, &load_result.m_Resource);
+            UnmarkPathInProgress(preloader, &req->m_PathDescriptor);
+            dmLoadQueue::FreeLoad(preloader->m_LoadQueue, req->m_LoadRequest);
+            req->m_LoadRequest = 0;
+
+            PreloaderTryPruneParent(preloader, req);
+            return true;
+        }
+
         // If no children, do the create step immediately with the buffer in place
         if (req->m_FirstChild == -1)
         {
             if (req->m_LoadResult == RESULT_PENDING)
             {
                 // Create the resource using the loading buffer directly.
-                CreateResource(preloader, req, buffer, buffer_size);
+                CreateResource(preloader, req, buffer, buffer_size, load_result.m_Mapped);
                 created_resource = true;
             }
             UnmarkPathInProgress(preloader, &req->m_PathDescriptor);
@@ -734,10 +764,18 @@ namespace dmResource
         }
         else
         {
-            // Keep the loaded bytes until we have loaded all children
-            req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
-            memcpy(req->m_Buffer, buffer, buffer_size);
-            req->m_BufferSize = buffer_size;
+            // Keep the loaded bytes until we have loaded all children, data in the memory mapped archive outlives the preloader
+            if (load_result.m_Mapped)
+            {
+                req->m_Buffer = buffer;
+            }
+            else
+            {
+                req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
+                memcpy(req->m_Buffer, buffer, buffer_size);
+            }
+            req->m_BufferSize   = buffer_size;
+            req->m_BufferMapped = load_result.m_Mapped;
             dmLoadQueue::FreeLoad(preloader->m_LoadQueue, req->m_LoadRequest);
             req->m_LoadRequest = 0;
         }
@@ -855,10 +893,18 @@ namespace dmResource
         }
 
         dmLoadQueue::PreloadInfo info;
+        SResourceType* resource_type = req->m_PathDescriptor.m_ResourceType;
         info.m_HintInfo.m_Preloader = preloader;
         info.m_HintInfo.m_Parent    = index;
-        info.m_Function             = req->m_PathDescriptor.m_ResourceType->m_PreloadFunction;
-        info.m_Context              = req->m_PathDescriptor.m_ResourceType->m_Context;
+        info.m_HintInfo.m_HintCount = 0;
+        info.m_Function             = resource_type->m_PreloadFunction;
+        info.m_Context              = resource_type->m_Context;
+        // A request that already has children (e.g. the extra names of NewPreloader) must wait for them before it is created
+        info.m_CreateFunction       = (resource_type->m_ThreadSafeCreate && req->m_FirstChild == -1) ? resource_type->m_CreateFunction : 0;
+        info.m_ResourceType         = resource_type;
+        info.m_CanonicalPathHash    = req->m_PathDescriptor.m_CanonicalPathHash;
+        // Resources with a preload function hint their dependencies, so they are on the critical path of the preloader
+        info.m_Priority             = resource_type->m_PreloadFunction ? 1 : 0;
 
         // If we can't add the request to the load queue it is because the queue is full
         // We will try again once we completed loading of an item via dmLoadQueue::EndLoad
@@ -1046,6 +1092,9 @@ namespace dmResource
 
         HPreloader preloader = info->m_Preloader;
 
+        // Counted even if the hint fails, since the Create function will then get the resource itself
+        info->m_HintCount++;
+
         PathDescriptor path_descriptor;
         Result res = MakePathDescriptor(info->m_Preloader, name, path_descriptor);
         if (res != RESULT_OK)
@@ -44,6 +44,7 @@ namespace dmResource
         FResourcePostCreate m_PostCreateFunction;
         FResourceDestroy    m_DestroyFunction;
         FResourceRecreate   m_RecreateFunction;
+        bool                m_ThreadSafeCreate;
     };
 
     typedef dmArray<char> LoadBufferType;
@@ -53,9 +54,10 @@ namespace dmResource
     Result CheckSuppliedResourcePath(const char* name);
 
     // load with default internal buffer and its management, returns buffer ptr in 'buffer'
-    Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size);
-    // load with own buffer
-    Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer);
+    // 'mapped' is set if the returned buffer points straight into the memory mapped archive
+    Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size, bool* mapped);
+    // load with own buffer, or in place in the memory mapped archive if mapped_data is set (which leaves the buffer empty)
+    Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, const void** mapped_data);
 
     Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, SResourceDescriptor* descriptor);
     uint32_t GetCanonicalPath(const char* relative_dir, char* buf);
@@ -64,6 +66,8 @@ namespace dmResource
     SResourceType* FindResourceType(SResourceFactory* factory, const char* extension);
     uint32_t GetRefCount(HFactory factory, void* resource);
     uint32_t GetRefCount(HFactory factory, dmhash_t identifier);
+    // Number of threads each preloader uses to load resources
+    uint32_t GetLoadThreadCount(HFactory factory);
 
     /**
      * The manifest has a signature embedded. This signature is created when bundling by hashing the manifest content
@@ -93,6 +97,8 @@ namespace dmResource
     {
         HPreloader m_Preloader;
         int32_t m_Parent;
+        // Number of PreloadHint calls, a resource with dependencies is not created on the load thread
+        uint32_t m_HintCount;
     };
 }
 
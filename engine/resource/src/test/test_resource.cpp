@@ -10,6 +10,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <dlib/atomic.h>
 #include <dlib/log.h>
 
 #include <dlib/socket.h>
@@ -23,6 +24,7 @@
 #include "resource_ddf.h"
 #include "../resource.h"
 #include "../resource_private.h"
+#include "../async/load_queue.h"
 #include "test/test_resource_ddf.h"
 
 #define JC_TEST_IMPLEMENTATION
@@ -820,6 +822,202 @@ TEST_P(GetResourceTest, PreloadGetAbort)
 }
 
 
+TEST_P(GetResourceTest, PreloadThreadSafeCreate)
+{
+    ASSERT_EQ(dmResource::RESULT_UNKNOWN_RESOURCE_TYPE, dmResource::SetThreadSafeCreate(m_Factory, "does_not_exist", true));
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetThreadSafeCreate(m_Factory, "foo", true));
+    // The container hints its children and gets them in Create, so it must still be created on the main thread
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetThreadSafeCreate(m_Factory, "cont", true));
+
+    TestResourceContainer* resource = 0;
+    dmResource::Result e = PreloaderGet(m_Factory, m_ResourceName, (void**) &resource);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_NE((void*) 0, resource);
+    ASSERT_EQ(2U, resource->m_Resources.size());
+    ASSERT_EQ(1U, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ(2U, m_FooResourceCreateCallCount);
+    ASSERT_EQ(2U, m_FooResourcePostCreateCallCount);
+
+    dmResource::Release(m_Factory, resource);
+    ASSERT_EQ(1U, m_ResourceContainerDestroyCallCount);
+    ASSERT_EQ(2U, m_FooResourceDestroyCallCount);
+}
+
+// The thread calling UpdatePreloader, and the number of SlowFooResourceCreate calls in total and on that thread
+static dmThread::Thread g_PreloaderMainThread;
+static int32_atomic_t g_CreateCount = 0;
+static uint32_t g_MainThreadCreateCount = 0;
+
+// Emulates a resource with an expensive parse/decode step in Create
+static dmResource::Result SlowFooResourceCreate(const dmResource::ResourceCreateParams& params)
+{
+    dmAtomicIncrement32(&g_CreateCount);
+    if (dmThread::GetCurrentThread() == g_PreloaderMainThread)
+    {
+        ++g_MainThreadCreateCount;
+    }
+
+    TestResource::ResourceFoo* resource_foo;
+    dmDDF::Result e = dmDDF::LoadMessage(params.m_Buffer, params.m_BufferSize, &TestResource_ResourceFoo_DESCRIPTOR, (void**) &resource_foo);
+    if (e != dmDDF::RESULT_OK)
+    {
+        return dmResource::RESULT_FORMAT_ERROR;
+    }
+
+    uint64_t end = dmTime::GetTime() + 2000;
+    while (dmTime::GetTime() < end)
+    {
+    }
+
+    params.m_Resource->m_Resource = (void*) resource_foo;
+    return dmResource::RESULT_OK;
+}
+
+static dmResource::Result SlowFooResourceDestroy(const dmResource::ResourceDestroyParams& params)
+{
+    dmDDF::FreeMessage(params.m_Resource->m_Resource);
+    return dmResource::RESULT_OK;
+}
+
+// Returns the time spent in UpdatePreloader, i.e. on the main thread, per loaded resource
+static uint64_t PreloaderMainThreadTime(bool thread_safe_create)
+{
+    g_PreloaderMainThread = dmThread::GetCurrentThread();
+    dmAtomicStore32(&g_CreateCount, 0);
+    g_MainThreadCreateCount = 0;
+
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, "build/default/src/test/");
+    if (!factory)
+        return 0;
+    dmResource::RegisterType(factory, "foo", 0, 0, &SlowFooResourceCreate, 0, &SlowFooResourceDestroy, 0);
+    dmResource::SetThreadSafeCreate(factory, "foo", thread_safe_create);
+
+    const char* names[] = { "/test01.foo", "/test02.foo" };
+    dmArray<const char*> resource_names(names, 2, 2);
+
+    const uint32_t iterations = 50;
+    uint64_t main_thread_time = 0;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmResource::HPreloader pr = dmResource::NewPreloader(factory, resource_names);
+        dmResource::Result r = dmResource::RESULT_PENDING;
+        while (r == dmResource::RESULT_PENDING)
+        {
+            uint64_t start = dmTime::GetTime();
+            // No time limit, so that the preloader returns instead of waiting for the load thread
+            r = dmResource::UpdatePreloader(pr, 0, 0, 0);
+            main_thread_time += dmTime::GetTime() - start;
+            dmTime::Sleep(500);
+        }
+        dmResource::DeletePreloader(pr);
+        if (r != dmResource::RESULT_OK)
+        {
+            main_thread_time = 0;
+            break;
+        }
+    }
+
+    dmResource::DeleteFactory(factory);
+    return main_thread_time / (iterations * resource_names.Size());
+}
+
+TEST(PreloaderPerformance, MainThreadTime)
+{
+    // 50 iterations of two resources
+    uint64_t main_thread_create = PreloaderMainThreadTime(false);
+    ASSERT_EQ(100, dmAtomicAdd32(&g_CreateCount, 0));
+    ASSERT_EQ(100U, g_MainThreadCreateCount);
+
+    // The slow create no longer runs in UpdatePreloader, except for the root which waits for the second resource
+    uint64_t load_thread_create = PreloaderMainThreadTime(true);
+    ASSERT_EQ(100, dmAtomicAdd32(&g_CreateCount, 0));
+    ASSERT_EQ(50U, g_MainThreadCreateCount);
+
+    printf("Main thread time per resource: %u us (create on main thread), %u us (create on load thread)\n", (uint32_t) main_thread_create, (uint32_t) load_thread_create);
+}
+
+
+TEST(LoadQueue, LoadThreads)
+{
+    const char* names[] = { "/test01.foo", "/test02.foo" };
+    const uint32_t thread_counts[] = { 1, 2, 4 };
+    const uint32_t request_count = 64;
+
+    for (uint32_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t)
+    {
+        dmResource::NewFactoryParams params;
+        params.m_MaxResources = 16;
+        params.m_LoadThreadCount = thread_counts[t];
+        dmResource::HFactory factory = dmResource::NewFactory(&params, "build/default/src/test/");
+        ASSERT_NE((void*) 0, factory);
+
+        uint32_t expected_size[2];
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            void* buffer;
+            ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetRaw(factory, names[i], &buffer, &expected_size[i]));
+            free(buffer);
+        }
+
+        dmLoadQueue::HQueue queue = dmLoadQueue::CreateQueue(factory);
+        dmLoadQueue::HRequest requests[request_count];
+        uint32_t request_name[request_count];
+        uint32_t issued = 0;
+        uint32_t completed = 0;
+        uint64_t start = dmTime::GetTime();
+        while (completed < request_count)
+        {
+            while (issued < request_count)
+            {
+                dmLoadQueue::PreloadInfo info;
+                memset(&info, 0, sizeof(info));
+                info.m_Priority = issued % 3;
+                request_name[issued] = issued % 2;
+                requests[issued] = dmLoadQueue::BeginLoad(queue, names[request_name[issued]], names[request_name[issued]], &info);
+                if (!requests[issued])
+                    break;
+                ++issued;
+            }
+
+            // Requests may complete in any order when more than one thread is loading
+            for (uint32_t i = 0; i < issued; ++i)
+            {
+                if (!requests[i])
+                    continue;
+                void* buffer;
+                uint32_t size;
+                dmLoadQueue::LoadResult result;
+                if (dmLoadQueue::EndLoad(queue, requests[i], &buffer, &size, &result) == dmLoadQueue::RESULT_OK)
+                {
+                    ASSERT_EQ(dmResource::RESULT_OK, result.m_LoadResult);
+                    ASSERT_EQ(dmResource::RESULT_OK, result.m_PreloadResult);
+                    ASSERT_EQ(expected_size[request_name[i]], size);
+                    dmLoadQueue::FreeLoad(queue, requests[i]);
+                    requests[i] = 0;
+                    ++completed;
+                }
+            }
+        }
+        uint64_t elapsed = dmTime::GetTime() - start;
+
+        dmLoadQueue::QueueStats stats;
+        dmLoadQueue::GetStats(queue, &stats);
+        ASSERT_EQ(request_count, stats.m_RequestsLoaded);
+        ASSERT_EQ(0U, stats.m_QueueDepth);
+        ASSERT_EQ((uint64_t) request_count * (expected_size[0] + expected_size[1]) / 2, stats.m_BytesLoaded);
+        ASSERT_GE(stats.m_TotalLatency, stats.m_MaxLatency);
+        printf("Load threads: %u, requests: %u, max queue depth: %u, bytes/s: %u, avg latency: %u us, max latency: %u us\n",
+            stats.m_ThreadCount, stats.m_RequestsLoaded, stats.m_MaxQueueDepth,
+            (uint32_t) (elapsed ? stats.m_BytesLoaded * 1000000 / elapsed : 0),
+            (uint32_t) (stats.m_TotalLatency / stats.m_RequestsLoaded), (uint32_t) stats.m_MaxLatency);
+
+        dmLoadQueue::DeleteQueue(queue);
+        dmResource::DeleteFactory(factory);
+    }
+}
+
 dmResource::Result RecreateResourceCreate(const dmResource::ResourceCreateParams& params)
 {
     const int TMP_BUFFER_SIZE = 64;
@@ -936,6 +1134,59 @@ TEST(dmResource, Builtins)
     dmResource::DeleteFactory(factory);
 }
 
+static const void* g_MappedCreateBuffer = 0;
+
+static dmResource::Result MappedResourceCreate(const dmResource::ResourceCreateParams& params)
+{
+    g_MappedCreateBuffer = params.m_Buffer;
+    return AdResourceCreate(params);
+}
+
+static bool MappedResourceIterator(const dmResource::IteratorResource& resource, void* user_ctx)
+{
+    uint32_t* count = (uint32_t*) user_ctx;
+    if (resource.m_SizeMapped == resource.m_SizeOnDisc)
+    {
+        (*count)++;
+    }
+    return true;
+}
+
+TEST(dmResource, BuiltinsMapped)
+{
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+
+    params.m_ArchiveIndex.m_Data    = (const void*) RESOURCES_ARCI;
+    params.m_ArchiveIndex.m_Size    = RESOURCES_ARCI_SIZE;
+
+    params.m_ArchiveData.m_Data     = (const void*) RESOURCES_ARCD;
+    params.m_ArchiveData.m_Size     = RESOURCES_ARCD_SIZE;
+
+    params.m_ArchiveManifest.m_Data = (const void*) RESOURCES_DMANIFEST;
+    params.m_ArchiveManifest.m_Size = RESOURCES_DMANIFEST_SIZE;
+
+    dmResource::HFactory factory = dmResource::NewFactory(&params, ".");
+    ASSERT_NE((void*) 0, factory);
+
+    dmResource::RegisterType(factory, "adc", 0, 0, MappedResourceCreate, 0, AdResourceDestroy, 0);
+
+    // The archive is uncompressed, so the resource is created straight from the archive data
+    void* resource;
+    g_MappedCreateBuffer = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(factory, "/archive_data/file1.adc", &resource));
+    ASSERT_STREQ("file1_datafile1_datafile1_data", (const char*) resource);
+    ASSERT_GE((uintptr_t) g_MappedCreateBuffer, (uintptr_t) RESOURCES_ARCD);
+    ASSERT_LT((uintptr_t) g_MappedCreateBuffer, (uintptr_t) RESOURCES_ARCD + RESOURCES_ARCD_SIZE);
+
+    uint32_t mapped_count = 0;
+    dmResource::IterateResources(factory, MappedResourceIterator, &mapped_count);
+    ASSERT_EQ(1U, mapped_count);
+
+    dmResource::Release(factory, resource);
+    dmResource::DeleteFactory(factory);
+}
+
 struct ReloadData {
     ReloadData(): m_Old(0), m_New(0) {}
     int m_Old;
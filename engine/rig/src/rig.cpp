@@ -14,6 +14,15 @@
 
 #include <dlib/log.h>
 #include <dlib/profile.h>
+#include <dlib/static_assert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_RIG_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define DM_RIG_NEON
+    #include <arm_neon.h>
+#endif
 
 namespace dmRig
 {
@@ -23,10 +32,12 @@ namespace dmRig
     static const float CURSOR_EPSILON = 0.0001f;
     static const int SIGNAL_DELTA_UNCHANGED = 0x10cced; // Used to indicate if a draw order was unchanged for a certain slot
     static const uint32_t INVALID_ATTACHMENT_INDEX = 0xffffffffu;
+    // An instance takes about 0.5 us to animate, and the worker pool adds 0.1-0.3 us per instance plus waking the workers
+    static const uint32_t DEFAULT_MIN_PARALLEL_INSTANCE_COUNT = 128;
 
     static const float white[] = {1.0f, 1.0f, 1.0, 1.0f};
 
-    static void DoAnimate(HRigContext context, RigInstance* instance, float dt);
+    static int DoAnimate(RigInstance* instance, float dt, dmArray<int32_t>& draw_order_deltas);
     static bool DoPostUpdate(RigInstance* instance);
     static void UpdateSlotDrawOrder(dmArray<int32_t>& draw_order, dmArray<int32_t>& deltas, int changed, dmArray<int32_t>& unchanged);
 
@@ -39,8 +50,11 @@ namespace dmRig
         }
 
         context->m_Instances.SetCapacity(params.m_MaxRigInstanceCount);
+        context->m_WorkerPool = params.m_WorkerPool;
+        context->m_MinParallelInstanceCount = params.m_MinParallelInstanceCount ? params.m_MinParallelInstanceCount : DEFAULT_MIN_PARALLEL_INSTANCE_COUNT;
         context->m_ScratchPoseTransformBuffer.SetCapacity(0);
         context->m_ScratchPoseMatrixBuffer.SetCapacity(0);
+        context->m_ScratchSkinMatrixBuffer.SetCapacity(0);
 
         return dmRig::RESULT_OK;
     }
@@ -132,6 +146,7 @@ namespace dmRig
         player->m_BlendFinished = blend_duration > 0.0f ? 0 : 1;
         player->m_AnimationId = animation_id;
         player->m_Animation = anim;
+        player->m_CompressedAnimation = instance->m_CompressedAnimationSet ? &instance->m_CompressedAnimationSet->m_Animations[anim - instance->m_AnimationSet->m_Animations.m_Data] : 0x0;
         player->m_Playing = 1;
         player->m_Playback = playback;
 
@@ -270,6 +285,23 @@ namespace dmRig
         return duration;
     }
 
+    static void SendEvent(HRigInstance instance, RigEventType event_type, const void* event_data, uint32_t event_data_size)
+    {
+        if (instance->m_Deferred)
+        {
+            if (instance->m_DeferredEvents.Full())
+            {
+                instance->m_DeferredEvents.OffsetCapacity(8);
+            }
+            RigDeferredEvent event;
+            event.m_Type = event_type;
+            memcpy(&event.m_Keyframe, event_data, event_data_size);
+            instance->m_DeferredEvents.Push(event);
+            return;
+        }
+        instance->m_EventCallback(event_type, (void*)event_data, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
+    }
+
     static void PostEventsInterval(HRigInstance instance, const dmRigDDF::RigAnimation* animation, float start_cursor, float end_cursor, float duration, bool backwards, float blend_weight)
     {
         const uint32_t track_count = animation->m_EventTracks.m_Count;
@@ -294,7 +326,7 @@ namespace dmRig
                     event_data.m_Float = key->m_Float;
                     event_data.m_String = key->m_String;
 
-                    instance->m_EventCallback(RIG_EVENT_TYPE_KEYFRAME, (void*)&event_data, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
+                    SendEvent(instance, RIG_EVENT_TYPE_KEYFRAME, &event_data, sizeof(event_data));
                 }
             }
         }
@@ -409,7 +441,7 @@ namespace dmRig
                 event_data.m_AnimationId = player->m_AnimationId;
                 event_data.m_Playback = player->m_Playback;
 
-                instance->m_EventCallback(RIG_EVENT_TYPE_COMPLETED, (void*)&event_data, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
+                SendEvent(instance, RIG_EVENT_TYPE_COMPLETED, &event_data, sizeof(event_data));
             }
         }
 
@@ -435,6 +467,115 @@ namespace dmRig
         return slerp(frac, Quat(data[i+0], data[i+1], data[i+2], data[i+3]), Quat(data[i+0+4], data[i+1+4], data[i+2+4], data[i+3+4]));
     }
 
+    // Max magnitude of the three smallest components of a unit quaternion, 1 / sqrt(2)
+    static const float QUAT_COMPONENT_RANGE = 0.70710678f;
+    static const uint16_t QUAT_COMPONENT_MAX = 0x7fff;
+
+    static inline Quat DequantizeQuat(const uint16_t* q)
+    {
+        // The index of the largest component is stored in the top bits of the first two values
+        uint32_t largest = (q[0] >> 15) | ((q[1] >> 15) << 1);
+        float c[4];
+        float sum = 0.0f;
+        for (uint32_t i = 0, j = 0; i < 4; ++i)
+        {
+            if (i == largest)
+                continue;
+            float v = ((q[j++] & QUAT_COMPONENT_MAX) * (2.0f / QUAT_COMPONENT_MAX) - 1.0f) * QUAT_COMPONENT_RANGE;
+            c[i] = v;
+            sum += v * v;
+        }
+        c[largest] = sqrtf(dmMath::Max(0.0f, 1.0f - sum));
+        return Quat(c[0], c[1], c[2], c[3]);
+    }
+
+    static inline Vector3 DequantizeVec3(const CompressedTrack* track, const uint16_t* q)
+    {
+        return Vector3(track->m_Min[0] + q[0] * track->m_Step[0], track->m_Min[1] + q[1] * track->m_Step[1], track->m_Min[2] + q[2] * track->m_Step[2]);
+    }
+
+    static void ApplyCompressedAnimation(const CompressedAnimation* animation, uint32_t sample, float fraction, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, uint32_t animated_bone_count, float blend_weight)
+    {
+        const uint16_t* frame0 = 0x0;
+        const uint16_t* frame1 = 0x0;
+        if (animation->m_FrameCount > 0)
+        {
+            uint32_t last_frame = animation->m_FrameCount - 1;
+            frame0 = &animation->m_Frames[dmMath::Min(sample, last_frame) * animation->m_FrameSize];
+            frame1 = &animation->m_Frames[dmMath::Min(sample + 1, last_frame) * animation->m_FrameSize];
+        }
+        const float* constants = animation->m_Constants.Empty() ? 0x0 : &animation->m_Constants[0];
+
+        uint32_t track_count = animation->m_Tracks.Size();
+        for (uint32_t ti = 0; ti < track_count; ++ti)
+        {
+            const CompressedTrack* track = &animation->m_Tracks[ti];
+            uint32_t bone_index = track->m_BoneIndex;
+            if (bone_index >= track_idx_to_pose.Size()) {
+                continue;
+            }
+            uint32_t pose_index = track_idx_to_pose[bone_index];
+            if (pose_index >= animated_bone_count) {
+                continue;
+            }
+            dmTransform::Transform& transform = pose[pose_index];
+            uint32_t offset = track->m_Offset;
+            switch (track->m_Type)
+            {
+            case COMPRESSED_TRACK_ROTATION:
+            {
+                Quat q = track->m_Constant ?
+                    Quat(constants[offset+0], constants[offset+1], constants[offset+2], constants[offset+3]) :
+                    slerp(fraction, DequantizeQuat(frame0 + offset), DequantizeQuat(frame1 + offset));
+                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), q));
+                break;
+            }
+            case COMPRESSED_TRACK_TRANSLATION:
+            case COMPRESSED_TRACK_SCALE:
+            {
+                Vector3 v = track->m_Constant ?
+                    Vector3(constants[offset+0], constants[offset+1], constants[offset+2]) :
+                    lerp(fraction, DequantizeVec3(track, frame0 + offset), DequantizeVec3(track, frame1 + offset));
+                if (track->m_Type == COMPRESSED_TRACK_TRANSLATION)
+                    transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), v));
+                else
+                    transform.SetScale(lerp(blend_weight, transform.GetScale(), v));
+                break;
+            }
+            }
+        }
+    }
+
+    static void ApplyAnimationTracks(const dmRigDDF::RigAnimation* animation, uint32_t sample, float fraction, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, uint32_t animated_bone_count, float blend_weight)
+    {
+        uint32_t track_count = animation->m_Tracks.m_Count;
+        for (uint32_t ti = 0; ti < track_count; ++ti)
+        {
+            const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
+            uint32_t bone_index = track->m_BoneIndex;
+            if (bone_index >= track_idx_to_pose.Size()) {
+                continue;
+            }
+            uint32_t pose_index = track_idx_to_pose[bone_index];
+            if (pose_index >= animated_bone_count) {
+                continue;
+            }
+            dmTransform::Transform& transform = pose[pose_index];
+            if (track->m_Positions.m_Count > 0)
+            {
+                transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), SampleVec3(sample, fraction, track->m_Positions.m_Data)));
+            }
+            if (track->m_Rotations.m_Count > 0)
+            {
+                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), SampleQuat(sample, fraction, track->m_Rotations.m_Data)));
+            }
+            if (track->m_Scale.m_Count > 0)
+            {
+                transform.SetScale(lerp(blend_weight, transform.GetScale(), SampleVec3(sample, fraction, track->m_Scale.m_Data)));
+            }
+        }
+    }
+
     static float CursorToTime(float cursor, float duration, bool backwards, bool once_pingpong)
     {
         float t = cursor;
@@ -511,7 +652,7 @@ namespace dmRig
         child_t.SetRotation( dmVMath::QuatFromAngle(2, childRotation) );
     }
 
-    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
+    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, uint32_t animated_bone_count, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
     {
         const dmRigDDF::RigAnimation* animation = player->m_Animation;
         if (animation == 0x0)
@@ -524,31 +665,16 @@ namespace dmRig
         uint32_t rounded_sample = (uint32_t)(fraction + 0.5f);
         fraction -= sample;
         // Sample animation tracks
-        uint32_t track_count = animation->m_Tracks.m_Count;
-        for (uint32_t ti = 0; ti < track_count; ++ti)
+        if (player->m_CompressedAnimation)
         {
-            const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
-            uint32_t bone_index = track->m_BoneIndex;
-            if (bone_index >= track_idx_to_pose.Size()) {
-                continue;
-            }
-            uint32_t pose_index = track_idx_to_pose[bone_index];
-            dmTransform::Transform& transform = pose[pose_index];
-            if (track->m_Positions.m_Count > 0)
-            {
-                transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), SampleVec3(sample, fraction, track->m_Positions.m_Data)));
-            }
-            if (track->m_Rotations.m_Count > 0)
-            {
-                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), SampleQuat(sample, fraction, track->m_Rotations.m_Data)));
-            }
-            if (track->m_Scale.m_Count > 0)
-            {
-                transform.SetScale(lerp(blend_weight, transform.GetScale(), SampleVec3(sample, fraction, track->m_Scale.m_Data)));
-            }
+            ApplyCompressedAnimation(player->m_CompressedAnimation, sample, fraction, pose, track_idx_to_pose, animated_bone_count, blend_weight);
+        }
+        else
+        {
+            ApplyAnimationTracks(animation, sample, fraction, pose, track_idx_to_pose, animated_bone_count, blend_weight);
         }
 
-        track_count = animation->m_IkTracks.m_Count;
+        uint32_t track_count = animation->m_IkTracks.m_Count;
         for (uint32_t ti = 0; ti < track_count; ++ti)
         {
             const dmRigDDF::IKAnimationTrack* track = &animation->m_IkTracks[ti];
@@ -598,6 +724,77 @@ namespace dmRig
         }
     }
 
+    // Advances the players and posts their events, without sampling the pose
+    static void AdvancePlayers(RigInstance* instance, float dt)
+    {
+        UpdateBlend(instance, dt);
+        RigPlayer* player = GetPlayer(instance);
+        if (instance->m_Blending)
+        {
+            float fade_rate = instance->m_BlendTimer / instance->m_BlendDuration;
+            for (uint32_t pi = 0; pi < 2; ++pi)
+            {
+                RigPlayer* p = &instance->m_Players[pi];
+                UpdatePlayer(instance, p, dt, player == p ? fade_rate : 1.0f - fade_rate);
+            }
+        }
+        else
+        {
+            UpdatePlayer(instance, player, dt, 1.0f);
+        }
+    }
+
+    static void StoreSampledPose(RigInstance* instance)
+    {
+        const dmArray<dmTransform::Transform>& pose = instance->m_Pose;
+        dmArray<dmTransform::Transform>& prev_pose = instance->m_PrevSampledPose;
+        dmArray<dmTransform::Transform>& sampled_pose = instance->m_SampledPose;
+        uint32_t bone_count = pose.Size();
+        // The first sample has nothing to interpolate from
+        bool first = sampled_pose.Empty();
+        if (sampled_pose.Capacity() < bone_count)
+        {
+            sampled_pose.SetCapacity(bone_count);
+            prev_pose.SetCapacity(bone_count);
+        }
+        sampled_pose.SetSize(bone_count);
+        prev_pose.SetSize(bone_count);
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            prev_pose[bi] = first ? pose[bi] : sampled_pose[bi];
+            sampled_pose[bi] = pose[bi];
+        }
+        instance->m_UpdatesSinceSample = 0;
+    }
+
+    // The pose reaches the last sampled pose the update before the next one is sampled
+    static void InterpolatePose(RigInstance* instance)
+    {
+        dmArray<dmTransform::Transform>& pose = instance->m_Pose;
+        const dmArray<dmTransform::Transform>& prev_pose = instance->m_PrevSampledPose;
+        const dmArray<dmTransform::Transform>& sampled_pose = instance->m_SampledPose;
+        float t = (instance->m_UpdatesSinceSample + 1) / (float)instance->m_LOD.m_UpdateInterval;
+        uint32_t bone_count = pose.Size();
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            const dmTransform::Transform& t0 = prev_pose[bi];
+            const dmTransform::Transform& t1 = sampled_pose[bi];
+            dmTransform::Transform& transform = pose[bi];
+            transform.SetTranslation(lerp(t, t0.GetTranslation(), t1.GetTranslation()));
+            transform.SetRotation(slerp(t, t0.GetRotation(), t1.GetRotation()));
+            transform.SetScale(lerp(t, t0.GetScale(), t1.GetScale()));
+        }
+    }
+
+    static void AnimateInstance(HRigContext context, RigInstance* instance, float dt)
+    {
+        int slot_changed = DoAnimate(instance, dt, context->m_ScratchDrawOrderDeltas);
+        // Update draw order after animation
+        if (slot_changed > 0) {
+            UpdateSlotDrawOrder(instance->m_DrawOrder, context->m_ScratchDrawOrderDeltas, slot_changed, context->m_ScratchDrawOrderUnchanged);
+        }
+    }
+
     static void Animate(HRigContext context, float dt)
     {
         DM_PROFILE(Rig, "Animate");
@@ -607,15 +804,119 @@ namespace dmRig
         for (uint32_t i = 0; i < n; ++i)
         {
             RigInstance* instance = instances[i];
-            DoAnimate(context, instance, dt);
+            AnimateInstance(context, instance, dt);
+        }
+    }
+
+    // IK target callbacks may access the world of the caller, so they are called before animating on the worker threads
+    static void ResolveIKTargets(RigInstance* instance)
+    {
+        if (instance->m_Pose.Empty() || !instance->m_Enabled || instance->m_Culled || instance->m_LOD.m_SkipIK)
+            return;
+
+        dmArray<IKTarget>& ik_targets = instance->m_IKTargets;
+        uint32_t count = ik_targets.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            IKTarget& target = ik_targets[i];
+            if (target.m_Mix == 0.0f)
+                continue;
+            if (target.m_Callback != 0)
+            {
+                instance->m_IKTargetPositions[i] = target.m_Callback(&target);
+            }
+            else
+            {
+                // instance have been removed, disable animation
+                target.m_UserHash = 0;
+                target.m_Mix = 0.0f;
+            }
+        }
+    }
+
+    struct AnimateContext
+    {
+        RigInstance**   m_Instances;
+        float           m_DT;
+    };
+
+    static void AnimateTask(void* _ctx, uint32_t index)
+    {
+        AnimateContext* ctx = (AnimateContext*)_ctx;
+        RigInstance* instance = ctx->m_Instances[index];
+        instance->m_Deferred = 1;
+        instance->m_DrawOrderChangedCount = DoAnimate(instance, ctx->m_DT, instance->m_DrawOrderDeltas);
+        instance->m_Deferred = 0;
+    }
+
+    // Animates the instances on the worker pool. Each instance only touches its own pose, players and slots,
+    // while IK target callbacks, events and draw order changes are handled on the calling thread in instance order.
+    static void AnimateParallel(HRigContext context, float dt)
+    {
+        DM_PROFILE(Rig, "Animate");
+
+        dmArray<RigInstance*>& instances = context->m_Instances.m_Objects;
+        uint32_t n = instances.Size();
+        if (n == 0)
+            return;
+
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            ResolveIKTargets(instances[i]);
+        }
+
+        AnimateContext ctx;
+        ctx.m_Instances = instances.Begin();
+        ctx.m_DT = dt;
+        dmWorkerPool::Run(context->m_WorkerPool, AnimateTask, &ctx, n);
+
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            RigInstance* instance = instances[i];
+            if (instance->m_DrawOrderChangedCount > 0) {
+                UpdateSlotDrawOrder(instance->m_DrawOrder, instance->m_DrawOrderDeltas, instance->m_DrawOrderChangedCount, context->m_ScratchDrawOrderUnchanged);
+                instance->m_DrawOrderChangedCount = 0;
+            }
+
+            // The callback is read for each event, since a previous event might have changed it
+            for (uint32_t ei = 0; ei < instance->m_DeferredEvents.Size(); ++ei)
+            {
+                RigDeferredEvent* event = &instance->m_DeferredEvents[ei];
+                if (instance->m_EventCallback)
+                {
+                    instance->m_EventCallback(event->m_Type, (void*)&event->m_Keyframe, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
+                }
+            }
+            instance->m_DeferredEvents.SetSize(0);
         }
     }
 
-    static void DoAnimate(HRigContext context, RigInstance* instance, float dt)
+    static int DoAnimate(RigInstance* instance, float dt, dmArray<int32_t>& draw_order_deltas)
     {
+            instance->m_Skipped = 0;
+            instance->m_Throttled = 0;
+
             // NOTE we previously checked for (!instance->m_Enabled || !instance->m_AddedToUpdate) here also
             if (instance->m_Pose.Empty() || !instance->m_Enabled)
-                return;
+                return 0;
+
+            // Culled instances, and throttled instances between the updates where the pose is sampled, only advance their players
+            const RigLOD& lod = instance->m_LOD;
+            if (instance->m_Culled)
+            {
+                instance->m_Skipped = 1;
+                // Sample the pose as soon as the instance is visible again
+                instance->m_SampledPose.SetSize(0);
+                AdvancePlayers(instance, dt);
+                return 0;
+            }
+            if (lod.m_UpdateInterval > 1 && !instance->m_SampledPose.Empty() && ++instance->m_UpdatesSinceSample < lod.m_UpdateInterval)
+            {
+                instance->m_Throttled = 1;
+                AdvancePlayers(instance, dt);
+                InterpolatePose(instance);
+                return 0;
+            }
 
             const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
             const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
@@ -623,6 +924,7 @@ namespace dmRig
             dmArray<dmTransform::Transform>& pose = instance->m_Pose;
             // Reset pose
             uint32_t bone_count = pose.Size();
+            uint32_t animated_bone_count = lod.m_AnimatedBoneCount > 0 ? dmMath::Min(lod.m_AnimatedBoneCount, bone_count) : bone_count;
             for (uint32_t bi = 0; bi < bone_count; ++bi)
             {
                 pose[bi].SetIdentity();
@@ -650,15 +952,15 @@ namespace dmRig
             // Make sure we have enough space in the draw order deltas scratch buffer.
             uint32_t slot_count = instance->m_MeshSet->m_SlotCount;
             int slot_changed = 0;
-            if (context->m_ScratchDrawOrderDeltas.Capacity() < slot_count) {
-                context->m_ScratchDrawOrderDeltas.OffsetCapacity(slot_count - context->m_ScratchDrawOrderDeltas.Capacity());
+            if (draw_order_deltas.Capacity() < slot_count) {
+                draw_order_deltas.OffsetCapacity(slot_count - draw_order_deltas.Capacity());
             }
-            context->m_ScratchDrawOrderDeltas.SetSize(slot_count);
+            draw_order_deltas.SetSize(slot_count);
 
             // Reset draw order deltas to "unchanged" constant.
             for (uint32_t i = 0; i < slot_count; i++) {
                 instance->m_DrawOrder[i] = i;
-                context->m_ScratchDrawOrderDeltas[i] = SIGNAL_DELTA_UNCHANGED;
+                draw_order_deltas[i] = SIGNAL_DELTA_UNCHANGED;
             }
 
             if (instance->m_Blending)
@@ -685,7 +987,7 @@ namespace dmRig
 
                     UpdatePlayer(instance, p, dt, blend_weight);
                     bool draw_order = player == p ? fade_rate >= 0.5f : fade_rate < 0.5f;
-                    ApplyAnimation(p, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, context->m_ScratchDrawOrderDeltas, slot_changed, alpha);
+                    ApplyAnimation(p, pose, track_idx_to_pose, animated_bone_count, ik_animation, instance->m_MeshSlotPose, draw_order, draw_order_deltas, slot_changed, alpha);
                     if (player == p)
                     {
                         alpha = 1.0f - fade_rate;
@@ -699,12 +1001,7 @@ namespace dmRig
             else
             {
                 UpdatePlayer(instance, player, dt, 1.0f);
-                ApplyAnimation(player, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, context->m_ScratchDrawOrderDeltas, slot_changed, 1.0f);
-            }
-
-            // Update draw order after animation
-            if (slot_changed > 0) {
-                UpdateSlotDrawOrder(instance->m_DrawOrder, context->m_ScratchDrawOrderDeltas, slot_changed, context->m_ScratchDrawOrderUnchanged);
+                ApplyAnimation(player, pose, track_idx_to_pose, animated_bone_count, ik_animation, instance->m_MeshSlotPose, true, draw_order_deltas, slot_changed, 1.0f);
             }
 
             for (uint32_t bi = 0; bi < bone_count; ++bi)
@@ -724,7 +1021,7 @@ namespace dmRig
                 t.SetScale(mulPerElem(bind_t.GetScale(), t.GetScale()));
             }
 
-            if (skeleton->m_Iks.m_Count > 0) {
+            if (skeleton->m_Iks.m_Count > 0 && !lod.m_SkipIK) {
                 DM_PROFILE(Rig, "IK");
                 const uint32_t count = skeleton->m_Iks.m_Count;
                 dmArray<IKTarget>& ik_targets = instance->m_IKTargets;
@@ -751,7 +1048,11 @@ namespace dmRig
                     {
                         // get custom target position either from go or vector position
                         Vector3 user_target_position = target_position;
-                        if(ik_targets[i].m_Callback != 0)
+                        if(instance->m_Deferred)
+                        {
+                            user_target_position = instance->m_IKTargetPositions[i];
+                        }
+                        else if(ik_targets[i].m_Callback != 0)
                         {
                             user_target_position = ik_targets[i].m_Callback(&ik_targets[i]);
                         } else {
@@ -776,6 +1077,14 @@ namespace dmRig
                         ApplyTwoBoneIKConstraint(ik, bind_pose, pose, target_position, parent_position, ik_animation[i].m_Positive, ik_animation[i].m_Mix);
                 }
             }
+
+            if (lod.m_UpdateInterval > 1)
+            {
+                StoreSampledPose(instance);
+                InterpolatePose(instance);
+            }
+
+            return slot_changed;
     }
 
     static Result PostUpdate(HRigContext context)
@@ -783,14 +1092,21 @@ namespace dmRig
         const dmArray<RigInstance*>& instances = context->m_Instances.m_Objects;
         uint32_t count = instances.Size();
         bool updated_pose = false;
+        uint32_t skipped = 0;
+        uint32_t throttled = 0;
         for (uint32_t i = 0; i < count; ++i)
         {
             RigInstance* instance = instances[i];
+            skipped += instance->m_Skipped;
+            throttled += instance->m_Throttled;
             if (DoPostUpdate(instance)) {
                 updated_pose = true;
             }
         }
 
+        DM_COUNTER("Rig.SkippedInstances", skipped);
+        DM_COUNTER("Rig.ThrottledInstances", throttled);
+
         return updated_pose ? dmRig::RESULT_UPDATED_POSE : dmRig::RESULT_OK;
     }
 
@@ -814,7 +1130,14 @@ namespace dmRig
     {
         DM_PROFILE(Rig, "Update");
 
-        Animate(context, dt);
+        if (dmWorkerPool::GetThreadCount(context->m_WorkerPool) > 0 && context->m_Instances.Size() >= context->m_MinParallelInstanceCount)
+        {
+            AnimateParallel(context, dt);
+        }
+        else
+        {
+            Animate(context, dt);
+        }
 
         return PostUpdate(context);
     }
@@ -844,6 +1167,9 @@ namespace dmRig
         instance->m_IKTargets.SetSize(skeleton->m_Iks.m_Count);
         memset(instance->m_IKTargets.Begin(), 0x0, instance->m_IKTargets.Size()*sizeof(IKTarget));
 
+        instance->m_IKTargetPositions.SetCapacity(skeleton->m_Iks.m_Count);
+        instance->m_IKTargetPositions.SetSize(skeleton->m_Iks.m_Count);
+
         instance->m_IKAnimation.SetCapacity(skeleton->m_Iks.m_Count);
         instance->m_IKAnimation.SetSize(skeleton->m_Iks.m_Count);
 
@@ -1039,26 +1365,91 @@ namespace dmRig
         return vertex_count;
     }
 
+    // Minimal wrapper for the skinning kernels, which transform one vertex per register (x, y, z, w lanes).
+    // The scalar fallback uses the vector math library with the same operation order.
+#if defined(DM_RIG_SSE)
+    typedef __m128 SimdFloat;
+    static inline SimdFloat SimdLoad(const float* p)                { return _mm_loadu_ps(p); }
+    static inline SimdFloat SimdSet(float v)                        { return _mm_set1_ps(v); }
+    static inline SimdFloat SimdZero()                              { return _mm_setzero_ps(); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return _mm_add_ps(a, b); }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return _mm_mul_ps(a, b); }
+    static inline SimdFloat SimdSplatX(SimdFloat v)                 { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+    static inline SimdFloat SimdSplatY(SimdFloat v)                 { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)); }
+    static inline SimdFloat SimdSplatZ(SimdFloat v)                 { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)); }
+    // Stores x, y, z without touching the float after
+    static inline void SimdStore3(float* p, SimdFloat v)
+    {
+        _mm_storel_pi((__m64*)p, v);
+        _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+    }
+#elif defined(DM_RIG_NEON)
+    typedef float32x4_t SimdFloat;
+    static inline SimdFloat SimdLoad(const float* p)                { return vld1q_f32(p); }
+    static inline SimdFloat SimdSet(float v)                        { return vdupq_n_f32(v); }
+    static inline SimdFloat SimdZero()                              { return vdupq_n_f32(0.0f); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return vaddq_f32(a, b); }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return vmulq_f32(a, b); }
+    static inline SimdFloat SimdSplatX(SimdFloat v)                 { return vdupq_lane_f32(vget_low_f32(v), 0); }
+    static inline SimdFloat SimdSplatY(SimdFloat v)                 { return vdupq_lane_f32(vget_low_f32(v), 1); }
+    static inline SimdFloat SimdSplatZ(SimdFloat v)                 { return vdupq_lane_f32(vget_high_f32(v), 0); }
+    static inline void SimdStore3(float* p, SimdFloat v)
+    {
+        vst1_f32(p, vget_low_f32(v));
+        vst1q_lane_f32(p + 2, v, 2);
+    }
+#else
+    typedef Vector4 SimdFloat;
+    static inline SimdFloat SimdLoad(const float* p)                { return Vector4(p[0], p[1], p[2], p[3]); }
+    static inline SimdFloat SimdSet(float v)                        { return Vector4(v); }
+    static inline SimdFloat SimdZero()                              { return Vector4(0.0f); }
+    static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)       { return a + b; }
+    static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)       { return mulPerElem(a, b); }
+    static inline SimdFloat SimdSplatX(SimdFloat v)                 { return Vector4(v.getX()); }
+    static inline SimdFloat SimdSplatY(SimdFloat v)                 { return Vector4(v.getY()); }
+    static inline SimdFloat SimdSplatZ(SimdFloat v)                 { return Vector4(v.getZ()); }
+    static inline void SimdStore3(float* p, SimdFloat v)
+    {
+        p[0] = v.getX();
+        p[1] = v.getY();
+        p[2] = v.getZ();
+    }
+#endif
+
+    // Same as Matrix4 * Point3, m points to the four columns of the matrix
+    static inline SimdFloat SimdTransformPoint(const float* m, SimdFloat x, SimdFloat y, SimdFloat z)
+    {
+        SimdFloat r = SimdAdd(SimdMul(SimdLoad(m), x), SimdMul(SimdLoad(m + 4), y));
+        return SimdAdd(SimdAdd(r, SimdMul(SimdLoad(m + 8), z)), SimdLoad(m + 12));
+    }
+
+    // Same as Matrix4 * Vector3
+    static inline SimdFloat SimdTransformVector(const float* m, SimdFloat x, SimdFloat y, SimdFloat z)
+    {
+        SimdFloat r = SimdAdd(SimdMul(SimdLoad(m), x), SimdMul(SimdLoad(m + 4), y));
+        return SimdAdd(r, SimdMul(SimdLoad(m + 8), z));
+    }
+
+    static inline const float* MatrixData(const Matrix4& m)
+    {
+        return (const float*)&m;
+    }
+
     static float* GenerateNormalData(const dmRigDDF::Mesh* mesh, const Matrix4& normal_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
     {
         const float* normals_in = mesh->m_Normals.m_Data;
         const uint32_t* normal_indices = mesh->m_NormalsIndices.m_Data;
         uint32_t index_count = mesh->m_PositionIndices.m_Count;
-        Vector4 v;
+        const float* normal_m = MatrixData(normal_matrix);
 
+        // NOTE: The normals are written as transformed, without normalization.
         if (!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
         {
             for (uint32_t ii = 0; ii < index_count; ++ii)
             {
-                uint32_t ni = normal_indices[ii];
-                Vector3 normal_in(normals_in[ni*3+0], normals_in[ni*3+1], normals_in[ni*3+2]);
-                v = normal_matrix * normal_in;
-                if (lengthSqr(v) > 0.0f) {
-                    normalize(v);
-                }
-                *out_buffer++ = v[0];
-                *out_buffer++ = v[1];
-                *out_buffer++ = v[2];
+                const float* n = &normals_in[normal_indices[ii]*3];
+                SimdStore3(out_buffer, SimdTransformVector(normal_m, SimdSet(n[0]), SimdSet(n[1]), SimdSet(n[2])));
+                out_buffer += 3;
             }
             return out_buffer;
         }
@@ -1068,100 +1459,85 @@ namespace dmRig
         const uint32_t* vertex_indices = mesh->m_PositionIndices.m_Data;
         for (uint32_t ii = 0; ii < index_count; ++ii)
         {
-            const uint32_t ni = normal_indices[ii]*3;
-            const Vector3 normal_in(normals_in[ni+0], normals_in[ni+1], normals_in[ni+2]);
-            Vector4 normal_out(0.0f, 0.0f, 0.0f, 0.0f);
+            const float* n = &normals_in[normal_indices[ii]*3];
+            const SimdFloat x = SimdSet(n[0]);
+            const SimdFloat y = SimdSet(n[1]);
+            const SimdFloat z = SimdSet(n[2]);
 
             const uint32_t bi_offset = vertex_indices[ii] << 2;
             const uint32_t* bone_indices = &indices[bi_offset];
             const float* bone_weights = &weights[bi_offset];
 
-            if (bone_weights[0])
+            SimdFloat normal_out;
+            if (bone_weights[0] == 1.0f && !bone_weights[1])
             {
-                normal_out += (pose_matrices[bone_indices[0]] * normal_in) * bone_weights[0];
-                if (bone_weights[1])
+                // Single bone influence
+                normal_out = SimdTransformVector(MatrixData(pose_matrices[bone_indices[0]]), x, y, z);
+            }
+            else
+            {
+                normal_out = SimdZero();
+                for (uint32_t bi = 0; bi < 4 && bone_weights[bi]; ++bi)
                 {
-                    normal_out += (pose_matrices[bone_indices[1]] * normal_in) * bone_weights[1];
-                    if (bone_weights[2])
-                    {
-                        normal_out += (pose_matrices[bone_indices[2]] * normal_in) * bone_weights[2];
-                        if (bone_weights[3])
-                        {
-                            normal_out += (pose_matrices[bone_indices[3]] * normal_in) * bone_weights[3];
-                        }
-                    }
+                    SimdFloat n_bone = SimdTransformVector(MatrixData(pose_matrices[bone_indices[bi]]), x, y, z);
+                    normal_out = SimdAdd(normal_out, SimdMul(n_bone, SimdSet(bone_weights[bi])));
                 }
             }
 
-            v = normal_matrix * Vector3(normal_out.getX(), normal_out.getY(), normal_out.getZ());
-            if (lengthSqr(v) > 0.0f) {
-                normalize(v);
-            }
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+            SimdStore3(out_buffer, SimdTransformVector(normal_m, SimdSplatX(normal_out), SimdSplatY(normal_out), SimdSplatZ(normal_out)));
+            out_buffer += 3;
         }
 
         return out_buffer;
     }
 
-    static float* GeneratePositionData(const dmRigDDF::Mesh* mesh, const Matrix4& model_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
+    /*
+     * skin_matrices are the pose matrices premultiplied with the model matrix, used for vertices
+     * with a single bone influence (the common case) to transform them with one matrix.
+     */
+    static float* GeneratePositionData(const dmRigDDF::Mesh* mesh, const Matrix4& model_matrix, const dmArray<Matrix4>& pose_matrices, const dmArray<Matrix4>& skin_matrices, float* out_buffer)
     {
+        DM_STATIC_ASSERT(sizeof(Matrix4) == 16 * sizeof(float), Invalid_Struct_Size);
+
         const float *positions = mesh->m_Positions.m_Data;
-        const size_t vertex_count = mesh->m_Positions.m_Count / 3;
-        Point3 in_p;
-        Vector4 v;
+        const uint32_t vertex_count = mesh->m_Positions.m_Count / 3;
+        const float* model_m = MatrixData(model_matrix);
         if(!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
         {
-            for (uint32_t i = 0; i < vertex_count; ++i)
+            for (uint32_t i = 0; i < vertex_count; ++i, positions += 3, out_buffer += 3)
             {
-                in_p[0] = *positions++;
-                in_p[1] = *positions++;
-                in_p[2] = *positions++;
-                v = model_matrix * in_p;
-                *out_buffer++ = v[0];
-                *out_buffer++ = v[1];
-                *out_buffer++ = v[2];
+                SimdStore3(out_buffer, SimdTransformPoint(model_m, SimdSet(positions[0]), SimdSet(positions[1]), SimdSet(positions[2])));
             }
             return out_buffer;
         }
 
         const uint32_t* indices = mesh->m_BoneIndices.m_Data;
         const float* weights = mesh->m_Weights.m_Data;
-        for (uint32_t i = 0; i < vertex_count; ++i)
+        for (uint32_t i = 0; i < vertex_count; ++i, positions += 3, out_buffer += 3)
         {
-            Vector4 in_v;
-            in_v.setX(*positions++);
-            in_v.setY(*positions++);
-            in_v.setZ(*positions++);
-            in_v.setW(1.0f);
+            const SimdFloat x = SimdSet(positions[0]);
+            const SimdFloat y = SimdSet(positions[1]);
+            const SimdFloat z = SimdSet(positions[2]);
 
-            Vector4 out_p(0.0f, 0.0f, 0.0f, 0.0f);
             const uint32_t bi_offset = i << 2;
             const uint32_t* bone_indices = &indices[bi_offset];
             const float* bone_weights = &weights[bi_offset];
 
-            if(bone_weights[0])
+            if (bone_weights[0] == 1.0f && !bone_weights[1])
             {
-                out_p += pose_matrices[bone_indices[0]] * in_v * bone_weights[0];
-                if(bone_weights[1])
-                {
-                    out_p += pose_matrices[bone_indices[1]] * in_v * bone_weights[1];
-                    if(bone_weights[2])
-                    {
-                        out_p += pose_matrices[bone_indices[2]] * in_v * bone_weights[2];
-                        if(bone_weights[3])
-                        {
-                            out_p += pose_matrices[bone_indices[3]] * in_v * bone_weights[3];
-                        }
-                    }
-                }
+                // Single bone influence
+                SimdStore3(out_buffer, SimdTransformPoint(MatrixData(skin_matrices[bone_indices[0]]), x, y, z));
+                continue;
+            }
+
+            SimdFloat out_p = SimdZero();
+            for (uint32_t bi = 0; bi < 4 && bone_weights[bi]; ++bi)
+            {
+                SimdFloat p_bone = SimdTransformPoint(MatrixData(pose_matrices[bone_indices[bi]]), x, y, z);
+                out_p = SimdAdd(out_p, SimdMul(p_bone, SimdSet(bone_weights[bi])));
             }
 
-            v = model_matrix * Point3(out_p.getX(), out_p.getY(), out_p.getZ());
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+            SimdStore3(out_buffer, SimdTransformPoint(model_m, SimdSplatX(out_p), SimdSplatY(out_p), SimdSplatZ(out_p)));
         }
         return out_buffer;
     }
@@ -1334,6 +1710,7 @@ namespace dmRig
 
         dmArray<Matrix4>& pose_matrices      = context->m_ScratchPoseMatrixBuffer;
         dmArray<Matrix4>& influence_matrices = context->m_ScratchInfluenceMatrixBuffer;
+        dmArray<Matrix4>& skin_matrices      = context->m_ScratchSkinMatrixBuffer;
         dmArray<Vector3>& positions          = context->m_ScratchPositionBuffer;
         dmArray<Vector3>& normals            = context->m_ScratchNormalBuffer;
 
@@ -1389,6 +1766,16 @@ namespace dmRig
 
             // Rearrange pose matrices to indices that the mesh vertices understand.
             PoseToInfluence(*instance->m_PoseIdxToInfluence, pose_matrices, influence_matrices);
+
+            // Premultiply with the model matrix for vertices influenced by a single bone.
+            if (skin_matrices.Capacity() < max_bone_count) {
+                skin_matrices.OffsetCapacity(max_bone_count - skin_matrices.Capacity());
+            }
+            skin_matrices.SetSize(max_bone_count);
+            for (uint32_t bi = 0; bi < max_bone_count; ++bi)
+            {
+                skin_matrices[bi] = model_matrix * influence_matrices[bi];
+            }
         }
 
         // Loop that generates actual vertex data for current mesh entry.
@@ -1432,7 +1819,7 @@ namespace dmRig
                     // Fill scratch buffers for positions, and normals if applicable, using pose matrices.
                     float* positions_buffer = (float*)positions.Begin();
                     float* normals_buffer = (float*)normals.Begin();
-                    dmRig::GeneratePositionData(mesh_attachment, model_matrix, influence_matrices, positions_buffer);
+                    dmRig::GeneratePositionData(mesh_attachment, model_matrix, influence_matrices, skin_matrices, positions_buffer);
                     if (vertex_format == RIG_VERTEX_FORMAT_MODEL && mesh_attachment->m_NormalsIndices.m_Count) {
                         dmRig::GenerateNormalData(mesh_attachment, normal_matrix, influence_matrices, normals_buffer);
                     }
@@ -1533,6 +1920,23 @@ namespace dmRig
         instance->m_EventCBUserData2 = user_data2;
     }
 
+    void SetLOD(HRigInstance instance, const RigLOD& lod)
+    {
+        instance->m_LOD = lod;
+        // Sample the pose in the next update
+        instance->m_SampledPose.SetSize(0);
+    }
+
+    void SetCulled(HRigInstance instance, bool culled)
+    {
+        instance->m_Culled = culled;
+    }
+
+    bool GetCulled(HRigInstance instance)
+    {
+        return instance->m_Culled;
+    }
+
     IKTarget* GetIKTarget(HRigInstance instance, dmhash_t constraint_id)
     {
         if (!instance) {
@@ -1577,6 +1981,11 @@ namespace dmRig
         // If we're going to use memset, then we should explicitly clear pose and instance arrays.
         instance->m_Pose.SetCapacity(0);
         instance->m_IKTargets.SetCapacity(0);
+        instance->m_IKTargetPositions.SetCapacity(0);
+        instance->m_DeferredEvents.SetCapacity(0);
+        instance->m_DrawOrderDeltas.SetCapacity(0);
+        instance->m_PrevSampledPose.SetCapacity(0);
+        instance->m_SampledPose.SetCapacity(0);
         instance->m_MeshSlotPose.SetCapacity(0);
         delete instance;
         context->m_Instances.Free(index, true);
@@ -1612,8 +2021,10 @@ namespace dmRig
         instance->m_Skeleton           = params.m_Skeleton;
         instance->m_MeshSet            = params.m_MeshSet;
         instance->m_AnimationSet       = params.m_AnimationSet;
+        instance->m_CompressedAnimationSet = params.m_CompressedAnimationSet;
         instance->m_PoseIdxToInfluence = params.m_PoseIdxToInfluence;
         instance->m_TrackIdxToPose     = params.m_TrackIdxToPose;
+        instance->m_LOD                = params.m_LOD;
 
         instance->m_Enabled = 1;
 
@@ -1639,7 +2050,7 @@ namespace dmRig
         // before that happens, for example cloning a GUI spine node happens in script update,
         // which comes after the regular dmRig::Update.
         if (params.m_ForceAnimatePose) {
-            DoAnimate(context, instance, 0.0f);
+            AnimateInstance(context, instance, 0.0f);
         }
 
         return dmRig::RESULT_OK;
@@ -1742,4 +2153,251 @@ namespace dmRig
         }
     }
 
+    // Tracks where all components of all frames are within this distance from the first frame are stored once
+    static const float COMPRESSED_CONSTANT_EPSILON = 0.00001f;
+
+    static void QuantizeQuat(const float* data, uint16_t* out)
+    {
+        Quat q = normalize(Quat(data[0], data[1], data[2], data[3]));
+        float c[4] = { q.getX(), q.getY(), q.getZ(), q.getW() };
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; ++i)
+        {
+            if (fabsf(c[i]) > fabsf(c[largest]))
+                largest = i;
+        }
+        // q and -q are the same rotation, the largest component is made positive so it can be restored from the others
+        float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+        for (uint32_t i = 0, j = 0; i < 4; ++i)
+        {
+            if (i == largest)
+                continue;
+            float v = dmMath::Clamp(sign * c[i] / QUAT_COMPONENT_RANGE, -1.0f, 1.0f);
+            out[j++] = (uint16_t)((v * 0.5f + 0.5f) * QUAT_COMPONENT_MAX + 0.5f);
+        }
+        out[0] |= (largest & 1) << 15;
+        out[1] |= (largest >> 1) << 15;
+    }
+
+    static const float* GetTrackData(const dmRigDDF::AnimationTrack& track, uint32_t type, uint32_t* component_count, uint32_t* frame_count)
+    {
+        switch (type)
+        {
+        case COMPRESSED_TRACK_TRANSLATION:
+            *component_count = 3;
+            *frame_count = track.m_Positions.m_Count / 3;
+            return track.m_Positions.m_Data;
+        case COMPRESSED_TRACK_ROTATION:
+            *component_count = 4;
+            *frame_count = track.m_Rotations.m_Count / 4;
+            return track.m_Rotations.m_Data;
+        default:
+            *component_count = 3;
+            *frame_count = track.m_Scale.m_Count / 3;
+            return track.m_Scale.m_Data;
+        }
+    }
+
+    static bool IsConstantTrack(const float* data, uint32_t component_count, uint32_t frame_count)
+    {
+        for (uint32_t i = component_count; i < frame_count * component_count; ++i)
+        {
+            if (fabsf(data[i] - data[i % component_count]) > COMPRESSED_CONSTANT_EPSILON)
+                return false;
+        }
+        return true;
+    }
+
+    static void CompressAnimation(const dmRigDDF::RigAnimation& animation, CompressedAnimation& out)
+    {
+        // Classify the tracks and lay out the frames
+        uint32_t track_count = 0;
+        uint32_t constant_count = 0;
+        uint32_t frame_size = 0;
+        uint32_t frame_count = 0;
+        for (uint32_t ti = 0; ti < animation.m_Tracks.m_Count; ++ti)
+        {
+            for (uint32_t type = COMPRESSED_TRACK_TRANSLATION; type <= COMPRESSED_TRACK_SCALE; ++type)
+            {
+                uint32_t component_count, track_frame_count;
+                const float* data = GetTrackData(animation.m_Tracks[ti], type, &component_count, &track_frame_count);
+                if (track_frame_count == 0)
+                    continue;
+                ++track_count;
+                if (IsConstantTrack(data, component_count, track_frame_count))
+                {
+                    constant_count += component_count;
+                }
+                else
+                {
+                    frame_size += 3;
+                    frame_count = dmMath::Max(frame_count, track_frame_count);
+                }
+            }
+        }
+
+        out.m_Tracks.SetCapacity(track_count);
+        out.m_Constants.SetCapacity(constant_count);
+        out.m_FrameSize = frame_size;
+        out.m_FrameCount = frame_count;
+        out.m_Frames.SetCapacity(frame_size * frame_count);
+        out.m_Frames.SetSize(frame_size * frame_count);
+
+        uint32_t frame_offset = 0;
+        for (uint32_t ti = 0; ti < animation.m_Tracks.m_Count; ++ti)
+        {
+            for (uint32_t type = COMPRESSED_TRACK_TRANSLATION; type <= COMPRESSED_TRACK_SCALE; ++type)
+            {
+                uint32_t component_count, track_frame_count;
+                const float* data = GetTrackData(animation.m_Tracks[ti], type, &component_count, &track_frame_count);
+                if (track_frame_count == 0)
+                    continue;
+
+                CompressedTrack track;
+                memset(&track, 0, sizeof(track));
+                track.m_BoneIndex = animation.m_Tracks[ti].m_BoneIndex;
+                track.m_Type = type;
+                if (IsConstantTrack(data, component_count, track_frame_count))
+                {
+                    track.m_Constant = 1;
+                    track.m_Offset = out.m_Constants.Size();
+                    for (uint32_t c = 0; c < component_count; ++c)
+                    {
+                        out.m_Constants.Push(data[c]);
+                    }
+                    out.m_Tracks.Push(track);
+                    continue;
+                }
+
+                track.m_Offset = frame_offset;
+                frame_offset += 3;
+
+                float inv_step[3];
+                if (type != COMPRESSED_TRACK_ROTATION)
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        float min_value = data[c];
+                        float max_value = data[c];
+                        for (uint32_t f = 1; f < track_frame_count; ++f)
+                        {
+                            min_value = dmMath::Min(min_value, data[f*3+c]);
+                            max_value = dmMath::Max(max_value, data[f*3+c]);
+                        }
+                        track.m_Min[c] = min_value;
+                        track.m_Step[c] = (max_value - min_value) / 0xffff;
+                        inv_step[c] = track.m_Step[c] > 0.0f ? 1.0f / track.m_Step[c] : 0.0f;
+                    }
+                }
+
+                // Tracks with fewer frames than the animation repeat their last frame
+                for (uint32_t f = 0; f < frame_count; ++f)
+                {
+                    const float* src = &data[dmMath::Min(f, track_frame_count - 1) * component_count];
+                    uint16_t* dst = &out.m_Frames[f * frame_size + track.m_Offset];
+                    if (type == COMPRESSED_TRACK_ROTATION)
+                    {
+                        QuantizeQuat(src, dst);
+                    }
+                    else
+                    {
+                        for (uint32_t c = 0; c < 3; ++c)
+                        {
+                            dst[c] = (uint16_t)dmMath::Min((src[c] - track.m_Min[c]) * inv_step[c] + 0.5f, (float)0xffff);
+                        }
+                    }
+                }
+                out.m_Tracks.Push(track);
+            }
+        }
+    }
+
+    CompressedAnimationSet* CompressAnimationSet(const dmRigDDF::AnimationSet& animation_set)
+    {
+        DM_PROFILE(Rig, "CompressAnimationSet");
+        CompressedAnimationSet* compressed = new CompressedAnimationSet;
+        compressed->m_AnimationCount = animation_set.m_Animations.m_Count;
+        compressed->m_Animations = new CompressedAnimation[compressed->m_AnimationCount];
+        for (uint32_t i = 0; i < compressed->m_AnimationCount; ++i)
+        {
+            CompressAnimation(animation_set.m_Animations[i], compressed->m_Animations[i]);
+        }
+        return compressed;
+    }
+
+    void DeleteCompressedAnimationSet(CompressedAnimationSet* animation_set)
+    {
+        delete [] animation_set->m_Animations;
+        delete animation_set;
+    }
+
+    dmRigDDF::AnimationSet* CopyAnimationSetWithoutBoneTracks(dmRigDDF::AnimationSet* animation_set, uint32_t* out_size)
+    {
+        DM_PROFILE(Rig, "CopyAnimationSetWithoutBoneTracks");
+
+        // Hide the samples while saving the message, the track bone indices are kept for FillBoneListArrays
+        uint32_t track_count = 0;
+        for (uint32_t ai = 0; ai < animation_set->m_Animations.m_Count; ++ai)
+        {
+            track_count += animation_set->m_Animations[ai].m_Tracks.m_Count;
+        }
+        dmArray<uint32_t> counts;
+        counts.SetCapacity(track_count * 3);
+        for (uint32_t ai = 0; ai < animation_set->m_Animations.m_Count; ++ai)
+        {
+            dmRigDDF::RigAnimation& animation = animation_set->m_Animations[ai];
+            for (uint32_t ti = 0; ti < animation.m_Tracks.m_Count; ++ti)
+            {
+                dmRigDDF::AnimationTrack& track = animation.m_Tracks[ti];
+                counts.Push(track.m_Positions.m_Count);
+                counts.Push(track.m_Rotations.m_Count);
+                counts.Push(track.m_Scale.m_Count);
+                track.m_Positions.m_Count = 0;
+                track.m_Rotations.m_Count = 0;
+                track.m_Scale.m_Count = 0;
+            }
+        }
+
+        dmArray<uint8_t> buffer;
+        dmDDF::Result result = dmDDF::SaveMessageToArray(animation_set, dmRigDDF::AnimationSet::m_DDFDescriptor, buffer);
+
+        uint32_t* count = counts.Begin();
+        for (uint32_t ai = 0; ai < animation_set->m_Animations.m_Count; ++ai)
+        {
+            dmRigDDF::RigAnimation& animation = animation_set->m_Animations[ai];
+            for (uint32_t ti = 0; ti < animation.m_Tracks.m_Count; ++ti)
+            {
+                dmRigDDF::AnimationTrack& track = animation.m_Tracks[ti];
+                track.m_Positions.m_Count = *count++;
+                track.m_Rotations.m_Count = *count++;
+                track.m_Scale.m_Count = *count++;
+            }
+        }
+
+        dmRigDDF::AnimationSet* copy = 0x0;
+        if (result == dmDDF::RESULT_OK)
+        {
+            result = dmDDF::LoadMessage(buffer.Begin(), buffer.Size(), dmRigDDF::AnimationSet::m_DDFDescriptor, (void**) &copy, 0, out_size);
+        }
+        if (result != dmDDF::RESULT_OK)
+        {
+            dmLogError("Unable to copy the animation set (%d)", result);
+            return 0x0;
+        }
+        return copy;
+    }
+
+    uint32_t GetCompressedAnimationSetSize(const CompressedAnimationSet* animation_set)
+    {
+        uint32_t size = sizeof(CompressedAnimationSet);
+        for (uint32_t i = 0; i < animation_set->m_AnimationCount; ++i)
+        {
+            const CompressedAnimation& animation = animation_set->m_Animations[i];
+            size += sizeof(CompressedAnimation);
+            size += animation.m_Tracks.Size() * sizeof(CompressedTrack);
+            size += animation.m_Constants.Size() * sizeof(float);
+            size += animation.m_Frames.Size() * sizeof(uint16_t);
+        }
+        return size;
+    }
 }
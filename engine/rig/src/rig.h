@@ -20,6 +20,7 @@
 #include <dlib/vmath.h>
 #include <dlib/align.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include <render/render.h>
 
@@ -62,9 +63,58 @@ namespace dmRig
         PLAYBACK_COUNT = 7,
     };
 
+    enum CompressedTrackType
+    {
+        COMPRESSED_TRACK_TRANSLATION = 0,
+        COMPRESSED_TRACK_ROTATION    = 1,
+        COMPRESSED_TRACK_SCALE       = 2,
+    };
+
+    /// Translation, rotation or scale of an animation track in the compressed format.
+    struct CompressedTrack
+    {
+        /// Bone index of the animation track
+        uint32_t m_BoneIndex;
+        /// CompressedTrackType
+        uint16_t m_Type;
+        /// Whether the track has the same value in all frames, in which case it is stored once in the constants
+        uint16_t m_Constant;
+        /// Offset within a frame for animated tracks, or into the constants for constant tracks
+        uint32_t m_Offset;
+        /// Translation and scale are quantized to 16 bits per component, value = m_Min + q * m_Step
+        float    m_Min[3];
+        float    m_Step[3];
+    };
+
+    /**
+     * Bone tracks of an animation in the compressed runtime format. Rotations are quantized with
+     * the smallest three components in 48 bits, translations and scales with 16 bits per component
+     * within the range of the track. The animated tracks are interleaved per frame, so sampling a
+     * pose reads two consecutive frames.
+     */
+    struct CompressedAnimation
+    {
+        dmArray<CompressedTrack> m_Tracks;
+        /// Values of the constant tracks
+        dmArray<float>           m_Constants;
+        /// Quantized values of the animated tracks, m_FrameSize values per frame
+        dmArray<uint16_t>        m_Frames;
+        uint32_t                 m_FrameSize;
+        uint32_t                 m_FrameCount;
+    };
+
+    /// Compressed bone tracks of an animation set, see CompressAnimationSet.
+    struct CompressedAnimationSet
+    {
+        /// One per animation, in the same order as in the animation set
+        CompressedAnimation* m_Animations;
+        uint32_t             m_AnimationCount;
+    };
+
     struct RigPlayer
     {
         RigPlayer() : m_Animation(0x0),
+                      m_CompressedAnimation(0x0),
                       m_AnimationId(0x0),
                       m_Cursor(0.0f),
                       m_Playback(dmRig::PLAYBACK_ONCE_FORWARD),
@@ -73,6 +123,8 @@ namespace dmRig
                       m_Initial(0x1) {};
         /// Currently playing animation
         const dmRigDDF::RigAnimation* m_Animation;
+        /// Compressed bone tracks of the animation, may be 0
+        const CompressedAnimation*    m_CompressedAnimation;
         dmhash_t                      m_AnimationId;
         /// Playback cursor in the interval [0,duration]
         float                         m_Cursor;
@@ -169,6 +221,17 @@ namespace dmRig
         uint64_t  m_String;
     };
 
+    /// Event posted while the instance is animated on a worker thread, sent after the update
+    struct RigDeferredEvent
+    {
+        RigEventType m_Type;
+        union
+        {
+            RigCompletedEventData m_Completed;
+            RigKeyframeEventData  m_Keyframe;
+        };
+    };
+
     // NOTE: We expose two different vertex format that GenerateVertexData can output.
     // This is a temporary fix until we have better support for custom vertex formats.
     enum RigVertexFormat
@@ -210,6 +273,8 @@ namespace dmRig
         dmArray<dmTransform::Transform> m_ScratchPoseTransformBuffer;
         dmArray<Matrix4>                m_ScratchInfluenceMatrixBuffer;
         dmArray<Matrix4>                m_ScratchPoseMatrixBuffer;
+        // Influence matrices premultiplied with the model matrix, used for single bone vertices.
+        dmArray<Matrix4>                m_ScratchSkinMatrixBuffer;
         // Temporary scratch buffers used when transforming the vertex buffer,
         // used to creating primitives from indices.
         dmArray<Vector3>                m_ScratchPositionBuffer;
@@ -217,11 +282,36 @@ namespace dmRig
         // Temporary scratch buffers to handle draw order changes.
         dmArray<int32_t>                m_ScratchDrawOrderDeltas;
         dmArray<int32_t>                m_ScratchDrawOrderUnchanged;
+        // Worker pool used to animate the instances in parallel, may be 0.
+        dmWorkerPool::HWorkerPool       m_WorkerPool;
+        // Fewer instances than this are animated on the calling thread, even with a worker pool.
+        uint32_t                        m_MinParallelInstanceCount;
     };
 
     struct NewContextParams {
         HRigContext* m_Context;
         uint32_t     m_MaxRigInstanceCount;
+        /// Worker pool used to animate the instances in parallel, or 0 to animate them on the calling thread.
+        /// Events and draw order changes are applied on the calling thread after all instances have been animated,
+        /// and IK target callbacks are called on the calling thread before.
+        dmWorkerPool::HWorkerPool m_WorkerPool;
+        /// Min number of instances to animate them on the worker pool, below this the dispatch costs more than it saves.
+        /// 0 uses the default of 128 instances.
+        uint32_t     m_MinParallelInstanceCount;
+    };
+
+    /**
+     * Level of detail of a rig instance, the default (all zero) samples all bones every update.
+     */
+    struct RigLOD
+    {
+        /// Sample the animation every Nth update, 0 or 1 samples every update. The pose is interpolated
+        /// between the last two sampled poses in between, which delays it by up to N-1 updates.
+        uint32_t m_UpdateInterval;
+        /// Number of bones to animate, in skeleton order, 0 animates all bones. The other bones keep their bind pose.
+        uint32_t m_AnimatedBoneCount;
+        /// Skip the IK constraints
+        bool     m_SkipIK;
     };
 
     typedef void (*RigEventCallback)(RigEventType, void*, void*, void*);
@@ -236,6 +326,7 @@ namespace dmRig
         const dmRigDDF::Skeleton*     m_Skeleton;
         const dmRigDDF::MeshSet*      m_MeshSet;
         const dmRigDDF::AnimationSet* m_AnimationSet;
+        const CompressedAnimationSet* m_CompressedAnimationSet;
         const dmArray<uint32_t>*      m_PoseIdxToInfluence;
         const dmArray<uint32_t>*      m_TrackIdxToPose;
         RigPoseCallback               m_PoseCallback;
@@ -252,6 +343,20 @@ namespace dmRig
         dmArray<IKAnimation>          m_IKAnimation;
         /// User IK constraint targets
         dmArray<IKTarget>             m_IKTargets;
+        /// IK target positions resolved on the calling thread, when animated on a worker thread
+        dmArray<Vector3>              m_IKTargetPositions;
+        /// Events posted while animated on a worker thread
+        dmArray<RigDeferredEvent>     m_DeferredEvents;
+        /// Draw order deltas from the last update, when animated on a worker thread
+        dmArray<int32_t>              m_DrawOrderDeltas;
+        /// Number of slots with a changed draw order in the last update, when animated on a worker thread
+        int32_t                       m_DrawOrderChangedCount;
+        RigLOD                        m_LOD;
+        /// The last two sampled poses, when the animation is not sampled every update
+        dmArray<dmTransform::Transform> m_PrevSampledPose;
+        dmArray<dmTransform::Transform> m_SampledPose;
+        /// Number of updates since the pose was sampled
+        uint32_t                      m_UpdatesSinceSample;
         /// Slot pose state (active mesh attachment index and color) that can be animated.
         dmArray<MeshSlotPose>         m_MeshSlotPose;
         /// Currently used mesh
@@ -269,6 +374,14 @@ namespace dmRig
         uint8_t                       m_Blending : 1;
         uint8_t                       m_Enabled : 1;
         uint8_t                       m_DoRender : 1;
+        /// Set while animated on a worker thread
+        uint8_t                       m_Deferred : 1;
+        /// Culled instances advance their animations and post events, but the pose is not sampled.
+        /// Vertex data is still generated from the last pose, for the frame the instance becomes visible again.
+        uint8_t                       m_Culled : 1;
+        /// Whether the pose was interpolated (throttled) or left as is (skipped) in the last update
+        uint8_t                       m_Throttled : 1;
+        uint8_t                       m_Skipped : 1;
     };
 
     struct InstanceCreateParams
@@ -284,6 +397,8 @@ namespace dmRig
         const dmRigDDF::Skeleton*     m_Skeleton;
         const dmRigDDF::MeshSet*      m_MeshSet;
         const dmRigDDF::AnimationSet* m_AnimationSet;
+        /// Compressed bone tracks of the animation set, sampled instead of the bone tracks of the animation set if set
+        const CompressedAnimationSet* m_CompressedAnimationSet;
 
         const dmArray<uint32_t>*      m_PoseIdxToInfluence;
         const dmArray<uint32_t>*      m_TrackIdxToPose;
@@ -295,6 +410,8 @@ namespace dmRig
         void*                         m_EventCBUserData1;
         void*                         m_EventCBUserData2;
 
+        RigLOD                        m_LOD;
+
         bool                          m_ForceAnimatePose;
     };
 
@@ -335,11 +452,23 @@ namespace dmRig
     uint32_t GetBoneCount(HRigInstance instance);
     uint32_t GetMaxBoneCount(HRigInstance instance);
     void SetEventCallback(HRigInstance instance, RigEventCallback event_callback, void* user_data1, void* user_data2);
+    void SetLOD(HRigInstance instance, const RigLOD& lod);
+    void SetCulled(HRigInstance instance, bool culled);
+    bool GetCulled(HRigInstance instance);
 
     // Util function used to fill a bind pose array from skeleton data
     // used in rig tests and loading rig resources.
     void CreateBindPose(dmRigDDF::Skeleton& skeleton, dmArray<RigBone>& bind_pose);
     void FillBoneListArrays(const dmRigDDF::MeshSet& meshset, const dmRigDDF::AnimationSet& animationset, const dmRigDDF::Skeleton& skeleton, dmArray<uint32_t>& track_idx_to_pose, dmArray<uint32_t>& pose_idx_to_influence);
+
+    // Builds the compressed bone tracks of an animation set, used when loading rig resources.
+    CompressedAnimationSet* CompressAnimationSet(const dmRigDDF::AnimationSet& animation_set);
+    void DeleteCompressedAnimationSet(CompressedAnimationSet* animation_set);
+    // Size in bytes of the compressed bone tracks
+    uint32_t GetCompressedAnimationSetSize(const CompressedAnimationSet* animation_set);
+    // Copy of an animation set without the bone track samples, for instances that sample the compressed bone tracks.
+    // The copy is one DDF message (free it with dmDDF::FreeMessage), its size in bytes is returned in out_size.
+    dmRigDDF::AnimationSet* CopyAnimationSetWithoutBoneTracks(dmRigDDF::AnimationSet* animation_set, uint32_t* out_size);
 }
 
 #endif // DM_RIG_H
@@ -13,6 +13,7 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/log.h>
+#include <dlib/time.h>
 
 #include <../rig.h>
 
@@ -2493,6 +2494,671 @@ PlaybackCursorTestParams playback_cursor_test_params[] = {
 };
 INSTANTIATE_TEST_CASE_P(Rig, PlaybackCursorTest, jc_test_values_in(playback_cursor_test_params));
 
+struct RigEventRecord
+{
+    uint32_t            m_Instance;
+    dmRig::RigEventType m_Type;
+    dmhash_t            m_AnimationId;
+};
+
+static void RecordEventCallback(dmRig::RigEventType event_type, void* event_data, void* user_data1, void* user_data2)
+{
+    dmArray<RigEventRecord>* events = (dmArray<RigEventRecord>*)user_data1;
+    RigEventRecord record;
+    record.m_Instance = (uint32_t)(uintptr_t)user_data2;
+    record.m_Type = event_type;
+    record.m_AnimationId = ((dmRig::RigCompletedEventData*)event_data)->m_AnimationId;
+    if (events->Full())
+    {
+        events->OffsetCapacity(16);
+    }
+    events->Push(record);
+}
+
+// The transforms are compared per component since the padding of the vector types is not initialized
+static void TransformToFloats(const dmTransform::Transform& transform, float* out)
+{
+    Quat r = transform.GetRotation();
+    Vector3 t = transform.GetTranslation();
+    Vector3 s = transform.GetScale();
+    out[0] = r.getX(); out[1] = r.getY(); out[2] = r.getZ(); out[3] = r.getW();
+    out[4] = t.getX(); out[5] = t.getY(); out[6] = t.getZ();
+    out[7] = s.getX(); out[8] = s.getY(); out[9] = s.getZ();
+}
+
+// Runs the same set of rig instances on a context animated on the calling thread and on one animated on a worker pool
+class RigWorkerPoolTest : public jc_test_base_class
+{
+public:
+    static const uint32_t INSTANCE_COUNT = 64;
+
+    dmWorkerPool::HWorkerPool m_Pool;
+    dmRig::HRigContext      m_Contexts[2];
+    dmRig::HRigInstance     m_Instances[2][INSTANCE_COUNT];
+    dmArray<RigEventRecord> m_Events[2];
+    dmArray<dmRig::RigBone> m_BindPose;
+    dmRigDDF::Skeleton*     m_Skeleton;
+    dmRigDDF::MeshSet*      m_MeshSet;
+    dmRigDDF::AnimationSet* m_AnimationSet;
+    dmArray<uint32_t>       m_PoseIdxToInfluence;
+    dmArray<uint32_t>       m_TrackIdxToPose;
+
+protected:
+    virtual void SetUp() {
+        m_Pool = dmWorkerPool::New("rig", 3);
+
+        m_Skeleton     = new dmRigDDF::Skeleton();
+        m_MeshSet      = new dmRigDDF::MeshSet();
+        m_AnimationSet = new dmRigDDF::AnimationSet();
+        SetUpSimpleRig(m_BindPose, m_Skeleton, m_MeshSet, m_AnimationSet, m_PoseIdxToInfluence, m_TrackIdxToPose);
+
+        for (uint32_t c = 0; c < 2; ++c)
+        {
+            dmRig::NewContextParams params = {0};
+            params.m_Context = &m_Contexts[c];
+            params.m_MaxRigInstanceCount = INSTANCE_COUNT;
+            params.m_WorkerPool = c == 0 ? 0 : m_Pool;
+            // Animate on the worker pool even below the default threshold
+            params.m_MinParallelInstanceCount = 1;
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::NewContext(params));
+
+            for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+            {
+                dmRig::InstanceCreateParams create_params = {0};
+                create_params.m_Context            = m_Contexts[c];
+                create_params.m_Instance           = &m_Instances[c][i];
+                create_params.m_BindPose           = &m_BindPose;
+                create_params.m_Skeleton           = m_Skeleton;
+                create_params.m_MeshSet            = m_MeshSet;
+                create_params.m_AnimationSet       = m_AnimationSet;
+                create_params.m_TrackIdxToPose     = &m_TrackIdxToPose;
+                create_params.m_PoseIdxToInfluence = &m_PoseIdxToInfluence;
+                create_params.m_MeshId             = dmHashString64("test");
+                create_params.m_DefaultAnimation   = dmHashString64("");
+                create_params.m_EventCallback      = RecordEventCallback;
+                create_params.m_EventCBUserData1   = &m_Events[c];
+                create_params.m_EventCBUserData2   = (void*)(uintptr_t)i;
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::InstanceCreate(create_params));
+            }
+        }
+    }
+
+    virtual void TearDown() {
+        for (uint32_t c = 0; c < 2; ++c)
+        {
+            for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+            {
+                dmRig::InstanceDestroyParams destroy_params = {0};
+                destroy_params.m_Context = m_Contexts[c];
+                destroy_params.m_Instance = m_Instances[c][i];
+                dmRig::InstanceDestroy(destroy_params);
+            }
+            dmRig::DeleteContext(m_Contexts[c]);
+        }
+        DeleteRigData(m_MeshSet, m_Skeleton, m_AnimationSet);
+        dmWorkerPool::Delete(m_Pool);
+    }
+};
+
+TEST_F(RigWorkerPoolTest, SameAsSerial)
+{
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+        {
+            dmRig::HRigInstance instance = m_Instances[c][i];
+            switch (i % 4)
+            {
+            case 0:
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("valid"), dmRig::PLAYBACK_ONCE_FORWARD, 0.0f, 0.0f, 1.0f));
+                break;
+            case 1:
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::SetMesh(instance, dmHashString64("draw_order_skin")));
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("draw_order_anim"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+                break;
+            case 2:
+            {
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("ik"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+                dmRig::IKTarget* target = dmRig::GetIKTarget(instance, dmHashString64("test_ik"));
+                ASSERT_NE((dmRig::IKTarget*)0x0, target);
+                target->m_Callback = UpdateIKPositionCallback;
+                target->m_Mix = 1.0f;
+                target->m_Position = Vector3(100.0f, (float)i, 0.0f);
+                break;
+            }
+            case 3:
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("rot_blend1"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+                ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("rot_blend2"), dmRig::PLAYBACK_LOOP_PINGPONG, 1.0f, 0.0f, 1.0f));
+                break;
+            }
+        }
+    }
+
+    const float dts[] = { 0.0f, 0.25f, 0.5f, 1.0f, 0.75f, 1.0f, 2.0f };
+    for (uint32_t frame = 0; frame < sizeof(dts) / sizeof(dts[0]); ++frame)
+    {
+        ASSERT_EQ(dmRig::Update(m_Contexts[0], dts[frame]), dmRig::Update(m_Contexts[1], dts[frame]));
+
+        for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+        {
+            dmArray<dmTransform::Transform>& pose0 = *dmRig::GetPose(m_Instances[0][i]);
+            dmArray<dmTransform::Transform>& pose1 = *dmRig::GetPose(m_Instances[1][i]);
+            ASSERT_EQ(pose0.Size(), pose1.Size());
+            for (uint32_t k = 0; k < pose0.Size(); ++k)
+            {
+                float t0[10], t1[10];
+                TransformToFloats(pose0[k], t0);
+                TransformToFloats(pose1[k], t1);
+                ASSERT_EQ(0, memcmp(t0, t1, sizeof(t0)));
+            }
+
+            dmRig::RigSpineModelVertex data[2][4];
+            uint32_t vertex_count = dmRig::GetVertexCount(m_Instances[0][i]);
+            ASSERT_GE(4u, vertex_count);
+            for (uint32_t c = 0; c < 2; ++c)
+            {
+                memset(data[c], 0, sizeof(data[c]));
+                dmRig::GenerateVertexData(m_Contexts[c], m_Instances[c][i], Matrix4::identity(), Matrix4::identity(), Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_SPINE, (void*)data[c]);
+            }
+            ASSERT_EQ(0, memcmp(data[0], data[1], sizeof(data[0])));
+        }
+    }
+
+    // One completed event per instance playing "valid" once, in instance order
+    ASSERT_EQ(INSTANCE_COUNT / 4, m_Events[0].Size());
+    ASSERT_EQ(m_Events[0].Size(), m_Events[1].Size());
+    for (uint32_t i = 0; i < m_Events[0].Size(); ++i)
+    {
+        ASSERT_EQ(m_Events[0][i].m_Instance, m_Events[1][i].m_Instance);
+        ASSERT_EQ(m_Events[0][i].m_Type, m_Events[1][i].m_Type);
+        ASSERT_EQ(m_Events[0][i].m_AnimationId, m_Events[1][i].m_AnimationId);
+    }
+}
+
+/**
+ * Measure the number of rig instances animated per ms, on the calling thread and on the worker pool
+ */
+TEST_F(RigWorkerPoolTest, BenchUpdate)
+{
+    const uint32_t frame_count = 200;
+    const char* names[] = { "calling thread", "worker pool" };
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+        {
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instances[c][i], dmHashString64("rot_blend1"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instances[c][i], dmHashString64("rot_blend2"), dmRig::PLAYBACK_LOOP_PINGPONG, 1.0f, 0.0f, 1.0f));
+        }
+
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            dmRig::Update(m_Contexts[c], 1.0f / 60.0f);
+        }
+        uint64_t end = dmTime::GetTime();
+        double ms = (end - start) / 1000.0;
+        printf("Update %u rig instances, %s: %.2f ms/frame, %.1f instances/ms\n", INSTANCE_COUNT, names[c], ms / frame_count, INSTANCE_COUNT * frame_count / ms);
+    }
+}
+
+// Samples the animations from the animation set and from the compressed animation set,
+// with a copy of the animation set without bone track samples (like the animation set resource)
+class RigCompressedAnimationTest : public RigInstanceTest
+{
+public:
+    dmRig::CompressedAnimationSet* m_CompressedAnimationSet;
+    dmRigDDF::AnimationSet*        m_StrippedAnimationSet;
+    dmRig::HRigInstance            m_CompressedInstance;
+
+protected:
+    virtual void SetUp() {
+        RigInstanceTest::SetUp();
+
+        m_CompressedAnimationSet = dmRig::CompressAnimationSet(*m_AnimationSet);
+        uint32_t size = 0;
+        m_StrippedAnimationSet = dmRig::CopyAnimationSetWithoutBoneTracks(m_AnimationSet, &size);
+
+        m_CompressedInstance = 0x0;
+        dmRig::InstanceCreateParams create_params = {0};
+        create_params.m_Context                = m_Context;
+        create_params.m_Instance               = &m_CompressedInstance;
+        create_params.m_BindPose               = &m_BindPose;
+        create_params.m_Skeleton               = m_Skeleton;
+        create_params.m_MeshSet                = m_MeshSet;
+        create_params.m_AnimationSet           = m_StrippedAnimationSet;
+        create_params.m_CompressedAnimationSet = m_CompressedAnimationSet;
+        create_params.m_TrackIdxToPose         = &m_TrackIdxToPose;
+        create_params.m_PoseIdxToInfluence     = &m_PoseIdxToInfluence;
+        create_params.m_MeshId                 = dmHashString64("test");
+        create_params.m_DefaultAnimation       = dmHashString64("");
+        if (dmRig::RESULT_OK != dmRig::InstanceCreate(create_params)) {
+            dmLogError("Could not create rig instance!");
+        }
+    }
+
+    virtual void TearDown() {
+        dmRig::InstanceDestroyParams destroy_params = {0};
+        destroy_params.m_Context = m_Context;
+        destroy_params.m_Instance = m_CompressedInstance;
+        if (dmRig::RESULT_OK != dmRig::InstanceDestroy(destroy_params)) {
+            dmLogError("Could not delete rig instance!");
+        }
+        dmRig::DeleteCompressedAnimationSet(m_CompressedAnimationSet);
+        dmDDF::FreeMessage(m_StrippedAnimationSet);
+
+        RigInstanceTest::TearDown();
+    }
+};
+
+TEST_F(RigCompressedAnimationTest, SameAsUncompressed)
+{
+    ASSERT_NE((dmRigDDF::AnimationSet*) 0x0, m_StrippedAnimationSet);
+    ASSERT_EQ(m_AnimationSet->m_Animations.m_Count, m_StrippedAnimationSet->m_Animations.m_Count);
+    for (uint32_t a = 0; a < m_StrippedAnimationSet->m_Animations.m_Count; ++a)
+    {
+        const dmRigDDF::RigAnimation& animation = m_StrippedAnimationSet->m_Animations[a];
+        ASSERT_EQ(m_AnimationSet->m_Animations[a].m_Tracks.m_Count, animation.m_Tracks.m_Count);
+        for (uint32_t t = 0; t < animation.m_Tracks.m_Count; ++t)
+        {
+            ASSERT_EQ(m_AnimationSet->m_Animations[a].m_Tracks[t].m_BoneIndex, animation.m_Tracks[t].m_BoneIndex);
+            ASSERT_EQ(0u, animation.m_Tracks[t].m_Positions.m_Count + animation.m_Tracks[t].m_Rotations.m_Count + animation.m_Tracks[t].m_Scale.m_Count);
+        }
+    }
+
+    const char* animations[] = { "valid", "ik", "scaling", "rot_blend1", "rot_blend2", "trans_rot" };
+    const float dts[] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f, 1.5f };
+    const float epsilon = 0.001f;
+
+    for (uint32_t a = 0; a < sizeof(animations) / sizeof(animations[0]); ++a)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64(animations[a]), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_CompressedInstance, dmHashString64(animations[a]), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+        for (uint32_t frame = 0; frame < sizeof(dts) / sizeof(dts[0]); ++frame)
+        {
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, dts[frame]));
+
+            dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+            dmArray<dmTransform::Transform>& compressed_pose = *dmRig::GetPose(m_CompressedInstance);
+            ASSERT_EQ(pose.Size(), compressed_pose.Size());
+            for (uint32_t i = 0; i < pose.Size(); ++i)
+            {
+                ASSERT_NEAR(0.0f, length(pose[i].GetTranslation() - compressed_pose[i].GetTranslation()), epsilon);
+                ASSERT_NEAR(0.0f, length(pose[i].GetScale() - compressed_pose[i].GetScale()), epsilon);
+                // q and -q are the same rotation
+                ASSERT_NEAR(1.0f, fabsf(dot(pose[i].GetRotation(), compressed_pose[i].GetRotation())), epsilon);
+            }
+        }
+    }
+}
+
+/**
+ * Compress an animation where all bones have animated rotations, every other bone has an animated
+ * translation and all bones have a constant scale, and measure the size of the bone tracks.
+ */
+TEST(RigCompressedAnimation, Size)
+{
+    const uint32_t bone_count = 32;
+    const uint32_t frame_count = 121;
+
+    dmRigDDF::AnimationSet animation_set;
+    memset(&animation_set, 0, sizeof(animation_set));
+    animation_set.m_Animations.m_Data = new dmRigDDF::RigAnimation[1];
+    animation_set.m_Animations.m_Count = 1;
+    dmRigDDF::RigAnimation& anim = animation_set.m_Animations.m_Data[0];
+    memset(&anim, 0, sizeof(anim));
+    anim.m_Id = dmHashString64("size");
+    anim.m_Duration = 4.0f;
+    anim.m_SampleRate = 30.0f;
+    anim.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[bone_count];
+    anim.m_Tracks.m_Count = bone_count;
+
+    uint32_t uncompressed_size = 0;
+    for (uint32_t bi = 0; bi < bone_count; ++bi)
+    {
+        dmRigDDF::AnimationTrack& track = anim.m_Tracks.m_Data[bi];
+        memset(&track, 0, sizeof(track));
+        track.m_BoneIndex = bi;
+        track.m_Positions.m_Data = new float[frame_count * 3];
+        track.m_Positions.m_Count = frame_count * 3;
+        track.m_Rotations.m_Data = new float[frame_count * 4];
+        track.m_Rotations.m_Count = frame_count * 4;
+        track.m_Scale.m_Data = new float[frame_count * 3];
+        track.m_Scale.m_Count = frame_count * 3;
+        for (uint32_t f = 0; f < frame_count; ++f)
+        {
+            float t = (bi & 1) ? 0.0f : (float)f;
+            track.m_Positions.m_Data[f*3+0] = t;
+            track.m_Positions.m_Data[f*3+1] = 2.0f * t;
+            track.m_Positions.m_Data[f*3+2] = 0.0f;
+            Quat q = Quat::rotationZ(0.05f * f + bi);
+            track.m_Rotations.m_Data[f*4+0] = q.getX();
+            track.m_Rotations.m_Data[f*4+1] = q.getY();
+            track.m_Rotations.m_Data[f*4+2] = q.getZ();
+            track.m_Rotations.m_Data[f*4+3] = q.getW();
+            track.m_Scale.m_Data[f*3+0] = 1.0f;
+            track.m_Scale.m_Data[f*3+1] = 1.0f;
+            track.m_Scale.m_Data[f*3+2] = 1.0f;
+        }
+        uncompressed_size += (track.m_Positions.m_Count + track.m_Rotations.m_Count + track.m_Scale.m_Count) * sizeof(float);
+    }
+
+    dmRig::CompressedAnimationSet* compressed = dmRig::CompressAnimationSet(animation_set);
+    ASSERT_EQ(1u, compressed->m_AnimationCount);
+    const dmRig::CompressedAnimation& compressed_anim = compressed->m_Animations[0];
+    ASSERT_EQ(bone_count * 3, compressed_anim.m_Tracks.Size());
+    ASSERT_EQ(frame_count, compressed_anim.m_FrameCount);
+
+    uint32_t constant_count = 0;
+    for (uint32_t i = 0; i < compressed_anim.m_Tracks.Size(); ++i)
+    {
+        constant_count += compressed_anim.m_Tracks[i].m_Constant;
+    }
+    ASSERT_EQ(bone_count + bone_count / 2, constant_count);
+    // Three 16 bit values per animated rotation and translation
+    ASSERT_EQ((bone_count + bone_count / 2) * 3, compressed_anim.m_FrameSize);
+
+    uint32_t compressed_size = dmRig::GetCompressedAnimationSetSize(compressed);
+    printf("Bone tracks of %u bones, %u frames: %u bytes, compressed %u bytes (%.1fx)\n", bone_count, frame_count, uncompressed_size, compressed_size, uncompressed_size / (float)compressed_size);
+    ASSERT_GT(uncompressed_size, 3 * compressed_size);
+
+    // Resident memory of the loaded animation set message, and of the copy kept by the resource with the compressed tracks
+    dmArray<uint8_t> buffer;
+    ASSERT_EQ(dmDDF::RESULT_OK, dmDDF::SaveMessageToArray(&animation_set, dmRigDDF::AnimationSet::m_DDFDescriptor, buffer));
+    dmRigDDF::AnimationSet* loaded = 0x0;
+    uint32_t loaded_size = 0;
+    ASSERT_EQ(dmDDF::RESULT_OK, dmDDF::LoadMessage(buffer.Begin(), buffer.Size(), dmRigDDF::AnimationSet::m_DDFDescriptor, (void**) &loaded, 0, &loaded_size));
+    uint32_t stripped_size = 0;
+    dmRigDDF::AnimationSet* stripped = dmRig::CopyAnimationSetWithoutBoneTracks(loaded, &stripped_size);
+    ASSERT_NE((dmRigDDF::AnimationSet*) 0x0, stripped);
+    printf("Resident animation set: %u bytes, with compressed tracks %u + %u bytes\n", loaded_size, stripped_size, compressed_size);
+    ASSERT_GT(loaded_size, 3 * (stripped_size + compressed_size));
+    dmDDF::FreeMessage(stripped);
+    dmDDF::FreeMessage(loaded);
+
+    dmRig::DeleteCompressedAnimationSet(compressed);
+    DeleteRigAnimation(anim);
+    delete [] animation_set.m_Animations.m_Data;
+}
+
+// Replaces the mesh data with vertex_count vertices, where each group of three vertices has the same position
+// and normal, influenced by the same bone with one, two and four weights.
+static void CreateSkinningMesh(dmRigDDF::Mesh& mesh, uint32_t vertex_count, uint32_t bone_count)
+{
+    delete [] mesh.m_NormalsIndices.m_Data;
+    delete [] mesh.m_Normals.m_Data;
+    delete [] mesh.m_BoneIndices.m_Data;
+    delete [] mesh.m_Weights.m_Data;
+    delete [] mesh.m_MeshColor.m_Data;
+    delete [] mesh.m_Texcoord0Indices.m_Data;
+    delete [] mesh.m_Texcoord0.m_Data;
+    delete [] mesh.m_Positions.m_Data;
+    delete [] mesh.m_PositionIndices.m_Data;
+    memset(&mesh, 0, sizeof(mesh));
+
+    mesh.m_Positions.m_Data = new float[vertex_count*3];
+    mesh.m_Positions.m_Count = vertex_count*3;
+    mesh.m_Normals.m_Data = new float[vertex_count*3];
+    mesh.m_Normals.m_Count = vertex_count*3;
+    mesh.m_Texcoord0.m_Data = new float[vertex_count*2];
+    mesh.m_Texcoord0.m_Count = vertex_count*2;
+    mesh.m_PositionIndices.m_Data = new uint32_t[vertex_count];
+    mesh.m_PositionIndices.m_Count = vertex_count;
+    mesh.m_NormalsIndices.m_Data = new uint32_t[vertex_count];
+    mesh.m_NormalsIndices.m_Count = vertex_count;
+    mesh.m_BoneIndices.m_Data = new uint32_t[vertex_count*4];
+    mesh.m_BoneIndices.m_Count = vertex_count*4;
+    mesh.m_Weights.m_Data = new float[vertex_count*4];
+    mesh.m_Weights.m_Count = vertex_count*4;
+
+    const float weights[3][4] = { {1.0f, 0.0f, 0.0f, 0.0f}, {0.5f, 0.5f, 0.0f, 0.0f}, {0.25f, 0.25f, 0.25f, 0.25f} };
+    for (uint32_t i = 0; i < vertex_count; ++i)
+    {
+        uint32_t group = i / 3;
+        mesh.m_Positions.m_Data[i*3+0] = (float)((group * 7919) % 200) - 100.0f;
+        mesh.m_Positions.m_Data[i*3+1] = (float)((group * 104729) % 200) - 100.0f;
+        mesh.m_Positions.m_Data[i*3+2] = (float)(group % 10);
+        mesh.m_Normals.m_Data[i*3+0] = (group & 1) ? 1.0f : 0.0f;
+        mesh.m_Normals.m_Data[i*3+1] = (group & 1) ? 0.0f : 1.0f;
+        mesh.m_Normals.m_Data[i*3+2] = 0.0f;
+        mesh.m_Texcoord0.m_Data[i*2+0] = 0.0f;
+        mesh.m_Texcoord0.m_Data[i*2+1] = 0.0f;
+        mesh.m_PositionIndices.m_Data[i] = i;
+        mesh.m_NormalsIndices.m_Data[i] = i;
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            mesh.m_BoneIndices.m_Data[i*4+j] = group % bone_count;
+            mesh.m_Weights.m_Data[i*4+j] = weights[i % 3][j];
+        }
+    }
+}
+
+class RigSkinningTest : public RigInstanceTest
+{
+protected:
+    void SetVertexCount(uint32_t vertex_count)
+    {
+        const uint32_t bone_count = m_Skeleton->m_Bones.m_Count;
+        CreateSkinningMesh(m_MeshSet->m_MeshAttachments[0], vertex_count, bone_count);
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("rot_blend1"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("rot_blend2"), dmRig::PLAYBACK_LOOP_PINGPONG, 1.0f, 0.0f, 1.0f));
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.5f));
+        ASSERT_EQ(vertex_count, dmRig::GetVertexCount(m_Instance));
+    }
+};
+
+// Single bone vertices are transformed with the pose matrix premultiplied with the model matrix,
+// the result should match the same vertex transformed with the blended path
+TEST_F(RigSkinningTest, SingleBoneSameAsBlended)
+{
+    const uint32_t vertex_count = 3 * 64;
+    SetVertexCount(vertex_count);
+
+    Matrix4 model_matrix = Matrix4::translation(Vector3(10.0f, -20.0f, 30.0f)) * Matrix4::rotationZ(0.7f) * Matrix4::scale(Vector3(2.0f, 3.0f, 1.0f));
+    Matrix4 normal_matrix = Matrix4::rotationZ(0.7f);
+
+    dmRig::RigModelVertex* data = new dmRig::RigModelVertex[vertex_count];
+    ASSERT_EQ(data + vertex_count, dmRig::GenerateVertexData(m_Context, m_Instance, model_matrix, normal_matrix, Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)data));
+
+    const float epsilon = 0.001f;
+    for (uint32_t i = 0; i < vertex_count; i += 3)
+    {
+        for (uint32_t j = 1; j < 3; ++j)
+        {
+            ASSERT_NEAR(data[i].x, data[i+j].x, epsilon);
+            ASSERT_NEAR(data[i].y, data[i+j].y, epsilon);
+            ASSERT_NEAR(data[i].z, data[i+j].z, epsilon);
+            ASSERT_NEAR(data[i].nx, data[i+j].nx, epsilon);
+            ASSERT_NEAR(data[i].ny, data[i+j].ny, epsilon);
+            ASSERT_NEAR(data[i].nz, data[i+j].nz, epsilon);
+        }
+    }
+
+    delete [] data;
+}
+
+/**
+ * Measure the number of skinned vertices generated per second
+ */
+TEST_F(RigSkinningTest, BenchGenerateVertexData)
+{
+    const uint32_t vertex_counts[] = { 1020, 10020, 50010 };
+    for (uint32_t c = 0; c < sizeof(vertex_counts) / sizeof(vertex_counts[0]); ++c)
+    {
+        const uint32_t vertex_count = vertex_counts[c];
+        SetVertexCount(vertex_count);
+
+        dmRig::RigModelVertex* data = new dmRig::RigModelVertex[vertex_count];
+        const uint32_t iterations = 2000000 / vertex_count;
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            dmRig::GenerateVertexData(m_Context, m_Instance, Matrix4::identity(), Matrix4::identity(), Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)data);
+        }
+        uint64_t end = dmTime::GetTime();
+        delete [] data;
+
+        double seconds = (end - start) / 1000000.0;
+        printf("Generate %u vertices: %.3f ms, %.1f M vertices/s\n", vertex_count, seconds * 1000.0 / iterations, vertex_count * iterations / seconds / 1000000.0);
+    }
+}
+
+// Animates the same rig at full rate and with a level of detail
+class RigLODTest : public RigInstanceTest
+{
+public:
+    dmRig::HRigInstance m_LODInstance;
+
+protected:
+    virtual void SetUp() {
+        RigInstanceTest::SetUp();
+
+        m_LODInstance = 0x0;
+        dmRig::InstanceCreateParams create_params = {0};
+        create_params.m_Context            = m_Context;
+        create_params.m_Instance           = &m_LODInstance;
+        create_params.m_BindPose           = &m_BindPose;
+        create_params.m_Skeleton           = m_Skeleton;
+        create_params.m_MeshSet            = m_MeshSet;
+        create_params.m_AnimationSet       = m_AnimationSet;
+        create_params.m_TrackIdxToPose     = &m_TrackIdxToPose;
+        create_params.m_PoseIdxToInfluence = &m_PoseIdxToInfluence;
+        create_params.m_MeshId             = dmHashString64("test");
+        create_params.m_DefaultAnimation   = dmHashString64("");
+        if (dmRig::RESULT_OK != dmRig::InstanceCreate(create_params)) {
+            dmLogError("Could not create rig instance!");
+        }
+    }
+
+    virtual void TearDown() {
+        dmRig::InstanceDestroyParams destroy_params = {0};
+        destroy_params.m_Context = m_Context;
+        destroy_params.m_Instance = m_LODInstance;
+        if (dmRig::RESULT_OK != dmRig::InstanceDestroy(destroy_params)) {
+            dmLogError("Could not delete rig instance!");
+        }
+
+        RigInstanceTest::TearDown();
+    }
+
+    void SetLOD(uint32_t update_interval, uint32_t animated_bone_count, bool skip_ik) {
+        dmRig::RigLOD lod;
+        lod.m_UpdateInterval = update_interval;
+        lod.m_AnimatedBoneCount = animated_bone_count;
+        lod.m_SkipIK = skip_ik;
+        dmRig::SetLOD(m_LODInstance, lod);
+    }
+};
+
+// A throttled instance samples its pose every second update and interpolates towards it in between
+TEST_F(RigLODTest, UpdateInterval)
+{
+    SetLOD(2, 0, false);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_LODInstance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    const dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+    const dmArray<dmTransform::Transform>& lod_pose = *dmRig::GetPose(m_LODInstance);
+    uint32_t bone_count = pose.Size();
+
+    const uint32_t update_count = 8;
+    dmArray<dmTransform::Transform> poses;
+    poses.SetCapacity(bone_count * update_count);
+    for (uint32_t u = 0; u < update_count; ++u)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.5f));
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            poses.Push(pose[bi]);
+        }
+
+        // The cursor is advanced every update
+        ASSERT_NEAR(dmRig::GetCursor(m_Instance, false), dmRig::GetCursor(m_LODInstance, false), RIG_EPSILON_FLOAT);
+
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            // The first update samples the pose, after that the pose lags one update behind
+            const dmTransform::Transform& t1 = poses[(u > 0 ? u - 1 : 0) * bone_count + bi];
+            const dmTransform::Transform& t0 = poses[(u > 1 ? u - 2 : 0) * bone_count + bi];
+            float t = (u > 0 && (u % 2) == 0) ? 0.5f : 1.0f;
+            const dmTransform::Transform& from = (u % 2) == 0 ? t0 : t1;
+            const dmTransform::Transform& to = (u % 2) == 0 ? poses[u * bone_count + bi] : t1;
+            ASSERT_VEC3(lerp(t, from.GetTranslation(), to.GetTranslation()), lod_pose[bi].GetTranslation());
+            ASSERT_VEC4(slerp(t, from.GetRotation(), to.GetRotation()), lod_pose[bi].GetRotation());
+        }
+    }
+}
+
+// A culled instance keeps playing and posting events, but its pose is not sampled. It is still skinned from the last pose.
+TEST_F(RigLODTest, Culled)
+{
+    dmArray<RigEventRecord> events;
+    dmRig::SetEventCallback(m_LODInstance, RecordEventCallback, &events, 0);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_LODInstance, dmHashString64("valid"), dmRig::PLAYBACK_ONCE_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    dmRig::SetCulled(m_LODInstance, true);
+    ASSERT_TRUE(dmRig::GetCulled(m_LODInstance));
+
+    const dmArray<dmTransform::Transform>& lod_pose = *dmRig::GetPose(m_LODInstance);
+    for (uint32_t u = 0; u < 4; ++u)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+        ASSERT_VEC4(Quat::identity(), lod_pose[0].GetRotation());
+        ASSERT_VEC4(Quat::identity(), lod_pose[1].GetRotation());
+        ASSERT_EQ(4u, dmRig::GetVertexCount(m_LODInstance));
+    }
+
+    ASSERT_EQ(1u, events.Size());
+    ASSERT_EQ(dmRig::RIG_EVENT_TYPE_COMPLETED, events[0].m_Type);
+    ASSERT_EQ(dmHashString64("valid"), events[0].m_AnimationId);
+
+    dmRig::SetCulled(m_LODInstance, false);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.0f));
+    ASSERT_EQ(4u, dmRig::GetVertexCount(m_LODInstance));
+}
+
+TEST_F(RigLODTest, AnimatedBoneCount)
+{
+    SetLOD(1, 1, false);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_LODInstance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    const dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+    const dmArray<dmTransform::Transform>& lod_pose = *dmRig::GetPose(m_LODInstance);
+
+    // sample 1, only the second bone is animated
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_VEC4(Quat::rotationZ((float)M_PI / 2.0f), pose[1].GetRotation());
+    ASSERT_VEC4(Quat::identity(), lod_pose[1].GetRotation());
+
+    // sample 2, only the first bone is animated
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+    ASSERT_VEC4(Quat::rotationZ((float)M_PI / 2.0f), pose[0].GetRotation());
+    ASSERT_VEC4(Quat::rotationZ((float)M_PI / 2.0f), lod_pose[0].GetRotation());
+}
+
+TEST_F(RigLODTest, SkipIK)
+{
+    SetLOD(1, 0, true);
+    dmRig::HRigInstance instances[] = { m_Instance, m_LODInstance };
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instances[i], dmHashString64("ik"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+        dmRig::IKTarget* target = dmRig::GetIKTarget(instances[i], dmHashString64("test_ik"));
+        ASSERT_NE((dmRig::IKTarget*)0x0, target);
+        target->m_Callback = UpdateIKPositionCallback;
+        target->m_Mix = 1.0f;
+        target->m_Position = Vector3(100.0f, 1.0f, 0.0f);
+    }
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0f));
+
+    const dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+    const dmArray<dmTransform::Transform>& lod_pose = *dmRig::GetPose(m_LODInstance);
+    ASSERT_VEC4(Quat::rotationZ(-(float)M_PI / 2.0f), pose[4].GetRotation());
+    ASSERT_VEC4(Quat::identity(), lod_pose[4].GetRotation());
+}
+
 #undef ASSERT_VEC3
 #undef ASSERT_VEC4
 #undef ASSERT_VEC4_NEAR
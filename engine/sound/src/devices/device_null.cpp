@@ -11,43 +11,97 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <dlib/math.h>
+#include <dlib/time.h>
 #include "sound.h"
 
 namespace dmDeviceNull
 {
+    // Mix rate reported by the device
+    static const uint32_t NULL_DEVICE_MIX_RATE = 44100;
+
+    /**
+     * Discards the queued buffers, but consumes them at the rate of a real device
+     * so that sounds play to the end, e.g. when running headless
+     */
+    struct NullDevice
+    {
+        uint64_t m_Time;
+        uint64_t m_PlayedFrames;
+        uint32_t m_BufferCount;
+        uint32_t m_FrameCount;
+        uint32_t m_QueuedBuffers;
+        bool     m_Started;
+    };
+
+    static void ConsumeBuffers(NullDevice* device)
+    {
+        uint64_t now = dmTime::GetTime();
+        if (device->m_Started && device->m_QueuedBuffers > 0)
+        {
+            device->m_PlayedFrames += ((now - device->m_Time) * NULL_DEVICE_MIX_RATE) / 1000000U;
+            uint32_t played = (uint32_t) dmMath::Min((uint64_t) device->m_QueuedBuffers, device->m_PlayedFrames / device->m_FrameCount);
+            device->m_QueuedBuffers -= played;
+            device->m_PlayedFrames -= (uint64_t) played * device->m_FrameCount;
+            if (device->m_QueuedBuffers == 0)
+                device->m_PlayedFrames = 0;
+        }
+        device->m_Time = now;
+    }
+
     dmSound::Result DeviceNullOpen(const dmSound::OpenDeviceParams* params, dmSound::HDevice* device)
     {
+        NullDevice* d = new NullDevice;
+        d->m_Time = dmTime::GetTime();
+        d->m_PlayedFrames = 0;
+        d->m_BufferCount = params->m_BufferCount;
+        d->m_FrameCount = dmMath::Max(1U, params->m_FrameCount);
+        d->m_QueuedBuffers = 0;
+        d->m_Started = false;
+        *device = d;
         return dmSound::RESULT_OK;
     }
 
     void DeviceNullClose(dmSound::HDevice device)
     {
+        delete (NullDevice*) device;
     }
 
     dmSound::Result DeviceNullQueue(dmSound::HDevice device, const int16_t* samples, uint32_t sample_count)
     {
+        NullDevice* d = (NullDevice*) device;
+        ConsumeBuffers(d);
+        if (d->m_QueuedBuffers >= d->m_BufferCount)
+            return dmSound::RESULT_OUT_OF_BUFFERS;
+        d->m_QueuedBuffers++;
         return dmSound::RESULT_OK;
     }
 
     uint32_t DeviceNullFreeBufferSlots(dmSound::HDevice device)
     {
-        return 0;
+        NullDevice* d = (NullDevice*) device;
+        ConsumeBuffers(d);
+        return d->m_BufferCount - d->m_QueuedBuffers;
     }
 
     void DeviceNullDeviceInfo(dmSound::HDevice device, dmSound::DeviceInfo* info)
     {
+        info->m_MixRate = NULL_DEVICE_MIX_RATE;
     }
 
     void DeviceNullRestart(dmSound::HDevice device)
     {
-
+        NullDevice* d = (NullDevice*) device;
+        d->m_Started = true;
+        d->m_Time = dmTime::GetTime();
     }
 
     void DeviceNullStop(dmSound::HDevice device)
     {
-
+        NullDevice* d = (NullDevice*) device;
+        ConsumeBuffers(d);
+        d->m_Started = false;
     }
 
     DM_DECLARE_SOUND_DEVICE(NullSoundDevice, "null", DeviceNullOpen, DeviceNullClose, DeviceNullQueue, DeviceNullFreeBufferSlots, DeviceNullDeviceInfo, DeviceNullRestart, DeviceNullStop);
 }
-
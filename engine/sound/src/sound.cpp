@@ -11,11 +11,15 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <dlib/atomic.h>
 #include <dlib/hashtable.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/mutex.h>
 #include <dlib/profile.h>
+#include <dlib/thread.h>
+#include <dlib/time.h>
 
 #include "sound.h"
 #include "sound_codec.h"
@@ -36,6 +40,8 @@ namespace dmSound
     #define SOUND_MAX_MIX_CHANNELS (2)
     #define SOUND_OUTBUFFER_COUNT (6)
     #define SOUND_MAX_SPEED (5)
+    // Must be a power of two
+    #define SOUND_COMMAND_QUEUE_SIZE (1024)
 
     // TODO: How many bits?
     const uint32_t RESAMPLE_FRACTION_BITS = 31;
@@ -95,28 +101,6 @@ namespace dmSound
         float m_Next;
     };
 
-    /**
-     * Helper for calculating ramps
-     */
-    struct Ramp
-    {
-        float m_From, m_To, m_TotalSamplesRecip;
-
-        Ramp(const Value* value, uint32_t buffer, uint32_t total_buffers, uint32_t total_samples)
-        {
-            float ramp_length = (value->m_Current - value->m_Prev) / total_buffers;
-            m_From = value->m_Prev + ramp_length * buffer;
-            m_To = m_From + ramp_length;
-            m_TotalSamplesRecip = 1.0f / total_samples;
-        }
-
-        inline float GetValue(int i) const
-        {
-            float mix = i * m_TotalSamplesRecip;
-            return m_From + mix * (m_To - m_From);
-        }
-    };
-
     /**
      * Context with data for mixing N buffers, i.e. during update
      */
@@ -135,7 +119,11 @@ namespace dmSound
 
     Ramp GetRamp(const MixContext* mix_context, const Value* value, uint32_t total_samples)
     {
-        Ramp ramp(value, mix_context->m_CurrentBuffer, mix_context->m_TotalBuffers, total_samples);
+        Ramp ramp;
+        float ramp_length = (value->m_Current - value->m_Prev) / mix_context->m_TotalBuffers;
+        ramp.m_From = value->m_Prev + ramp_length * mix_context->m_CurrentBuffer;
+        ramp.m_To = ramp.m_From + ramp_length;
+        ramp.m_TotalSamplesRecip = 1.0f / total_samples;
         return ramp;
     }
 
@@ -161,6 +149,12 @@ namespace dmSound
         uint32_t    m_FrameCount;
         uint64_t    m_FrameFraction;
 
+        // Playing state as seen by the game thread, (serial << 1) | playing
+        // The serial is bumped for each play/stop/pause so that the mixer
+        // never clears a state it hasn't seen yet, see SetStopped()
+        int32_atomic_t m_PlayState;
+        uint32_t    m_PlaySerial; // Serial of the last applied play/stop/pause
+
         uint16_t    m_Index;
         uint16_t    m_SoundDataIndex;
         uint8_t     m_Looping : 1;
@@ -173,12 +167,38 @@ namespace dmSound
     {
         dmhash_t m_NameHash;
         Value    m_Gain;
+        float    m_RequestedGain; // Last gain set from the game thread
         float*   m_MixBuffer;
         float    m_SumSquaredMemory[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
         float    m_PeakMemorySq[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
         int      m_NextMemorySlot;
     };
 
+    enum CommandType
+    {
+        COMMAND_PLAY               = 0,
+        COMMAND_STOP               = 1,
+        COMMAND_PAUSE              = 2,
+        COMMAND_SET_LOOPING        = 3,
+        COMMAND_SET_PARAMETER      = 4,
+        COMMAND_SET_INSTANCE_GROUP = 5,
+        COMMAND_SET_GROUP_GAIN     = 6,
+    };
+
+    /**
+     * State change issued from the game thread. In threaded mode the commands are
+     * queued and applied by the mixer thread before the next mix, see PushCommand()
+     */
+    struct Command
+    {
+        dmhash_t    m_Group;
+        float       m_Value;
+        uint32_t    m_Serial;
+        uint16_t    m_Index;     // Instance or group index
+        uint8_t     m_Type;      // CommandType
+        uint8_t     m_Parameter; // Parameter, or flag for pause/looping
+    };
+
     struct SoundSystem
     {
         dmSoundCodec::HCodecContext   m_CodecContext;
@@ -203,9 +223,30 @@ namespace dmSound
         int16_t*                m_OutBuffers[SOUND_OUTBUFFER_COUNT];
         uint16_t                m_NextOutBuffer;
 
+        const MixKernels*       m_MixKernels;
+        // Scratch buffers for mixing one instance, m_FrameCount frames each
+        float*                  m_MixFrames; // Converted/resampled frames, up to SOUND_MAX_MIX_CHANNELS interleaved
+        float*                  m_MixLeft;   // Per frame gain and pan
+        float*                  m_MixRight;
+
+        // Protects the mixer state when mixing on a separate thread
+        dmMutex::HMutex         m_Mutex;
+        dmThread::Thread        m_Thread;
+        int32_atomic_t          m_IsRunning;
+        // Polled on the game thread since the platform query may not be callable from the mixer thread
+        int32_atomic_t          m_PlatformPhoneCallActive;
+        // Set on the game thread, may be read while the mixer thread is running
+        int32_atomic_t          m_HasWindowFocus;
+        uint32_t                m_ThreadSleepTime;
+
+        // Single producer (game thread), single consumer (mixer, with m_Mutex held) ring buffer
+        Command                 m_Commands[SOUND_COMMAND_QUEUE_SIZE];
+        int32_atomic_t          m_CommandWrite;
+        int32_atomic_t          m_CommandRead;
+
         bool                    m_IsDeviceStarted;
         bool                    m_IsPhoneCallActive;
-        bool                    m_HasWindowFocus;
+        bool                    m_UseThread;
     };
 
     SoundSystem* g_SoundSystem = 0;
@@ -223,6 +264,7 @@ namespace dmSound
         params->m_BufferSize = 12 * 4096;
         params->m_FrameCount = 768;
         params->m_MaxInstances = 256;
+        params->m_UseThread = false;
     }
 
     Result RegisterDevice(struct DeviceType* device)
@@ -263,6 +305,7 @@ namespace dmSound
         SoundGroup* group = &sound->m_Groups[index];
         group->m_NameHash = group_hash;
         group->m_Gain.Reset(1.0f);
+        group->m_RequestedGain = 1.0f;
         size_t mix_buffer_size = sound->m_FrameCount * sizeof(float) * SOUND_MAX_MIX_CHANNELS;
         group->m_MixBuffer = (float*) malloc(mix_buffer_size);
         memset(group->m_MixBuffer, 0, mix_buffer_size);
@@ -270,6 +313,29 @@ namespace dmSound
         return index;
     }
 
+    static Result UpdateInternal(SoundSystem* sound, bool is_phone_call_active);
+
+    static inline int32_t AtomicGet(int32_atomic_t* ptr)
+    {
+        return dmAtomicAdd32(ptr, 0);
+    }
+
+    static void FlushCommands(SoundSystem* sound);
+
+    static void SoundThread(void* ctx)
+    {
+        SoundSystem* sound = (SoundSystem*) ctx;
+        while (AtomicGet(&sound->m_IsRunning))
+        {
+            {
+                DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+                FlushCommands(sound);
+                UpdateInternal(sound, AtomicGet(&sound->m_PlatformPhoneCallActive) != 0);
+            }
+            dmTime::Sleep(sound->m_ThreadSleepTime);
+        }
+    }
+
     Result Initialize(dmConfigFile::HConfig config, const InitializeParams* params)
     {
         Result r = PlatformInitialize(config, params);
@@ -298,7 +364,7 @@ namespace dmSound
         SoundSystem* sound = g_SoundSystem;
         sound->m_IsDeviceStarted = false;
         sound->m_IsPhoneCallActive = false;
-        sound->m_HasWindowFocus = true; // Assume we startup with the window focused
+        dmAtomicStore32(&sound->m_HasWindowFocus, 1); // Assume we startup with the window focused
         sound->m_DeviceType = device_type;
         sound->m_Device = device;
         dmSoundCodec::NewCodecContextParams codec_params;
@@ -309,6 +375,7 @@ namespace dmSound
         uint32_t max_buffers = params->m_MaxBuffers;
         uint32_t max_sources = params->m_MaxSources;
         uint32_t max_instances = params->m_MaxInstances;
+        bool use_thread = params->m_UseThread;
 
         if (config)
         {
@@ -317,8 +384,13 @@ namespace dmSound
             max_buffers = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_buffers", (int32_t) max_buffers);
             max_sources = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_sources", (int32_t) max_sources);
             max_instances = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_instances", (int32_t) max_instances);
+            use_thread = dmConfigFile::GetInt(config, "sound.use_thread", (int32_t) use_thread) != 0;
         }
 
+#if defined(__EMSCRIPTEN__)
+        use_thread = false;
+#endif
+
         sound->m_Instances.SetCapacity(max_instances);
         sound->m_Instances.SetSize(max_instances);
         sound->m_InstancesPool.SetCapacity(max_instances);
@@ -350,6 +422,11 @@ namespace dmSound
         }
         sound->m_NextOutBuffer = 0;
 
+        sound->m_MixKernels = GetMixKernels(MIX_KERNEL_SIMD);
+        sound->m_MixFrames = (float*) malloc(params->m_FrameCount * sizeof(float) * SOUND_MAX_MIX_CHANNELS);
+        sound->m_MixLeft = (float*) malloc(params->m_FrameCount * sizeof(float));
+        sound->m_MixRight = (float*) malloc(params->m_FrameCount * sizeof(float));
+
         memset(&g_SoundSystem->m_Stats, 0, sizeof(g_SoundSystem->m_Stats));
         sound->m_GroupMap.SetCapacity(MAX_GROUPS * 2 + 1, MAX_GROUPS);
         for (uint32_t i = 0; i < MAX_GROUPS; ++i) {
@@ -359,12 +436,33 @@ namespace dmSound
         int master_index = GetOrCreateGroup("master");
         SoundGroup* master = &sound->m_Groups[master_index];
         master->m_Gain.Reset(master_gain);
+        master->m_RequestedGain = master_gain;
+
+        sound->m_Mutex = dmMutex::New();
+        sound->m_CommandWrite = 0;
+        sound->m_CommandRead = 0;
+        sound->m_PlatformPhoneCallActive = 0;
+        sound->m_UseThread = use_thread;
+        if (use_thread)
+        {
+            // Wake up about twice per device buffer
+            uint32_t mix_rate = sound->m_MixRate > 0 ? sound->m_MixRate : 44100;
+            sound->m_ThreadSleepTime = dmMath::Max(1000U, (uint32_t) (((uint64_t) sound->m_FrameCount * 1000000U) / mix_rate / 2));
+            sound->m_IsRunning = 1;
+            sound->m_Thread = dmThread::New(SoundThread, 0x80000, sound, "sound");
+        }
 
         return RESULT_OK;
     }
 
     Result Finalize()
     {
+        if (g_SoundSystem && g_SoundSystem->m_UseThread)
+        {
+            dmAtomicStore32(&g_SoundSystem->m_IsRunning, 0);
+            dmThread::Join(g_SoundSystem->m_Thread);
+        }
+
         PlatformFinalize();
 
         Result result = RESULT_OK;
@@ -387,6 +485,10 @@ namespace dmSound
                 free((void*) sound->m_OutBuffers[i]);
             }
 
+            free((void*) sound->m_MixFrames);
+            free((void*) sound->m_MixLeft);
+            free((void*) sound->m_MixRight);
+
             for (uint32_t i = 0; i < MAX_GROUPS; i++) {
                 SoundGroup* g = &sound->m_Groups[i];
                 if (g->m_MixBuffer) {
@@ -396,6 +498,8 @@ namespace dmSound
 
             sound->m_DeviceType->m_Close(sound->m_Device);
 
+            dmMutex::Delete(sound->m_Mutex);
+
             delete sound;
             g_SoundSystem = 0;
         }
@@ -405,6 +509,7 @@ namespace dmSound
 
     void GetStats(Stats* stats)
     {
+        DM_MUTEX_SCOPED_LOCK(g_SoundSystem->m_Mutex);
         *stats = g_SoundSystem->m_Stats;
     }
 
@@ -414,9 +519,174 @@ namespace dmSound
         return dmHashReverseSafe64(hash);
     }
 
+    /**
+     * Mark the instance as stopped from the mixer, e.g. at end of stream.
+     * The game thread view is only cleared if no newer play/stop/pause has been issued.
+     */
+    static void SetStopped(SoundInstance* instance)
+    {
+        instance->m_Playing = 0;
+        int32_t serial = (int32_t) (instance->m_PlaySerial << 1);
+        dmAtomicCompareStore32(&instance->m_PlayState, serial, serial | 1);
+    }
+
+    // Called from the game thread only
+    static uint32_t SetPlayState(SoundInstance* instance, bool playing)
+    {
+        uint32_t serial = ((uint32_t) AtomicGet(&instance->m_PlayState) >> 1) + 1;
+        dmAtomicStore32(&instance->m_PlayState, (int32_t) ((serial << 1) | (playing ? 1 : 0)));
+        return serial;
+    }
+
+    static void ApplyGroupGain(SoundSystem* sound, SoundGroup* group, float gain)
+    {
+        // If all playing sounds is currently at gain zero
+        // we can safely do a hard reset of the group gain
+        bool reset = true;
+        uint32_t instances = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instances; ++i)
+        {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (instance->m_Group != group->m_NameHash)
+            {
+                continue;
+            }
+
+            if (instance->m_Playing || instance->m_FrameCount > 0)
+            {
+                if (instance->m_Gain.m_Prev == 0.0)
+                {
+                    continue;
+                }
+                reset = false;
+                break;
+            }
+        }
+
+        group->m_Gain.Set(gain, reset);
+    }
+
+    static void ApplyParameter(SoundInstance* instance, Parameter parameter, float value)
+    {
+        bool reset = !instance->m_Playing;
+        switch(parameter)
+        {
+            case PARAMETER_GAIN:
+                instance->m_Gain.Set(dmMath::Max(0.0f, value), reset);
+                break;
+            case PARAMETER_PAN:
+                {
+                    float pan = dmMath::Max(-1.0f, dmMath::Min(1.0f, value));
+                    pan = (pan + 1.0f) * 0.5f; // map [-1,1] to [0,1] for easier calculations later
+                    instance->m_Pan.Set(pan, reset);
+                }
+                break;
+            case PARAMETER_SPEED:
+                instance->m_Speed = dmMath::Max(0.0f, dmMath::Min((float)SOUND_MAX_SPEED, value));
+                break;
+            default:
+                break;
+        }
+    }
+
+    static void ApplyCommand(SoundSystem* sound, const Command& command)
+    {
+        switch (command.m_Type)
+        {
+            case COMMAND_PLAY:
+            case COMMAND_STOP:
+            case COMMAND_PAUSE:
+                {
+                    SoundInstance* instance = &sound->m_Instances[command.m_Index];
+                    instance->m_PlaySerial = command.m_Serial;
+                    if (command.m_Type == COMMAND_PLAY)
+                    {
+                        instance->m_Playing = 1;
+                    }
+                    else if (command.m_Type == COMMAND_STOP)
+                    {
+                        instance->m_Playing = 0;
+                        dmSoundCodec::Reset(sound->m_CodecContext, instance->m_Decoder);
+                    }
+                    else
+                    {
+                        instance->m_Playing = (uint8_t) !command.m_Parameter;
+                    }
+                }
+                break;
+            case COMMAND_SET_LOOPING:
+                sound->m_Instances[command.m_Index].m_Looping = command.m_Parameter;
+                break;
+            case COMMAND_SET_PARAMETER:
+                ApplyParameter(&sound->m_Instances[command.m_Index], (Parameter) command.m_Parameter, command.m_Value);
+                break;
+            case COMMAND_SET_INSTANCE_GROUP:
+                sound->m_Instances[command.m_Index].m_Group = command.m_Group;
+                break;
+            case COMMAND_SET_GROUP_GAIN:
+                ApplyGroupGain(sound, &sound->m_Groups[command.m_Index], command.m_Value);
+                break;
+        }
+    }
+
+    // Must be called with m_Mutex held
+    static void FlushCommands(SoundSystem* sound)
+    {
+        int32_t read = AtomicGet(&sound->m_CommandRead);
+        int32_t write = AtomicGet(&sound->m_CommandWrite);
+        if (read == write)
+            return;
+
+        DM_PROFILE(Sound, "FlushCommands");
+        for (int32_t i = read; i != write; ++i)
+        {
+            ApplyCommand(sound, sound->m_Commands[i & (SOUND_COMMAND_QUEUE_SIZE - 1)]);
+        }
+        // Releases the slots to the producer (full barrier)
+        dmAtomicAdd32(&sound->m_CommandRead, write - read);
+    }
+
+    /**
+     * Apply the command directly, or queue it for the mixer thread. If the queue is full
+     * the pending commands are flushed from the calling thread instead.
+     */
+    static void PushCommand(SoundSystem* sound, const Command& command)
+    {
+        if (!sound->m_UseThread)
+        {
+            ApplyCommand(sound, command);
+            return;
+        }
+
+        int32_t write = AtomicGet(&sound->m_CommandWrite);
+        if (write - AtomicGet(&sound->m_CommandRead) < SOUND_COMMAND_QUEUE_SIZE)
+        {
+            sound->m_Commands[write & (SOUND_COMMAND_QUEUE_SIZE - 1)] = command;
+            // Publishes the command (full barrier)
+            dmAtomicIncrement32(&sound->m_CommandWrite);
+            return;
+        }
+
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+        FlushCommands(sound);
+        ApplyCommand(sound, command);
+    }
+
+    static inline Command MakeCommand(CommandType type, uint16_t index)
+    {
+        Command command;
+        memset(&command, 0, sizeof(command));
+        command.m_Type = (uint8_t) type;
+        command.m_Index = index;
+        return command;
+    }
+
+    // May be called from a resource load thread. The mixer only reads the sound data of playing instances,
+    // never the pool or a slot that is being created, so a non-threaded Update doesn't need to hold m_Mutex.
     Result NewSoundData(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
     {
         SoundSystem* sound = g_SoundSystem;
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
 
         if (sound->m_SoundDataPool.Remaining() == 0)
         {
@@ -444,6 +714,7 @@ namespace dmSound
 
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
+        DM_MUTEX_SCOPED_LOCK(g_SoundSystem->m_Mutex);
         free(sound_data->m_Data);
         sound_data->m_Data = malloc(sound_buffer_size);
         sound_data->m_Size = sound_buffer_size;
@@ -458,10 +729,12 @@ namespace dmSound
 
     Result DeleteSoundData(HSoundData sound_data)
     {
+        SoundSystem* sound = g_SoundSystem;
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+
         if (sound_data->m_Data != 0x0)
             free((void*) sound_data->m_Data);
 
-        SoundSystem* sound = g_SoundSystem;
         sound->m_SoundDataPool.Push(sound_data->m_Index);
         sound_data->m_Index = 0xffff;
 
@@ -471,6 +744,7 @@ namespace dmSound
     Result NewSoundInstance(HSoundData sound_data, HSoundInstance* sound_instance)
     {
         SoundSystem* ss = g_SoundSystem;
+        DM_MUTEX_SCOPED_LOCK(ss->m_Mutex);
 
         if (ss->m_InstancesPool.Remaining() == 0)
         {
@@ -510,6 +784,8 @@ namespace dmSound
         si->m_Looping = 0;
         si->m_EndOfStream = 0;
         si->m_Playing = 0;
+        si->m_PlayState = 0;
+        si->m_PlaySerial = 0;
         si->m_Decoder = decoder;
         si->m_Group = MASTER_GROUP_HASH;
 
@@ -526,6 +802,11 @@ namespace dmSound
             dmLogError("Deleting playing sound instance (%s)", GetSoundName(sound, sound_instance));
             Stop(sound_instance);
         }
+
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+        // Apply any pending commands for this instance before the slot can be reused
+        FlushCommands(sound);
+
         uint16_t index = sound_instance->m_Index;
         sound->m_InstancesPool.Push(index);
         sound_instance->m_Index = 0xffff;
@@ -551,12 +832,15 @@ namespace dmSound
         if (!index) {
             return RESULT_NO_SUCH_GROUP;
         }
-        instance->m_Group = group_hash;
+        Command command = MakeCommand(COMMAND_SET_INSTANCE_GROUP, instance->m_Index);
+        command.m_Group = group_hash;
+        PushCommand(sound, command);
         return RESULT_OK;
     }
 
     Result AddGroup(const char* group)
     {
+        DM_MUTEX_SCOPED_LOCK(g_SoundSystem->m_Mutex);
         int index = GetOrCreateGroup(group);
         if (index == -1) {
             return RESULT_OUT_OF_GROUPS;
@@ -572,29 +856,10 @@ namespace dmSound
             return RESULT_NO_SUCH_GROUP;
         }
 
-        // If all playing sounds is currently at gain zero
-        // we can safely do a hard reset of the group gain
-        bool reset = true;
-        uint32_t instances = sound->m_Instances.Size();
-        for (uint32_t i = 0; i < instances; ++i)
-        {
-            SoundInstance* instance = &sound->m_Instances[i];
-            if (instance->m_Group != group_hash)
-            {
-                continue;
-            }
-            if (instance->m_Playing || instance->m_FrameCount > 0)
-            {
-                if (instance->m_Gain.m_Prev == 0.0)
-                {
-                    continue;
-                }
-                reset = false;
-                break;
-            }
-        }
-        SoundGroup* group = &sound->m_Groups[*index];
-        group->m_Gain.Set(gain, reset);
+        sound->m_Groups[*index].m_RequestedGain = gain;
+        Command command = MakeCommand(COMMAND_SET_GROUP_GAIN, (uint16_t) *index);
+        command.m_Value = gain;
+        PushCommand(sound, command);
         return RESULT_OK;
     }
 
@@ -607,7 +872,7 @@ namespace dmSound
         }
 
         SoundGroup* group = &sound->m_Groups[*index];
-        *gain = group->m_Gain.m_Next;
+        *gain = group->m_RequestedGain;
         return RESULT_OK;
     }
 
@@ -637,6 +902,7 @@ namespace dmSound
             return RESULT_NO_SUCH_GROUP;
         }
 
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
         SoundGroup* g = &sound->m_Groups[*index];
         uint32_t rms_frames = (uint32_t) (sound->m_MixRate * window);
         int left = rms_frames;
@@ -667,6 +933,7 @@ namespace dmSound
             return RESULT_NO_SUCH_GROUP;
         }
 
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
         SoundGroup* g = &sound->m_Groups[*index];
         uint32_t rms_frames = (uint32_t) (sound->m_MixRate * window);
         int left = rms_frames;
@@ -691,21 +958,26 @@ namespace dmSound
 
     Result Play(HSoundInstance sound_instance)
     {
-        sound_instance->m_Playing = 1;
+        Command command = MakeCommand(COMMAND_PLAY, sound_instance->m_Index);
+        command.m_Serial = SetPlayState(sound_instance, true);
+        PushCommand(g_SoundSystem, command);
         return RESULT_OK;
     }
 
     Result Stop(HSoundInstance sound_instance)
     {
-        SoundSystem* sound = g_SoundSystem;
-        sound_instance->m_Playing = 0;
-        dmSoundCodec::Reset(sound->m_CodecContext, sound_instance->m_Decoder);
+        Command command = MakeCommand(COMMAND_STOP, sound_instance->m_Index);
+        command.m_Serial = SetPlayState(sound_instance, false);
+        PushCommand(g_SoundSystem, command);
         return RESULT_OK;
     }
 
     Result Pause(HSoundInstance sound_instance, bool pause)
     {
-        sound_instance->m_Playing = (uint8_t)!pause;
+        Command command = MakeCommand(COMMAND_PAUSE, sound_instance->m_Index);
+        command.m_Serial = SetPlayState(sound_instance, !pause);
+        command.m_Parameter = (uint8_t) pause;
+        PushCommand(g_SoundSystem, command);
         return RESULT_OK;
     }
 
@@ -720,46 +992,72 @@ namespace dmSound
 
     bool IsPlaying(HSoundInstance sound_instance)
     {
-        return sound_instance->m_Playing; // && !sound_instance->m_EndOfStream;
+        return (AtomicGet(&sound_instance->m_PlayState) & 1) != 0;
     }
 
     Result SetLooping(HSoundInstance sound_instance, bool looping)
     {
-        sound_instance->m_Looping = (uint32_t) looping;
+        Command command = MakeCommand(COMMAND_SET_LOOPING, sound_instance->m_Index);
+        command.m_Parameter = (uint8_t) looping;
+        PushCommand(g_SoundSystem, command);
         return RESULT_OK;
     }
 
     Result SetParameter(HSoundInstance sound_instance, Parameter parameter, const Vector4& value)
     {
-        bool reset = !sound_instance->m_Playing;
         switch(parameter)
         {
             case PARAMETER_GAIN:
-                sound_instance->m_Gain.Set(dmMath::Max(0.0f, value.getX()), reset);
-                break;
             case PARAMETER_PAN:
-                {
-                    float pan = dmMath::Max(-1.0f, dmMath::Min(1.0f, value.getX()));
-                    pan = (pan + 1.0f) * 0.5f; // map [-1,1] to [0,1] for easier calculations later
-                    sound_instance->m_Pan.Set(pan, reset);
-                }
-                break;
             case PARAMETER_SPEED:
-                sound_instance->m_Speed = dmMath::Max(0.0f, dmMath::Min((float)SOUND_MAX_SPEED, value.getX()));
                 break;
             default:
                 dmLogError("Invalid parameter: %d (%s)\n", parameter, GetSoundName(g_SoundSystem, sound_instance));
                 return RESULT_INVALID_PROPERTY;
         }
+
+        Command command = MakeCommand(COMMAND_SET_PARAMETER, sound_instance->m_Index);
+        command.m_Parameter = (uint8_t) parameter;
+        command.m_Value = value.getX();
+        PushCommand(g_SoundSystem, command);
         return RESULT_OK;
     }
 
-    static inline void GetPanScale(float pan, float* left_scale, float* right_scale)
+    void SetMixKernels(MixKernelType type)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+        sound->m_MixKernels = GetMixKernels(type);
+    }
+
+    static inline void ConvertFrames(const MixKernels* kernels, const int16_t* frames, float* out, uint32_t count)
     {
-        // Constant power panning: https://www.cs.cmu.edu/~music/icm-online/readings/panlaws/index.html
-        const float theta = pan * M_PI_2;
-        *left_scale = cosf(theta);
-        *right_scale = sinf(theta);
+        kernels->m_ConvertS16(frames, out, count);
+    }
+
+    static inline void ConvertFrames(const MixKernels* kernels, const uint8_t* frames, float* out, uint32_t count)
+    {
+        kernels->m_ConvertU8(frames, out, count);
+    }
+
+    // Applies gain and pan to the frames in m_MixFrames and adds them to the mix buffer
+    static void MixFrames(const MixContext* mix_context, SoundInstance* instance, uint32_t channels, float* mix_buffer, uint32_t mix_buffer_count)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        const MixKernels* kernels = sound->m_MixKernels;
+
+        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
+        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
+        kernels->m_PanGain(&gain_ramp, &pan_ramp, sound->m_MixLeft, sound->m_MixRight, mix_buffer_count);
+
+        if (channels == 1)
+        {
+            kernels->m_MixMono(mix_buffer, sound->m_MixFrames, sound->m_MixLeft, sound->m_MixRight, mix_buffer_count);
+        }
+        else
+        {
+            kernels->m_MixStereo(mix_buffer, sound->m_MixFrames, sound->m_MixLeft, sound->m_MixRight, mix_buffer_count);
+        }
     }
 
     template <typename T, int offset, int scale>
@@ -775,29 +1073,21 @@ namespace dmSound
         delta *= instance->m_Speed;
 
         T* frames = (T*) instance->m_Frames;
+        float* out = g_SoundSystem->m_MixFrames;
 
         // Typically when the buffer is less than a mix-buffer we might overfetch
         // We never overfetch for identity mixing as identity mixing is a special case
         frames[instance->m_FrameCount] = frames[instance->m_FrameCount-1];
 
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip;
             T s1 = frames[index];
             T s2 = frames[index + 1];
             s1 = (s1 - offset) * scale;
             s2 = (s2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-
-            float s = (1.0f - mix) * s1 + mix * s2;
-            mix_buffer[2 * i] += s * gain * left_scale;
-            mix_buffer[2 * i + 1] += s * gain * right_scale;
+            out[i] = (1.0f - mix) * s1 + mix * s2;
 
             prev_index = index;
             frac += delta;
@@ -810,6 +1100,8 @@ namespace dmSound
 
         assert(prev_index <= instance->m_FrameCount);
 
+        MixFrames(mix_context, instance, 1, mix_buffer, mix_buffer_count);
+
         memmove(instance->m_Frames, (char*) instance->m_Frames + index * sizeof(T), (instance->m_FrameCount - index) * sizeof(T));
         instance->m_FrameCount -= index;
     }
@@ -827,18 +1119,15 @@ namespace dmSound
         delta *= instance->m_Speed;
 
         T* frames = (T*) instance->m_Frames;
+        float* out = g_SoundSystem->m_MixFrames;
 
         // Typically when the buffer is less than a mix-buffer we might overfetch
         // We never overfetch for identity mixing as identity mixing is a special case
         frames[2 * instance->m_FrameCount] = frames[2 * instance->m_FrameCount - 2];
         frames[2 * instance->m_FrameCount + 1] = frames[2 * instance->m_FrameCount - 1];
 
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip;
             T sl1 = frames[2 * index];
             T sl2 = frames[2 * index + 2];
@@ -850,13 +1139,8 @@ namespace dmSound
             sr1 = (sr1 - offset) * scale;
             sr2 = (sr2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-
-            float sl = (1.0f - mix) * sl1 + mix * sl2;
-            float sr = (1.0f - mix) * sr1 + mix * sr2;
-            mix_buffer[2 * i]       += sl * gain * left_scale;
-            mix_buffer[2 * i + 1]   += sr * gain * right_scale;
+            out[2 * i]     = (1.0f - mix) * sl1 + mix * sl2;
+            out[2 * i + 1] = (1.0f - mix) * sr1 + mix * sr2;
 
             prev_index = index;
             frac += delta;
@@ -868,59 +1152,31 @@ namespace dmSound
 
         assert(prev_index <= instance->m_FrameCount);
 
+        MixFrames(mix_context, instance, 2, mix_buffer, mix_buffer_count);
+
         memmove(instance->m_Frames, (char*) instance->m_Frames + index * sizeof(T) * 2, (instance->m_FrameCount - index) * sizeof(T) * 2);
         instance->m_FrameCount -= index;
     }
 
-    template <typename T, int offset, int scale>
+    template <typename T>
     static void MixResampleIdentityMono(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
     {
         (void)rate;
         (void)mix_rate;
         assert(instance->m_FrameCount == mix_buffer_count);
-        T* frames = (T*) instance->m_Frames;
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
-
-        for (uint32_t i = 0; i < mix_buffer_count; i++)
-        {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
-            float s = frames[i];
-            s = (s - offset) * scale * gain;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-            mix_buffer[2 * i]       += s * left_scale;
-            mix_buffer[2 * i + 1]   += s * right_scale;
-        }
+        ConvertFrames(g_SoundSystem->m_MixKernels, (const T*) instance->m_Frames, g_SoundSystem->m_MixFrames, mix_buffer_count);
+        MixFrames(mix_context, instance, 1, mix_buffer, mix_buffer_count);
         instance->m_FrameCount -= mix_buffer_count;
     }
 
-    template <typename T, int offset, int scale>
+    template <typename T>
     static void MixResampleIdentityStereo(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
     {
         (void)rate;
         (void)mix_rate;
         assert(instance->m_FrameCount == mix_buffer_count);
-        T* frames = (T*) instance->m_Frames;
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
-
-        for (uint32_t i = 0; i < mix_buffer_count; i++)
-        {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
-            float s1 = frames[2 * i];
-            float s2 = frames[2 * i + 1];
-            s1 = (s1 - offset) * scale * gain;
-            s2 = (s2 - offset) * scale * gain;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-            mix_buffer[2 * i]       += s1 * left_scale;
-            mix_buffer[2 * i + 1]   += s2 * right_scale;
-        }
+        ConvertFrames(g_SoundSystem->m_MixKernels, (const T*) instance->m_Frames, g_SoundSystem->m_MixFrames, 2 * mix_buffer_count);
+        MixFrames(mix_context, instance, 2, mix_buffer, mix_buffer_count);
         instance->m_FrameCount -= mix_buffer_count;
     }
 
@@ -947,10 +1203,10 @@ namespace dmSound
     };
 
     Mixer g_IdentityMixers[] = {
-            Mixer(1, 8, MixResampleIdentityMono<uint8_t, 128, 255>),
-            Mixer(1, 16, MixResampleIdentityMono<int16_t, 0, 1>),
-            Mixer(2, 8, MixResampleIdentityStereo<uint8_t, 128, 255>),
-            Mixer(2, 16, MixResampleIdentityStereo<int16_t, 0, 1>),
+            Mixer(1, 8, MixResampleIdentityMono<uint8_t>),
+            Mixer(1, 16, MixResampleIdentityMono<int16_t>),
+            Mixer(2, 8, MixResampleIdentityStereo<uint8_t>),
+            Mixer(2, 16, MixResampleIdentityStereo<int16_t>),
     };
 
     static void MixResample(const MixContext* mix_context, SoundInstance* instance, const dmSoundCodec::Info* info, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
@@ -1109,7 +1365,7 @@ namespace dmSound
         if (r != dmSoundCodec::RESULT_OK) {
             dmLogWarning("Unable to decode file '%s'. Result %d", GetSoundName(sound, instance), r);
 
-            instance->m_Playing = 0;
+            SetStopped(instance);
             return;
         }
 
@@ -1169,7 +1425,7 @@ namespace dmSound
             }
 
             if (instance->m_EndOfStream && instance->m_FrameCount == 0) {
-                instance->m_Playing = 0;
+                SetStopped(instance);
             }
         }
     }
@@ -1205,29 +1461,11 @@ namespace dmSound
                 continue;
             }
             Ramp ramp = GetRamp(mix_context, &g->m_Gain, n);
-            for (uint32_t i = 0; i < n; i++) {
-                float gain = ramp.GetValue(i);
-                gain = dmMath::Clamp(gain, 0.0f, 1.0f);
-
-                float s1 = g->m_MixBuffer[2 * i];
-                float s2 = g->m_MixBuffer[2 * i + 1];
-                mix_buffer[2 * i] += s1 * gain;
-                mix_buffer[2 * i + 1] += s2 * gain;
-            }
+            sound->m_MixKernels->m_MixGroup(mix_buffer, g->m_MixBuffer, &ramp, n);
         }
 
         Ramp ramp = GetRamp(mix_context, &master->m_Gain, n);
-        for (uint32_t i = 0; i < n; i++) {
-            float gain = ramp.GetValue(i);
-            float s1 = mix_buffer[2 * i] * gain;
-            float s2 = mix_buffer[2 * i + 1] * gain;
-            s1 = dmMath::Min(32767.0f, s1);
-            s1 = dmMath::Max(-32768.0f, s1);
-            s2 = dmMath::Min(32767.0f, s2);
-            s2 = dmMath::Max(-32768.0f, s2);
-            out[2 * i] = (int16_t) s1;
-            out[2 * i + 1] = (int16_t) s2;
-        }
+        sound->m_MixKernels->m_Master(mix_buffer, &ramp, out, n);
     }
 
     static void StepGroupValues()
@@ -1256,14 +1494,12 @@ namespace dmSound
         }
     }
 
-    Result Update()
+    static Result UpdateInternal(SoundSystem* sound, bool currentIsPhoneCallActive)
     {
         DM_PROFILE(Sound, "Update")
-        SoundSystem* sound = g_SoundSystem;
 
         uint16_t active_instance_count = sound->m_InstancesPool.Size();
 
-        bool currentIsPhoneCallActive = IsPhoneCallActive();
         if (!sound->m_IsPhoneCallActive && currentIsPhoneCallActive)
         {
             sound->m_IsPhoneCallActive = true;
@@ -1347,9 +1583,28 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result Update()
+    {
+        SoundSystem* sound = g_SoundSystem;
+        bool is_phone_call_active = IsPhoneCallActive();
+        if (!sound->m_UseThread)
+        {
+            return UpdateInternal(sound, is_phone_call_active);
+        }
+
+        // The mixing is done on the sound thread
+        dmAtomicStore32(&sound->m_PlatformPhoneCallActive, is_phone_call_active ? 1 : 0);
+        return sound->m_InstancesPool.Size() == 0 ? RESULT_NOTHING_TO_PLAY : RESULT_OK;
+    }
+
     bool IsMusicPlaying()
     {
-        return PlatformIsMusicPlaying(g_SoundSystem->m_IsDeviceStarted, g_SoundSystem->m_HasWindowFocus);
+        bool is_device_started;
+        {
+            DM_MUTEX_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+            is_device_started = g_SoundSystem->m_IsDeviceStarted;
+        }
+        return PlatformIsMusicPlaying(is_device_started, AtomicGet(&g_SoundSystem->m_HasWindowFocus) != 0);
     }
 
     bool IsPhoneCallActive()
@@ -1361,7 +1616,7 @@ namespace dmSound
     {
         SoundSystem* sound = g_SoundSystem;
         if (sound) {
-            sound->m_HasWindowFocus = focus;
+            dmAtomicStore32(&sound->m_HasWindowFocus, focus ? 1 : 0);
         }
     }
 
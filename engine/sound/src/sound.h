@@ -84,6 +84,7 @@ namespace dmSound
         uint32_t m_BufferSize;
         uint32_t m_FrameCount;
         uint32_t m_MaxInstances;
+        bool     m_UseThread; // Mix on a separate thread. Ignored on platforms without threads
 
         InitializeParams()
         {
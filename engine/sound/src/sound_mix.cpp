@@ -0,0 +1,554 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <math.h>
+#include <dlib/math.h>
+
+#include "sound.h"
+#include "sound_private.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_SOUND_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define DM_SOUND_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace dmSound
+{
+    static inline void GetPanScale(float pan, float* left_scale, float* right_scale)
+    {
+        // Constant power panning: https://www.cs.cmu.edu/~music/icm-online/readings/panlaws/index.html
+        const float theta = pan * M_PI_2;
+        *left_scale = cosf(theta);
+        *right_scale = sinf(theta);
+    }
+
+    // The scalar kernels work on [start, start + count) so that the SIMD kernels can use them for the tail
+
+    static void ConvertS16Range(const int16_t* in, float* out, uint32_t start, uint32_t count)
+    {
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            out[i] = in[i];
+        }
+    }
+
+    static void ConvertU8Range(const uint8_t* in, float* out, uint32_t start, uint32_t count)
+    {
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            float s = in[i];
+            out[i] = (s - 128.0f) * 255.0f;
+        }
+    }
+
+    static void PanGainRange(const Ramp* gain, const Ramp* pan, float* left, float* right, uint32_t start, uint32_t count)
+    {
+        if (pan->m_From == pan->m_To)
+        {
+            // The common case, no pan change during this buffer
+            float left_scale, right_scale;
+            GetPanScale(pan->m_From, &left_scale, &right_scale);
+            for (uint32_t i = start; i < start + count; ++i)
+            {
+                float g = gain->GetValue(i);
+                left[i] = g * left_scale;
+                right[i] = g * right_scale;
+            }
+            return;
+        }
+
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            float g = gain->GetValue(i);
+            float left_scale, right_scale;
+            GetPanScale(pan->GetValue(i), &left_scale, &right_scale);
+            left[i] = g * left_scale;
+            right[i] = g * right_scale;
+        }
+    }
+
+    static void MixMonoRange(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t start, uint32_t count)
+    {
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            mix_buffer[2 * i]     += in[i] * left[i];
+            mix_buffer[2 * i + 1] += in[i] * right[i];
+        }
+    }
+
+    static void MixStereoRange(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t start, uint32_t count)
+    {
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            mix_buffer[2 * i]     += in[2 * i] * left[i];
+            mix_buffer[2 * i + 1] += in[2 * i + 1] * right[i];
+        }
+    }
+
+    static void MixGroupRange(float* mix_buffer, const float* in, const Ramp* gain, uint32_t start, uint32_t count)
+    {
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            float g = dmMath::Clamp(gain->GetValue(i), 0.0f, 1.0f);
+            mix_buffer[2 * i]     += in[2 * i] * g;
+            mix_buffer[2 * i + 1] += in[2 * i + 1] * g;
+        }
+    }
+
+    static void MasterRange(const float* mix_buffer, const Ramp* gain, int16_t* out, uint32_t start, uint32_t count)
+    {
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            float g = gain->GetValue(i);
+            float s1 = mix_buffer[2 * i] * g;
+            float s2 = mix_buffer[2 * i + 1] * g;
+            s1 = dmMath::Min(32767.0f, s1);
+            s1 = dmMath::Max(-32768.0f, s1);
+            s2 = dmMath::Min(32767.0f, s2);
+            s2 = dmMath::Max(-32768.0f, s2);
+            out[2 * i] = (int16_t) s1;
+            out[2 * i + 1] = (int16_t) s2;
+        }
+    }
+
+    static void ConvertS16Scalar(const int16_t* in, float* out, uint32_t count)
+    {
+        ConvertS16Range(in, out, 0, count);
+    }
+
+    static void ConvertU8Scalar(const uint8_t* in, float* out, uint32_t count)
+    {
+        ConvertU8Range(in, out, 0, count);
+    }
+
+    static void PanGainScalar(const Ramp* gain, const Ramp* pan, float* left, float* right, uint32_t count)
+    {
+        PanGainRange(gain, pan, left, right, 0, count);
+    }
+
+    static void MixMonoScalar(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count)
+    {
+        MixMonoRange(mix_buffer, in, left, right, 0, count);
+    }
+
+    static void MixStereoScalar(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count)
+    {
+        MixStereoRange(mix_buffer, in, left, right, 0, count);
+    }
+
+    static void MixGroupScalar(float* mix_buffer, const float* in, const Ramp* gain, uint32_t count)
+    {
+        MixGroupRange(mix_buffer, in, gain, 0, count);
+    }
+
+    static void MasterScalar(const float* mix_buffer, const Ramp* gain, int16_t* out, uint32_t count)
+    {
+        MasterRange(mix_buffer, gain, out, 0, count);
+    }
+
+    static const MixKernels g_ScalarKernels = {
+        ConvertS16Scalar,
+        ConvertU8Scalar,
+        PanGainScalar,
+        MixMonoScalar,
+        MixStereoScalar,
+        MixGroupScalar,
+        MasterScalar,
+    };
+
+#if defined(DM_SOUND_SSE)
+
+    // Four consecutive ramp values, starting at index i, computed as in Ramp::GetValue()
+    struct RampSSE
+    {
+        __m128 m_Index, m_From, m_Delta, m_Recip;
+
+        RampSSE(const Ramp* ramp)
+        {
+            m_Index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            m_From  = _mm_set1_ps(ramp->m_From);
+            m_Delta = _mm_set1_ps(ramp->m_To - ramp->m_From);
+            m_Recip = _mm_set1_ps(ramp->m_TotalSamplesRecip);
+        }
+
+        inline __m128 Next()
+        {
+            __m128 v = _mm_add_ps(m_From, _mm_mul_ps(_mm_mul_ps(m_Index, m_Recip), m_Delta));
+            m_Index = _mm_add_ps(m_Index, _mm_set1_ps(4.0f));
+            return v;
+        }
+    };
+
+    // sin(x) for x in [0, pi/2], Taylor series to x^11 (error < 1e-7)
+    static inline __m128 SinSSE(__m128 x)
+    {
+        const __m128 x2 = _mm_mul_ps(x, x);
+        __m128 p = _mm_set1_ps(-1.0f / 39916800.0f);
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f / 362880.0f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.0f / 5040.0f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f / 120.0f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.0f / 6.0f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f));
+        return _mm_mul_ps(p, x);
+    }
+
+    static void ConvertS16SSE(const int16_t* in, float* out, uint32_t count)
+    {
+        uint32_t n = count & ~7U;
+        for (uint32_t i = 0; i < n; i += 8)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*) (in + i));
+            // Sign extend by placing the value in the upper half and shifting down
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            _mm_storeu_ps(out + i, _mm_cvtepi32_ps(lo));
+            _mm_storeu_ps(out + i + 4, _mm_cvtepi32_ps(hi));
+        }
+        ConvertS16Range(in, out, n, count - n);
+    }
+
+    static void ConvertU8SSE(const uint8_t* in, float* out, uint32_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 offset = _mm_set1_ps(128.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        uint32_t n = count & ~7U;
+        for (uint32_t i = 0; i < n; i += 8)
+        {
+            __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (in + i)), zero);
+            __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, zero));
+            __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, zero));
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_sub_ps(lo, offset), scale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_sub_ps(hi, offset), scale));
+        }
+        ConvertU8Range(in, out, n, count - n);
+    }
+
+    static void PanGainSSE(const Ramp* gain, const Ramp* pan, float* left, float* right, uint32_t count)
+    {
+        RampSSE gain_ramp(gain);
+        uint32_t n = count & ~3U;
+        if (pan->m_From == pan->m_To)
+        {
+            float left_scale, right_scale;
+            GetPanScale(pan->m_From, &left_scale, &right_scale);
+            const __m128 l = _mm_set1_ps(left_scale);
+            const __m128 r = _mm_set1_ps(right_scale);
+            for (uint32_t i = 0; i < n; i += 4)
+            {
+                __m128 g = gain_ramp.Next();
+                _mm_storeu_ps(left + i, _mm_mul_ps(g, l));
+                _mm_storeu_ps(right + i, _mm_mul_ps(g, r));
+            }
+        }
+        else
+        {
+            RampSSE pan_ramp(pan);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 half_pi = _mm_set1_ps((float) M_PI_2);
+            for (uint32_t i = 0; i < n; i += 4)
+            {
+                __m128 g = gain_ramp.Next();
+                __m128 theta = _mm_mul_ps(pan_ramp.Next(), half_pi);
+                theta = _mm_min_ps(_mm_max_ps(theta, zero), half_pi);
+                // cos(x) = sin(pi/2 - x)
+                __m128 l = SinSSE(_mm_sub_ps(half_pi, theta));
+                __m128 r = SinSSE(theta);
+                _mm_storeu_ps(left + i, _mm_mul_ps(g, l));
+                _mm_storeu_ps(right + i, _mm_mul_ps(g, r));
+            }
+        }
+        PanGainRange(gain, pan, left, right, n, count - n);
+    }
+
+    static void MixMonoSSE(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count)
+    {
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            __m128 s = _mm_loadu_ps(in + i);
+            __m128 l = _mm_mul_ps(s, _mm_loadu_ps(left + i));
+            __m128 r = _mm_mul_ps(s, _mm_loadu_ps(right + i));
+            float* m = mix_buffer + 2 * i;
+            _mm_storeu_ps(m, _mm_add_ps(_mm_loadu_ps(m), _mm_unpacklo_ps(l, r)));
+            _mm_storeu_ps(m + 4, _mm_add_ps(_mm_loadu_ps(m + 4), _mm_unpackhi_ps(l, r)));
+        }
+        MixMonoRange(mix_buffer, in, left, right, n, count - n);
+    }
+
+    static void MixStereoSSE(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count)
+    {
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            float* m = mix_buffer + 2 * i;
+            const float* s = in + 2 * i;
+            _mm_storeu_ps(m, _mm_add_ps(_mm_loadu_ps(m), _mm_mul_ps(_mm_loadu_ps(s), _mm_unpacklo_ps(l, r))));
+            _mm_storeu_ps(m + 4, _mm_add_ps(_mm_loadu_ps(m + 4), _mm_mul_ps(_mm_loadu_ps(s + 4), _mm_unpackhi_ps(l, r))));
+        }
+        MixStereoRange(mix_buffer, in, left, right, n, count - n);
+    }
+
+    static void MixGroupSSE(float* mix_buffer, const float* in, const Ramp* gain, uint32_t count)
+    {
+        RampSSE gain_ramp(gain);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            __m128 g = _mm_min_ps(_mm_max_ps(gain_ramp.Next(), zero), one);
+            float* m = mix_buffer + 2 * i;
+            const float* s = in + 2 * i;
+            _mm_storeu_ps(m, _mm_add_ps(_mm_loadu_ps(m), _mm_mul_ps(_mm_loadu_ps(s), _mm_unpacklo_ps(g, g))));
+            _mm_storeu_ps(m + 4, _mm_add_ps(_mm_loadu_ps(m + 4), _mm_mul_ps(_mm_loadu_ps(s + 4), _mm_unpackhi_ps(g, g))));
+        }
+        MixGroupRange(mix_buffer, in, gain, n, count - n);
+    }
+
+    static void MasterSSE(const float* mix_buffer, const Ramp* gain, int16_t* out, uint32_t count)
+    {
+        RampSSE gain_ramp(gain);
+        const __m128 max = _mm_set1_ps(32767.0f);
+        const __m128 min = _mm_set1_ps(-32768.0f);
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            __m128 g = gain_ramp.Next();
+            __m128 s1 = _mm_mul_ps(_mm_loadu_ps(mix_buffer + 2 * i), _mm_unpacklo_ps(g, g));
+            __m128 s2 = _mm_mul_ps(_mm_loadu_ps(mix_buffer + 2 * i + 4), _mm_unpackhi_ps(g, g));
+            s1 = _mm_max_ps(_mm_min_ps(s1, max), min);
+            s2 = _mm_max_ps(_mm_min_ps(s2, max), min);
+            // Truncate as the scalar cast does. The values are already in range so the saturating pack is exact
+            __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(s1), _mm_cvttps_epi32(s2));
+            _mm_storeu_si128((__m128i*) (out + 2 * i), packed);
+        }
+        MasterRange(mix_buffer, gain, out, n, count - n);
+    }
+
+    static const MixKernels g_SimdKernels = {
+        ConvertS16SSE,
+        ConvertU8SSE,
+        PanGainSSE,
+        MixMonoSSE,
+        MixStereoSSE,
+        MixGroupSSE,
+        MasterSSE,
+    };
+
+#elif defined(DM_SOUND_NEON)
+
+    // Four consecutive ramp values, starting at index i, computed as in Ramp::GetValue()
+    struct RampNEON
+    {
+        float32x4_t m_Index, m_From, m_Delta, m_Recip;
+
+        RampNEON(const Ramp* ramp)
+        {
+            const float index[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+            m_Index = vld1q_f32(index);
+            m_From  = vdupq_n_f32(ramp->m_From);
+            m_Delta = vdupq_n_f32(ramp->m_To - ramp->m_From);
+            m_Recip = vdupq_n_f32(ramp->m_TotalSamplesRecip);
+        }
+
+        inline float32x4_t Next()
+        {
+            float32x4_t v = vaddq_f32(m_From, vmulq_f32(vmulq_f32(m_Index, m_Recip), m_Delta));
+            m_Index = vaddq_f32(m_Index, vdupq_n_f32(4.0f));
+            return v;
+        }
+    };
+
+    // sin(x) for x in [0, pi/2], Taylor series to x^11 (error < 1e-7)
+    static inline float32x4_t SinNEON(float32x4_t x)
+    {
+        const float32x4_t x2 = vmulq_f32(x, x);
+        float32x4_t p = vdupq_n_f32(-1.0f / 39916800.0f);
+        p = vaddq_f32(vmulq_f32(p, x2), vdupq_n_f32(1.0f / 362880.0f));
+        p = vaddq_f32(vmulq_f32(p, x2), vdupq_n_f32(-1.0f / 5040.0f));
+        p = vaddq_f32(vmulq_f32(p, x2), vdupq_n_f32(1.0f / 120.0f));
+        p = vaddq_f32(vmulq_f32(p, x2), vdupq_n_f32(-1.0f / 6.0f));
+        p = vaddq_f32(vmulq_f32(p, x2), vdupq_n_f32(1.0f));
+        return vmulq_f32(p, x);
+    }
+
+    static void ConvertS16NEON(const int16_t* in, float* out, uint32_t count)
+    {
+        uint32_t n = count & ~7U;
+        for (uint32_t i = 0; i < n; i += 8)
+        {
+            int16x8_t s = vld1q_s16(in + i);
+            vst1q_f32(out + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))));
+            vst1q_f32(out + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))));
+        }
+        ConvertS16Range(in, out, n, count - n);
+    }
+
+    static void ConvertU8NEON(const uint8_t* in, float* out, uint32_t count)
+    {
+        const float32x4_t offset = vdupq_n_f32(128.0f);
+        const float32x4_t scale = vdupq_n_f32(255.0f);
+        uint32_t n = count & ~7U;
+        for (uint32_t i = 0; i < n; i += 8)
+        {
+            uint16x8_t s = vmovl_u8(vld1_u8(in + i));
+            float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(s)));
+            float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(s)));
+            vst1q_f32(out + i, vmulq_f32(vsubq_f32(lo, offset), scale));
+            vst1q_f32(out + i + 4, vmulq_f32(vsubq_f32(hi, offset), scale));
+        }
+        ConvertU8Range(in, out, n, count - n);
+    }
+
+    static void PanGainNEON(const Ramp* gain, const Ramp* pan, float* left, float* right, uint32_t count)
+    {
+        RampNEON gain_ramp(gain);
+        uint32_t n = count & ~3U;
+        if (pan->m_From == pan->m_To)
+        {
+            float left_scale, right_scale;
+            GetPanScale(pan->m_From, &left_scale, &right_scale);
+            for (uint32_t i = 0; i < n; i += 4)
+            {
+                float32x4_t g = gain_ramp.Next();
+                vst1q_f32(left + i, vmulq_n_f32(g, left_scale));
+                vst1q_f32(right + i, vmulq_n_f32(g, right_scale));
+            }
+        }
+        else
+        {
+            RampNEON pan_ramp(pan);
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            const float32x4_t half_pi = vdupq_n_f32((float) M_PI_2);
+            for (uint32_t i = 0; i < n; i += 4)
+            {
+                float32x4_t g = gain_ramp.Next();
+                float32x4_t theta = vmulq_f32(pan_ramp.Next(), half_pi);
+                theta = vminq_f32(vmaxq_f32(theta, zero), half_pi);
+                // cos(x) = sin(pi/2 - x)
+                float32x4_t l = SinNEON(vsubq_f32(half_pi, theta));
+                float32x4_t r = SinNEON(theta);
+                vst1q_f32(left + i, vmulq_f32(g, l));
+                vst1q_f32(right + i, vmulq_f32(g, r));
+            }
+        }
+        PanGainRange(gain, pan, left, right, n, count - n);
+    }
+
+    static void MixMonoNEON(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count)
+    {
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            float32x4_t s = vld1q_f32(in + i);
+            float32x4x2_t m = vld2q_f32(mix_buffer + 2 * i);
+            m.val[0] = vaddq_f32(m.val[0], vmulq_f32(s, vld1q_f32(left + i)));
+            m.val[1] = vaddq_f32(m.val[1], vmulq_f32(s, vld1q_f32(right + i)));
+            vst2q_f32(mix_buffer + 2 * i, m);
+        }
+        MixMonoRange(mix_buffer, in, left, right, n, count - n);
+    }
+
+    static void MixStereoNEON(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count)
+    {
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            float32x4x2_t s = vld2q_f32(in + 2 * i);
+            float32x4x2_t m = vld2q_f32(mix_buffer + 2 * i);
+            m.val[0] = vaddq_f32(m.val[0], vmulq_f32(s.val[0], vld1q_f32(left + i)));
+            m.val[1] = vaddq_f32(m.val[1], vmulq_f32(s.val[1], vld1q_f32(right + i)));
+            vst2q_f32(mix_buffer + 2 * i, m);
+        }
+        MixStereoRange(mix_buffer, in, left, right, n, count - n);
+    }
+
+    static void MixGroupNEON(float* mix_buffer, const float* in, const Ramp* gain, uint32_t count)
+    {
+        RampNEON gain_ramp(gain);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            float32x4_t g = vminq_f32(vmaxq_f32(gain_ramp.Next(), zero), one);
+            float32x4x2_t s = vld2q_f32(in + 2 * i);
+            float32x4x2_t m = vld2q_f32(mix_buffer + 2 * i);
+            m.val[0] = vaddq_f32(m.val[0], vmulq_f32(s.val[0], g));
+            m.val[1] = vaddq_f32(m.val[1], vmulq_f32(s.val[1], g));
+            vst2q_f32(mix_buffer + 2 * i, m);
+        }
+        MixGroupRange(mix_buffer, in, gain, n, count - n);
+    }
+
+    static void MasterNEON(const float* mix_buffer, const Ramp* gain, int16_t* out, uint32_t count)
+    {
+        RampNEON gain_ramp(gain);
+        const float32x4_t max = vdupq_n_f32(32767.0f);
+        const float32x4_t min = vdupq_n_f32(-32768.0f);
+        uint32_t n = count & ~3U;
+        for (uint32_t i = 0; i < n; i += 4)
+        {
+            float32x4_t g = gain_ramp.Next();
+            float32x4x2_t s = vld2q_f32(mix_buffer + 2 * i);
+            float32x4_t s1 = vmaxq_f32(vminq_f32(vmulq_f32(s.val[0], g), max), min);
+            float32x4_t s2 = vmaxq_f32(vminq_f32(vmulq_f32(s.val[1], g), max), min);
+            // vcvtq truncates as the scalar cast does
+            int16x4x2_t packed;
+            packed.val[0] = vqmovn_s32(vcvtq_s32_f32(s1));
+            packed.val[1] = vqmovn_s32(vcvtq_s32_f32(s2));
+            vst2_s16(out + 2 * i, packed);
+        }
+        MasterRange(mix_buffer, gain, out, n, count - n);
+    }
+
+    static const MixKernels g_SimdKernels = {
+        ConvertS16NEON,
+        ConvertU8NEON,
+        PanGainNEON,
+        MixMonoNEON,
+        MixStereoNEON,
+        MixGroupNEON,
+        MasterNEON,
+    };
+
+#endif
+
+    bool HasSimdMixKernels()
+    {
+#if defined(DM_SOUND_SSE) || defined(DM_SOUND_NEON)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    const MixKernels* GetMixKernels(MixKernelType type)
+    {
+#if defined(DM_SOUND_SSE) || defined(DM_SOUND_NEON)
+        if (type == MIX_KERNEL_SIMD)
+        {
+            return &g_SimdKernels;
+        }
+#else
+        (void)type;
+#endif
+        return &g_ScalarKernels;
+    }
+}
@@ -15,6 +15,60 @@
 
 namespace dmSound
 {
+    /**
+     * Linear ramp of a value over a mix buffer. See Value and GetRamp() in sound.cpp
+     */
+    struct Ramp
+    {
+        float m_From, m_To, m_TotalSamplesRecip;
+
+        inline float GetValue(int i) const
+        {
+            float mix = i * m_TotalSamplesRecip;
+            return m_From + mix * (m_To - m_From);
+        }
+    };
+
+    enum MixKernelType
+    {
+        MIX_KERNEL_SCALAR = 0,
+        MIX_KERNEL_SIMD   = 1,
+    };
+
+    /**
+     * Inner loops of the mixer. All buffers are float unless stated otherwise,
+     * "stereo" buffers are interleaved left/right and count is in frames.
+     */
+    struct MixKernels
+    {
+        // out[i] = in[i]
+        void (*m_ConvertS16)(const int16_t* in, float* out, uint32_t count);
+        // out[i] = (in[i] - 128) * 255
+        void (*m_ConvertU8)(const uint8_t* in, float* out, uint32_t count);
+        // left[i] = gain(i) * cos(pan(i) * pi/2), right[i] = gain(i) * sin(pan(i) * pi/2)
+        void (*m_PanGain)(const Ramp* gain, const Ramp* pan, float* left, float* right, uint32_t count);
+        // Mono in, stereo mix_buffer += in * left/right
+        void (*m_MixMono)(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count);
+        // Stereo in, stereo mix_buffer += in * left/right
+        void (*m_MixStereo)(float* mix_buffer, const float* in, const float* left, const float* right, uint32_t count);
+        // Stereo in, stereo mix_buffer += in * clamp(gain(i), 0, 1)
+        void (*m_MixGroup)(float* mix_buffer, const float* in, const Ramp* gain, uint32_t count);
+        // Stereo in, stereo out = clamp(in * gain(i), -32768, 32767)
+        void (*m_Master)(const float* mix_buffer, const Ramp* gain, int16_t* out, uint32_t count);
+    };
+
+    /**
+     * Get the mixer kernels of a type. MIX_KERNEL_SIMD returns the scalar kernels
+     * on targets without SSE2 or NEON support, see HasSimdMixKernels()
+     */
+    const MixKernels* GetMixKernels(MixKernelType type);
+
+    bool HasSimdMixKernels();
+
+    /**
+     * Select the kernels used by the mixer. The SIMD kernels are selected by Initialize()
+     */
+    void SetMixKernels(MixKernelType type);
 
     Result PlatformInitialize(dmConfigFile::HConfig config, const InitializeParams* params);
 
@@ -24,6 +24,7 @@
 #include <dlib/math.h>
 #include "../sound.h"
 #include "../sound_codec.h"
+#include "../sound_private.h"
 #include "../stb_vorbis/stb_vorbis.h"
 
 #include "test/mono_tone_440_22050_44100.wav.embed.h"
@@ -1327,6 +1328,200 @@ const TestParams2 params_mixer_test[] = {
 INSTANTIATE_TEST_CASE_P(dmSoundMixerTest, dmSoundMixerTest, jc_test_values_in(params_mixer_test));
 #endif
 
+// Mixing on the sound thread, fed through the command queue. The null device
+// consumes the buffers in real time, so the test runs headless
+TEST(dmSoundThreadTest, PlayStop)
+{
+    dmSound::InitializeParams params;
+    params.m_OutputDevice = "null";
+    params.m_UseThread = true;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &sd, 1234));
+
+    dmSound::HSoundInstance instance = 0;
+    dmSound::HSoundInstance looping = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &looping));
+
+    // More commands than fit in the queue
+    for (uint32_t i = 0; i < 4000; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instance, dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(i / 4000.0f)));
+    }
+    // 2 seconds of sound at 5x speed
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instance, dmSound::PARAMETER_SPEED, Vectormath::Aos::Vector4(5.0f)));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetLooping(looping, true));
+
+    // The play state is visible immediately, before the mixer has seen the commands
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(looping));
+    ASSERT_TRUE(dmSound::IsPlaying(instance));
+    ASSERT_TRUE(dmSound::IsPlaying(looping));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Pause(looping, true));
+    ASSERT_FALSE(dmSound::IsPlaying(looping));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Pause(looping, false));
+    ASSERT_TRUE(dmSound::IsPlaying(looping));
+
+    uint64_t start = dmTime::GetTime();
+    while (dmSound::IsPlaying(instance) && (dmTime::GetTime() - start) < 5000000)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+        dmTime::Sleep(10000);
+    }
+    ASSERT_FALSE(dmSound::IsPlaying(instance));
+    ASSERT_TRUE(dmSound::IsPlaying(looping));
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Stop(looping));
+    ASSERT_FALSE(dmSound::IsPlaying(looping));
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(looping));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+    ASSERT_EQ(dmSound::RESULT_NOTHING_TO_PLAY, dmSound::Update());
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+static void CompareMixKernels(const dmSound::MixKernels* scalar, const dmSound::MixKernels* simd)
+{
+    // Odd count to exercise the scalar tail of the vector loops
+    const uint32_t count = 771;
+    std::vector<int16_t> s16(count * 2);
+    std::vector<uint8_t> u8(count * 2);
+    std::vector<float> in(count * 2);
+    for (uint32_t i = 0; i < count * 2; ++i)
+    {
+        s16[i] = (int16_t) (rand() % 65536 - 32768);
+        u8[i] = (uint8_t) (rand() % 256);
+        in[i] = (float) (rand() % 65536 - 32768);
+    }
+
+    std::vector<float> a(count * 2), b(count * 2);
+    scalar->m_ConvertS16(&s16[0], &a[0], count * 2);
+    simd->m_ConvertS16(&s16[0], &b[0], count * 2);
+    for (uint32_t i = 0; i < count * 2; ++i)
+        ASSERT_EQ(a[i], b[i]);
+
+    scalar->m_ConvertU8(&u8[0], &a[0], count * 2);
+    simd->m_ConvertU8(&u8[0], &b[0], count * 2);
+    for (uint32_t i = 0; i < count * 2; ++i)
+        ASSERT_EQ(a[i], b[i]);
+
+    dmSound::Ramp gain = { 0.25f, 1.5f, 1.0f / count };
+    dmSound::Ramp pans[] = { { 0.5f, 0.5f, 1.0f / count }, { 0.0f, 1.0f, 1.0f / count } };
+    for (uint32_t p = 0; p < sizeof(pans) / sizeof(pans[0]); ++p)
+    {
+        std::vector<float> left_a(count), right_a(count), left_b(count), right_b(count);
+        scalar->m_PanGain(&gain, &pans[p], &left_a[0], &right_a[0], count);
+        simd->m_PanGain(&gain, &pans[p], &left_b[0], &right_b[0], count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ASSERT_NEAR(left_a[i], left_b[i], 1e-6f);
+            ASSERT_NEAR(right_a[i], right_b[i], 1e-6f);
+        }
+
+        std::vector<float> mix_a(count * 2, 1.0f), mix_b(count * 2, 1.0f);
+        scalar->m_MixMono(&mix_a[0], &in[0], &left_a[0], &right_a[0], count);
+        simd->m_MixMono(&mix_b[0], &in[0], &left_a[0], &right_a[0], count);
+        scalar->m_MixStereo(&mix_a[0], &in[0], &left_a[0], &right_a[0], count);
+        simd->m_MixStereo(&mix_b[0], &in[0], &left_a[0], &right_a[0], count);
+        for (uint32_t i = 0; i < count * 2; ++i)
+            ASSERT_NEAR(mix_a[i], mix_b[i], 0.01f);
+    }
+
+    // The gain ramp goes above 1 to exercise the clamping
+    std::vector<float> mix_a(count * 2, 1.0f), mix_b(count * 2, 1.0f);
+    scalar->m_MixGroup(&mix_a[0], &in[0], &gain, count);
+    simd->m_MixGroup(&mix_b[0], &in[0], &gain, count);
+    for (uint32_t i = 0; i < count * 2; ++i)
+        ASSERT_NEAR(mix_a[i], mix_b[i], 0.01f);
+
+    // Values outside of the int16 range to exercise the clamping
+    std::vector<int16_t> out_a(count * 2), out_b(count * 2);
+    for (uint32_t i = 0; i < count * 2; ++i)
+        in[i] *= 3.0f;
+    scalar->m_Master(&in[0], &gain, &out_a[0], count);
+    simd->m_Master(&in[0], &gain, &out_b[0], count);
+    for (uint32_t i = 0; i < count * 2; ++i)
+        ASSERT_NEAR(out_a[i], out_b[i], 1);
+}
+
+TEST(dmSoundMixKernelTest, Tolerance)
+{
+    if (!dmSound::HasSimdMixKernels())
+    {
+        printf("No SIMD mix kernels on this platform\n");
+    }
+    CompareMixKernels(dmSound::GetMixKernels(dmSound::MIX_KERNEL_SCALAR), dmSound::GetMixKernels(dmSound::MIX_KERNEL_SIMD));
+}
+
+// Measures the time spent in Update() when mixing a number of voices into the null device.
+// The null device consumes the buffers in real time, so the mixed time is the elapsed time.
+static uint64_t MixVoices(dmSound::MixKernelType type, uint32_t voice_count, uint64_t* elapsed)
+{
+    dmSound::InitializeParams params;
+    params.m_OutputDevice = "null";
+    params.m_MaxInstances = voice_count;
+    if (dmSound::RESULT_OK != dmSound::Initialize(0, &params))
+        return 0;
+    dmSound::SetMixKernels(type);
+
+    dmSound::HSoundData mono = 0;
+    dmSound::HSoundData stereo = 0;
+    dmSound::NewSoundData(MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &mono, 1);
+    dmSound::NewSoundData(STEREO_TONE_440_22050_44100_WAV, STEREO_TONE_440_22050_44100_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &stereo, 2);
+
+    // Every other voice is an identity mixed mono sound, and a resampled stereo sound
+    std::vector<dmSound::HSoundInstance> instances(voice_count);
+    for (uint32_t i = 0; i < voice_count; ++i)
+    {
+        dmSound::NewSoundInstance((i & 1) ? stereo : mono, &instances[i]);
+        dmSound::SetLooping(instances[i], true);
+        dmSound::SetParameter(instances[i], dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(0.5f / voice_count));
+        dmSound::SetParameter(instances[i], dmSound::PARAMETER_PAN, Vectormath::Aos::Vector4((i % 5) * 0.5f - 1.0f));
+        dmSound::Play(instances[i]);
+    }
+
+    uint64_t mix_time = 0;
+    uint64_t start = dmTime::GetTime();
+    while ((dmTime::GetTime() - start) < 500000)
+    {
+        uint64_t t = dmTime::GetTime();
+        dmSound::Update();
+        mix_time += dmTime::GetTime() - t;
+        dmTime::Sleep(4000);
+    }
+
+    *elapsed = dmTime::GetTime() - start;
+
+    for (uint32_t i = 0; i < voice_count; ++i)
+    {
+        dmSound::Stop(instances[i]);
+        dmSound::DeleteSoundInstance(instances[i]);
+    }
+    dmSound::DeleteSoundData(mono);
+    dmSound::DeleteSoundData(stereo);
+    dmSound::Finalize();
+    return mix_time;
+}
+
+TEST(dmSoundMixKernelTest, Performance)
+{
+    const uint32_t voice_counts[] = { 8, 32 };
+    for (uint32_t i = 0; i < sizeof(voice_counts) / sizeof(voice_counts[0]); ++i)
+    {
+        uint64_t scalar_elapsed = 0;
+        uint64_t simd_elapsed = 0;
+        uint64_t scalar = MixVoices(dmSound::MIX_KERNEL_SCALAR, voice_counts[i], &scalar_elapsed);
+        uint64_t simd = MixVoices(dmSound::MIX_KERNEL_SIMD, voice_counts[i], &simd_elapsed);
+        ASSERT_GT(scalar, 0U);
+        ASSERT_GT(simd, 0U);
+        printf("%3u voices: scalar %5.2f%%, simd %5.2f%% of real time spent mixing\n", voice_counts[i],
+                100.0 * scalar / scalar_elapsed, 100.0 * simd / simd_elapsed);
+    }
+}
+
 DM_DECLARE_SOUND_DEVICE(LoopBackDevice, "loopback", DeviceLoopbackOpen, DeviceLoopbackClose, DeviceLoopbackQueue, DeviceLoopbackFreeBufferSlots, DeviceLoopbackDeviceInfo, DeviceLoopbackRestart, DeviceLoopbackStop);
 
 int main(int argc, char **argv)